@@ -243,6 +243,10 @@ class ClientCmd : public Cmd {
 
   std::string operation_, info_, kill_type_;
   void DoInitial() override;
+  void Clear() override {
+    info_.clear();
+    kill_type_.clear();
+  }
 };
 
 class InfoCmd : public Cmd {
@@ -492,6 +496,7 @@ class PKPatternMatchDelCmd : public Cmd {
   std::string pattern_;
   int64_t max_count_;
   void DoInitial() override;
+  void Clear() override { remove_keys_.clear(); }
 };
 
 class DummyCmd : public Cmd {
@@ -7,6 +7,8 @@
 #define PIKA_BINLOG_H_
 
 #include <atomic>
+#include <deque>
+#include <thread>
 
 #include "pstd/include/env.h"
 #include "pstd/include/pstd_mutex.h"
@@ -43,6 +45,20 @@ class Version final : public pstd::noncopyable {
   std::shared_ptr<pstd::RWFile> save_;
 };
 
+// When the binlog leader fdatasyncs the file after appending a batch
+enum class BinlogSyncPolicy {
+  kNone,      // never, left to the page cache
+  kBatch,     // after every batch
+  kInterval,  // after a batch once sync_interval_ms passed since the last sync,
+              // a background thread syncs what the last batches left behind
+};
+
+/*
+ * Put is a group commit: producers queue their items and the first one in
+ * the queue becomes the leader, it appends everything queued so far under
+ * mutex_, saves the Version and syncs once for the whole batch, then wakes
+ * the others with their status.
+ */
 class Binlog : public pstd::noncopyable {
  public:
   Binlog(std::string  Binlog_path, int file_size = 100 * 1024 * 1024);
@@ -75,9 +91,29 @@ class Binlog : public pstd::noncopyable {
     return version_->term_;
   }
 
+  void SetSyncPolicy(BinlogSyncPolicy policy, uint64_t sync_interval_ms);
+  // false while items appended under a sync policy wait for their sync
+  bool IsSynced() { return !unsynced_.load(); }
+
   void Close();
 
  private:
+  struct Writer {
+    explicit Writer(const std::string* _item) : item(_item) {}
+    const std::string* item;
+    pstd::Status status;
+    bool done = false;
+    pstd::CondVar cv;
+  };
+
+  // the kInterval sync thread
+  void RunIntervalSync();
+  void StopIntervalSync();
+
+  // Need to hold mutex_
+  pstd::Status AppendItem(const std::string& item);
+  pstd::Status SyncBatch();
+  pstd::Status SyncFile();
   pstd::Status Put(const char* item, int len);
   pstd::Status EmitPhysicalRecord(RecordType t, const char* ptr, size_t n, int* temp_pro_offset);
   static pstd::Status AppendPadding(pstd::WritableFile* file, uint64_t* len);
@@ -108,6 +144,22 @@ class Binlog : public pstd::noncopyable {
   std::string filename_;
 
   std::atomic<bool> binlog_io_error_;
+
+  // group commit queue, the front writer is the leader
+  pstd::Mutex writers_mu_;
+  std::deque<Writer*> writers_;
+
+  std::atomic<BinlogSyncPolicy> sync_policy_{BinlogSyncPolicy::kNone};
+  std::atomic<uint64_t> sync_interval_ms_{1000};
+  // written under mutex_, read by the sync thread to time its next round
+  std::atomic<uint64_t> last_sync_us_{0};
+  std::atomic<bool> unsynced_{false};
+
+  // syncs the tail of a burst for kInterval, no later Put may come to do it
+  std::thread sync_thread_;
+  pstd::Mutex sync_mu_;
+  pstd::CondVar sync_cv_;
+  bool sync_thread_exit_ = false;
 };
 
 #endif
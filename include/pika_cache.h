@@ -18,7 +18,7 @@
 #include "cache/include/cache.h"
 #include "storage/storage.h"
 
-class PikaCacheLoadThread;
+class PikaCacheLoader;
 class ZIncrbyCmd;
 class ZRangebyscoreCmd;
 class ZRevrangebyscoreCmd;
@@ -34,6 +34,9 @@ struct CacheInfo {
   int64_t misses = 0;
   uint64_t async_load_keys_num = 0;
   uint32_t waitting_load_keys_num = 0;
+  uint64_t dropped_load_keys_num = 0;
+  uint64_t skipped_load_keys_num = 0;
+  uint64_t load_keys_time_us = 0;
   void clear() {
     status = PIKA_CACHE_STATUS_NONE;
     cache_num = 0;
@@ -43,6 +46,9 @@ struct CacheInfo {
     misses = 0;
     async_load_keys_num = 0;
     waitting_load_keys_num = 0;
+    dropped_load_keys_num = 0;
+    skipped_load_keys_num = 0;
+    load_keys_time_us = 0;
   }
 };
 
@@ -218,7 +224,7 @@ class PikaCache : public pstd::noncopyable, public std::enable_shared_from_this<
   int zset_cache_start_direction_ = 0;
   int zset_cache_field_num_per_key_ = 0;
   std::shared_mutex rwlock_;
-  std::unique_ptr<PikaCacheLoadThread> cache_load_thread_;
+  std::unique_ptr<PikaCacheLoader> cache_loader_;
   std::vector<cache::RedisCache*> caches_;
   std::vector<std::shared_ptr<pstd::Mutex>> cache_mutexs_;
 };
@@ -8,8 +8,10 @@
 #define PIKA_CACHE_LOAD_THREAD_H_
 
 #include <atomic>
+#include <deque>
 #include <string>
-#include <unordered_map>
+#include <tuple>
+#include <unordered_set>
 #include <vector>
 
 #include "include/pika_cache.h"
@@ -17,39 +19,72 @@
 #include "net/include/net_thread.h"
 #include "storage/storage.h"
 
+// One loader thread, draining its own queue of keys to load into the cache
 class PikaCacheLoadThread : public net::Thread {
  public:
+  using LoadKey = std::tuple<char, std::string, std::shared_ptr<DB>>;
+
   PikaCacheLoadThread(int zset_cache_start_direction, int zset_cache_field_num_per_key);
   ~PikaCacheLoadThread() override;
 
   uint64_t AsyncLoadKeysNum(void) { return async_load_keys_num_; }
   uint32_t WaittingLoadKeysNum(void) { return waitting_load_keys_num_; }
-  void Push(const char key_type, std::string& key, const std::shared_ptr<DB>& db);
+  uint64_t DroppedLoadKeysNum(void) { return dropped_load_keys_num_; }
+  uint64_t LoadKeysTimeUs(void) { return load_keys_time_us_; }
+  void Push(const char key_type, const std::string& key, const std::shared_ptr<DB>& db);
 
  private:
-  bool LoadKV(std::string& key, const std::shared_ptr<DB>& db);
+  // loads the strings keys with one MultiGet, returns how many were loaded
+  size_t LoadKVs(const std::vector<std::string>& keys, const std::shared_ptr<DB>& db);
   bool LoadHash(std::string& key, const std::shared_ptr<DB>& db);
   bool LoadList(std::string& key, const std::shared_ptr<DB>& db);
   bool LoadSet(std::string& key, const std::shared_ptr<DB>& db);
   bool LoadZset(std::string& key, const std::shared_ptr<DB>& db);
   bool LoadKey(const char key_type, std::string& key, const std::shared_ptr<DB>& db);
+  size_t LoadKeys(std::vector<LoadKey>& load_keys);
   virtual void* ThreadMain() override;
 
  private:
   std::atomic_bool should_exit_;
-  std::deque<std::tuple<const char, std::string, const std::shared_ptr<DB>>> loadkeys_queue_;
+  std::deque<LoadKey> loadkeys_queue_;
+  // the keys queued or being loaded, a key pushed again meanwhile is dropped
+  std::unordered_set<std::string> loadkeys_set_;
 
   pstd::CondVar loadkeys_cond_;
   pstd::Mutex loadkeys_mutex_;
 
-  std::unordered_map<std::string, std::string> loadkeys_map_;
-  pstd::Mutex loadkeys_map_mutex_;
   std::atomic_uint64_t async_load_keys_num_;
   std::atomic_uint32_t waitting_load_keys_num_;
+  // the keys dropped because the queue was full
+  std::atomic_uint64_t dropped_load_keys_num_;
+  std::atomic_uint64_t load_keys_time_us_;
   // currently only take effects to zset
   int zset_cache_start_direction_;
   int zset_cache_field_num_per_key_;
-  std::shared_ptr<PikaCache> cache_;
+};
+
+/*
+ * The pool of loader threads of one cache. A key goes to the thread of its
+ * cache shard, so that every shard is loaded by one thread and its queue
+ * stays bounded and deduplicated. Keys too large for the cache are skipped
+ * before anything is read.
+ */
+class PikaCacheLoader {
+ public:
+  PikaCacheLoader(int thread_num, int zset_cache_start_direction, int zset_cache_field_num_per_key);
+  ~PikaCacheLoader();
+
+  uint64_t AsyncLoadKeysNum(void);
+  uint32_t WaittingLoadKeysNum(void);
+  uint64_t DroppedLoadKeysNum(void);
+  uint64_t SkippedLoadKeysNum(void) { return skipped_load_keys_num_; }
+  uint64_t LoadKeysTimeUs(void);
+  void Push(uint32_t cache_index, const char key_type, const std::string& key, const std::shared_ptr<DB>& db);
+
+ private:
+  std::vector<std::unique_ptr<PikaCacheLoadThread>> threads_;
+  // the keys larger than max-key-size-in-cache
+  std::atomic_uint64_t skipped_load_keys_num_;
 };
 
 #endif  // PIKA_CACHE_LOAD_THREAD_H_
@@ -74,11 +74,13 @@ class PikaClientConn : public net::RedisConn {
                  const net::HandleType& handle_type, int max_conn_rbuf_size);
   ~PikaClientConn() = default;
 
-  bool IsInterceptedByRTC(std::string& opt);
+  bool IsInterceptedByRTC(const std::shared_ptr<Cmd>& c_ptr);
 
   void ProcessRedisCmds(const std::vector<net::RedisCmdArgsType>& argvs, bool async, std::string* response) override;
 
-  bool ReadCmdInCache(const net::RedisCmdArgsType& argv, const std::string& opt);
+  // answers the leading commands of argvs found in the cache, returns how many
+  size_t ReadCmdsInCache(const std::vector<net::RedisCmdArgsType>& argvs, bool* cache_miss);
+  bool ReadCmdInCache(const net::RedisCmdArgsType& argv, std::string* resp, bool* cache_miss);
   void BatchExecRedisCmd(const std::vector<net::RedisCmdArgsType>& argvs, bool cache_miss_in_rtc);
   int DealMessage(const net::RedisCmdArgsType& argv, std::string* response) override { return 0; }
   static void DoBackgroundTask(void* arg);
@@ -19,6 +19,7 @@ class PikaClientProcessor {
   int Start();
   void Stop();
   void SchedulePool(net::TaskFunc func, void* arg);
+  void SchedulePool(net::TaskFunc func, void* arg, uint64_t affinity);
   size_t ThreadPoolCurQueueSize();
   size_t ThreadPoolMaxQueueSize();
 
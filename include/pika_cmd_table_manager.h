@@ -13,16 +13,6 @@
 #include "include/pika_command.h"
 #include "include/pika_data_distribution.h"
 
-struct CommandStatistics {
-  CommandStatistics() = default;
-  CommandStatistics(const CommandStatistics& other) {
-    cmd_time_consuming.store(other.cmd_time_consuming.load());
-    cmd_count.store(other.cmd_count.load());
-  }
-  std::atomic<uint64_t> cmd_count = 0;
-  std::atomic<uint64_t> cmd_time_consuming = 0;
-};
-
 class PikaCmdTableManager {
   friend AclSelector;
 
@@ -38,11 +28,6 @@ class PikaCmdTableManager {
 
   std::vector<std::string> GetAclCategoryCmdNames(uint32_t flag);
 
-  /*
-  * Info Commandstats used
-  */
-  std::unordered_map<std::string, CommandStatistics>* GetCommandStatMap();
-
  private:
   std::shared_ptr<Cmd> NewCommand(const std::string& opt);
 
@@ -55,10 +40,5 @@ class PikaCmdTableManager {
 
   std::shared_mutex map_protector_;
   std::unordered_map<std::thread::id, std::unique_ptr<PikaDataDistribution>> thread_distribution_map_;
-
-  /*
-  * Info Commandstats used
-  */
-  std::unordered_map<std::string, CommandStatistics> cmdstat_map_;
 };
 #endif
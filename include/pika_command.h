@@ -12,6 +12,7 @@
 #include <unordered_set>
 #include <utility>
 
+#include "rocksdb/slice.h"
 #include "rocksdb/status.h"
 
 #include "net/include/net_conn.h"
@@ -23,6 +24,9 @@
 class SyncMasterDB;
 class SyncSlaveDB;
 class DB;
+namespace storage {
+struct StagedWrite;
+}  // namespace storage
 // Constant for command name
 // Admin
 const std::string kCmdNameSlaveof = "slaveof";
@@ -344,6 +348,13 @@ class CmdRes {
     message_.clear();
     ret_ = kNone;
   }
+  // keeps the reply buffer for the next request unless it grew too large
+  void Reset(size_t max_kept_capacity) {
+    if (message_.capacity() > max_kept_capacity) {
+      std::string().swap(message_);
+    }
+    clear();
+  }
   bool CacheMiss() const { return ret_ == kCacheMiss; }
   std::string raw_message() const { return message_; }
   std::string message() const {
@@ -448,6 +459,12 @@ class CmdRes {
     AppendStringLenUint64(value.size());
     AppendContent(value);
   }
+  // a bulk string straight from a slice, e.g. one pinned by storage
+  void AppendStringSlice(const rocksdb::Slice& value) {
+    AppendStringLenUint64(value.size());
+    message_.append(value.data(), value.size());
+    message_.append(kNewLine);
+  }
   void AppendStringRaw(const std::string& value) { message_.append(value); }
 
   void AppendStringVector(const std::vector<std::string>& strArray) {
@@ -530,10 +547,18 @@ class Cmd : public std::enable_shared_from_this<Cmd> {
   virtual void Split(const HintKeys& hint_keys) = 0;
   virtual void Merge() = 0;
   virtual bool IsTooLargeKey(const int &max_sz) { return false; }
+  // A replicated write that the slave may apply in one WriteBatch with the
+  // writes of other keys fills write and returns true, FinishStagedWrite
+  // then takes its outcome in place of Do, see PikaReplBgWorker::WriteDBInBatch
+  virtual bool StageWrite(storage::StagedWrite* write) { return false; }
+  virtual void FinishStagedWrite(const storage::StagedWrite& write) {}
 
   int8_t SubCmdIndex(const std::string& cmdName);  // if the command no subCommand，return -1；
 
   void Initial(const PikaCmdArgsType& argv, const std::string& db_name);
+  // Called before the command goes back to the per thread pool, see
+  // PikaCmdTableManager::NewCommand
+  void ResetForReuse();
   uint32_t flag() const;
   bool hasFlag(uint32_t flag) const;
   bool is_read() const;
@@ -611,6 +636,8 @@ class Cmd : public std::enable_shared_from_this<Cmd> {
 
  private:
   virtual void DoInitial() = 0;
+  // Commands are reused, Clear must reset whatever a previous request left
+  // in the members that DoInitial does not overwrite unconditionally
   virtual void Clear(){};
 
   Cmd& operator=(const Cmd&);
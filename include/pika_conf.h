@@ -73,6 +73,10 @@ class PikaConf : public pstd::BaseConf {
     std::shared_lock l(rwlock_);
     return sync_binlog_thread_num_;
   }
+  int slave_apply_batch_size() {
+    std::shared_lock l(rwlock_);
+    return slave_apply_batch_size_;
+  }
   std::string log_path() {
     std::shared_lock l(rwlock_);
     return log_path_;
@@ -292,6 +296,34 @@ class PikaConf : public pstd::BaseConf {
     std::shared_lock l(rwlock_);
     return small_compaction_duration_threshold_;
   }
+  int zset_rank_index_threshold() {
+    std::shared_lock l(rwlock_);
+    return zset_rank_index_threshold_;
+  }
+  int64_t sets_sample_cache_size() {
+    std::shared_lock l(rwlock_);
+    return sets_sample_cache_size_;
+  }
+  int list_chunk_max_elements() {
+    std::shared_lock l(rwlock_);
+    return list_chunk_max_elements_;
+  }
+  int inline_collection_max_entries() {
+    std::shared_lock l(rwlock_);
+    return inline_collection_max_entries_;
+  }
+  int keyspace_scan_threads() {
+    std::shared_lock l(rwlock_);
+    return keyspace_scan_threads_;
+  }
+  bool expire_index() {
+    std::shared_lock l(rwlock_);
+    return expire_index_;
+  }
+  int expire_reaper_keys_per_second() {
+    std::shared_lock l(rwlock_);
+    return expire_reaper_keys_per_second_;
+  }
   int max_background_flushes() {
     std::shared_lock l(rwlock_);
     return max_background_flushes_;
@@ -423,6 +455,7 @@ class PikaConf : public pstd::BaseConf {
   int GetCacheList() { return cache_list_; }
   int GetCacheBit() { return cache_bit_; }
   int GetCacheNum() { return cache_num_; }
+  int cache_load_thread_num() { return cache_load_thread_num_; }
   void SetCacheNum(const int value) { cache_num_ = value; }
   void SetCacheMode(const int value) { cache_mode_ = value; }
   void SetCacheStartDirection(const int value) { zset_cache_start_direction_ = value; }
@@ -487,6 +520,8 @@ class PikaConf : public pstd::BaseConf {
   bool rtc_cache_read_enabled() { return rtc_cache_read_enabled_; }
   std::string pidfile() { return pidfile_; }
   int binlog_file_size() { return binlog_file_size_; }
+  std::string binlog_sync_policy() { return binlog_sync_policy_; }
+  int binlog_sync_interval_ms() { return binlog_sync_interval_ms_; }
   std::vector<rocksdb::CompressionType> compression_per_level();
   std::string compression_all_levels() const { return compression_per_level_; };
   static rocksdb::CompressionType GetCompression(const std::string& value);
@@ -570,6 +605,16 @@ class PikaConf : public pstd::BaseConf {
     TryPushDiffCommands("small-compaction-duration-threshold", std::to_string(value));
     small_compaction_duration_threshold_ = value;
   }
+  void SetKeyspaceScanThreads(const int value) {
+    std::lock_guard l(rwlock_);
+    TryPushDiffCommands("keyspace-scan-threads", std::to_string(value));
+    keyspace_scan_threads_ = value;
+  }
+  void SetExpireReaperKeysPerSecond(const int value) {
+    std::lock_guard l(rwlock_);
+    TryPushDiffCommands("expire-reaper-keys-per-second", std::to_string(value));
+    expire_reaper_keys_per_second_ = value;
+  }
   void SetMaxClientResponseSize(const int value) {
     std::lock_guard l(rwlock_);
     TryPushDiffCommands("max-client-response-size", std::to_string(value));
@@ -778,6 +823,36 @@ class PikaConf : public pstd::BaseConf {
     TryPushDiffCommands("arena-block-size", std::to_string(value));
     arena_block_size_ = value;
   }
+  void SetEnableBlobFiles(bool value) {
+    std::lock_guard l(rwlock_);
+    TryPushDiffCommands("enable-blob-files", value ? "yes" : "no");
+    enable_blob_files_ = value;
+  }
+  void SetMinBlobSize(int64_t value) {
+    std::lock_guard l(rwlock_);
+    TryPushDiffCommands("min-blob-size", std::to_string(value));
+    min_blob_size_ = value;
+  }
+  void SetBlobFileSize(int64_t value) {
+    std::lock_guard l(rwlock_);
+    TryPushDiffCommands("blob-file-size", std::to_string(value));
+    blob_file_size_ = value;
+  }
+  void SetEnableBlobGarbageCollection(bool value) {
+    std::lock_guard l(rwlock_);
+    TryPushDiffCommands("enable-blob-garbage-collection", value ? "yes" : "no");
+    enable_blob_garbage_collection_ = value;
+  }
+  void SetBlobGarbageCollectionAgeCutoff(double value) {
+    std::lock_guard l(rwlock_);
+    TryPushDiffCommands("blob-garbage-collection-age-cutoff", std::to_string(value));
+    blob_garbage_collection_age_cutoff_ = value;
+  }
+  void SetBlobGarbageCollectionForceThreshold(double value) {
+    std::lock_guard l(rwlock_);
+    TryPushDiffCommands("blob-garbage-collection-force-threshold", std::to_string(value));
+    blob_garbage_collection_force_threshold_ = value;
+  }
 
   void SetRateLmiterBandwidth(int64_t value) {
     std::lock_guard l(rwlock_);
@@ -918,6 +993,7 @@ class PikaConf : public pstd::BaseConf {
   std::unordered_set<std::string> admin_cmd_set_ = {"info", "ping", "monitor"};
   int sync_thread_num_ = 0;
   int sync_binlog_thread_num_ = 0;
+  int slave_apply_batch_size_ = 64;
   int expire_dump_days_ = 3;
   int db_sync_speed_ = 0;
   std::string slaveof_;
@@ -987,6 +1063,13 @@ class PikaConf : public pstd::BaseConf {
   int max_cache_statistic_keys_ = 0;
   int small_compaction_threshold_ = 0;
   int small_compaction_duration_threshold_ = 0;
+  int zset_rank_index_threshold_ = 0;
+  int64_t sets_sample_cache_size_ = 32 << 20;
+  int list_chunk_max_elements_ = 0;
+  int inline_collection_max_entries_ = 0;
+  int keyspace_scan_threads_ = 4;
+  bool expire_index_ = false;
+  int expire_reaper_keys_per_second_ = 1000;
   int max_background_flushes_ = -1;
   int max_background_compactions_ = -1;
   int max_background_jobs_ = 0;
@@ -1036,12 +1119,15 @@ class PikaConf : public pstd::BaseConf {
   int64_t target_file_size_base_ = 0;
   int64_t max_compaction_bytes_ = 0;
   int binlog_file_size_ = 0;
+  std::string binlog_sync_policy_ = "none";
+  int binlog_sync_interval_ms_ = 1000;
 
   // cache
   std::vector<std::string> cache_type_;
   std::atomic_bool tmp_cache_disable_flag_ = false;
   std::atomic_int64_t cache_maxmemory_ = 10737418240;
   std::atomic_int cache_num_ = 5;
+  std::atomic_int cache_load_thread_num_ = 2;
   std::atomic_int cache_mode_ = 1;
   std::atomic_int cache_string_ = 1;
   std::atomic_int cache_set_ = 1;
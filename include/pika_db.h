@@ -61,6 +61,11 @@ struct DisplayCacheInfo {
   uint64_t last_time_us = 0;
   uint64_t last_load_keys_num = 0;
   uint32_t waitting_load_keys_num = 0;
+  uint64_t dropped_load_keys_num = 0;
+  uint64_t skipped_load_keys_num = 0;
+  // the average time to load a key over the last period
+  uint64_t load_key_latency_us = 0;
+  uint64_t last_load_keys_time_us = 0;
   DisplayCacheInfo& operator=(const DisplayCacheInfo &obj) {
     status = obj.status;
     cache_num = obj.cache_num;
@@ -76,6 +81,10 @@ struct DisplayCacheInfo {
     last_time_us = obj.last_time_us;
     last_load_keys_num = obj.last_load_keys_num;
     waitting_load_keys_num = obj.waitting_load_keys_num;
+    dropped_load_keys_num = obj.dropped_load_keys_num;
+    skipped_load_keys_num = obj.skipped_load_keys_num;
+    load_key_latency_us = obj.load_key_latency_us;
+    last_load_keys_time_us = obj.last_load_keys_time_us;
     return *this;
   }
 };
@@ -155,6 +164,13 @@ class DB : public std::enable_shared_from_this<DB>, public pstd::noncopyable {
   bool IsBgSaving();
   BgSaveInfo bgsave_info();
   pstd::Status GetKeyNum(std::vector<storage::KeyInfo>* key_info);
+  // live keyspace counters, Incomplete until storage finished its first scan
+  pstd::Status GetKeyCounters(std::vector<storage::KeyInfo>* key_infos);
+  // deletes at most count expired keys, each reaped batch is replicated as
+  // one DEL. Needs the expiry index, see expire-index
+  pstd::Status ReapExpiredKeys(int64_t count, int64_t* reaped_num);
+  // how long ago the oldest key still waiting for the reaper expired
+  int64_t ExpireReaperLagMs() const { return expire_reaper_lag_ms_; }
 
  private:
   bool opened_ = false;
@@ -171,6 +187,7 @@ class DB : public std::enable_shared_from_this<DB>, public pstd::noncopyable {
   std::shared_ptr<pstd::lock::LockMgr> lock_mgr_;
   std::shared_ptr<storage::Storage> storage_;
   std::shared_ptr<PikaCache> cache_;
+  std::atomic<int64_t> expire_reaper_lag_ms_ = 0;
   /*
    * KeyScan use
    */
@@ -0,0 +1,25 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef PIKA_EXPIRE_REAPER_H_
+#define PIKA_EXPIRE_REAPER_H_
+
+#include "net/include/net_thread.h"
+
+/*
+ * Deletes the keys whose TTL passed, in the order they expired, at most
+ * expire-reaper-keys-per-second keys per second in every db. Runs only with
+ * expire-index on, and not on slaves, they get the DELs of their master.
+ */
+class PikaExpireReaper : public net::Thread {
+ public:
+  PikaExpireReaper() { set_thread_name("ExpireReaper"); }
+  ~PikaExpireReaper() override;
+
+ private:
+  void* ThreadMain() override;
+};
+
+#endif
@@ -100,6 +100,8 @@ class HSetCmd : public Cmd {
   void DoUpdateCache() override;
   void Split(const HintKeys& hint_keys) override {};
   void Merge() override {};
+  bool StageWrite(storage::StagedWrite* write) override;
+  void FinishStagedWrite(const storage::StagedWrite& write) override;
   Cmd* Clone() override { return new HSetCmd(*this); }
 
  private:
@@ -260,6 +262,8 @@ class HMsetCmd : public Cmd {
   void DoUpdateCache() override;
   void Split(const HintKeys& hint_keys) override {};
   void Merge() override {};
+  bool StageWrite(storage::StagedWrite* write) override;
+  void FinishStagedWrite(const storage::StagedWrite& write) override;
   Cmd* Clone() override { return new HMsetCmd(*this); }
 
  private:
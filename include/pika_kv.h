@@ -30,6 +30,8 @@ class SetCmd : public Cmd {
   void Split(const HintKeys& hint_keys) override{};
   void Merge() override{};
   bool IsTooLargeKey(const int& max_sz) override { return key_.size() > static_cast<uint32_t>(max_sz); }
+  bool StageWrite(storage::StagedWrite* write) override;
+  void FinishStagedWrite(const storage::StagedWrite& write) override;
   Cmd* Clone() override { return new SetCmd(*this); }
 
  private:
@@ -43,6 +45,7 @@ class SetCmd : public Cmd {
   void DoInitial() override;
   void Clear() override {
     ttl_millsec = 0;
+    has_ttl_ = false;
     success_ = 0;
     condition_ = kNONE;
   }
@@ -93,6 +96,7 @@ class DelCmd : public Cmd {
   std::vector<std::string> keys_;
   int64_t split_res_ = 0;
   void DoInitial() override;
+  void Clear() override { split_res_ = 0; }
   rocksdb::Status s_;
 };
 
@@ -281,6 +285,11 @@ class MgetCmd : public Cmd {
 
  private:
   void DoInitial() override;
+  void Clear() override {
+    cache_miss_keys_.clear();
+    cache_hit_values_.clear();
+    split_res_.clear();
+  }
   void MergeCachedAndDbResults();
   void AssembleResponseFromCache();
 
@@ -563,6 +572,7 @@ class ExistsCmd : public Cmd {
   std::vector<std::string> keys_;
   int64_t split_res_ = 0;
   void DoInitial() override;
+  void Clear() override { split_res_ = 0; }
 };
 
 class ExpireCmd : public Cmd {
@@ -150,6 +150,7 @@ class LPopCmd : public Cmd {
   std::string key_;
   std::int64_t count_ = 1;
   void DoInitial() override;
+  void Clear() override { count_ = 1; }
   rocksdb::Status s_;
 };
 
@@ -197,6 +198,7 @@ class LPushxCmd : public Cmd {
   rocksdb::Status s_;
   std::vector<std::string> values_;
   void DoInitial() override;
+  void Clear() override { values_.clear(); }
 };
 
 class LRangeCmd : public Cmd {
@@ -335,6 +337,7 @@ class RPopCmd : public Cmd {
   std::string key_;
   std::int64_t count_ = 1;
   void DoInitial() override;
+  void Clear() override { count_ = 1; }
   rocksdb::Status s_;
 };
 
@@ -377,6 +380,7 @@ class RPopLPushCmd : public BlockingBaseCmd {
   std::shared_ptr<Cmd> lpush_cmd_;
   rocksdb::Status s_;
   void DoInitial() override;
+  void Clear() override { is_write_binlog_ = false; }
 };
 
 class RPushCmd : public BlockingBaseCmd {
@@ -425,5 +429,6 @@ class RPushxCmd : public Cmd {
   std::vector<std::string> values_;
   rocksdb::Status s_;
   void DoInitial() override;
+  void Clear() override { values_.clear(); }
 };
 #endif
@@ -65,7 +65,7 @@ class PikaMigrateThread : public net::Thread {
   void DestroyThread(bool is_self_exit);
   void NotifyRequestMigrate(void);
   bool IsMigrating(std::pair<const char, std::string>& kpair);
-  void ReadSlotKeys(const std::string& slotKey, int64_t need_read_num, int64_t& real_read_num, int32_t* finish);
+  void ReadSlotKeys(int64_t need_read_num, int64_t& real_read_num, int32_t* finish);
   bool CreateParseSendThreads(int32_t dispatch_num);
   void DestroyParseSendThreads(void);
   void *ThreadMain() override;
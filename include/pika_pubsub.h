@@ -41,6 +41,7 @@ class SubscribeCmd : public Cmd {
  private:
   std::vector<std::string> channels_;
   void DoInitial() override;
+  void Clear() override { channels_.clear(); }
 };
 
 class UnSubscribeCmd : public Cmd {
@@ -56,6 +57,7 @@ class UnSubscribeCmd : public Cmd {
  private:
   std::vector<std::string> channels_;
   void DoInitial() override;
+  void Clear() override { channels_.clear(); }
 };
 
 class PUnSubscribeCmd : public Cmd {
@@ -71,6 +73,7 @@ class PUnSubscribeCmd : public Cmd {
  private:
   std::vector<std::string> channels_;
   void DoInitial() override;
+  void Clear() override { channels_.clear(); }
 };
 
 class PSubscribeCmd : public Cmd {
@@ -86,6 +89,7 @@ class PSubscribeCmd : public Cmd {
   std::vector<std::string> channels_;
  private:
   void DoInitial() override;
+  void Clear() override { channels_.clear(); }
 };
 
 class PubSubCmd : public Cmd {
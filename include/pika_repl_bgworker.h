@@ -9,6 +9,7 @@
 #include <memory>
 #include <string>
 #include <functional>
+#include <vector>
 #include "net/include/bg_thread.h"
 #include "net/include/pb_conn.h"
 #include "net/include/thread_pool.h"
@@ -33,7 +34,10 @@ class PikaReplBgWorker {
   void Schedule(net::TaskFunc func, void* arg);
   void Schedule(net::TaskFunc func, void* arg, std::function<void()>& call_back);
   static void HandleBGWorkerWriteBinlog(void* arg);
-  static void HandleBGWorkerWriteDB(void* arg);
+  // Drains up to slave-apply-batch-size commands of a ReplWriteDBQueue
+  static void HandleBGWorkerWriteDBBatch(void* arg);
+  // Returns the number of commands applied through Storage::ApplyStagedWrites
+  static size_t WriteDBInBatch(const std::vector<std::shared_ptr<Cmd>>& cmds);
   static void WriteDBInSyncWay(const std::shared_ptr<Cmd>& c_ptr);
   void SetThreadName(const std::string& thread_name) {
     bg_thread_.set_thread_name(thread_name);
@@ -47,6 +51,10 @@ class PikaReplBgWorker {
   net::BGThread bg_thread_;
   static int HandleWriteBinlog(net::RedisParser* parser, const net::RedisCmdArgsType& argv);
   static void ParseBinlogOffset(const InnerMessage::BinlogOffset& pb_offset, LogOffset* offset);
+  static bool CanApplyInBatch(const std::shared_ptr<Cmd>& c_ptr);
+  static void ApplyCmd(const std::shared_ptr<Cmd>& c_ptr);
+  static size_t ApplyRun(const std::vector<std::shared_ptr<Cmd>>& run);
+  static void FailWatchedTxns(const std::vector<std::shared_ptr<Cmd>>& cmds);
 };
 
 #endif  // PIKA_REPL_BGWROKER_H_
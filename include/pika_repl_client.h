@@ -6,7 +6,9 @@
 #ifndef PIKA_REPL_CLIENT_H_
 #define PIKA_REPL_CLIENT_H_
 
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -42,11 +44,34 @@ struct ReplClientWriteBinlogTaskArg {
       : res(_res), conn(_conn), res_private_data(_res_private_data), worker(_worker) {}
 };
 
-struct ReplClientWriteDBTaskArg {
-  const std::shared_ptr<Cmd> cmd_ptr;
-  explicit ReplClientWriteDBTaskArg(std::shared_ptr<Cmd> _cmd_ptr)
-      : cmd_ptr(std::move(_cmd_ptr)) {}
-  ~ReplClientWriteDBTaskArg() = default;
+class PikaReplClient;
+
+/*
+ * Commands waiting for one write-DB worker. At most one drain task of the
+ * queue is scheduled on the worker at a time, it applies the queued
+ * commands in batches, see PikaReplBgWorker::WriteDBInBatch.
+ */
+struct ReplWriteDBQueue {
+  struct Item {
+    std::shared_ptr<Cmd> cmd_ptr;
+    uint64_t enqueue_us;
+  };
+  std::mutex mu;
+  std::deque<Item> items;
+  bool scheduled = false;
+  PikaReplClient* client = nullptr;
+  PikaReplBgWorker* worker = nullptr;
+};
+
+struct ReplApplyStats {
+  uint64_t pending_cmds = 0;
+  // age of the oldest command still queued
+  uint64_t lag_ms = 0;
+  uint64_t applied_cmds = 0;
+  uint64_t applied_batches = 0;
+  uint64_t max_batch_size = 0;
+  // applied through one WriteBatch with other commands of their run
+  uint64_t staged_cmds = 0;
 };
 
 class PikaReplClient {
@@ -65,6 +90,9 @@ class PikaReplClient {
   void ScheduleWriteBinlogTask(const std::string& db_name, const std::shared_ptr<InnerMessage::InnerResponse>& res,
                                const std::shared_ptr<net::PbConn>& conn, void* res_private_data);
   void ScheduleWriteDBTask(const std::shared_ptr<Cmd>& cmd_ptr, const std::string& db_name);
+  // Called by the write-DB workers after applying a batch
+  void FinishWriteDBBatch(const std::vector<std::shared_ptr<Cmd>>& cmds, size_t staged_cmds);
+  ReplApplyStats GetReplApplyStats();
 
   pstd::Status SendMetaSync();
   pstd::Status SendDBSync(const std::string& ip, uint32_t port, const std::string& db_name,
@@ -110,8 +138,15 @@ class PikaReplClient {
   std::atomic<int32_t> async_write_db_task_counts_[MAX_DB_NUM];
   // [NOTICE] write_db_workers_ must be declared after async_write_db_task_counts_ to ensure write_db_workers_ will be destroyed before async_write_db_task_counts_
   // when PikaReplClient is de-constructing, because some of the async task that exec by write_db_workers_ will manipulate async_write_db_task_counts_
+  // write_db_queues_[i] is drained by write_db_workers_[i], the queues must outlive the workers
+  std::vector<std::unique_ptr<ReplWriteDBQueue>> write_db_queues_;
   std::vector<std::unique_ptr<PikaReplBgWorker>> write_binlog_workers_;
   std::vector<std::unique_ptr<PikaReplBgWorker>> write_db_workers_;
+
+  std::atomic<uint64_t> applied_cmds_{0};
+  std::atomic<uint64_t> applied_batches_{0};
+  std::atomic<uint64_t> max_batch_size_{0};
+  std::atomic<uint64_t> staged_cmds_{0};
 };
 
 #endif
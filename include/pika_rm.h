@@ -209,6 +209,10 @@ class PikaReplicaManager {
     return pika_repl_client_->GetUnfinishedAsyncWriteDBTaskCount(db_name);
   }
 
+  ReplApplyStats GetReplApplyStats() {
+    return pika_repl_client_->GetReplApplyStats();
+  }
+
  private:
   void InitDB();
   pstd::Status SelectLocalIp(const std::string& remote_ip, int remote_port, std::string* local_ip);
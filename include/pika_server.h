@@ -39,6 +39,7 @@
 #include "include/pika_db.h"
 #include "include/pika_define.h"
 #include "include/pika_dispatch_thread.h"
+#include "include/pika_expire_reaper.h"
 #include "include/pika_instant.h"
 #include "include/pika_migrate_thread.h"
 #include "include/pika_repl_client.h"
@@ -70,6 +71,7 @@ struct TaskArg {
 
 void DoBgslotscleanup(void* arg);
 void DoBgslotsreload(void* arg);
+void DoBgslotsconvert(void* arg);
 
 class PikaServer : public pstd::noncopyable {
  public:
@@ -138,6 +140,8 @@ class PikaServer : public pstd::noncopyable {
   void DBSetMaxCacheStatisticKeys(uint32_t max_cache_statistic_keys);
   void DBSetSmallCompactionThreshold(uint32_t small_compaction_threshold);
   void DBSetSmallCompactionDurationThreshold(uint32_t small_compaction_duration_threshold);
+  void DBSetKeyspaceScanThreads(uint32_t keyspace_scan_threads);
+  void DBSetSlotIndexEnabled(bool enabled);
   bool GetDBBinlogOffset(const std::string& db_name, BinlogOffset* boffset);
   pstd::Status DoSameThingEveryDB(const TaskType& type);
 
@@ -181,6 +185,8 @@ class PikaServer : public pstd::noncopyable {
    * PikaClientProcessor Process Task
    */
   void ScheduleClientPool(net::TaskFunc func, void* arg, bool is_slow_cmd, bool is_admin_cmd);
+  // tasks of the same connection run in scheduling order
+  void ScheduleClientPool(net::TaskFunc func, void* arg, bool is_slow_cmd, bool is_admin_cmd, int conn_fd);
 
   // for info debug
   size_t ClientProcessorThreadPoolCurQueueSize();
@@ -252,8 +258,18 @@ class PikaServer : public pstd::noncopyable {
   void ResetStat();
   void incr_accumulative_connections();
   void ResetLastSecQuerynum();
-  void UpdateQueryNumAndExecCountDB(const std::string& db_name, const std::string& command, bool is_write);
+  void UpdateQueryNumAndExecCountDB(const std::string& db_name, uint32_t cmd_id, bool is_write);
+  void UpdateCmdTimeConsuming(uint32_t cmd_id, uint64_t time_consuming);
+  void IncrRtcCacheHits(uint64_t num);
+  void IncrRtcCacheFallbacks();
+  uint64_t RtcCacheHits();
+  uint64_t RtcCacheFallbacks();
+  // expire reaper, see pika_expire_reaper.h
+  void ReapExpiredKeys(int64_t count_per_db);
+  uint64_t ExpiredKeys();
+  int64_t ExpireReaperLagMs();
   std::unordered_map<std::string, uint64_t> ServerExecCountDB();
+  std::unordered_map<std::string, CmdStatistic> ServerCmdStats();
   std::unordered_map<std::string, QpsStatistic> ServerAllDBStat();
 
   /*
@@ -363,6 +379,8 @@ class PikaServer : public pstd::noncopyable {
     bgslots_reload_.end_time = time(nullptr);
   }
   void Bgslotsreload(const std::shared_ptr<DB>& db);
+  // one-time move of the legacy slot sets into the slot index
+  void Bgslotsconvert(const std::shared_ptr<DB>& db);
 
   // Revoke the authorization of the specified account, when handle Cmd deleteUser
   void AllClientUnAuth(const std::set<std::string>& users);
@@ -499,15 +517,9 @@ class PikaServer : public pstd::noncopyable {
   int64_t GetLastSave() const {return lastsave_;}
   void UpdateLastSave(int64_t lastsave) {lastsave_ = lastsave;}
   void InitStatistic(CmdTable *inited_cmd_table) {
-    // we insert all cmd name to statistic_.server_stat.exec_count_db,
-    // then when we can call PikaServer::UpdateQueryNumAndExecCountDB(const std::string&, const std::string&, bool) in parallel without lock
-    // although exec_count_db(unordered_map) is not thread-safe, but we won't trigger any insert or erase operation toward exec_count_db(unordered_map) during the running of pika
-    auto &exec_stat_map = statistic_.server_stat.exec_count_db;
-    for (auto& it : *inited_cmd_table) {
-      std::string cmd_name = it.first; //value copy is needed
-      pstd::StringToUpper(cmd_name); //cmd_name now is all uppercase
-      exec_stat_map.insert(std::make_pair(cmd_name, 0));
-    }
+    // the statistic counters are indexed by cmd id, sized once here so that
+    // PikaServer::UpdateQueryNumAndExecCountDB runs in parallel without lock
+    statistic_.Init(*inited_cmd_table, g_pika_conf->databases());
   }
  private:
   /*
@@ -609,6 +621,7 @@ class PikaServer : public pstd::noncopyable {
    * Communication used
    */
   std::unique_ptr<PikaAuxiliaryThread> pika_auxiliary_thread_;
+  std::unique_ptr<PikaExpireReaper> pika_expire_reaper_;
 
   /*
    * Async slotsMgrt use
@@ -87,6 +87,8 @@ class SPopCmd : public Cmd {
 
  private:
   void DoInitial() override;
+  // SPop appends the popped members
+  void Clear() override { members_.clear(); }
 
  private:
   std::string key_;
@@ -333,6 +335,7 @@ class SMoveCmd : public Cmd {
  private:
   std::string src_key_, dest_key_, member_;
   void DoInitial() override;
+  void Clear() override { move_success_ = 0; }
   // used for write binlog
   std::shared_ptr<SRemCmd> srem_cmd_;
   std::shared_ptr<SAddCmd> sadd_cmd_;
@@ -16,7 +16,6 @@ const size_t MaxKeySendSize = 10 * 1024;
 
 int GetKeyType(const std::string& key, std::string &key_type, const std::shared_ptr<DB>& db);
 void AddSlotKey(const std::string& type, const std::string& key, const std::shared_ptr<DB>& db);
-void RemSlotKey(const std::string& key, const std::shared_ptr<DB>& db);
 int DeleteKey(const std::string& key, const char key_type, const std::shared_ptr<DB>& db);
 void RemSlotKeyByType(const std::string& type, const std::string& key, const std::shared_ptr<DB>& db);
 std::string GetSlotKey(uint32_t slot);
@@ -138,6 +137,10 @@ class SlotsInfoCmd : public Cmd {
 
  private:
   void DoInitial() override;
+  void Clear() override {
+    begin_ = 0;
+    end_ = 1024;
+  }
 
   int64_t begin_ = 0;
   int64_t end_ = 1024;
@@ -190,7 +193,7 @@ class SlotsScanCmd : public Cmd {
   Cmd* Clone() override { return new SlotsScanCmd(*this); }
 
  private:
-  std::string key_;
+  int64_t slot_id_ = 0;
   std::string pattern_ = "*";
   int64_t cursor_ = 0;
   int64_t count_ = 10;
@@ -7,16 +7,21 @@
 #define PIKA_STATISTIC_H_
 
 #include <atomic>
+#include <memory>
 #include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+#include "pstd/include/thread_counters.h"
+
+#include "include/pika_command.h"
 
 class QpsStatistic {
  public:
   QpsStatistic();
   QpsStatistic(const QpsStatistic& other);
   ~QpsStatistic() = default;
-  void IncreaseQueryNum(bool is_write);
   void ResetLastSecQuerynum();
 
   std::atomic<uint64_t> querynum;
@@ -36,18 +41,49 @@ struct ServerStatistic {
   ~ServerStatistic() = default;
 
   std::atomic<uint64_t> accumulative_connections;
-  std::unordered_map<std::string, std::atomic<uint64_t>> exec_count_db;
+  // reads answered from the cache on the network thread, and batches sent
+  // to the pool by a cache miss there
+  std::atomic<uint64_t> rtc_cache_hits = 0;
+  std::atomic<uint64_t> rtc_cache_fallbacks = 0;
+  // keys deleted by the expire reaper
+  std::atomic<uint64_t> expired_keys = 0;
   QpsStatistic qps;
 };
 
+// The counts of one command, summed over the threads
+struct CmdStatistic {
+  // commands dispatched, and executed with the time they took
+  uint64_t exec_count = 0;
+  uint64_t calls = 0;
+  uint64_t time_consuming = 0;
+};
+
+/*
+ * The command hot path counts into per-thread counters indexed by the
+ * command id and the DB index, nothing on it is shared between the
+ * threads. The querynum of the QpsStatistic members is refreshed from the
+ * counters once a second by ResetLastSecQuerynum, the per command counts
+ * are summed when INFO reads them.
+ */
 struct Statistic {
-  Statistic();
+  Statistic() = default;
+
+  // sizes the counters, before the first command is counted
+  void Init(const CmdTable& cmd_table, int db_num);
+
+  void UpdateQuery(const std::string& db_name, uint32_t cmd_id, bool is_write);
+  void UpdateCmdTime(uint32_t cmd_id, uint64_t time_consuming);
+
+  uint64_t QueryNum() const;
+  std::unordered_map<std::string, CmdStatistic> CmdStats() const;
 
   QpsStatistic DBStat(const std::string& db_name);
   std::unordered_map<std::string, QpsStatistic> AllDBStat();
 
-  void UpdateDBQps(const std::string& db_name, const std::string& command, bool is_write);
+  // sets the querynum of server_stat and db_stat from the counters
+  void RefreshQuerynum();
   void ResetDBLastSecQuerynum();
+  void ResetQuerynum();
 
   // statistic shows accumulated data of all tables
   ServerStatistic server_stat;
@@ -55,6 +91,19 @@ struct Statistic {
   // statistic shows accumulated data of every single table
   std::shared_mutex db_stat_rw;
   std::unordered_map<std::string, QpsStatistic> db_stat;
+
+ private:
+  enum CmdField { kExecCount = 0, kCalls = 1, kTimeConsuming = 2, kCmdFieldNum = 3 };
+  enum DBField { kQuerynum = 0, kWriteQuerynum = 1, kDBFieldNum = 2 };
+
+  // the counter slot of db_name, db_num_ for a name that is not "db<index>"
+  size_t DBIndex(const std::string& db_name) const;
+
+  // names by command id
+  std::vector<std::string> cmd_names_;
+  size_t db_num_ = 0;
+  std::unique_ptr<pstd::ThreadCounters> cmd_counters_;
+  std::unique_ptr<pstd::ThreadCounters> db_counters_;
 };
 
 struct DiskStatistic {
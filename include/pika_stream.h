@@ -155,6 +155,12 @@ class XInfoCmd : public Cmd {
   bool is_full_{false};
 
   void DoInitial() override;
+  void Clear() override {
+    cgroupname_.clear();
+    consumername_.clear();
+    count_ = 0;
+    is_full_ = false;
+  }
   void StreamInfo(std::shared_ptr<DB>& db);
   void GroupsInfo(std::shared_ptr<DB>& db);
   void ConsumersInfo(std::shared_ptr<DB>& db);
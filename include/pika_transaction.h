@@ -45,6 +45,15 @@ class ExecCmd : public Cmd {
     std::shared_ptr<SyncMasterDB> sync_db_;
   };
   void DoInitial() override;
+  void Clear() override {
+    lock_db_.clear();
+    lock_db_keys_.clear();
+    r_lock_dbs_.clear();
+    is_lock_rm_dbs_ = false;
+    cmds_.clear();
+    list_cmd_.clear();
+    keys_.clear();
+  }
   void Lock();
   void Unlock();
   bool IsTxnFailedAndSetState();
@@ -86,6 +95,10 @@ class WatchCmd : public Cmd {
 
  private:
   void DoInitial() override;
+  void Clear() override {
+    keys_.clear();
+    db_keys_.clear();
+  }
   std::vector<std::string> keys_;
   std::vector<std::string> db_keys_;  // cause the keys watched may cross different dbs, so add dbname as keys prefix
 };
@@ -0,0 +1,128 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "net/include/net_define.h"
+#include "net/include/redis_parser.h"
+
+// Parse throughput of pipelines of 64 SET commands, each pipeline is fed in
+// REDIS_IOBUF_LEN reads the way RedisConn feeds the parser:
+//   copy      ProcessInputBuffer, the half command is cached and concatenated
+//   in-place  ProcessInputBufferInPlace, argv copied once for Complete
+//
+// usage: ./redis_parser_bench [total_mb]
+
+namespace {
+
+uint64_t parsed_args = 0;
+uint64_t parsed_bytes = 0;
+
+int CountArgv(net::RedisParser* parser, const net::RedisCmdArgsType& argv) {
+  for (const auto& arg : argv) {
+    parsed_bytes += arg.size();
+  }
+  parsed_args += argv.size();
+  return 0;
+}
+
+int CountArgvs(net::RedisParser* parser, const std::vector<net::RedisCmdArgsType>& argvs) {
+  for (const auto& argv : argvs) {
+    CountArgv(parser, argv);
+  }
+  return 0;
+}
+
+const int kPipelineDepth = 64;
+
+std::string BuildPipeline(size_t value_size) {
+  std::string value(value_size, 'v');
+  std::string input;
+  for (uint64_t i = 0; i < kPipelineDepth; ++i) {
+    std::string key = "key:" + std::to_string(i);
+    input.append("*3\r\n$3\r\nSET\r\n$" + std::to_string(key.size()) + "\r\n" + key + "\r\n$" +
+                 std::to_string(value.size()) + "\r\n" + value + "\r\n");
+  }
+  return input;
+}
+
+bool RunCopy(const std::string& input, size_t rounds) {
+  net::RedisParserSettings settings;
+  settings.Complete = CountArgvs;
+  net::RedisParser parser;
+  parser.RedisParserInit(REDIS_PARSER_REQUEST, settings);
+  std::vector<char> rbuf(REDIS_IOBUF_LEN);
+  for (size_t round = 0; round < rounds; ++round) {
+    for (size_t pos = 0; pos < input.size(); pos += REDIS_IOBUF_LEN) {
+      int len = static_cast<int>(std::min<size_t>(REDIS_IOBUF_LEN, input.size() - pos));
+      memcpy(rbuf.data(), input.data() + pos, len);
+      int parsed_len = 0;
+      if (parser.ProcessInputBuffer(rbuf.data(), len, &parsed_len) == net::kRedisParserError) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool RunInPlace(const std::string& input, size_t rounds) {
+  net::RedisParserSettings settings;
+  settings.Complete = CountArgvs;
+  net::RedisParser parser;
+  parser.RedisParserInit(REDIS_PARSER_REQUEST, settings);
+  std::vector<char> rbuf(REDIS_IOBUF_LEN);
+  int rbuf_used = 0;
+  for (size_t round = 0; round < rounds; ++round) {
+    for (size_t pos = 0; pos < input.size();) {
+      if (rbuf_used == static_cast<int>(rbuf.size())) {
+        rbuf.resize(rbuf.size() + REDIS_IOBUF_LEN);
+      }
+      int len = static_cast<int>(std::min<size_t>(rbuf.size() - rbuf_used, input.size() - pos));
+      memcpy(rbuf.data() + rbuf_used, input.data() + pos, len);
+      pos += len;
+      rbuf_used += len;
+      int parsed_len = 0;
+      if (parser.ProcessInputBufferInPlace(rbuf.data(), rbuf_used, &parsed_len) == net::kRedisParserError) {
+        return false;
+      }
+      if (parsed_len > 0 && parsed_len < rbuf_used) {
+        memmove(rbuf.data(), rbuf.data() + parsed_len, rbuf_used - parsed_len);
+      }
+      rbuf_used -= parsed_len;
+    }
+  }
+  return true;
+}
+
+template <typename Func>
+void Bench(const std::string& name, size_t total_size, Func func) {
+  parsed_args = 0;
+  parsed_bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  bool ok = func();
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  double mb_per_sec = static_cast<double>(total_size) / static_cast<double>(elapsed.count());
+  std::cout << "  " << name << ": " << (ok ? "" : "PARSE ERROR, ") << static_cast<uint64_t>(mb_per_sec)
+            << " MB/s, " << parsed_args / 3 << " commands, " << parsed_bytes << " argument bytes" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t total_mb = argc > 1 ? std::stoul(argv[1]) : 256;
+  for (size_t value_size : {16, 128, 1024, 16 * 1024, 256 * 1024}) {
+    std::string input = BuildPipeline(value_size);
+    size_t rounds = total_mb * 1024 * 1024 / input.size() + 1;
+    size_t total_size = rounds * input.size();
+    std::cout << "value size " << value_size << ", input " << total_size / 1024 / 1024 << " MB" << std::endl;
+    Bench("copy", total_size, [&input, rounds]() { return RunCopy(input, rounds); });
+    Bench("in-place", total_size, [&input, rounds]() { return RunInPlace(input, rounds); });
+  }
+  return 0;
+}
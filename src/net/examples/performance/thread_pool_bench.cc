@@ -0,0 +1,156 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/include/thread_pool.h"
+#include "pstd/include/pstd_mutex.h"
+
+// Compare net::ThreadPool with the previous single mutex pool, one task
+// per client command: N producers (the net worker threads) schedule tiny
+// tasks into a pool of M workers.
+//
+// usage: ./thread_pool_bench [tasks_per_producer]
+
+namespace {
+
+// The pool before per-worker queues: every Schedule and every worker
+// contends on one mutex
+class LegacyThreadPool {
+ public:
+  LegacyThreadPool(size_t worker_num, size_t max_queue_size) : worker_num_(worker_num), max_queue_size_(max_queue_size) {}
+  ~LegacyThreadPool() { Stop(); }
+
+  void Start() {
+    for (size_t i = 0; i < worker_num_; ++i) {
+      workers_.emplace_back([this]() { Run(); });
+    }
+  }
+
+  void Stop() {
+    {
+      std::lock_guard lock(mu_);
+      should_stop_ = true;
+    }
+    rsignal_.notify_all();
+    wsignal_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+  }
+
+  void Schedule(net::TaskFunc func, void* arg) {
+    std::unique_lock lock(mu_);
+    wsignal_.wait(lock, [this]() { return queue_.size() < max_queue_size_ || should_stop_; });
+    if (!should_stop_) {
+      queue_.emplace(func, arg);
+      rsignal_.notify_one();
+    }
+  }
+
+ private:
+  void Run() {
+    while (true) {
+      std::unique_lock lock(mu_);
+      rsignal_.wait(lock, [this]() { return !queue_.empty() || should_stop_; });
+      if (should_stop_) {
+        return;
+      }
+      auto [func, arg] = queue_.front();
+      queue_.pop();
+      wsignal_.notify_one();
+      lock.unlock();
+      (*func)(arg);
+    }
+  }
+
+  size_t worker_num_;
+  size_t max_queue_size_;
+  bool should_stop_ = false;
+  std::queue<net::Task> queue_;
+  std::vector<std::thread> workers_;
+  pstd::Mutex mu_;
+  pstd::CondVar rsignal_;
+  pstd::CondVar wsignal_;
+};
+
+std::atomic<uint64_t> done_tasks{0};
+
+void CountTask(void* arg) {
+  // a few hundred nanoseconds of work, about a cached GET
+  volatile uint64_t sum = 0;
+  for (int i = 0; i < 64; ++i) {
+    sum = sum + i;
+  }
+  done_tasks.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename ScheduleFunc>
+double RunBench(size_t producer_num, uint64_t tasks_per_producer, ScheduleFunc schedule) {
+  done_tasks.store(0);
+  uint64_t total_tasks = producer_num * tasks_per_producer;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < producer_num; ++p) {
+    producers.emplace_back([p, tasks_per_producer, &schedule]() {
+      for (uint64_t i = 0; i < tasks_per_producer; ++i) {
+        schedule(p, i);
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  while (done_tasks.load() < total_tasks) {
+    std::this_thread::yield();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  return static_cast<double>(total_tasks) * 1000000 / static_cast<double>(elapsed.count());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint64_t tasks_per_producer = argc > 1 ? std::stoull(argv[1]) : 200000;
+  const size_t producer_num = 8;
+  const size_t max_queue_size = 100000;
+
+  std::cout << "producers " << producer_num << ", tasks per producer " << tasks_per_producer << std::endl;
+  for (size_t worker_num : {4, 8, 16, 32}) {
+    double legacy_qps = 0;
+    {
+      LegacyThreadPool pool(worker_num, max_queue_size);
+      pool.Start();
+      legacy_qps = RunBench(producer_num, tasks_per_producer,
+                            [&pool](size_t, uint64_t) { pool.Schedule(&CountTask, nullptr); });
+    }
+
+    double qps = 0;
+    double ordered_qps = 0;
+    {
+      net::ThreadPool pool(worker_num, max_queue_size);
+      pool.start_thread_pool();
+      qps = RunBench(producer_num, tasks_per_producer,
+                     [&pool](size_t, uint64_t) { pool.Schedule(&CountTask, nullptr); });
+      // 1024 connections spread over the producers, ordered per connection
+      ordered_qps = RunBench(producer_num, tasks_per_producer, [&pool, producer_num](size_t p, uint64_t i) {
+        pool.Schedule(&CountTask, nullptr, (i % 128) * producer_num + p);
+      });
+      pool.stop_thread_pool();
+    }
+
+    std::cout << "workers " << worker_num << ": legacy " << static_cast<uint64_t>(legacy_qps)
+              << " tasks/s, sharded " << static_cast<uint64_t>(qps) << " tasks/s, sharded with affinity "
+              << static_cast<uint64_t>(ordered_qps) << " tasks/s" << std::endl;
+  }
+  return 0;
+}
@@ -10,6 +10,7 @@
 #include <atomic>
 #include <functional>
 #include <map>
+#include <memory>
 #include <queue>
 #include <set>
 #include <string>
@@ -37,6 +38,13 @@ class PubSubThread : public Thread {
 
   // PubSub
 
+  /*
+   * Publish only queues the message, the pubsub thread delivers all the
+   * queued messages in one wakeup and writes every subscriber once per batch.
+   * The returned count is the number of ready subscribers of the channel when
+   * the message was queued. Publishers block only while kMaxPubQueueSize
+   * messages are waiting.
+   */
   int Publish(const std::string& channel, const std::string& msg);
 
   void Subscribe(const std::shared_ptr<NetConn>& conn, const std::vector<std::string>& channels, bool pattern,
@@ -92,9 +100,21 @@ class PubSubThread : public Thread {
   std::map<int, std::shared_ptr<ConnHandle>> conns_;
   std::atomic<bool> close_all_conn_sig_{false};
 
+  struct PublishItem {
+    std::string channel;
+    std::string msg;
+  };
+  static constexpr size_t kMaxPubQueueSize = 64 * 1024;
+
+  void EnqueuePublish(PublishItem item);
+  int CountReceivers(const std::string& channel);
+  void DeliverPublishBatch(std::vector<PublishItem>* batch);
+
   pstd::Mutex pub_mutex_;
-  pstd::CondVar receiver_rsignal_;
-  pstd::Mutex receiver_mutex_;
+  pstd::CondVar pub_space_signal_;
+  std::vector<PublishItem> pub_queue_;
+  // a wakeup byte is in the pipe for the queued messages
+  bool pub_notified_ = false;
 
   /*
    * receive fd from worker thread
@@ -102,10 +122,6 @@ class PubSubThread : public Thread {
   pstd::Mutex mutex_;
   std::queue<NetItem> queue_;
 
-  std::string channel_;
-  std::string message_;
-  int receivers_{-1};
-
   /*
    * The epoll handler
    */
@@ -8,6 +8,7 @@
 
 #include "net/include/net_define.h"
 
+#include <utility>
 #include <vector>
 
 #define REDIS_PARSER_REQUEST 1
@@ -54,6 +55,16 @@ class RedisParser {
   RedisParser();
   RedisParserStatus RedisParserInit(RedisParserType type, const RedisParserSettings& settings);
   RedisParserStatus ProcessInputBuffer(const char* input_buf, int length, int* parsed_len);
+  /*
+   * Parse input_buf without copying it. input_buf holds every byte not
+   * consumed yet, parsed_len returns the length of the complete commands at
+   * its head. The caller keeps the remaining bytes at the head of the next
+   * input_buf, parsing resumes where it stopped instead of starting over.
+   * Arguments are copied once, when a command is handed to DealMessage or
+   * Complete.
+   * Do not mix with ProcessInputBuffer on the same parser.
+   */
+  RedisParserStatus ProcessInputBufferInPlace(const char* input_buf, int length, int* parsed_len);
   long get_bulk_len() { return bulk_len_; }
   RedisParserError get_error_code() { return error_code_; }
   void* data = nullptr; /* A pointer to get hook to the "connection" or "socket" object */
@@ -69,6 +80,7 @@ class RedisParser {
   RedisParserStatus ProcessRequestBuffer();
   RedisParserStatus ProcessResponseBuffer();
   void SetParserStatus(RedisParserStatus status, RedisParserError error = kRedisParserOk);
+  int DealCompleteArgv();
   void ResetRedisParser();
   void ResetCommandStatus();
 
@@ -91,6 +103,12 @@ class RedisParser {
   const char* input_buf_{nullptr};
   std::string input_str_;
   int length_ = 0;
+
+  // For ProcessInputBufferInPlace, arguments of the current command are
+  // kept as (offset from cmd_start_, length)
+  bool in_place_ = false;
+  int cmd_start_ = 0;
+  std::vector<std::pair<int, long>> arg_offsets_;
 };
 
 }  // namespace net
@@ -8,8 +8,11 @@
 
 #include <pthread.h>
 #include <atomic>
-#include <queue>
+#include <deque>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "net/include/net_define.h"
 #include "pstd/include/pstd_mutex.h"
@@ -22,22 +25,31 @@ struct Task {
   Task() = default;
   TaskFunc func = nullptr;
   void* arg = nullptr;
+  // set for tasks scheduled with an affinity
+  bool ordered = false;
+  uint64_t affinity = 0;
   Task(TaskFunc _func, void* _arg) : func(_func), arg(_arg) {}
 };
 
-struct TimeTask {
-  uint64_t exec_time;
-  TaskFunc func;
-  void* arg;
-  TimeTask(uint64_t _exec_time, TaskFunc _func, void* _arg) : exec_time(_exec_time), func(_func), arg(_arg) {}
-  bool operator<(const TimeTask& task) const { return exec_time > task.exec_time; }
-};
-
+/*
+ * Every worker owns a task queue guarded by its own mutex, producers spread
+ * tasks over the queues and idle workers steal from busy ones, so Schedule
+ * and the workers no longer contend on one pool-wide mutex.
+ *
+ * Tasks scheduled with an affinity run one at a time in the order they
+ * were scheduled. Only the first one waiting for its affinity is queued,
+ * the others wait in a lane of the affinity and the worker that finishes a
+ * task queues the next one of its lane. The queued task may be stolen like
+ * any other, so a slow task only holds up the tasks of its own affinity.
+ *
+ * Delayed tasks live in a timer wheel driven by a dedicated timer thread,
+ * they are handed to the workers when they become due.
+ */
 class ThreadPool : public pstd::noncopyable {
  public:
   class Worker {
    public:
-    explicit Worker(ThreadPool* tp) : start_(false), thread_pool_(tp){};
+    explicit Worker(ThreadPool* tp, size_t index) : start_(false), thread_pool_(tp), index_(index){};
     static void* WorkerMain(void* arg);
 
     int start();
@@ -47,6 +59,7 @@ class ThreadPool : public pstd::noncopyable {
     pthread_t thread_id_;
     std::atomic<bool> start_;
     ThreadPool* const thread_pool_;
+    const size_t index_;
     std::string worker_name_;
   };
 
@@ -59,6 +72,11 @@ class ThreadPool : public pstd::noncopyable {
   void set_should_stop();
 
   void Schedule(TaskFunc func, void* arg);
+  /*
+   * Tasks with the same affinity (e.g. a connection fd) run one by one in
+   * scheduling order
+   */
+  void Schedule(TaskFunc func, void* arg, uint64_t affinity);
   void DelaySchedule(uint64_t timeout, TaskFunc func, void* arg);
   size_t max_queue_size();
   size_t worker_size();
@@ -67,21 +85,72 @@ class ThreadPool : public pstd::noncopyable {
   std::string thread_pool_name();
 
  private:
-  void runInThread();
+  struct alignas(64) WorkerQueue {
+    pstd::Mutex mu;
+    pstd::CondVar signal;
+    // any worker may steal these
+    std::deque<Task> tasks;
+    // read without the mutex to skip empty queues and busy workers
+    std::atomic<size_t> size{0};
+    std::atomic<bool> idle{false};
+    bool wakeup = false;
+  };
+
+  // An affinity has a lane while one of its tasks is queued or running, the
+  // lane holds the tasks scheduled behind that one
+  struct alignas(64) LaneShard {
+    pstd::Mutex mu;
+    std::unordered_map<uint64_t, std::deque<Task>> lanes;
+  };
+  static constexpr size_t kLaneShards = 64;
+
+  struct TimerWheelItem {
+    uint64_t due_ms;
+    Task task;
+  };
+  static constexpr uint64_t kTimerWheelSlots = 1024;
+
+  static void* TimerMain(void* arg);
+  void runInThread(size_t index);
+  void runTimer();
+  // with timer_mu_ held
+  uint64_t NextTimerDue();
+
+  void WaitForQueueSpace();
+  void PushTask(size_t index, const Task& task);
+  void FinishOrderedTask(size_t index, uint64_t affinity);
+  bool PopTask(size_t index, Task* task);
+  bool StealTask(size_t index, Task* task);
+  bool HasStealableTask();
+  void WakeupIdleWorker(size_t except_index);
 
   size_t worker_num_;
   size_t max_queue_size_;
   std::string thread_pool_name_;
-  std::queue<Task> queue_;
-  std::priority_queue<TimeTask> time_queue_;
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::unique_ptr<LaneShard>> lane_shards_;
   std::vector<Worker*> workers_;
   std::atomic<bool> running_;
   std::atomic<bool> should_stop_;
 
+  std::atomic<size_t> next_queue_{0};
+  std::atomic<size_t> queue_size_{0};
+  std::atomic<int> idle_workers_{0};
+  std::atomic<int> searching_workers_{0};
+
+  // Schedule blocks here only while the pool is full
+  std::atomic<int> blocked_producers_{0};
   pstd::Mutex mu_;
-  pstd::CondVar rsignal_;
   pstd::CondVar wsignal_;
 
+  // timer wheel with one millisecond per slot
+  pthread_t timer_thread_id_;
+  bool timer_started_ = false;
+  pstd::Mutex timer_mu_;
+  pstd::CondVar timer_signal_;
+  std::vector<std::vector<TimerWheelItem>> timer_wheel_;
+  uint64_t timer_current_ms_ = 0;
+  std::atomic<size_t> time_queue_size_{0};
 };
 
 }  // namespace net
@@ -180,22 +180,105 @@ void PubSubThread::CloseAllConns() {
 }
 
 int PubSubThread::Publish(const std::string& channel, const std::string& msg) {
-  // TODO(LIBA-S): change the Publish Mode to Asynchronous
-  std::lock_guard lk(pub_mutex_);
-  channel_ = channel;
-  message_ = msg;
-  // Send signal to ThreadMain()
-  ssize_t n = write(msg_pfd_[1], "", 1);
-  (void)(n);
-  std::unique_lock lock(receiver_mutex_);
-  receiver_rsignal_.wait(lock, [this]() { return receivers_ != -1; });
-
-  int receivers = receivers_;
-  receivers_ = -1;
+  int receivers = CountReceivers(channel);
+  EnqueuePublish({channel, msg});
+  return receivers;
+}
+
+void PubSubThread::EnqueuePublish(PublishItem item) {
+  std::unique_lock lk(pub_mutex_);
+  pub_space_signal_.wait(lk, [this]() { return pub_queue_.size() < kMaxPubQueueSize || should_stop(); });
+  pub_queue_.push_back(std::move(item));
+  if (!pub_notified_) {
+    // Send signal to ThreadMain(), one byte for all the messages queued until it drains
+    pub_notified_ = true;
+    ssize_t n = write(msg_pfd_[1], "", 1);
+    (void)(n);
+  }
+}
 
+int PubSubThread::CountReceivers(const std::string& channel) {
+  int receivers = 0;
+  {
+    std::lock_guard l(channel_mutex_);
+    auto it = pubsub_channel_.find(channel);
+    if (it != pubsub_channel_.end()) {
+      for (const auto& conn : it->second) {
+        receivers += IsReady(conn->fd()) ? 1 : 0;
+      }
+    }
+  }
+  std::lock_guard l(pattern_mutex_);
+  for (const auto& it : pubsub_pattern_) {
+    if (pstd::stringmatchlen(it.first.c_str(), static_cast<int32_t>(it.first.size()), channel.c_str(),
+                             static_cast<int32_t>(channel.size()), 0)) {
+      for (const auto& conn : it.second) {
+        receivers += IsReady(conn->fd()) ? 1 : 0;
+      }
+    }
+  }
   return receivers;
 }
 
+/*
+ * Appends every message of the batch to the output buffers of its
+ * subscribers, then writes each subscriber once.
+ */
+void PubSubThread::DeliverPublishBatch(std::vector<PublishItem>* batch) {
+  std::vector<std::shared_ptr<NetConn>> targets;
+  std::set<NetConn*> target_set;
+
+  auto append = [&](const std::shared_ptr<NetConn>& conn, const std::string& resp) {
+    if (!IsReady(conn->fd())) {
+      return;
+    }
+    conn->WriteResp(resp);
+    if (target_set.insert(conn.get()).second) {
+      targets.push_back(conn);
+    }
+  };
+
+  for (size_t i = 0; i < batch->size(); i++) {
+    const std::string& channel = (*batch)[i].channel;
+    const std::string& msg = (*batch)[i].msg;
+
+    // Send message to a channel's clients
+    {
+      std::lock_guard l(channel_mutex_);
+      auto it = pubsub_channel_.find(channel);
+      if (it != pubsub_channel_.end() && !it->second.empty()) {
+        std::string resp = ConstructPublishResp(it->first, channel, msg, false);
+        for (const auto& conn : it->second) {
+          append(conn, resp);
+        }
+      }
+    }
+
+    // Send message to a channel pattern's clients
+    std::lock_guard l(pattern_mutex_);
+    for (auto& it : pubsub_pattern_) {
+      if (!it.second.empty() &&
+          pstd::stringmatchlen(it.first.c_str(), static_cast<int32_t>(it.first.size()), channel.c_str(),
+                               static_cast<int32_t>(channel.size()), 0)) {
+        std::string resp = ConstructPublishResp(it.first, channel, msg, true);
+        for (const auto& conn : it.second) {
+          append(conn, resp);
+        }
+      }
+    }
+  }
+
+  for (auto& conn : targets) {
+    WriteStatus write_status = conn->SendReply();
+    if (write_status == kWriteHalf) {
+      net_multiplexer_->NetModEvent(conn->fd(), kReadable, kWritable);
+    } else if (write_status == kWriteError) {
+      MoveConnOut(conn);
+      CloseFd(conn);
+    }
+  }
+}
+
 /*
  * return the number of channels that the specific connection currently subscribed
  */
@@ -468,76 +551,14 @@ void* PubSubThread::ThreadMain() {
         if (pfe->mask & kReadable) {
           ssize_t n = read(msg_pfd_[0], triger, 1);
           (void)(n);
-          std::string channel;
-          std::string msg;
-          int32_t receivers = 0;
-          channel = channel_;
-          msg = message_;
-          channel_.clear();
-          message_.clear();
-
-          // Send message to a channel's clients
-          channel_mutex_.lock();
-          auto it = pubsub_channel_.find(channel);
-          if (it != pubsub_channel_.end()) {
-            for (size_t i = 0; i < it->second.size(); i++) {
-              auto& conn = it->second[i];
-              if (!IsReady(conn->fd())) {
-                continue;
-              }
-              std::string resp = ConstructPublishResp(it->first, channel, msg, false);
-              conn->WriteResp(resp);
-              WriteStatus write_status = conn->SendReply();
-              if (write_status == kWriteHalf) {
-                net_multiplexer_->NetModEvent(conn->fd(), kReadable, kWritable);
-              } else if (write_status == kWriteError) {
-                channel_mutex_.unlock();
-
-                MoveConnOut(conn);
-
-                channel_mutex_.lock();
-                CloseFd(conn);
-              } else if (write_status == kWriteAll) {
-                receivers++;
-              }
-            }
-          }
-          channel_mutex_.unlock();
-
-          // Send message to a channel pattern's clients
-          pattern_mutex_.lock();
-          for (auto& it : pubsub_pattern_) {
-            if (pstd::stringmatchlen(it.first.c_str(), static_cast<int32_t>(it.first.size()), channel.c_str(),
-                                     static_cast<int32_t>(channel.size()), 0)) {
-              for (size_t i = 0; i < it.second.size(); i++) {
-                auto& conn = it.second[i];
-                if (!IsReady(conn->fd())) {
-                  continue;
-                }
-                std::string resp = ConstructPublishResp(it.first, channel, msg, true);
-                conn->WriteResp(resp);
-                WriteStatus write_status = conn->SendReply();
-                if (write_status == kWriteHalf) {
-                  net_multiplexer_->NetModEvent(conn->fd(), kReadable, kWritable);
-                } else if (write_status == kWriteError) {
-                  pattern_mutex_.unlock();
-
-                  MoveConnOut(conn);
-
-                  pattern_mutex_.lock();
-                  CloseFd(conn);
-                } else if (write_status == kWriteAll) {
-                  receivers++;
-                }
-              }
-            }
+          std::vector<PublishItem> batch;
+          {
+            std::lock_guard lk(pub_mutex_);
+            batch.swap(pub_queue_);
+            pub_notified_ = false;
           }
-          pattern_mutex_.unlock();
-
-          receiver_mutex_.lock();
-          receivers_ = receivers;
-          receiver_rsignal_.notify_one();
-          receiver_mutex_.unlock();
+          pub_space_signal_.notify_all();
+          DeliverPublishBatch(&batch);
         } else {
           continue;
         }
@@ -605,6 +626,12 @@ void* PubSubThread::ThreadMain() {
 }
 
 void PubSubThread::Cleanup() {
+  {
+    std::lock_guard lk(pub_mutex_);
+    pub_queue_.clear();
+  }
+  pub_space_signal_.notify_all();
+
   std::lock_guard l(rwlock_);
   for (auto& iter : conns_) {
     CloseFd(iter.second->conn);
@@ -6,6 +6,7 @@
 #include "net/include/redis_conn.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
 
 #include <glog/logging.h>
@@ -109,14 +110,20 @@ ReadStatus RedisConn::GetRequest() {
     return kFullError;
   }
 
+  // rbuf_ keeps the unparsed tail of the last read at its head, the parser
+  // resumes on it and slices arguments out of rbuf_ directly
   int processed_len = 0;
-  RedisParserStatus ret = redis_parser_.ProcessInputBuffer(rbuf_ + next_read_pos, static_cast<int32_t>(nread), &processed_len);
+  RedisParserStatus ret = redis_parser_.ProcessInputBufferInPlace(rbuf_, last_read_pos_ + 1, &processed_len);
   ReadStatus read_status = ParseRedisParserStatus(ret);
   if (read_status == kReadAll || read_status == kReadHalf) {
     if (read_status == kReadAll) {
       command_len_ = 0;
     }
-    last_read_pos_ = -1;
+    int remain_len = last_read_pos_ + 1 - processed_len;
+    if (processed_len > 0 && remain_len > 0) {
+      memmove(rbuf_, rbuf_ + processed_len, remain_len);
+    }
+    last_read_pos_ = remain_len - 1;
     bulk_len_ = redis_parser_.get_bulk_len();
   }
   if (!response_.empty()) {
@@ -174,7 +174,7 @@ RedisParser::RedisParser()
     : redis_type_(0), bulk_len_(-1), redis_parser_type_(REDIS_PARSER_REQUEST) {}
 
 void RedisParser::SetParserStatus(RedisParserStatus status, RedisParserError error) {
-  if (status == kRedisParserHalf) {
+  if (status == kRedisParserHalf && !in_place_) {
     CacheHalfArgv();
   }
   status_code_ = status;
@@ -208,7 +208,7 @@ RedisParserStatus RedisParser::ProcessInlineBuffer() {
   pos = FindNextSeparators();
   if (pos == -1) {
     // change rbuf_len_ to length_
-    if (length_ > REDIS_INLINE_MAXLEN) {
+    if (length_ - cur_pos_ > REDIS_INLINE_MAXLEN) {
       SetParserStatus(kRedisParserError, kRedisParserFullError);
       return status_code_;
     } else {
@@ -244,6 +244,7 @@ RedisParserStatus RedisParser::ProcessMultibulkBuffer() {
       }
       cur_pos_ = pos + 1;
       argv_.clear();
+      arg_offsets_.clear();
       if (cur_pos_ > length_ - 1) {
         SetParserStatus(kRedisParserHalf);
         return status_code_;
@@ -278,7 +279,11 @@ RedisParserStatus RedisParser::ProcessMultibulkBuffer() {
       // Data not enough
       break;
     } else {
-      argv_.emplace_back(input_buf_ + cur_pos_, bulk_len_);
+      if (in_place_) {
+        arg_offsets_.emplace_back(cur_pos_ - cmd_start_, bulk_len_);
+      } else {
+        argv_.emplace_back(input_buf_ + cur_pos_, bulk_len_);
+      }
       cur_pos_ = static_cast<int32_t>(cur_pos_ + bulk_len_ + 2);
       bulk_len_ = -1;
       multibulk_len_--;
@@ -335,6 +340,38 @@ RedisParserStatus RedisParser::ProcessInputBuffer(const char* input_buf, int len
   return status_code_;
 }
 
+RedisParserStatus RedisParser::ProcessInputBufferInPlace(const char* input_buf, int length, int* parsed_len) {
+  if (status_code_ == kRedisParserInitDone || status_code_ == kRedisParserHalf || status_code_ == kRedisParserDone) {
+    in_place_ = true;
+    input_buf_ = input_buf;
+    length_ = length;
+    if (redis_parser_type_ == REDIS_PARSER_REQUEST) {
+      ProcessRequestBuffer();
+    } else if (redis_parser_type_ == REDIS_PARSER_RESPONSE) {
+      ProcessResponseBuffer();
+    } else {
+      SetParserStatus(kRedisParserError, kRedisParserInitError);
+      return status_code_;
+    }
+    if (status_code_ == kRedisParserHalf) {
+      // the caller moves the half command to the head of the next input
+      *parsed_len = cmd_start_;
+      cur_pos_ -= cmd_start_;
+    } else {
+      *parsed_len = cur_pos_;
+      ResetCommandStatus();
+      arg_offsets_.clear();
+      cur_pos_ = 0;
+    }
+    cmd_start_ = 0;
+    input_buf_ = nullptr;
+    length_ = 0;
+    return status_code_;
+  }
+  SetParserStatus(kRedisParserError, kRedisParserInitError);
+  return status_code_;
+}
+
 // TODO(): AZ
 RedisParserStatus RedisParser::ProcessResponseBuffer() {
   SetParserStatus(kRedisParserDone);
@@ -366,14 +403,9 @@ RedisParserStatus RedisParser::ProcessRequestBuffer() {
       // Unknown requeset type;
       return kRedisParserError;
     }
-    if (!argv_.empty()) {
-      argvs_.push_back(argv_);
-      if (parser_settings_.DealMessage) {
-        if (parser_settings_.DealMessage(this, argv_) != 0) {
-          SetParserStatus(kRedisParserError, kRedisParserDealError);
-          return status_code_;
-        }
-      }
+    if (DealCompleteArgv() != 0) {
+      SetParserStatus(kRedisParserError, kRedisParserDealError);
+      return status_code_;
     }
     argv_.clear();
     // Reset
@@ -390,11 +422,35 @@ RedisParserStatus RedisParser::ProcessRequestBuffer() {
   return status_code_;  // OK
 }
 
+int RedisParser::DealCompleteArgv() {
+  if (in_place_ && !arg_offsets_.empty()) {
+    // the command outlives the input buffer, copy it once
+    const char* cmd = input_buf_ + cmd_start_;
+    argv_.reserve(arg_offsets_.size());
+    for (const auto& [offset, len] : arg_offsets_) {
+      argv_.emplace_back(cmd + offset, len);
+    }
+    arg_offsets_.clear();
+  }
+
+  if (argv_.empty()) {
+    return 0;
+  }
+  if (parser_settings_.DealMessage) {
+    if (parser_settings_.DealMessage(this, argv_) != 0) {
+      return -1;
+    }
+  }
+  argvs_.push_back(std::move(argv_));
+  return 0;
+}
+
 void RedisParser::ResetCommandStatus() {
   redis_type_ = 0;
   multibulk_len_ = 0;
   bulk_len_ = -1;
   half_argv_.clear();
+  cmd_start_ = cur_pos_;
 }
 
 void RedisParser::ResetRedisParser() {
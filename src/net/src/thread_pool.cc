@@ -8,20 +8,22 @@
 
 #include <sys/time.h>
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <utility>
 
 namespace net {
 
 void* ThreadPool::Worker::WorkerMain(void* arg) {
-  auto tp = static_cast<ThreadPool*>(arg);
-  tp->runInThread();
+  auto worker = static_cast<Worker*>(arg);
+  worker->thread_pool_->runInThread(worker->index_);
   return nullptr;
 }
 
 int ThreadPool::Worker::start() {
   if (!start_.load()) {
-    if (pthread_create(&thread_id_, nullptr, &WorkerMain, thread_pool_) != 0) {
+    if (pthread_create(&thread_id_, nullptr, &WorkerMain, this) != 0) {
       return -1;
     } else {
       start_.store(true);
@@ -48,20 +50,44 @@ ThreadPool::ThreadPool(size_t worker_num, size_t max_queue_size, std::string  th
       max_queue_size_(max_queue_size),
       thread_pool_name_(std::move(thread_pool_name)),
       running_(false),
-      should_stop_(false) {}
+      should_stop_(false),
+      timer_wheel_(kTimerWheelSlots) {
+  for (size_t i = 0; i < worker_num_; ++i) {
+    queues_.push_back(std::make_unique<WorkerQueue>());
+  }
+  for (size_t i = 0; i < kLaneShards; ++i) {
+    lane_shards_.push_back(std::make_unique<LaneShard>());
+  }
+}
 
 ThreadPool::~ThreadPool() { stop_thread_pool(); }
 
+static uint64_t NowMillis() {
+  auto now = std::chrono::system_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
+void* ThreadPool::TimerMain(void* arg) {
+  auto tp = static_cast<ThreadPool*>(arg);
+  tp->runTimer();
+  return nullptr;
+}
+
 int ThreadPool::start_thread_pool() {
   if (!running_.load()) {
     should_stop_.store(false);
     for (size_t i = 0; i < worker_num_; ++i) {
-      workers_.push_back(new Worker(this));
+      workers_.push_back(new Worker(this, i));
       int res = workers_[i]->start();
       if (res != 0) {
         return kCreateThreadError;
       }
     }
+    if (pthread_create(&timer_thread_id_, nullptr, &TimerMain, this) != 0) {
+      return kCreateThreadError;
+    }
+    timer_started_ = true;
+    SetThreadName(timer_thread_id_, thread_pool_name_ + "_Timer");
     running_.store(true);
   }
   return kSuccess;
@@ -71,8 +97,18 @@ int ThreadPool::stop_thread_pool() {
   int res = 0;
   if (running_.load()) {
     should_stop_.store(true);
-    rsignal_.notify_all();
-    wsignal_.notify_all();
+    for (const auto& queue : queues_) {
+      std::lock_guard lock(queue->mu);
+      queue->signal.notify_all();
+    }
+    {
+      std::lock_guard lock(mu_);
+      wsignal_.notify_all();
+    }
+    {
+      std::lock_guard lock(timer_mu_);
+      timer_signal_.notify_all();
+    }
     for (const auto worker : workers_) {
       res = worker->stop();
       if (res != 0) {
@@ -82,6 +118,10 @@ int ThreadPool::stop_thread_pool() {
       }
     }
     workers_.clear();
+    if (timer_started_) {
+      pthread_join(timer_thread_id_, nullptr);
+      timer_started_ = false;
+    }
     running_.store(false);
   }
   return res;
@@ -92,76 +132,275 @@ bool ThreadPool::should_stop() { return should_stop_.load(); }
 void ThreadPool::set_should_stop() { should_stop_.store(true); }
 
 void ThreadPool::Schedule(TaskFunc func, void* arg) {
-  std::unique_lock lock(mu_);
-  wsignal_.wait(lock, [this]() { return queue_.size() < max_queue_size_ || should_stop(); });
-
+  WaitForQueueSpace();
   if (!should_stop()) {
-    queue_.emplace(func, arg);
-    rsignal_.notify_one();
+    size_t index = next_queue_.fetch_add(1, std::memory_order_relaxed) % worker_num_;
+    queue_size_.fetch_add(1);
+    PushTask(index, Task(func, arg));
   }
 }
 
+void ThreadPool::Schedule(TaskFunc func, void* arg, uint64_t affinity) {
+  WaitForQueueSpace();
+  if (should_stop()) {
+    return;
+  }
+  Task task(func, arg);
+  task.ordered = true;
+  task.affinity = affinity;
+  queue_size_.fetch_add(1);
+  {
+    LaneShard& shard = *lane_shards_[affinity % kLaneShards];
+    std::lock_guard lock(shard.mu);
+    auto lane = shard.lanes.find(affinity);
+    if (lane != shard.lanes.end()) {
+      lane->second.push_back(task);
+      return;
+    }
+    shard.lanes.emplace(affinity, std::deque<Task>());
+  }
+  PushTask(affinity % worker_num_, task);
+}
+
+// Called by the worker that ran a task of affinity, queues the next task of
+// its lane behind the tasks already waiting on that worker
+void ThreadPool::FinishOrderedTask(size_t index, uint64_t affinity) {
+  Task next;
+  {
+    LaneShard& shard = *lane_shards_[affinity % kLaneShards];
+    std::lock_guard lock(shard.mu);
+    auto lane = shard.lanes.find(affinity);
+    if (lane == shard.lanes.end()) {
+      return;
+    }
+    if (lane->second.empty()) {
+      shard.lanes.erase(lane);
+      return;
+    }
+    next = lane->second.front();
+    lane->second.pop_front();
+  }
+  PushTask(index, next);
+}
+
 /*
  * timeout is in millisecond
  */
 void ThreadPool::DelaySchedule(uint64_t timeout, TaskFunc func, void* arg) {
-  auto now = std::chrono::system_clock::now();
-  uint64_t unow = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
-  uint64_t exec_time = unow + timeout * 1000;
+  uint64_t exec_ms = NowMillis() + timeout;
 
-  std::lock_guard lock(mu_);
+  std::lock_guard lock(timer_mu_);
   if (!should_stop()) {
-    time_queue_.emplace(exec_time, func, arg);
-    rsignal_.notify_all();
+    if (time_queue_size_.load() == 0) {
+      timer_current_ms_ = NowMillis() - 1;
+    }
+    // a task is never put behind the wheel cursor, at worst it fires on the next tick
+    uint64_t due_ms = std::max(exec_ms, timer_current_ms_ + 1);
+    timer_wheel_[due_ms % kTimerWheelSlots].push_back({due_ms, Task(func, arg)});
+    time_queue_size_.fetch_add(1);
+    timer_signal_.notify_one();
   }
 }
 
 size_t ThreadPool::max_queue_size() { return max_queue_size_; }
 
-void ThreadPool::cur_queue_size(size_t* qsize) {
-  std::lock_guard lock(mu_);
-  *qsize = queue_.size();
+size_t ThreadPool::worker_size() { return worker_num_; }
+
+void ThreadPool::cur_queue_size(size_t* qsize) { *qsize = queue_size_.load(); }
+
+void ThreadPool::cur_time_queue_size(size_t* qsize) { *qsize = time_queue_size_.load(); }
+
+std::string ThreadPool::thread_pool_name() { return thread_pool_name_; }
+
+void ThreadPool::WaitForQueueSpace() {
+  if (queue_size_.load() < max_queue_size_) {
+    return;
+  }
+  std::unique_lock lock(mu_);
+  blocked_producers_.fetch_add(1);
+  wsignal_.wait(lock, [this]() { return queue_size_.load() < max_queue_size_ || should_stop(); });
+  blocked_producers_.fetch_sub(1);
+}
+
+// queue_size_ counts the task from the time it is scheduled, the caller
+// adds it
+void ThreadPool::PushTask(size_t index, const Task& task) {
+  WorkerQueue& queue = *queues_[index];
+  bool owner_idle = false;
+  {
+    std::lock_guard lock(queue.mu);
+    queue.tasks.push_back(task);
+    queue.size.fetch_add(1);
+    owner_idle = queue.idle.load();
+  }
+  if (owner_idle) {
+    queue.signal.notify_one();
+  } else if (searching_workers_.load() == 0 && idle_workers_.load() > 0) {
+    // the owner is busy and nobody is looking for work, let an idle
+    // worker steal the task
+    WakeupIdleWorker(index);
+  }
 }
 
-void ThreadPool::cur_time_queue_size(size_t* qsize) {
-  std::lock_guard lock(mu_);
-  *qsize = time_queue_.size();
+bool ThreadPool::PopTask(size_t index, Task* task) {
+  WorkerQueue& queue = *queues_[index];
+  if (queue.size.load() == 0) {
+    return false;
+  }
+  std::lock_guard lock(queue.mu);
+  if (!queue.tasks.empty()) {
+    *task = queue.tasks.front();
+    queue.tasks.pop_front();
+    queue.size.fetch_sub(1);
+    return true;
+  }
+  return false;
 }
 
-std::string ThreadPool::thread_pool_name() { return thread_pool_name_; }
+bool ThreadPool::StealTask(size_t index, Task* task) {
+  for (size_t i = 1; i < worker_num_; ++i) {
+    WorkerQueue& victim = *queues_[(index + i) % worker_num_];
+    if (victim.size.load() == 0) {
+      continue;
+    }
+    std::lock_guard lock(victim.mu);
+    if (!victim.tasks.empty()) {
+      *task = victim.tasks.front();
+      victim.tasks.pop_front();
+      victim.size.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
 
-void ThreadPool::runInThread() {
-  while (!should_stop()) {
-    std::unique_lock lock(mu_);
-    rsignal_.wait(lock, [this]() { return !queue_.empty() || !time_queue_.empty() || should_stop(); });
+bool ThreadPool::HasStealableTask() {
+  for (const auto& queue : queues_) {
+    if (queue->size.load() != 0) {
+      return true;
+    }
+  }
+  return false;
+}
 
-    if (should_stop()) {
-      break;
+void ThreadPool::WakeupIdleWorker(size_t except_index) {
+  for (size_t i = 1; i < worker_num_; ++i) {
+    WorkerQueue& queue = *queues_[(except_index + i) % worker_num_];
+    if (!queue.idle.load()) {
+      continue;
     }
-    if (!time_queue_.empty()) {
-      auto now = std::chrono::system_clock::now();
-      uint64_t unow = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    std::lock_guard lock(queue.mu);
+    if (queue.idle.load() && !queue.wakeup) {
+      queue.wakeup = true;
+      queue.signal.notify_one();
+      return;
+    }
+  }
+}
 
-      auto [exec_time, func, arg] = time_queue_.top();
-      if (unow  >= exec_time) {
-        time_queue_.pop();
-        lock.unlock();
-        (*func)(arg);
-        continue;
-      } else if (queue_.empty() && !should_stop()) {
-        rsignal_.wait_for(lock, std::chrono::microseconds(exec_time - unow));
-        lock.unlock();
+void ThreadPool::runInThread(size_t index) {
+  WorkerQueue& queue = *queues_[index];
+  // A worker between two tasks is searching, producers only wake an idle
+  // worker when nobody searches. The last searcher that finds a task wakes
+  // the next one if work is left, so a backlog keeps enough workers awake.
+  searching_workers_.fetch_add(1);
+  while (!should_stop()) {
+    Task task;
+    if (!PopTask(index, &task) && !StealTask(index, &task)) {
+      // recheck after leaving the searchers, a producer that saw us
+      // searching did not wake anybody for its task
+      searching_workers_.fetch_sub(1);
+      if (HasStealableTask()) {
+        searching_workers_.fetch_add(1);
         continue;
       }
+      {
+        std::unique_lock lock(queue.mu);
+        queue.idle.store(true);
+        idle_workers_.fetch_add(1);
+        queue.signal.wait(lock, [this, &queue]() {
+          return !queue.tasks.empty() || queue.wakeup || should_stop();
+        });
+        queue.idle.store(false);
+        queue.wakeup = false;
+        idle_workers_.fetch_sub(1);
+      }
+      searching_workers_.fetch_add(1);
+      continue;
     }
 
-    if (!queue_.empty()) {
-      auto [func, arg] = queue_.front();
-      queue_.pop();
+    if (searching_workers_.fetch_sub(1) == 1 && idle_workers_.load() > 0 && HasStealableTask()) {
+      WakeupIdleWorker(index);
+    }
+    queue_size_.fetch_sub(1);
+    if (blocked_producers_.load() > 0) {
+      std::lock_guard lock(mu_);
       wsignal_.notify_one();
+    }
+    (*task.func)(task.arg);
+    if (task.ordered) {
+      FinishOrderedTask(index, task.affinity);
+    }
+    searching_workers_.fetch_add(1);
+  }
+  searching_workers_.fetch_sub(1);
+}
+
+void ThreadPool::runTimer() {
+  std::vector<Task> ready;
+  std::unique_lock lock(timer_mu_);
+  while (!should_stop()) {
+    if (time_queue_size_.load() == 0) {
+      timer_signal_.wait(lock, [this]() { return time_queue_size_.load() != 0 || should_stop(); });
+      continue;
+    }
+
+    uint64_t now_ms = NowMillis();
+    if (now_ms > timer_current_ms_) {
+      // every slot is visited once even if the timer fell a whole round behind
+      uint64_t steps = std::min(now_ms - timer_current_ms_, kTimerWheelSlots);
+      for (uint64_t step = 1; step <= steps; ++step) {
+        auto& slot = timer_wheel_[(timer_current_ms_ + step) % kTimerWheelSlots];
+        auto due_end = std::partition(slot.begin(), slot.end(),
+                                      [now_ms](const TimerWheelItem& item) { return item.due_ms > now_ms; });
+        for (auto iter = due_end; iter != slot.end(); ++iter) {
+          ready.push_back(iter->task);
+        }
+        slot.erase(due_end, slot.end());
+      }
+      timer_current_ms_ = now_ms;
+    }
+
+    if (!ready.empty()) {
+      time_queue_size_.fetch_sub(ready.size());
       lock.unlock();
-      (*func)(arg);
+      // due tasks bypass max_queue_size, the timer thread must not block
+      queue_size_.fetch_add(ready.size());
+      for (const auto& task : ready) {
+        PushTask(next_queue_.fetch_add(1, std::memory_order_relaxed) % worker_num_, task);
+      }
+      ready.clear();
+      lock.lock();
+      continue;
+    }
+    // DelaySchedule wakes the timer for a task due earlier
+    timer_signal_.wait_for(lock, std::chrono::milliseconds(NextTimerDue() - now_ms));
+  }
+}
+
+/*
+ * The first slot after the cursor holding a task of this round, the wheel
+ * is walked again after a whole round if none does
+ */
+uint64_t ThreadPool::NextTimerDue() {
+  for (uint64_t step = 1; step <= kTimerWheelSlots; ++step) {
+    uint64_t slot_ms = timer_current_ms_ + step;
+    for (const auto& item : timer_wheel_[slot_ms % kTimerWheelSlots]) {
+      if (item.due_ms <= slot_ms) {
+        return slot_ms;
+      }
     }
   }
+  return timer_current_ms_ + kTimerWheelSlots;
 }
 }  // namespace net
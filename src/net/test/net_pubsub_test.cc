@@ -0,0 +1,183 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "net/include/net_pubsub.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "net/include/net_conn.h"
+
+namespace {
+
+// A subscriber that keeps what the pubsub thread sends it, one entry per
+// SendReply
+class FakeConn : public net::NetConn {
+ public:
+  explicit FakeConn(int fd) : NetConn(fd, "127.0.0.1:" + std::to_string(fd), nullptr) {}
+
+  net::ReadStatus GetRequest() override { return net::kReadAll; }
+
+  net::WriteStatus SendReply() override {
+    std::lock_guard l(mutex_);
+    if (!buffer_.empty()) {
+      replies_.push_back(std::move(buffer_));
+      buffer_.clear();
+    }
+    return net::kWriteAll;
+  }
+
+  int WriteResp(const std::string& resp) override {
+    std::lock_guard l(mutex_);
+    buffer_.append(resp);
+    return 0;
+  }
+
+  std::vector<std::string> Replies() {
+    std::lock_guard l(mutex_);
+    return replies_;
+  }
+
+  std::string Received() {
+    std::string received;
+    for (const auto& reply : Replies()) {
+      received.append(reply);
+    }
+    return received;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::string buffer_;
+  std::vector<std::string> replies_;
+};
+
+std::string Message(const std::string& channel, const std::string& msg) {
+  return "*3\r\n$7\r\nmessage\r\n$" + std::to_string(channel.size()) + "\r\n" + channel + "\r\n$" +
+         std::to_string(msg.size()) + "\r\n" + msg + "\r\n";
+}
+
+std::string PMessage(const std::string& pattern, const std::string& channel, const std::string& msg) {
+  return "*4\r\n$8\r\npmessage\r\n$" + std::to_string(pattern.size()) + "\r\n" + pattern + "\r\n$" +
+         std::to_string(channel.size()) + "\r\n" + channel + "\r\n$" + std::to_string(msg.size()) + "\r\n" + msg +
+         "\r\n";
+}
+
+// polls until conn received size bytes or a second passed
+std::string WaitReceived(const std::shared_ptr<FakeConn>& conn, size_t size) {
+  for (int round = 0; round < 1000; ++round) {
+    std::string received = conn->Received();
+    if (received.size() >= size) {
+      return received;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return conn->Received();
+}
+
+class PubSubThreadTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_EQ(0, pubsub_.StartThread()); }
+
+  void TearDown() override { pubsub_.StopThread(); }
+
+  std::shared_ptr<FakeConn> NewConn() {
+    int fds[2];
+    EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    // the pubsub thread closes the subscriber end
+    peers_.push_back(fds[1]);
+    return std::make_shared<FakeConn>(fds[0]);
+  }
+
+  void Subscribe(const std::shared_ptr<FakeConn>& conn, const std::string& channel, bool pattern) {
+    std::vector<std::pair<std::string, int>> result;
+    pubsub_.Subscribe(conn, {channel}, pattern, &result);
+    pubsub_.UpdateConnReadyState(conn->fd(), net::PubSubThread::kReady);
+  }
+
+  ~PubSubThreadTest() override {
+    for (int fd : peers_) {
+      close(fd);
+    }
+  }
+
+  net::PubSubThread pubsub_;
+  std::vector<int> peers_;
+};
+
+}  // namespace
+
+// The messages of a channel reach every subscriber in publish order
+TEST_F(PubSubThreadTest, DeliveryOrder) {
+  auto first = NewConn();
+  auto second = NewConn();
+  Subscribe(first, "order", false);
+  Subscribe(second, "order", false);
+
+  std::string expected;
+  for (int idx = 0; idx < 1000; ++idx) {
+    std::string msg = "msg-" + std::to_string(idx);
+    ASSERT_EQ(2, pubsub_.Publish("order", msg));
+    expected.append(Message("order", msg));
+  }
+  ASSERT_EQ(expected, WaitReceived(first, expected.size()));
+  ASSERT_EQ(expected, WaitReceived(second, expected.size()));
+}
+
+// Channel and pattern subscribers get the messages of a batch interleaved in
+// publish order
+TEST_F(PubSubThreadTest, PatternDeliveryOrder) {
+  auto conn = NewConn();
+  Subscribe(conn, "news.sport", false);
+  Subscribe(conn, "news.*", true);
+
+  ASSERT_EQ(2, pubsub_.Publish("news.sport", "goal"));
+  ASSERT_EQ(1, pubsub_.Publish("news.art", "paint"));
+  ASSERT_EQ(2, pubsub_.Publish("news.sport", "match"));
+  std::string expected = Message("news.sport", "goal") + PMessage("news.*", "news.sport", "goal") +
+                         PMessage("news.*", "news.art", "paint") + Message("news.sport", "match") +
+                         PMessage("news.*", "news.sport", "match");
+  ASSERT_EQ(expected, WaitReceived(conn, expected.size()));
+}
+
+// Publish counts the ready subscribers of the channel and of the matching
+// patterns when the message is queued
+TEST_F(PubSubThreadTest, PublishReceivers) {
+  auto ready = NewConn();
+  auto not_ready = NewConn();
+  auto pattern = NewConn();
+  Subscribe(ready, "count", false);
+  std::vector<std::pair<std::string, int>> result;
+  pubsub_.Subscribe(not_ready, {"count"}, false, &result);
+  Subscribe(pattern, "c*", true);
+
+  ASSERT_EQ(0, pubsub_.Publish("nobody", "msg"));
+  ASSERT_EQ(2, pubsub_.Publish("count", "first"));
+  // readiness is checked again on delivery, let the message out first
+  std::string expected = PMessage("c*", "count", "first");
+  ASSERT_EQ(expected, WaitReceived(pattern, expected.size()));
+
+  pubsub_.UpdateConnReadyState(not_ready->fd(), net::PubSubThread::kReady);
+  ASSERT_EQ(3, pubsub_.Publish("count", "second"));
+  expected += PMessage("c*", "count", "second");
+  ASSERT_EQ(expected, WaitReceived(pattern, expected.size()));
+
+  pubsub_.UpdateConnReadyState(ready->fd(), net::PubSubThread::kNotReady);
+  ASSERT_EQ(2, pubsub_.Publish("count", "third"));
+  expected += PMessage("c*", "count", "third");
+  ASSERT_EQ(expected, WaitReceived(pattern, expected.size()));
+
+  ASSERT_EQ(Message("count", "first") + Message("count", "second"), ready->Received());
+  ASSERT_EQ(Message("count", "second") + Message("count", "third"), not_ready->Received());
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "net/include/redis_parser.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using Commands = std::vector<net::RedisCmdArgsType>;
+
+int CollectArgvs(net::RedisParser* parser, const std::vector<net::RedisCmdArgsType>& argvs) {
+  auto* commands = static_cast<Commands*>(parser->data);
+  commands->insert(commands->end(), argvs.begin(), argvs.end());
+  return 0;
+}
+
+// Feeds input in reads of read_len bytes the way RedisConn does, the bytes
+// not parsed yet stay at the head of the buffer for the next read
+class InPlaceFeeder {
+ public:
+  InPlaceFeeder() {
+    net::RedisParserSettings settings;
+    settings.Complete = CollectArgvs;
+    parser_.RedisParserInit(REDIS_PARSER_REQUEST, settings);
+    parser_.data = &commands_;
+  }
+
+  net::RedisParserStatus Feed(const std::string& input, size_t read_len) {
+    net::RedisParserStatus status = net::kRedisParserDone;
+    for (size_t pos = 0; pos < input.size(); pos += read_len) {
+      rbuf_.append(input, pos, read_len);
+      int parsed_len = 0;
+      status = parser_.ProcessInputBufferInPlace(rbuf_.data(), static_cast<int>(rbuf_.size()), &parsed_len);
+      if (status == net::kRedisParserError) {
+        return status;
+      }
+      rbuf_.erase(0, parsed_len);
+    }
+    return status;
+  }
+
+  const Commands& commands() const { return commands_; }
+  const std::string& remain() const { return rbuf_; }
+
+ private:
+  net::RedisParser parser_;
+  Commands commands_;
+  std::string rbuf_;
+};
+
+std::string Multibulk(const net::RedisCmdArgsType& argv) {
+  std::string cmd = "*" + std::to_string(argv.size()) + "\r\n";
+  for (const auto& arg : argv) {
+    cmd += "$" + std::to_string(arg.size()) + "\r\n" + arg + "\r\n";
+  }
+  return cmd;
+}
+
+}  // namespace
+
+TEST(RedisParserTest, HalfCommandStaysInBuffer) {
+  InPlaceFeeder feeder;
+  std::string set = Multibulk({"SET", "key", "value"});
+  std::string get = Multibulk({"GET", "key"});
+
+  EXPECT_EQ(feeder.Feed(set + get.substr(0, 10), set.size() + 10), net::kRedisParserHalf);
+  EXPECT_EQ(feeder.remain(), get.substr(0, 10));
+
+  EXPECT_EQ(feeder.Feed(get.substr(10), get.size()), net::kRedisParserDone);
+  EXPECT_TRUE(feeder.remain().empty());
+  ASSERT_EQ(feeder.commands().size(), 2U);
+  EXPECT_EQ(feeder.commands()[0], net::RedisCmdArgsType({"SET", "key", "value"}));
+  EXPECT_EQ(feeder.commands()[1], net::RedisCmdArgsType({"GET", "key"}));
+}
+
+TEST(RedisParserTest, EveryByteBoundary) {
+  Commands expect = {{"SET", "key", "value"}, {"DEL", "k1", "k2", ""}, {"PING"}};
+  std::string input;
+  for (const auto& argv : expect) {
+    input += Multibulk(argv);
+  }
+  for (size_t read_len = 1; read_len <= input.size(); ++read_len) {
+    InPlaceFeeder feeder;
+    EXPECT_EQ(feeder.Feed(input, read_len), net::kRedisParserDone) << "read_len " << read_len;
+    EXPECT_TRUE(feeder.remain().empty()) << "read_len " << read_len;
+    EXPECT_EQ(feeder.commands(), expect) << "read_len " << read_len;
+  }
+}
+
+TEST(RedisParserTest, InlineCommand) {
+  InPlaceFeeder feeder;
+  EXPECT_EQ(feeder.Feed("set key \"a b\"\r\nPI", 64), net::kRedisParserHalf);
+  EXPECT_EQ(feeder.remain(), "PI");
+  EXPECT_EQ(feeder.Feed("NG\r\n", 64), net::kRedisParserDone);
+  ASSERT_EQ(feeder.commands().size(), 2U);
+  EXPECT_EQ(feeder.commands()[0], net::RedisCmdArgsType({"set", "key", "a b"}));
+  EXPECT_EQ(feeder.commands()[1], net::RedisCmdArgsType({"PING"}));
+}
+
+TEST(RedisParserTest, InlineAndMultibulkMixed) {
+  InPlaceFeeder feeder;
+  std::string input = "PING\r\n" + Multibulk({"GET", "key"}) + "echo 'x y'\r\n";
+  EXPECT_EQ(feeder.Feed(input, 5), net::kRedisParserDone);
+  ASSERT_EQ(feeder.commands().size(), 3U);
+  EXPECT_EQ(feeder.commands()[0], net::RedisCmdArgsType({"PING"}));
+  EXPECT_EQ(feeder.commands()[1], net::RedisCmdArgsType({"GET", "key"}));
+  EXPECT_EQ(feeder.commands()[2], net::RedisCmdArgsType({"echo", "x y"}));
+}
+
+TEST(RedisParserTest, BulkAcrossBuffers) {
+  std::string value(3 * REDIS_IOBUF_LEN + 17, 'v');
+  for (size_t i = 0; i < value.size(); i += 97) {
+    value[i] = static_cast<char>('a' + i % 26);
+  }
+  std::string input = Multibulk({"SET", "big", value}) + Multibulk({"GET", "big"});
+
+  InPlaceFeeder feeder;
+  EXPECT_EQ(feeder.Feed(input, REDIS_IOBUF_LEN), net::kRedisParserDone);
+  EXPECT_TRUE(feeder.remain().empty());
+  ASSERT_EQ(feeder.commands().size(), 2U);
+  EXPECT_EQ(feeder.commands()[0], net::RedisCmdArgsType({"SET", "big", value}));
+  EXPECT_EQ(feeder.commands()[1], net::RedisCmdArgsType({"GET", "big"}));
+}
+
+// ProcessInputBuffer caches the half command itself, both modes parse the
+// same commands
+TEST(RedisParserTest, SameCommandsAsCopyMode) {
+  std::string value(REDIS_IOBUF_LEN + 5, 'x');
+  std::string input = Multibulk({"SET", "k", value}) + "PING\r\n" + Multibulk({"HSET", "h", "f", "v"});
+
+  Commands copied;
+  net::RedisParserSettings settings;
+  settings.Complete = CollectArgvs;
+  net::RedisParser parser;
+  parser.RedisParserInit(REDIS_PARSER_REQUEST, settings);
+  parser.data = &copied;
+  for (size_t pos = 0; pos < input.size(); pos += 1000) {
+    std::string read = input.substr(pos, 1000);
+    int parsed_len = 0;
+    ASSERT_NE(parser.ProcessInputBuffer(read.data(), static_cast<int>(read.size()), &parsed_len),
+              net::kRedisParserError);
+  }
+
+  InPlaceFeeder feeder;
+  EXPECT_EQ(feeder.Feed(input, 1000), net::kRedisParserDone);
+  ASSERT_EQ(copied.size(), 3U);
+  EXPECT_EQ(feeder.commands(), copied);
+}
+
+TEST(RedisParserTest, ProtocolError) {
+  InPlaceFeeder feeder;
+  EXPECT_EQ(feeder.Feed("*2\r\n$3\r\nGET\r\n+key\r\n", 64), net::kRedisParserError);
+  EXPECT_TRUE(feeder.commands().empty());
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "net/include/thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+bool WaitFor(const std::atomic<int>& value, int expect) {
+  for (int i = 0; i < 5000 && value.load() != expect; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return value.load() == expect;
+}
+
+struct BlockArg {
+  std::atomic<bool> release{false};
+  std::atomic<int> started{0};
+};
+
+void BlockTask(void* arg) {
+  auto* block = static_cast<BlockArg*>(arg);
+  block->started.fetch_add(1);
+  while (!block->release.load()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+void CountTask(void* arg) { static_cast<std::atomic<int>*>(arg)->fetch_add(1); }
+
+struct Lane {
+  std::atomic<int> running{0};
+  std::atomic<bool> overlapped{false};
+  std::vector<int> order;
+};
+
+struct OrderedArg {
+  Lane* lane;
+  int seq;
+  std::atomic<int>* done;
+};
+
+void OrderedTask(void* arg) {
+  std::unique_ptr<OrderedArg> task(static_cast<OrderedArg*>(arg));
+  if (task->lane->running.fetch_add(1) != 0) {
+    task->lane->overlapped.store(true);
+  }
+  task->lane->order.push_back(task->seq);
+  task->lane->running.fetch_sub(1);
+  task->done->fetch_add(1);
+}
+
+}  // namespace
+
+// A task that blocks its worker must not hold up the tasks queued behind it,
+// neither plain ones nor ones with another affinity mapped to that worker
+TEST(ThreadPoolTest, BlockedWorkerTasksAreStolen) {
+  net::ThreadPool pool(2, 1000, "StealTest");
+  ASSERT_EQ(pool.start_thread_pool(), 0);
+
+  BlockArg block;
+  pool.Schedule(&BlockTask, &block, 0);
+  ASSERT_TRUE(WaitFor(block.started, 1));
+
+  std::atomic<int> done{0};
+  for (uint64_t affinity = 2; affinity < 200; affinity += 2) {
+    pool.Schedule(&CountTask, &done, affinity);
+    pool.Schedule(&CountTask, &done);
+  }
+  EXPECT_TRUE(WaitFor(done, 198));
+
+  block.release.store(true);
+  pool.stop_thread_pool();
+}
+
+// Tasks of one affinity wait for each other, the ones behind a blocked task
+// run after it in scheduling order
+TEST(ThreadPoolTest, SameAffinityWaitsForRunningTask) {
+  net::ThreadPool pool(4, 1000, "WaitTest");
+  ASSERT_EQ(pool.start_thread_pool(), 0);
+
+  BlockArg block;
+  Lane lane;
+  std::atomic<int> done{0};
+  pool.Schedule(&BlockTask, &block, 7);
+  ASSERT_TRUE(WaitFor(block.started, 1));
+  for (int seq = 0; seq < 10; ++seq) {
+    pool.Schedule(&OrderedTask, new OrderedArg{&lane, seq, &done}, 7);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(done.load(), 0);
+
+  block.release.store(true);
+  ASSERT_TRUE(WaitFor(done, 10));
+  EXPECT_FALSE(lane.overlapped.load());
+  for (int seq = 0; seq < 10; ++seq) {
+    EXPECT_EQ(lane.order[seq], seq);
+  }
+  pool.stop_thread_pool();
+}
+
+TEST(ThreadPoolTest, AffinityKeepsSchedulingOrder) {
+  const int kLanes = 16;
+  const int kTasksPerLane = 2000;
+  net::ThreadPool pool(4, 100000, "OrderTest");
+  ASSERT_EQ(pool.start_thread_pool(), 0);
+
+  std::vector<Lane> lanes(kLanes);
+  std::atomic<int> done{0};
+  for (int seq = 0; seq < kTasksPerLane; ++seq) {
+    for (int i = 0; i < kLanes; ++i) {
+      pool.Schedule(&OrderedTask, new OrderedArg{&lanes[i], seq, &done}, i);
+    }
+  }
+  ASSERT_TRUE(WaitFor(done, kLanes * kTasksPerLane));
+  pool.stop_thread_pool();
+
+  for (const auto& lane : lanes) {
+    EXPECT_FALSE(lane.overlapped.load());
+    ASSERT_EQ(lane.order.size(), static_cast<size_t>(kTasksPerLane));
+    for (int seq = 0; seq < kTasksPerLane; ++seq) {
+      ASSERT_EQ(lane.order[seq], seq);
+    }
+  }
+}
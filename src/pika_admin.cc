@@ -1088,6 +1088,8 @@ void InfoCmd::InfoStats(std::string& info) {
   tmp_stream << "is_compact:" << (g_pika_server->IsCompacting() ? "Yes" : "No") << "\r\n";
   tmp_stream << "compact_cron:" << g_pika_conf->compact_cron() << "\r\n";
   tmp_stream << "compact_interval:" << g_pika_conf->compact_interval() << "\r\n";
+  tmp_stream << "expired_keys:" << g_pika_server->ExpiredKeys() << "\r\n";
+  tmp_stream << "expire_reaper_lag_ms:" << g_pika_server->ExpireReaperLagMs() << "\r\n";
   time_t current_time_s = time(nullptr);
   PikaServer::BGSlotsReload bgslotsreload_info = g_pika_server->bgslots_reload();
   bool is_reloading = g_pika_server->GetSlotsreloading();
@@ -1217,6 +1219,21 @@ void InfoCmd::InfoReplication(std::string& info) {
       return;
   }
   tmp_stream << "ReplicationID:" << g_pika_conf->replication_id() << "\r\n";
+  std::stringstream repl_apply;
+  if ((host_role & PIKA_ROLE_SLAVE) != 0) {
+    ReplApplyStats apply_stats = g_pika_rm->GetReplApplyStats();
+    repl_apply << "repl_apply_pending:" << apply_stats.pending_cmds << "\r\n";
+    repl_apply << "repl_apply_lag_ms:" << apply_stats.lag_ms << "\r\n";
+    repl_apply << "repl_apply_cmds:" << apply_stats.applied_cmds << "\r\n";
+    repl_apply << "repl_apply_batches:" << apply_stats.applied_batches << "\r\n";
+    repl_apply << "repl_apply_avg_batch_size:" << std::setiosflags(std::ios::fixed) << std::setprecision(2)
+               << (apply_stats.applied_batches == 0
+                       ? 0.0
+                       : static_cast<double>(apply_stats.applied_cmds) / static_cast<double>(apply_stats.applied_batches))
+               << "\r\n";
+    repl_apply << "repl_apply_max_batch_size:" << apply_stats.max_batch_size << "\r\n";
+    repl_apply << "repl_apply_staged_cmds:" << apply_stats.staged_cmds << "\r\n";
+  }
   std::string slaves_list_str;
   switch (host_role) {
     case PIKA_ROLE_SLAVE:
@@ -1231,6 +1248,7 @@ void InfoCmd::InfoReplication(std::string& info) {
       if (!all_db_sync) {
         tmp_stream << "db_repl_state:" << out_of_sync.str() << "\r\n";
       }
+      tmp_stream << repl_apply.str();
       break;
     case PIKA_ROLE_MASTER | PIKA_ROLE_SLAVE:
       tmp_stream << "master_host:" << g_pika_server->master_ip() << "\r\n";
@@ -1243,6 +1261,7 @@ void InfoCmd::InfoReplication(std::string& info) {
       if (!all_db_sync) {
         tmp_stream << "db_repl_state:" << out_of_sync.str() << "\r\n";
       }
+      tmp_stream << repl_apply.str();
     case PIKA_ROLE_SINGLE:
     case PIKA_ROLE_MASTER:
       tmp_stream << "connected_slaves:" << g_pika_server->GetSlaveListString(slaves_list_str) << "\r\n"
@@ -1306,24 +1325,29 @@ void InfoCmd::InfoKeyspace(std::string& info) {
   for (const auto& db_item : g_pika_server->dbs_) {
     if (keyspace_scan_dbs_.find(db_item.first) != keyspace_scan_dbs_.end()) {
       db_name = db_item.second->GetDBName();
-      key_scan_info = db_item.second->GetKeyScanInfo();
-      key_infos = key_scan_info.key_infos;
-      duration = key_scan_info.duration;
-      if (key_infos.size() != (size_t)(storage::DataTypeNum)) {
-        LOG(ERROR) << "key_infos size is not equal with expected, potential data inconsistency";
-        info.append("info keyspace error\r\n");
-        return;
-      }
-      tmp_stream << "# Time:" << key_scan_info.s_start_time << "\r\n";
-      if (duration == -2) {
-        tmp_stream << "# Duration: "
-                   << "In Waiting\r\n";
-      } else if (duration == -1) {
-        tmp_stream << "# Duration: "
-                   << "In Processing\r\n";
-      } else if (duration >= 0) {
-        tmp_stream << "# Duration: " << std::to_string(duration) + "s"
-                   << "\r\n";
+      // the live counters, unless the full scan was asked for
+      if (!rescan_ && db_item.second->GetKeyCounters(&key_infos).ok()) {
+        tmp_stream << "# Counters: live\r\n";
+      } else {
+        key_scan_info = db_item.second->GetKeyScanInfo();
+        key_infos = key_scan_info.key_infos;
+        duration = key_scan_info.duration;
+        if (key_infos.size() != (size_t)(storage::DataTypeNum)) {
+          LOG(ERROR) << "key_infos size is not equal with expected, potential data inconsistency";
+          info.append("info keyspace error\r\n");
+          return;
+        }
+        tmp_stream << "# Time:" << key_scan_info.s_start_time << "\r\n";
+        if (duration == -2) {
+          tmp_stream << "# Duration: "
+                     << "In Waiting\r\n";
+        } else if (duration == -1) {
+          tmp_stream << "# Duration: "
+                     << "In Processing\r\n";
+        } else if (duration >= 0) {
+          tmp_stream << "# Duration: " << std::to_string(duration) + "s"
+                     << "\r\n";
+        }
       }
 
       tmp_stream << db_name << " Strings_keys=" << key_infos[0].keys << ", expires=" << key_infos[0].expires
@@ -1443,17 +1467,17 @@ void InfoCmd::InfoCommandStats(std::string& info) {
   tmp_stream.precision(2);
   tmp_stream.setf(std::ios::fixed);
   tmp_stream << "# Commandstats" << "\r\n";
-  auto cmdstat_map = g_pika_cmd_table_manager->GetCommandStatMap();
-  for (auto iter : *cmdstat_map) {
-    if (iter.second.cmd_count != 0) {
+  auto cmd_stats = g_pika_server->ServerCmdStats();
+  for (const auto& iter : cmd_stats) {
+    if (iter.second.calls != 0) {
       tmp_stream << iter.first << ":"
-                 << "calls=" << iter.second.cmd_count << ", usec="
-                 << MethodofTotalTimeCalculation(iter.second.cmd_time_consuming)
+                 << "calls=" << iter.second.calls << ", usec="
+                 << MethodofTotalTimeCalculation(iter.second.time_consuming)
                  << ", usec_per_call=";
-      if (!iter.second.cmd_time_consuming) {
+      if (!iter.second.time_consuming) {
         tmp_stream << 0 << "\r\n";
       } else {
-        tmp_stream << MethodofCommandStatistics(iter.second.cmd_time_consuming, iter.second.cmd_count)
+        tmp_stream << MethodofCommandStatistics(iter.second.time_consuming, iter.second.calls)
                    << "\r\n";
       }
     }
@@ -1481,6 +1505,12 @@ void InfoCmd::InfoCache(std::string& info, std::shared_ptr<DB> db) {
     tmp_stream << "hitratio_all:" << std::setprecision(4) << cache_info.hitratio_all << "%" << "\r\n";
     tmp_stream << "load_keys_per_sec:" << cache_info.load_keys_per_sec << "\r\n";
     tmp_stream << "waitting_load_keys_num:" << cache_info.waitting_load_keys_num << "\r\n";
+    tmp_stream << "load_key_latency_us:" << cache_info.load_key_latency_us << "\r\n";
+    tmp_stream << "dropped_load_keys_num:" << cache_info.dropped_load_keys_num << "\r\n";
+    tmp_stream << "skipped_load_keys_num:" << cache_info.skipped_load_keys_num << "\r\n";
+    tmp_stream << "rtc_cache_read:" << (g_pika_conf->rtc_cache_read_enabled() ? "yes" : "no") << "\r\n";
+    tmp_stream << "rtc_hits:" << g_pika_server->RtcCacheHits() << "\r\n";
+    tmp_stream << "rtc_fallbacks:" << g_pika_server->RtcCacheFallbacks() << "\r\n";
   }
   info.append(tmp_stream.str());
 }
@@ -1639,6 +1669,12 @@ void ConfigCmd::ConfigGet(std::string& ret) {
      EncodeNumber(&config_body, g_pika_conf->sync_binlog_thread_num());
     }
 
+  if (pstd::stringmatch(pattern.data(), "slave-apply-batch-size", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "slave-apply-batch-size");
+    EncodeNumber(&config_body, g_pika_conf->slave_apply_batch_size());
+  }
+
   if (pstd::stringmatch(pattern.data(), "log-path", 1) != 0) {
     elements += 2;
     EncodeString(&config_body, "log-path");
@@ -1795,6 +1831,24 @@ void ConfigCmd::ConfigGet(std::string& ret) {
     EncodeNumber(&config_body, g_pika_conf->small_compaction_duration_threshold());
   }
 
+  if (pstd::stringmatch(pattern.data(), "keyspace-scan-threads", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "keyspace-scan-threads");
+    EncodeNumber(&config_body, g_pika_conf->keyspace_scan_threads());
+  }
+
+  if (pstd::stringmatch(pattern.data(), "expire-index", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "expire-index");
+    EncodeString(&config_body, g_pika_conf->expire_index() ? "yes" : "no");
+  }
+
+  if (pstd::stringmatch(pattern.data(), "expire-reaper-keys-per-second", 1) != 0) {
+    elements += 2;
+    EncodeString(&config_body, "expire-reaper-keys-per-second");
+    EncodeNumber(&config_body, g_pika_conf->expire_reaper_keys_per_second());
+  }
+
   if (pstd::stringmatch(pattern.data(), "max-background-flushes", 1) != 0) {
     elements += 2;
     EncodeString(&config_body, "max-background-flushes");
@@ -2201,6 +2255,12 @@ void ConfigCmd::ConfigGet(std::string& ret) {
     EncodeNumber(&config_body, g_pika_conf->GetCacheNum());
   }
 
+  if (pstd::stringmatch(pattern.data(), "cache-load-thread-num", 1)) {
+    elements += 2;
+    EncodeString(&config_body, "cache-load-thread-num");
+    EncodeNumber(&config_body, g_pika_conf->cache_load_thread_num());
+  }
+
   if (pstd::stringmatch(pattern.data(), "cache-model", 1)) {
     elements += 2;
     EncodeString(&config_body, "cache-model");
@@ -2300,6 +2360,8 @@ void ConfigCmd::ConfigSet(std::shared_ptr<DB> db) {
         "max-cache-statistic-keys",
         "small-compaction-threshold",
         "small-compaction-duration-threshold",
+        "keyspace-scan-threads",
+        "expire-reaper-keys-per-second",
         "max-client-response-size",
         "db-sync-speed",
         "compact-cron",
@@ -2322,6 +2384,12 @@ void ConfigCmd::ConfigSet(std::shared_ptr<DB> db) {
         "level0-stop-writes-trigger",
         "level0-file-num-compaction-trigger",
         "arena-block-size",
+        "enable-blob-files",
+        "min-blob-size",
+        "blob-file-size",
+        "enable-blob-garbage-collection",
+        "blob-garbage-collection-age-cutoff",
+        "blob-garbage-collection-force-threshold",
         "throttle-bytes-per-second",
         "max-rsync-parallel-num",
         "cache-model",
@@ -2441,6 +2509,7 @@ void ConfigCmd::ConfigSet(std::shared_ptr<DB> db) {
       return;
     }
     g_pika_conf->SetSlotMigrate(slotmigrate);
+    g_pika_server->DBSetSlotIndexEnabled(slotmigrate);
     res_.AppendStringRaw("+OK\r\n");
   } else if (set_item == "slow_cmd_pool") {
     bool SlowCmdPool;
@@ -2494,6 +2563,21 @@ void ConfigCmd::ConfigSet(std::shared_ptr<DB> db) {
     g_pika_conf->SetSmallCompactionDurationThreshold(static_cast<int>(ival));
     g_pika_server->DBSetSmallCompactionDurationThreshold(static_cast<int>(ival));
     res_.AppendStringRaw("+OK\r\n");
+  } else if (set_item == "keyspace-scan-threads") {
+    if ((pstd::string2int(value.data(), value.size(), &ival) == 0) || ival < 1 || ival > 64) {
+      res_.AppendStringRaw("-ERR Invalid argument \'" + value + "\' for CONFIG SET 'keyspace-scan-threads'\r\n");
+      return;
+    }
+    g_pika_conf->SetKeyspaceScanThreads(static_cast<int>(ival));
+    g_pika_server->DBSetKeyspaceScanThreads(static_cast<int>(ival));
+    res_.AppendStringRaw("+OK\r\n");
+  } else if (set_item == "expire-reaper-keys-per-second") {
+    if ((pstd::string2int(value.data(), value.size(), &ival) == 0) || ival < 0 || ival > 1000000) {
+      res_.AppendStringRaw("-ERR Invalid argument \'" + value + "\' for CONFIG SET 'expire-reaper-keys-per-second'\r\n");
+      return;
+    }
+    g_pika_conf->SetExpireReaperKeysPerSecond(static_cast<int>(ival));
+    res_.AppendStringRaw("+OK\r\n");
   } else if (set_item == "disable_auto_compactions") {
     if (value != "true" && value != "false") {
       res_.AppendStringRaw("-ERR invalid disable_auto_compactions (true or false)\r\n");
@@ -2819,6 +2903,64 @@ void ConfigCmd::ConfigSet(std::shared_ptr<DB> db) {
     }
     g_pika_conf->SetArenaBlockSize(static_cast<int>(ival));
     res_.AppendStringRaw("+OK\r\n");
+  } else if (set_item == "enable-blob-files" || set_item == "enable-blob-garbage-collection") {
+    if (value != "yes" && value != "no") {
+      res_.AppendStringRaw("-ERR Invalid argument \'" + value + "\' for CONFIG SET '" + set_item + "'\r\n");
+      return;
+    }
+    bool enable = value == "yes";
+    std::string option = set_item == "enable-blob-files" ? "enable_blob_files" : "enable_blob_garbage_collection";
+    std::unordered_map<std::string, std::string> options_map{{option, enable ? "true" : "false"}};
+    storage::Status s = g_pika_server->RewriteStorageOptions(storage::OptionType::kColumnFamily, options_map);
+    if (!s.ok()) {
+      res_.AppendStringRaw("-ERR Set " + set_item + " wrong: " + s.ToString() + "\r\n");
+      return;
+    }
+    if (set_item == "enable-blob-files") {
+      g_pika_conf->SetEnableBlobFiles(enable);
+    } else {
+      g_pika_conf->SetEnableBlobGarbageCollection(enable);
+    }
+    res_.AppendStringRaw("+OK\r\n");
+  } else if (set_item == "min-blob-size" || set_item == "blob-file-size") {
+    if (pstd::string2int(value.data(), value.size(), &ival) == 0 || ival <= 0) {
+      res_.AppendStringRaw("-ERR Invalid argument \'" + value + "\' for CONFIG SET '" + set_item + "'\r\n");
+      return;
+    }
+    std::string option = set_item == "min-blob-size" ? "min_blob_size" : "blob_file_size";
+    std::unordered_map<std::string, std::string> options_map{{option, value}};
+    storage::Status s = g_pika_server->RewriteStorageOptions(storage::OptionType::kColumnFamily, options_map);
+    if (!s.ok()) {
+      res_.AppendStringRaw("-ERR Set " + set_item + " wrong: " + s.ToString() + "\r\n");
+      return;
+    }
+    if (set_item == "min-blob-size") {
+      g_pika_conf->SetMinBlobSize(ival);
+    } else {
+      g_pika_conf->SetBlobFileSize(ival);
+    }
+    res_.AppendStringRaw("+OK\r\n");
+  } else if (set_item == "blob-garbage-collection-age-cutoff" ||
+             set_item == "blob-garbage-collection-force-threshold") {
+    double dval = 0;
+    if (pstd::string2d(value.data(), value.size(), &dval) == 0 || dval <= 0 || dval > 1) {
+      res_.AppendStringRaw("-ERR Invalid argument \'" + value + "\' for CONFIG SET '" + set_item + "'\r\n");
+      return;
+    }
+    std::string option = set_item == "blob-garbage-collection-age-cutoff" ? "blob_garbage_collection_age_cutoff"
+                                                                          : "blob_garbage_collection_force_threshold";
+    std::unordered_map<std::string, std::string> options_map{{option, value}};
+    storage::Status s = g_pika_server->RewriteStorageOptions(storage::OptionType::kColumnFamily, options_map);
+    if (!s.ok()) {
+      res_.AppendStringRaw("-ERR Set " + set_item + " wrong: " + s.ToString() + "\r\n");
+      return;
+    }
+    if (set_item == "blob-garbage-collection-age-cutoff") {
+      g_pika_conf->SetBlobGarbageCollectionAgeCutoff(dval);
+    } else {
+      g_pika_conf->SetBlobGarbageCollectionForceThreshold(dval);
+    }
+    res_.AppendStringRaw("+OK\r\n");
   } else if (set_item == "throttle-bytes-per-second") {
     if ((pstd::string2int(value.data(), value.size(), &ival) == 0) || ival <= 0) {
       res_.AppendStringRaw("-ERR Invalid argument \'" + value + "\' for CONFIG SET 'throttle-bytes-per-second'\r\n");
@@ -3031,8 +3173,8 @@ void DbsizeCmd::Do() {
     if (g_pika_conf->slotmigrate()) {
       int64_t dbsize = 0;
       for (int i = 0; i < g_pika_conf->default_slot_num(); ++i) {
-        int32_t card = 0;
-        rocksdb::Status s = dbs->storage()->SCard(SlotKeyPrefix+std::to_string(i), &card);
+        int64_t card = 0;
+        rocksdb::Status s = dbs->storage()->SlotIndexCount(static_cast<uint32_t>(i), &card);
         if (s.ok() && card >= 0) {
           dbsize += card;
         } else {
@@ -3041,9 +3183,12 @@ void DbsizeCmd::Do() {
         }
       }
       res_.AppendInteger(dbsize);
+      return;
+    }
+    std::vector<storage::KeyInfo> key_infos;
+    if (!dbs->GetKeyCounters(&key_infos).ok()) {
+      key_infos = dbs->GetKeyScanInfo().key_infos;
     }
-    KeyScanInfo key_scan_info = dbs->GetKeyScanInfo();
-    std::vector<storage::KeyInfo> key_infos = key_scan_info.key_infos;
     if (key_infos.size() != (size_t)(storage::DataTypeNum)) {
       res_.SetRes(CmdRes::kErrOther, "Mismatch in expected data types and actual key info count");
       return;
@@ -3264,16 +3409,10 @@ void PKPatternMatchDelCmd::Do() {
   if(s.ok()) {
     res_.AppendInteger(count);
     s_ = rocksdb::Status::OK();
-    for (const auto& key : remove_keys_) {
-      RemSlotKey(key, db_);
-    }
   } else {
     res_.SetRes(CmdRes::kErrOther, s.ToString());
     if (count >= 0) {
       s_ = rocksdb::Status::OK();
-      for (const auto& key : remove_keys_) {
-        RemSlotKey(key, db_);
-      }
     }
   }
 }
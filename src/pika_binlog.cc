@@ -9,7 +9,10 @@
 #include <glog/logging.h>
 #include <sys/time.h>
 
+#include <algorithm>
+#include <chrono>
 #include <utility>
+#include <vector>
 
 #include "include/pika_binlog_transverter.h"
 #include "pstd/include/pstd_defer.h"
@@ -17,6 +20,9 @@
 
 using pstd::Status;
 
+// Upper bound of the items one binlog leader appends in a batch
+static const size_t kMaxBinlogBatchBytes = 4 * 1024 * 1024;
+
 std::string NewFileName(const std::string& name, const uint32_t current) {
   char buf[256];
   snprintf(buf, sizeof(buf), "%s%u", name.c_str(), current);
@@ -125,7 +131,14 @@ Binlog::Binlog(std::string  binlog_path, const int file_size)
 }
 
 Binlog::~Binlog() {
+  StopIntervalSync();
   std::lock_guard l(mutex_);
+  if (unsynced_.load()) {
+    Status s = SyncFile();
+    if (!s.ok()) {
+      LOG(WARNING) << "Binlog: sync " << filename_ << " on close failed, " << s.ToString();
+    }
+  }
   Close();
 }
 
@@ -136,6 +149,56 @@ void Binlog::Close() {
   opened_.store(false);
 }
 
+void Binlog::SetSyncPolicy(BinlogSyncPolicy policy, uint64_t sync_interval_ms) {
+  sync_policy_.store(policy);
+  sync_interval_ms_.store(sync_interval_ms);
+  if (policy == BinlogSyncPolicy::kInterval && !sync_thread_.joinable()) {
+    sync_thread_ = std::thread(&Binlog::RunIntervalSync, this);
+  }
+}
+
+void Binlog::StopIntervalSync() {
+  if (!sync_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard l(sync_mu_);
+    sync_thread_exit_ = true;
+  }
+  sync_cv_.notify_one();
+  sync_thread_.join();
+}
+
+// Wakes when the oldest unsynced batch is due and syncs it unless a Put
+// did meanwhile
+void Binlog::RunIntervalSync() {
+  std::unique_lock l(sync_mu_);
+  while (!sync_thread_exit_) {
+    uint64_t interval_us = std::max<uint64_t>(sync_interval_ms_.load(), 1) * 1000;
+    uint64_t wait_us = interval_us;
+    if (unsynced_.load()) {
+      uint64_t since_sync_us = pstd::NowMicros() - last_sync_us_.load();
+      wait_us = since_sync_us < interval_us ? interval_us - since_sync_us : 0;
+    }
+    if (wait_us > 0) {
+      sync_cv_.wait_for(l, std::chrono::microseconds(wait_us));
+      continue;
+    }
+    l.unlock();
+    {
+      std::lock_guard binlog_lock(mutex_);
+      if (opened_.load() && unsynced_.load() && sync_policy_.load() == BinlogSyncPolicy::kInterval) {
+        Status s = SyncFile();
+        if (!s.ok()) {
+          LOG(WARNING) << "Binlog: interval sync of " << filename_ << " failed, " << s.ToString();
+          binlog_io_error_.store(true);
+        }
+      }
+    }
+    l.lock();
+  }
+}
+
 void Binlog::InitLogFile() {
   assert(queue_ != nullptr);
 
@@ -171,21 +234,84 @@ Status Binlog::GetProducerStatus(uint32_t* filenum, uint64_t* pro_offset, uint32
   return Status::OK();
 }
 
-// Note: mutex lock should be held
 Status Binlog::Put(const std::string& item) {
   if (!opened_.load()) {
     return Status::Busy("Binlog is not open yet");
   }
+
+  Writer w(&item);
+  std::unique_lock l(writers_mu_);
+  writers_.push_back(&w);
+  while (!w.done && &w != writers_.front()) {
+    w.cv.wait(l);
+  }
+  if (w.done) {
+    return w.status;
+  }
+
+  // We are the leader, take what is queued, bounded so that the writers
+  // queued first are not held back by a huge batch
+  size_t batch_size = 0;
+  size_t batch_bytes = 0;
+  for (Writer* writer : writers_) {
+    if (batch_size > 0 && batch_bytes + writer->item->size() > kMaxBinlogBatchBytes) {
+      break;
+    }
+    batch_bytes += writer->item->size();
+    ++batch_size;
+  }
+  std::vector<Writer*> batch(writers_.begin(), writers_.begin() + static_cast<int64_t>(batch_size));
+  l.unlock();
+
+  {
+    std::lock_guard binlog_lock(mutex_);
+    Status s;
+    for (Writer* writer : batch) {
+      // items behind a failed one are not written, their offsets would be wrong
+      if (s.ok()) {
+        s = AppendItem(*writer->item);
+      }
+      writer->status = s;
+    }
+    {
+      std::lock_guard version_lock(version_->rwlock_);
+      version_->StableSave();
+    }
+    if (s.ok()) {
+      s = SyncBatch();
+      if (!s.ok()) {
+        for (Writer* writer : batch) {
+          writer->status = s;
+        }
+      }
+    }
+    if (!s.ok()) {
+      binlog_io_error_.store(true);
+    }
+  }
+
+  l.lock();
+  for (size_t i = 0; i < batch_size; ++i) {
+    Writer* writer = writers_.front();
+    writers_.pop_front();
+    writer->done = true;
+    if (writer != &w) {
+      writer->cv.notify_one();
+    }
+  }
+  if (!writers_.empty()) {
+    writers_.front()->cv.notify_one();
+  }
+  return w.status;
+}
+
+// Note: mutex lock should be held
+Status Binlog::AppendItem(const std::string& item) {
   uint32_t filenum = 0;
   uint32_t term = 0;
   uint64_t offset = 0;
   uint64_t logic_id = 0;
 
-  Lock();
-  DEFER {
-    Unlock();
-  };
-
   Status s = GetProducerStatus(&filenum, &offset, &term, &logic_id);
   if (!s.ok()) {
     return s;
@@ -194,9 +320,32 @@ Status Binlog::Put(const std::string& item) {
   std::string data = PikaBinlogTransverter::BinlogEncode(BinlogType::TypeFirst,
       time(nullptr), term, logic_id, filenum, offset, item, {});
 
-  s = Put(data.c_str(), static_cast<int>(data.size()));
-  if (!s.ok()) {
-    binlog_io_error_.store(true);
+  return Put(data.c_str(), static_cast<int>(data.size()));
+}
+
+// Note: mutex lock should be held
+Status Binlog::SyncBatch() {
+  switch (sync_policy_.load()) {
+    case BinlogSyncPolicy::kBatch:
+      return SyncFile();
+    case BinlogSyncPolicy::kInterval:
+      if (pstd::NowMicros() - last_sync_us_.load() < sync_interval_ms_.load() * 1000) {
+        // left to the next batch or to the sync thread
+        unsynced_.store(true);
+        return Status::OK();
+      }
+      return SyncFile();
+    default:
+      return Status::OK();
+  }
+}
+
+// Note: mutex lock should be held
+Status Binlog::SyncFile() {
+  Status s = queue_->Sync();
+  if (s.ok()) {
+    last_sync_us_.store(pstd::NowMicros());
+    unsynced_.store(false);
   }
   return s;
 }
@@ -215,6 +364,13 @@ Status Binlog::Put(const char* item, int len) {
       LOG(ERROR) << "Binlog: new " << filename_ << " " << s.ToString();
       return s;
     }
+    // SyncBatch only sees the new file
+    if (sync_policy_.load() != BinlogSyncPolicy::kNone) {
+      s = queue_->Sync();
+      if (!s.ok()) {
+        return s;
+      }
+    }
     queue_.reset();
     queue_ = std::move(queue);
     pro_num_++;
@@ -231,10 +387,10 @@ Status Binlog::Put(const char* item, int len) {
   int pro_offset;
   s = Produce(pstd::Slice(item, len), &pro_offset);
   if (s.ok()) {
+    // saved once per batch by Put
     std::lock_guard l(version_->rwlock_);
     version_->pro_offset_ = pro_offset;
     version_->logic_id_++;
-    version_->StableSave();
   }
 
   return s;
@@ -50,7 +50,6 @@ void BitSetCmd::Do() {
   s_ = db_->storage()->SetBit(key_, bit_offset_, static_cast<int32_t>(on_), &bit_val);
   if (s_.ok()) {
     res_.AppendInteger(static_cast<int>(bit_val));
-    AddSlotKey("k", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
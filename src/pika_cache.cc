@@ -26,8 +26,8 @@ PikaCache::PikaCache(int zset_cache_start_direction, int zset_cache_field_num_pe
       cache_num_(0),
       zset_cache_start_direction_(zset_cache_start_direction),
       zset_cache_field_num_per_key_(EXTEND_CACHE_SIZE(zset_cache_field_num_per_key)) {
-  cache_load_thread_ = std::make_unique<PikaCacheLoadThread> (zset_cache_start_direction_, zset_cache_field_num_per_key_);
-  cache_load_thread_->StartThread();
+  cache_loader_ = std::make_unique<PikaCacheLoader>(g_pika_conf->cache_load_thread_num(), zset_cache_start_direction_,
+                                                    zset_cache_field_num_per_key_);
 }
 
 PikaCache::~PikaCache() {
@@ -87,8 +87,11 @@ void PikaCache::Info(CacheInfo &info) {
   info.status = cache_status_;
   info.cache_num = cache_num_;
   info.used_memory = cache::RedisCache::GetUsedMemory();
-  info.async_load_keys_num = cache_load_thread_->AsyncLoadKeysNum();
-  info.waitting_load_keys_num = cache_load_thread_->WaittingLoadKeysNum();
+  info.async_load_keys_num = cache_loader_->AsyncLoadKeysNum();
+  info.waitting_load_keys_num = cache_loader_->WaittingLoadKeysNum();
+  info.dropped_load_keys_num = cache_loader_->DroppedLoadKeysNum();
+  info.skipped_load_keys_num = cache_loader_->SkippedLoadKeysNum();
+  info.load_keys_time_us = cache_loader_->LoadKeysTimeUs();
   cache::RedisCache::GetHitAndMissNum(&info.hits, &info.misses);
   for (uint32_t i = 0; i < caches_.size(); ++i) {
     std::lock_guard lm(*cache_mutexs_[i]);
@@ -1619,7 +1622,10 @@ Status PikaCache::WriteZSetToCache(std::string& key, std::vector<storage::ScoreM
 }
 
 void PikaCache::PushKeyToAsyncLoadQueue(const char key_type, std::string& key, const std::shared_ptr<DB>& db) {
-  cache_load_thread_->Push(key_type, key, db);
+  if (caches_.empty()) {
+    return;
+  }
+  cache_loader_->Push(CacheIndex(key), key_type, key, db);
 }
 
 void PikaCache::ClearHitRatio(void) {
@@ -4,6 +4,8 @@
 // of patent rights can be found in the PATENTS file in the same directory.
 #include <glog/logging.h>
 
+#include <algorithm>
+
 #include "include/pika_cache_load_thread.h"
 #include "include/pika_server.h"
 #include "include/pika_cache.h"
@@ -16,6 +18,8 @@ PikaCacheLoadThread::PikaCacheLoadThread(int zset_cache_start_direction, int zse
       , loadkeys_cond_()
       , async_load_keys_num_(0)
       , waitting_load_keys_num_(0)
+      , dropped_load_keys_num_(0)
+      , load_keys_time_us_(0)
       , zset_cache_start_direction_(zset_cache_start_direction)
       , zset_cache_field_num_per_key_(zset_cache_field_num_per_key)
 {
@@ -32,37 +36,49 @@ PikaCacheLoadThread::~PikaCacheLoadThread() {
   StopThread();
 }
 
-void PikaCacheLoadThread::Push(const char key_type, std::string& key, const std::shared_ptr<DB>& db) {
+void PikaCacheLoadThread::Push(const char key_type, const std::string& key, const std::shared_ptr<DB>& db) {
   std::unique_lock lq(loadkeys_mutex_);
-  std::unique_lock lm(loadkeys_map_mutex_);
-  if (CACHE_LOAD_QUEUE_MAX_SIZE < loadkeys_queue_.size()) {
+  if (loadkeys_set_.count(key) != 0) {
+    return;
+  }
+  if (CACHE_LOAD_QUEUE_MAX_SIZE < static_cast<int64_t>(loadkeys_queue_.size())) {
+    ++dropped_load_keys_num_;
     // 5s to print logs once
-    static uint64_t last_log_time_us = 0;
-    if (pstd::NowMicros() - last_log_time_us > 5000000) {
-      LOG(WARNING) << "PikaCacheLoadThread::Push waiting...";
-      last_log_time_us = pstd::NowMicros();
+    static std::atomic<uint64_t> last_log_time_us = 0;
+    uint64_t now_us = pstd::NowMicros();
+    if (now_us - last_log_time_us > 5000000) {
+      LOG(WARNING) << "PikaCacheLoadThread::Push queue full, dropped " << dropped_load_keys_num_ << " keys so far";
+      last_log_time_us = now_us;
     }
     return;
   }
 
-  if (loadkeys_map_.find(key) == loadkeys_map_.end()) {
-    std::tuple<const char, std::string, const std::shared_ptr<DB>> ktuple = std::make_tuple(key_type, key, db);
-    loadkeys_queue_.push_back(ktuple);
-    loadkeys_map_[key] = std::string("");
-    loadkeys_cond_.notify_all();
-  }
+  loadkeys_set_.insert(key);
+  loadkeys_queue_.emplace_back(key_type, key, db);
+  waitting_load_keys_num_ = loadkeys_queue_.size();
+  loadkeys_cond_.notify_one();
 }
 
-bool PikaCacheLoadThread::LoadKV(std::string& key, const std::shared_ptr<DB>& db) {
-  std::string value;
-  int64_t ttl = -1;
-  rocksdb::Status s = db->storage()->GetWithTTL(key, &value, &ttl);
+size_t PikaCacheLoadThread::LoadKVs(const std::vector<std::string>& keys, const std::shared_ptr<DB>& db) {
+  // writes to these keys wait until their values are in the cache
+  pstd::lock::MultiScopeRecordLock record_lock(db->LockMgr(), keys);
+  std::vector<storage::ValueStatus> vss;
+  rocksdb::Status s = db->storage()->MGetWithTTL(keys, &vss);
   if (!s.ok()) {
-    LOG(WARNING) << "load kv failed, key=" << key;
-    return false;
+    LOG(WARNING) << "load kv failed, keys=" << keys.size() << ", " << s.ToString();
+    return 0;
   }
-  db->cache()->WriteKVToCache(key, value, ttl);
-  return true;
+  size_t loaded = 0;
+  for (size_t idx = 0; idx < keys.size(); ++idx) {
+    if (!vss[idx].status.ok()) {
+      continue;
+    }
+    std::string key = keys[idx];
+    int64_t ttl_millsec = vss[idx].ttl_millsec;
+    db->cache()->WriteKVToCache(key, vss[idx].value, ttl_millsec > 0 ? ttl_millsec / 1000 : ttl_millsec);
+    ++loaded;
+  }
+  return loaded;
 }
 
 bool PikaCacheLoadThread::LoadHash(std::string& key, const std::shared_ptr<DB>& db) {
@@ -161,8 +177,6 @@ bool PikaCacheLoadThread::LoadZset(std::string& key, const std::shared_ptr<DB>&
 bool PikaCacheLoadThread::LoadKey(const char key_type, std::string& key, const std::shared_ptr<DB>& db) {
   pstd::lock::ScopeRecordLock record_lock(db->LockMgr(), key);
   switch (key_type) {
-    case 'k':
-      return LoadKV(key, db);
     case 'h':
       return LoadHash(key, db);
     case 'l':
@@ -177,15 +191,37 @@ bool PikaCacheLoadThread::LoadKey(const char key_type, std::string& key, const s
   }
 }
 
+size_t PikaCacheLoadThread::LoadKeys(std::vector<LoadKey>& load_keys) {
+  size_t loaded = 0;
+  // the strings are read in one batch per DB, the collections key by key
+  std::vector<std::pair<std::shared_ptr<DB>, std::vector<std::string>>> kv_keys;
+  for (auto& load_key : load_keys) {
+    const std::shared_ptr<DB>& db = std::get<2>(load_key);
+    if (std::get<0>(load_key) != PIKA_KEY_TYPE_KV) {
+      loaded += LoadKey(std::get<0>(load_key), std::get<1>(load_key), db) ? 1 : 0;
+      continue;
+    }
+    auto iter = std::find_if(kv_keys.begin(), kv_keys.end(), [&db](const auto& keys) { return keys.first == db; });
+    if (iter == kv_keys.end()) {
+      kv_keys.emplace_back(db, std::vector<std::string>());
+      iter = kv_keys.end() - 1;
+    }
+    iter->second.push_back(std::get<1>(load_key));
+  }
+  for (const auto& keys : kv_keys) {
+    loaded += LoadKVs(keys.second, keys.first);
+  }
+  return loaded;
+}
+
 void *PikaCacheLoadThread::ThreadMain() {
   LOG(INFO) << "PikaCacheLoadThread::ThreadMain Start";
 
   while (!should_exit_) {
-    std::deque<std::tuple<const char, std::string, const std::shared_ptr<DB>>> load_keys;
+    std::vector<LoadKey> load_keys;
     {
       std::unique_lock lq(loadkeys_mutex_);
-      waitting_load_keys_num_ = loadkeys_queue_.size();
-      while (!should_exit_ && loadkeys_queue_.size() <= 0) {
+      while (!should_exit_ && loadkeys_queue_.empty()) {
         loadkeys_cond_.wait(lq);
       }
 
@@ -193,22 +229,75 @@ void *PikaCacheLoadThread::ThreadMain() {
         return nullptr;
       }
 
-      for (int i = 0; i < CACHE_LOAD_NUM_ONE_TIME; ++i) {
-        if (!loadkeys_queue_.empty()) {
-          load_keys.push_back(loadkeys_queue_.front());
-          loadkeys_queue_.pop_front();
-        }
+      while (!loadkeys_queue_.empty() && static_cast<int64_t>(load_keys.size()) < CACHE_LOAD_NUM_ONE_TIME) {
+        load_keys.push_back(std::move(loadkeys_queue_.front()));
+        loadkeys_queue_.pop_front();
       }
+      waitting_load_keys_num_ = loadkeys_queue_.size();
     }
-    for (auto & load_key : load_keys) {
-      if (LoadKey(std::get<0>(load_key), std::get<1>(load_key), std::get<2>(load_key))) {
-        ++async_load_keys_num_;
-      }
 
-      std::unique_lock lm(loadkeys_map_mutex_);
-      loadkeys_map_.erase(std::get<1>(load_key));
+    uint64_t start_us = pstd::NowMicros();
+    async_load_keys_num_ += LoadKeys(load_keys);
+    load_keys_time_us_ += pstd::NowMicros() - start_us;
+
+    std::unique_lock lq(loadkeys_mutex_);
+    for (const auto& load_key : load_keys) {
+      loadkeys_set_.erase(std::get<1>(load_key));
     }
   }
 
   return nullptr;
 }
+
+PikaCacheLoader::PikaCacheLoader(int thread_num, int zset_cache_start_direction, int zset_cache_field_num_per_key)
+    : skipped_load_keys_num_(0) {
+  for (int i = 0; i < std::max(thread_num, 1); ++i) {
+    threads_.push_back(
+        std::make_unique<PikaCacheLoadThread>(zset_cache_start_direction, zset_cache_field_num_per_key));
+    threads_.back()->StartThread();
+  }
+}
+
+PikaCacheLoader::~PikaCacheLoader() = default;
+
+void PikaCacheLoader::Push(uint32_t cache_index, const char key_type, const std::string& key,
+                           const std::shared_ptr<DB>& db) {
+  // such keys are never kept in the cache, don't read them
+  if (static_cast<int64_t>(key.size()) > g_pika_conf->max_key_size_in_cache()) {
+    ++skipped_load_keys_num_;
+    return;
+  }
+  threads_[cache_index % threads_.size()]->Push(key_type, key, db);
+}
+
+uint64_t PikaCacheLoader::AsyncLoadKeysNum(void) {
+  uint64_t num = 0;
+  for (const auto& thread : threads_) {
+    num += thread->AsyncLoadKeysNum();
+  }
+  return num;
+}
+
+uint32_t PikaCacheLoader::WaittingLoadKeysNum(void) {
+  uint32_t num = 0;
+  for (const auto& thread : threads_) {
+    num += thread->WaittingLoadKeysNum();
+  }
+  return num;
+}
+
+uint64_t PikaCacheLoader::DroppedLoadKeysNum(void) {
+  uint64_t num = 0;
+  for (const auto& thread : threads_) {
+    num += thread->DroppedLoadKeysNum();
+  }
+  return num;
+}
+
+uint64_t PikaCacheLoader::LoadKeysTimeUs(void) {
+  uint64_t time_us = 0;
+  for (const auto& thread : threads_) {
+    time_us += thread->LoadKeysTimeUs();
+  }
+  return time_us;
+}
@@ -131,7 +131,7 @@ std::shared_ptr<Cmd> PikaClientConn::DoCmd(const PikaCmdArgsType& argv, const st
     ProcessMonitor(argv);
   }
 
-  g_pika_server->UpdateQueryNumAndExecCountDB(current_db_, opt, c_ptr->is_write());
+  g_pika_server->UpdateQueryNumAndExecCountDB(current_db_, c_ptr->GetCmdId(), c_ptr->is_write());
 
   // PubSub connection
   // (P)SubscribeCmd will set is_pubsub_
@@ -206,9 +206,7 @@ std::shared_ptr<Cmd> PikaClientConn::DoCmd(const PikaCmdArgsType& argv, const st
   // Process Command
   c_ptr->Execute();
   time_stat_->process_done_ts_ = pstd::NowMicros();
-  auto cmdstat_map = g_pika_cmd_table_manager->GetCommandStatMap();
-  (*cmdstat_map)[opt].cmd_count.fetch_add(1);
-  (*cmdstat_map)[opt].cmd_time_consuming.fetch_add(time_stat_->total_time());
+  g_pika_server->UpdateCmdTimeConsuming(c_ptr->GetCmdId(), time_stat_->total_time());
 
   if (g_pika_conf->slowlog_slower_than() >= 0) {
     ProcessSlowlog(argv, c_ptr->GetDoDuration());
@@ -258,15 +256,31 @@ void PikaClientConn::ProcessMonitor(const PikaCmdArgsType& argv) {
   g_pika_server->AddMonitorMessage(monitor_message);
 }
 
-bool PikaClientConn::IsInterceptedByRTC(std::string& opt) {
-  //currently we only Intercept: Get, HGet
-  if (opt == kCmdNameGet && g_pika_conf->GetCacheString()) {
-    return true;
+bool PikaClientConn::IsInterceptedByRTC(const std::shared_ptr<Cmd>& c_ptr) {
+  // only reads that know how to answer from the cache, of a type the cache holds
+  if (!c_ptr->is_read() || !c_ptr->IsNeedReadCache()) {
+    return false;
+  }
+  if (c_ptr->hasFlag(kCmdFlagsKv)) {
+    return g_pika_conf->GetCacheString() != 0;
+  }
+  if (c_ptr->hasFlag(kCmdFlagsHash)) {
+    return g_pika_conf->GetCacheHash() != 0;
+  }
+  if (c_ptr->hasFlag(kCmdFlagsList)) {
+    return g_pika_conf->GetCacheList() != 0;
+  }
+  if (c_ptr->hasFlag(kCmdFlagsSet)) {
+    return g_pika_conf->GetCacheSet() != 0;
+  }
+  if (c_ptr->hasFlag(kCmdFlagsZset)) {
+    return g_pika_conf->GetCacheZset() != 0;
   }
-  if (opt == kCmdNameHGet && g_pika_conf->GetCacheHash()) {
-    return true;
+  if (c_ptr->hasFlag(kCmdFlagsBit)) {
+    return g_pika_conf->GetCacheBit() != 0;
   }
-  return false;
+  // keyspace reads like EXISTS and TTL, a key of a type not cached just misses
+  return c_ptr->hasFlag(kCmdFlagsOperateKey);
 }
 
 void PikaClientConn::ProcessRedisCmds(const std::vector<net::RedisCmdArgsType>& argvs, bool async,
@@ -278,32 +292,39 @@ void PikaClientConn::ProcessRedisCmds(const std::vector<net::RedisCmdArgsType>&
     arg->redis_cmds = argvs;
     time_stat_->enqueue_ts_ = time_stat_->before_queue_ts_ = pstd::NowMicros();
     arg->conn_ptr = std::dynamic_pointer_cast<PikaClientConn>(shared_from_this());
+
+    if (g_pika_conf->rtc_cache_read_enabled() &&
+        PIKA_CACHE_NONE != g_pika_conf->cache_mode() &&
+        !IsInTxn() && !IsPubSub() && !g_pika_server->HasMonitorClients() &&
+        !g_pika_server->leader_protected_mode() && g_pika_server->IsDBExist(current_db_)) {
+      // answer the leading cache hits of the batch in place, the commands
+      // from the first one that can't be answered on go to the pool in order
+      bool cache_miss = false;
+      size_t served = ReadCmdsInCache(argvs, &cache_miss);
+      if (served == argvs.size()) {
+        delete arg;
+        return;
+      }
+      arg->redis_cmds.erase(arg->redis_cmds.begin(), arg->redis_cmds.begin() + static_cast<int64_t>(served));
+      if (cache_miss) {
+        arg->cache_miss_in_rtc_ = true;
+        g_pika_server->IncrRtcCacheFallbacks();
+      }
+      time_stat_->before_queue_ts_ = pstd::NowMicros();
+    }
+
     /**
      * If using the pipeline method to transmit batch commands to Pika, it is unable to
      * correctly distinguish between fast and slow commands.
      * However, if using the pipeline method for Codis, it can correctly distinguish between
      * fast and slow commands, but it cannot guarantee sequential execution.
      */
-    std::string opt = argvs[0][0];
+    std::string opt = arg->redis_cmds[0][0];
     pstd::StringToLower(opt);
     bool is_slow_cmd = g_pika_conf->is_slow_cmd(opt);
     bool is_admin_cmd = g_pika_conf->is_admin_cmd(opt);
 
-    //we don't intercept pipeline batch (argvs.size() > 1)
-    if (g_pika_conf->rtc_cache_read_enabled() &&
-        argvs.size() == 1 && IsInterceptedByRTC(opt) &&
-        PIKA_CACHE_NONE != g_pika_conf->cache_mode() &&
-        !IsInTxn()) {
-      // read in cache
-      if (ReadCmdInCache(argvs[0], opt)) {
-        delete arg;
-        return;
-      }
-      arg->cache_miss_in_rtc_ = true;
-      time_stat_->before_queue_ts_ = pstd::NowMicros();
-    }
-
-    g_pika_server->ScheduleClientPool(&DoBackgroundTask, arg, is_slow_cmd, is_admin_cmd);
+    g_pika_server->ScheduleClientPool(&DoBackgroundTask, arg, is_slow_cmd, is_admin_cmd, fd());
     return;
   }
   BatchExecRedisCmd(argvs, false);
@@ -329,19 +350,41 @@ void PikaClientConn::DoBackgroundTask(void* arg) {
 
 void PikaClientConn::BatchExecRedisCmd(const std::vector<net::RedisCmdArgsType>& argvs, bool cache_miss_in_rtc) {
   resp_num.store(static_cast<int32_t>(argvs.size()));
-  for (const auto& argv : argvs) {
+  for (size_t i = 0; i < argvs.size(); ++i) {
     std::shared_ptr<std::string> resp_ptr = std::make_shared<std::string>();
     resp_array.push_back(resp_ptr);
-    ExecRedisCmd(argv, resp_ptr, cache_miss_in_rtc);
+    // only the first command missed the cache in rtc, the rest never read it
+    ExecRedisCmd(argvs[i], resp_ptr, cache_miss_in_rtc && i == 0);
   }
   time_stat_->process_done_ts_ = pstd::NowMicros();
   TryWriteResp();
 }
 
-bool PikaClientConn::ReadCmdInCache(const net::RedisCmdArgsType& argv, const std::string& opt) {
-  resp_num.store(1);
+size_t PikaClientConn::ReadCmdsInCache(const std::vector<net::RedisCmdArgsType>& argvs, bool* cache_miss) {
+  size_t served = 0;
+  std::string resp;
+  while (served < argvs.size() && ReadCmdInCache(argvs[served], &resp, cache_miss)) {
+    resp_array.emplace_back(std::make_shared<std::string>(std::move(resp)));
+    ++served;
+  }
+  if (served > 0) {
+    g_pika_server->IncrRtcCacheHits(served);
+  }
+  if (served == argvs.size()) {
+    resp_num.store(0);
+    TryWriteResp();
+  }
+  return served;
+}
+
+bool PikaClientConn::ReadCmdInCache(const net::RedisCmdArgsType& argv, std::string* resp, bool* cache_miss) {
+  if (argv.empty()) {
+    return false;
+  }
+  std::string opt = argv[0];
+  pstd::StringToLower(opt);
   std::shared_ptr<Cmd> c_ptr = g_pika_cmd_table_manager->GetCmd(opt);
-  if (!c_ptr) {
+  if (!c_ptr || !IsInterceptedByRTC(c_ptr)) {
     return false;
   }
   // Check authed
@@ -350,19 +393,20 @@ bool PikaClientConn::ReadCmdInCache(const net::RedisCmdArgsType& argv, const std
       return false;
     }
   }
-  // Initial
+  // Initial, the pool replies the argument errors
   c_ptr->Initial(argv, current_db_);
-  // dont store cmd with too large key(only Get/HGet cmd can reach here)
+  if (!c_ptr->res().ok()) {
+    return false;
+  }
+  // dont store cmd with too large key
   // the cmd with large key should be non-exist in cache, except for pre-stored
   if (c_ptr->IsTooLargeKey(g_pika_conf->max_key_size_in_cache())) {
-    resp_num--;
     return false;
   }
   //acl check
   int8_t subCmdIndex = -1;
   std::string errKey;
   auto checkRes = user_->CheckUserPermission(c_ptr, argv, subCmdIndex, &errKey);
-  std::string object;
   if (checkRes == AclDeniedCmd::CMD ||
       checkRes == AclDeniedCmd::KEY ||
       checkRes == AclDeniedCmd::CHANNEL ||
@@ -372,18 +416,20 @@ bool PikaClientConn::ReadCmdInCache(const net::RedisCmdArgsType& argv, const std
     //acl check failed
     return false;
   }
-  //only read command(Get, HGet) will reach here, no need of record lock
-  bool read_status = c_ptr->DoReadCommandInCache();
-  auto cmdstat_map = g_pika_cmd_table_manager->GetCommandStatMap();
-  resp_num--;
-  if (read_status) {
-    time_stat_->process_done_ts_ = pstd::NowMicros();
-    (*cmdstat_map)[argv[0]].cmd_count.fetch_add(1);
-    (*cmdstat_map)[argv[0]].cmd_time_consuming.fetch_add(time_stat_->total_time());
-    resp_array.emplace_back(std::make_shared<std::string>(std::move(c_ptr->res().message())));
-    TryWriteResp();
+  //only read commands reach here, no need of record lock
+  if (!c_ptr->DoReadCommandInCache()) {
+    *cache_miss = true;
+    return false;
   }
-  return read_status;
+  // errors of the cache are answered by the db
+  if (!c_ptr->res().ok()) {
+    return false;
+  }
+  g_pika_server->UpdateQueryNumAndExecCountDB(current_db_, c_ptr->GetCmdId(), false);
+  time_stat_->process_done_ts_ = pstd::NowMicros();
+  g_pika_server->UpdateCmdTimeConsuming(c_ptr->GetCmdId(), time_stat_->total_time());
+  *resp = std::move(c_ptr->res().message());
+  return true;
 }
 
 void PikaClientConn::TryWriteResp() {
@@ -29,6 +29,10 @@ void PikaClientProcessor::Stop() {
 
 void PikaClientProcessor::SchedulePool(net::TaskFunc func, void* arg) { pool_->Schedule(func, arg); }
 
+void PikaClientProcessor::SchedulePool(net::TaskFunc func, void* arg, uint64_t affinity) {
+  pool_->Schedule(func, arg, affinity);
+}
+
 size_t PikaClientProcessor::ThreadPoolCurQueueSize() {
   size_t cur_size = 0;
   if (pool_) {
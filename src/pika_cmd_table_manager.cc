@@ -7,6 +7,7 @@
 
 #include <sys/syscall.h>
 #include <unistd.h>
+#include <vector>
 
 #include "include/acl.h"
 #include "include/pika_conf.h"
@@ -14,6 +15,97 @@
 
 extern std::unique_ptr<PikaConf> g_pika_conf;
 
+namespace {
+
+// Commands released to a full pool are freed
+const size_t kCmdPoolSizePerThread = 16;
+
+/*
+ * Cmd objects released on a thread are kept there per command id and handed
+ * out again by NewCommand on that thread instead of cloning the command
+ * table entry. A command may be released on another thread than the one it
+ * was taken from, it then simply moves to that thread's pool.
+ */
+class CmdPool {
+ public:
+  ~CmdPool() {
+    for (auto& slot : slots_) {
+      for (Cmd* cmd : slot.free_cmds) {
+        delete cmd;
+      }
+    }
+  }
+
+  Cmd* Get(const Cmd* prototype) {
+    uint32_t cmd_id = prototype->GetCmdId();
+    if (cmd_id >= slots_.size() || slots_[cmd_id].prototype != prototype || slots_[cmd_id].free_cmds.empty()) {
+      return nullptr;
+    }
+    Cmd* cmd = slots_[cmd_id].free_cmds.back();
+    slots_[cmd_id].free_cmds.pop_back();
+    return cmd;
+  }
+
+  // prototype is only compared, the command table may be gone already
+  void Put(const Cmd* prototype, Cmd* cmd) {
+    uint32_t cmd_id = cmd->GetCmdId();
+    if (cmd_id >= slots_.size()) {
+      slots_.resize(cmd_id + 1);
+    }
+    Slot& slot = slots_[cmd_id];
+    // ids are only unique after InitCmdTable, never mix two commands
+    if (slot.prototype != prototype) {
+      if (!slot.free_cmds.empty()) {
+        delete cmd;
+        return;
+      }
+      slot.prototype = prototype;
+    }
+    if (slot.free_cmds.size() >= kCmdPoolSizePerThread) {
+      delete cmd;
+      return;
+    }
+    slot.free_cmds.push_back(cmd);
+  }
+
+ private:
+  struct Slot {
+    const Cmd* prototype = nullptr;
+    std::vector<Cmd*> free_cmds;
+  };
+  std::vector<Slot> slots_;
+};
+
+thread_local bool cmd_pool_destroyed = false;
+
+// Commands released while the thread exits, after its pool is gone, are freed
+CmdPool* ThreadCmdPool() {
+  struct CmdPoolHolder {
+    ~CmdPoolHolder() { cmd_pool_destroyed = true; }
+    CmdPool pool;
+  };
+  if (cmd_pool_destroyed) {
+    return nullptr;
+  }
+  thread_local CmdPoolHolder holder;
+  return &holder.pool;
+}
+
+struct CmdPoolDeleter {
+  const Cmd* prototype;
+  void operator()(Cmd* cmd) const {
+    CmdPool* pool = ThreadCmdPool();
+    if (pool == nullptr) {
+      delete cmd;
+      return;
+    }
+    cmd->ResetForReuse();
+    pool->Put(prototype, cmd);
+  }
+};
+
+}  // namespace
+
 PikaCmdTableManager::PikaCmdTableManager() {
   cmds_ = std::make_unique<CmdTable>();
   cmds_->reserve(300);
@@ -44,9 +136,7 @@ void PikaCmdTableManager::InitCmdTable(void) {
     }
   }
 
-  CommandStatistics statistics;
   for (auto& iter : *cmds_) {
-    cmdstat_map_.emplace(iter.first, statistics);
     iter.second->SetCmdId(cmdId_++);
   }
 }
@@ -63,10 +153,6 @@ void PikaCmdTableManager::RenameCommand(const std::string before, const std::str
   }
 }
 
-std::unordered_map<std::string, CommandStatistics>* PikaCmdTableManager::GetCommandStatMap() {
-  return &cmdstat_map_;
-}
-
 std::shared_ptr<Cmd> PikaCmdTableManager::GetCmd(const std::string& opt) {
   const std::string& internal_opt = opt;
   return NewCommand(internal_opt);
@@ -74,10 +160,12 @@ std::shared_ptr<Cmd> PikaCmdTableManager::GetCmd(const std::string& opt) {
 
 std::shared_ptr<Cmd> PikaCmdTableManager::NewCommand(const std::string& opt) {
   Cmd* cmd = GetCmdFromDB(opt, *cmds_);
-  if (cmd) {
-    return std::shared_ptr<Cmd>(cmd->Clone());
+  if (!cmd) {
+    return nullptr;
   }
-  return nullptr;
+  CmdPool* pool = ThreadCmdPool();
+  Cmd* pooled_cmd = pool ? pool->Get(cmd) : nullptr;
+  return std::shared_ptr<Cmd>(pooled_cmd ? pooled_cmd : cmd->Clone(), CmdPoolDeleter{cmd});
 }
 
 CmdTable* PikaCmdTableManager::GetCmdTable() { return cmds_.get(); }
@@ -840,6 +840,28 @@ void Cmd::Initial(const PikaCmdArgsType& argv, const std::string& db_name) {
   DoInitial();
 };
 
+void Cmd::ResetForReuse() {
+  // a pooled command should not pin a huge request or reply
+  static const size_t kMaxKeptBufferSize = 64 * 1024;
+  size_t argv_size = 0;
+  for (const auto& arg : argv_) {
+    argv_size += arg.capacity();
+  }
+  if (argv_size > kMaxKeptBufferSize) {
+    PikaCmdArgsType().swap(argv_);
+  }
+  res_.Reset(kMaxKeptBufferSize);
+  s_ = rocksdb::Status::OK();
+  db_.reset();
+  sync_db_.reset();
+  conn_.reset();
+  resp_.reset();
+  stage_ = kNone;
+  do_duration_ = 0;
+  cache_missed_in_rtc_ = false;
+  Clear();
+}
+
 std::vector<std::string> Cmd::current_key() const { return {""}; }
 
 void Cmd::Execute() {
@@ -205,6 +205,14 @@ int PikaConf::Load() {
     sync_thread_num_ = 24;
   }
 
+  GetConfInt("slave-apply-batch-size", &slave_apply_batch_size_);
+  if (slave_apply_batch_size_ <= 0) {
+    slave_apply_batch_size_ = 64;
+  }
+  if (slave_apply_batch_size_ > 1024) {
+    slave_apply_batch_size_ = 1024;
+  }
+
   std::string instance_mode;
   GetConfStr("instance-mode", &instance_mode);
   classic_mode_.store(instance_mode.empty() || !strcasecmp(instance_mode.data(), "classic"));
@@ -457,6 +465,54 @@ int PikaConf::Load() {
     small_compaction_duration_threshold_ = 1000000;
   }
 
+  zset_rank_index_threshold_ = 0;
+  GetConfInt("zset-rank-index-threshold", &zset_rank_index_threshold_);
+  if (zset_rank_index_threshold_ < 0) {
+    zset_rank_index_threshold_ = 0;
+  }
+
+  sets_sample_cache_size_ = 32 << 20;
+  GetConfInt64("sets-sample-cache-size", &sets_sample_cache_size_);
+  if (sets_sample_cache_size_ < 0) {
+    sets_sample_cache_size_ = 0;
+  }
+
+  list_chunk_max_elements_ = 0;
+  GetConfInt("list-chunk-max-elements", &list_chunk_max_elements_);
+  if (list_chunk_max_elements_ < 0) {
+    list_chunk_max_elements_ = 0;
+  } else if (list_chunk_max_elements_ > 65536) {
+    list_chunk_max_elements_ = 65536;
+  }
+
+  inline_collection_max_entries_ = 0;
+  GetConfInt("inline-collection-max-entries", &inline_collection_max_entries_);
+  if (inline_collection_max_entries_ < 0) {
+    inline_collection_max_entries_ = 0;
+  } else if (inline_collection_max_entries_ > 512) {
+    inline_collection_max_entries_ = 512;
+  }
+
+  keyspace_scan_threads_ = 4;
+  GetConfInt("keyspace-scan-threads", &keyspace_scan_threads_);
+  if (keyspace_scan_threads_ < 1) {
+    keyspace_scan_threads_ = 1;
+  } else if (keyspace_scan_threads_ > 64) {
+    keyspace_scan_threads_ = 64;
+  }
+
+  std::string expire_index;
+  GetConfStr("expire-index", &expire_index);
+  expire_index_ = expire_index == "yes";
+
+  expire_reaper_keys_per_second_ = 1000;
+  GetConfInt("expire-reaper-keys-per-second", &expire_reaper_keys_per_second_);
+  if (expire_reaper_keys_per_second_ < 0) {
+    expire_reaper_keys_per_second_ = 0;
+  } else if (expire_reaper_keys_per_second_ > 1000000) {
+    expire_reaper_keys_per_second_ = 1000000;
+  }
+
   // max-background-flushes and max-background-compactions should both be -1 or both not
   GetConfInt("max-background-flushes", &max_background_flushes_);
   if (max_background_flushes_ <= 0 && max_background_flushes_ != -1) {
@@ -558,6 +614,14 @@ int PikaConf::Load() {
   if (binlog_file_size_ < 1024 || static_cast<int64_t>(binlog_file_size_) > (1024LL * 1024 * 1024)) {
     binlog_file_size_ = 100 * 1024 * 1024;  // 100M
   }
+  GetConfStr("binlog-sync-policy", &binlog_sync_policy_);
+  if (binlog_sync_policy_ != "batch" && binlog_sync_policy_ != "interval") {
+    binlog_sync_policy_ = "none";
+  }
+  GetConfInt("binlog-sync-interval-ms", &binlog_sync_interval_ms_);
+  if (binlog_sync_interval_ms_ <= 0) {
+    binlog_sync_interval_ms_ = 1000;
+  }
   GetConfStr("pidfile", &pidfile_);
 
   // db sync
@@ -618,6 +682,10 @@ int PikaConf::Load() {
   GetConfInt("cache-num", &cache_num);
   cache_num_ = (0 >= cache_num || 48 < cache_num) ? 16 : cache_num;
 
+  int cache_load_thread_num = 2;
+  GetConfInt("cache-load-thread-num", &cache_load_thread_num);
+  cache_load_thread_num_ = (0 >= cache_load_thread_num || 16 < cache_load_thread_num) ? 2 : cache_load_thread_num;
+
   int cache_mode = 0;
   GetConfInt("cache-model", &cache_mode);
   cache_mode_ = (PIKA_CACHE_NONE > cache_mode || PIKA_CACHE_READ < cache_mode) ? PIKA_CACHE_NONE : cache_mode;
@@ -704,7 +772,7 @@ int PikaConf::Load() {
   if (blob_garbage_collection_force_threshold_ <= 0) {
     blob_garbage_collection_force_threshold_ = 1.0;
   }
-  GetConfInt64("blob-cache", &block_cache_);
+  GetConfInt64("blob-cache", &blob_cache_);
   GetConfInt64("blob-num-shard-bits", &blob_num_shard_bits_);
 
   // throttle-bytes-per-second
@@ -801,6 +869,8 @@ int PikaConf::ConfigRewrite() {
   SetConfInt("max-cache-statistic-keys", max_cache_statistic_keys_);
   SetConfInt("small-compaction-threshold", small_compaction_threshold_);
   SetConfInt("small-compaction-duration-threshold", small_compaction_duration_threshold_);
+  SetConfInt("keyspace-scan-threads", keyspace_scan_threads_);
+  SetConfInt("expire-reaper-keys-per-second", expire_reaper_keys_per_second_);
   SetConfInt("max-client-response-size", static_cast<int32_t>(max_client_response_size_));
   SetConfInt("db-sync-speed", db_sync_speed_);
   SetConfStr("compact-cron", compact_cron_);
@@ -833,6 +903,12 @@ int PikaConf::ConfigRewrite() {
   SetConfInt("level0-slowdown-writes-trigger", level0_slowdown_writes_trigger_);
   SetConfInt("level0-file-num-compaction-trigger", level0_file_num_compaction_trigger_);
   SetConfInt64("arena-block-size", arena_block_size_);
+  SetConfStr("enable-blob-files", enable_blob_files_ ? "yes" : "no");
+  SetConfInt64("min-blob-size", min_blob_size_);
+  SetConfInt64("blob-file-size", blob_file_size_);
+  SetConfStr("enable-blob-garbage-collection", enable_blob_garbage_collection_ ? "yes" : "no");
+  SetConfDouble("blob-garbage-collection-age-cutoff", blob_garbage_collection_age_cutoff_);
+  SetConfDouble("blob-garbage-collection-force-threshold", blob_garbage_collection_force_threshold_);
   SetConfStr("slotmigrate", slotmigrate_.load() ? "yes" : "no");
   SetConfInt64("slotmigrate-thread-num", slotmigrate_thread_num_);
   SetConfInt64("thread-migrate-keys-num", thread_migrate_keys_num_);
@@ -843,6 +919,7 @@ int PikaConf::ConfigRewrite() {
   // cache config
   SetConfStr("cache-index-and-filter-blocks", cache_index_and_filter_blocks_ ? "yes" : "no");
   SetConfInt("cache-model", cache_mode_);
+  SetConfInt("cache-load-thread-num", cache_load_thread_num_);
   SetConfInt("zset-cache-start-direction", zset_cache_start_direction_);
   SetConfInt("zset_cache_field_num_per_key", zset_cache_field_num_per_key_);
 
@@ -316,13 +316,6 @@ Status ConsensusCoordinator::Reset(const LogOffset& offset) {
 }
 
 Status ConsensusCoordinator::ProposeLog(const std::shared_ptr<Cmd>& cmd_ptr) {
-  std::vector<std::string> keys = cmd_ptr->current_key();
-  // slotkey shouldn't add binlog
-  if (cmd_ptr->name() == kCmdNameSAdd && !keys.empty() &&
-      (keys[0].compare(0, SlotKeyPrefix.length(), SlotKeyPrefix) == 0 || keys[0].compare(0, SlotTagPrefix.length(), SlotTagPrefix) == 0)) {
-    return Status::OK();
-  }
-
   // make sure stable log and mem log consistent
   Status s = InternalAppendLog(cmd_ptr);
   if (!s.ok()) {
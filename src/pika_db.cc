@@ -9,9 +9,11 @@
 #include "include/pika_db.h"
 
 #include "include/pika_cmd_table_manager.h"
+#include "include/pika_kv.h"
 #include "include/pika_rm.h"
 #include "include/pika_server.h"
 #include "mutex_impl.h"
+#include "pstd/include/scope_record_lock.h"
 
 using pstd::Status;
 extern PikaServer* g_pika_server;
@@ -156,6 +158,63 @@ Status DB::GetKeyNum(std::vector<storage::KeyInfo>* key_info) {
   return Status::OK();
 }
 
+Status DB::GetKeyCounters(std::vector<storage::KeyInfo>* key_infos) {
+  std::shared_lock l(dbs_rw_);
+  rocksdb::Status s = storage_->GetKeyCounters(key_infos);
+  if (!s.ok()) {
+    return Status::Incomplete(s.ToString());
+  }
+  return Status::OK();
+}
+
+Status DB::ReapExpiredKeys(int64_t count, int64_t* reaped_num) {
+  *reaped_num = 0;
+  std::vector<std::string> keys;
+  int64_t lag_ms = 0;
+  rocksdb::Status s;
+  {
+    std::shared_lock l(dbs_rw_);
+    s = storage_->ScanExpiredKeys(count, &keys, &lag_ms);
+  }
+  if (!s.ok()) {
+    return Status::Corruption(s.ToString());
+  }
+  expire_reaper_lag_ms_ = lag_ms;
+  if (keys.empty()) {
+    return Status::OK();
+  }
+
+  // like a DEL command, writers of these keys wait until the DEL is in the binlog
+  pstd::lock::MultiScopeRecordLock record_lock(lock_mgr_, keys);
+  std::shared_lock l(dbs_rw_);
+  std::vector<std::string> reaped;
+  s = storage_->ReapExpiredKeys(keys, &reaped);
+  if (!s.ok()) {
+    return Status::Corruption(s.ToString());
+  }
+  if (reaped.empty()) {
+    return Status::OK();
+  }
+  *reaped_num = static_cast<int64_t>(reaped.size());
+  if (PIKA_CACHE_NONE != g_pika_conf->cache_mode() && cache_->CacheStatus() == PIKA_CACHE_STATUS_OK) {
+    cache_->Del(reaped);
+  }
+  if (!g_pika_conf->write_binlog()) {
+    return Status::OK();
+  }
+  std::shared_ptr<SyncMasterDB> sync_db = g_pika_rm->GetSyncMasterDBByName(DBInfo(db_name_));
+  if (!sync_db) {
+    return Status::NotFound(db_name_ + " sync db not found");
+  }
+  PikaCmdArgsType del_args;
+  del_args.reserve(reaped.size() + 1);
+  del_args.emplace_back(kCmdNameDel);
+  del_args.insert(del_args.end(), reaped.begin(), reaped.end());
+  auto del_cmd = std::make_shared<DelCmd>(kCmdNameDel, -2, kCmdFlagsWrite | kCmdFlagsOperateKey);
+  del_cmd->Initial(del_args, db_name_);
+  return sync_db->ConsensusProposeLog(del_cmd);
+}
+
 void DB::StopKeyScan() {
   std::shared_lock rwl(dbs_rw_);
   std::lock_guard ml(key_scan_protector_);
@@ -590,6 +649,8 @@ void DB::UpdateCacheInfo(CacheInfo& cache_info) {
   cache_info_.keys_num = cache_info.keys_num;
   cache_info_.used_memory = cache_info.used_memory;
   cache_info_.waitting_load_keys_num = cache_info.waitting_load_keys_num;
+  cache_info_.dropped_load_keys_num = cache_info.dropped_load_keys_num;
+  cache_info_.skipped_load_keys_num = cache_info.skipped_load_keys_num;
   cache_usage_ = cache_info.used_memory;
 
   uint64_t all_cmds = cache_info.hits + cache_info.misses;
@@ -607,11 +668,14 @@ void DB::UpdateCacheInfo(CacheInfo& cache_info) {
 
   uint64_t delta_load_keys = cache_info.async_load_keys_num - cache_info_.last_load_keys_num;
   cache_info_.load_keys_per_sec = delta_load_keys * 1000000 / delta_time;
+  uint64_t delta_load_time_us = cache_info.load_keys_time_us - cache_info_.last_load_keys_time_us;
+  cache_info_.load_key_latency_us = (0 >= delta_load_keys) ? 0 : delta_load_time_us / delta_load_keys;
 
   cache_info_.hits = cache_info.hits;
   cache_info_.misses = cache_info.misses;
   cache_info_.last_time_us = cur_time_us;
   cache_info_.last_load_keys_num = cache_info.async_load_keys_num;
+  cache_info_.last_load_keys_time_us = cache_info.load_keys_time_us;
 }
 
 void DB::ResetDisplayCacheInfo(int status) {
@@ -628,5 +692,8 @@ void DB::ResetDisplayCacheInfo(int status) {
   cache_info_.hitratio_all = 0.0;
   cache_info_.load_keys_per_sec = 0;
   cache_info_.waitting_load_keys_num = 0;
+  cache_info_.dropped_load_keys_num = 0;
+  cache_info_.skipped_load_keys_num = 0;
+  cache_info_.load_key_latency_us = 0;
   cache_usage_ = 0;
 }
@@ -0,0 +1,44 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "include/pika_expire_reaper.h"
+
+#include <chrono>
+#include <thread>
+
+#include "include/pika_conf.h"
+#include "include/pika_define.h"
+#include "include/pika_server.h"
+
+extern PikaServer* g_pika_server;
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// the rate is spread over the rounds of a second
+const int64_t kReapRoundsPerSecond = 10;
+
+}  // namespace
+
+PikaExpireReaper::~PikaExpireReaper() {
+  StopThread();
+  LOG(INFO) << "PikaExpireReaper thread " << thread_id() << " exit!!!";
+}
+
+void* PikaExpireReaper::ThreadMain() {
+  int64_t round = 0;
+  while (!should_stop()) {
+    int64_t rate = g_pika_conf->expire_reaper_keys_per_second();
+    // rate / 10 per round, the remainder goes to the first rounds
+    int64_t count = rate * (round + 1) / kReapRoundsPerSecond - rate * round / kReapRoundsPerSecond;
+    round = (round + 1) % kReapRoundsPerSecond;
+    if (count > 0 && (g_pika_server->role() & PIKA_ROLE_SLAVE) == 0) {
+      g_pika_server->ReapExpiredKeys(count);
+    }
+    std::this_thread::sleep_for(1000ms / kReapRoundsPerSecond);
+  }
+  return nullptr;
+}
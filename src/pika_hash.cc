@@ -62,7 +62,6 @@ void HSetCmd::Do() {
   s_ = db_->storage()->HSet(key_, field_, value_, &ret);
   if (s_.ok()) {
     res_.AppendContent(":" + std::to_string(ret));
-    AddSlotKey("h", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -74,6 +73,24 @@ void HSetCmd::DoThroughDB() {
   Do();
 }
 
+bool HSetCmd::StageWrite(storage::StagedWrite* write) {
+  write->type = storage::StagedWrite::kHSet;
+  write->key = key_;
+  write->fvs = {{field_, value_}};
+  return true;
+}
+
+void HSetCmd::FinishStagedWrite(const storage::StagedWrite& write) {
+  s_ = write.status;
+  if (s_.ok()) {
+    res_.AppendContent(":" + std::to_string(write.ret));
+  } else if (s_.IsInvalidArgument()) {
+    res_.SetRes(CmdRes::kMultiKey);
+  } else {
+    res_.SetRes(CmdRes::kErrOther, s_.ToString());
+  }
+}
+
 void HSetCmd::DoUpdateCache() {
   // HSetIfKeyExist() can void storing large key, but IsTooLargeKey() can speed up it
   if (IsTooLargeKey(g_pika_conf->max_key_size_in_cache())) {
@@ -273,7 +290,6 @@ void HIncrbyCmd::Do() {
   s_ = db_->storage()->HIncrby(key_, field_, by_, &new_value);
   if (s_.ok() || s_.IsNotFound()) {
     res_.AppendContent(":" + std::to_string(new_value));
-    AddSlotKey("h", key_, db_);
   } else if (s_.IsInvalidArgument() && s_.ToString().substr(0, std::char_traits<char>::length(ErrTypeMessage)) == ErrTypeMessage) {
     res_.SetRes(CmdRes::kMultiKey);
   } else if (s_.IsCorruption() && s_.ToString() == "Corruption: hash value is not an integer") {
@@ -311,7 +327,6 @@ void HIncrbyfloatCmd::Do() {
   if (s_.ok()) {
     res_.AppendStringLenUint64(new_value.size());
     res_.AppendContent(new_value);
-    AddSlotKey("h", key_, db_);
   } else if (s_.IsInvalidArgument() && s_.ToString().substr(0, std::char_traits<char>::length(ErrTypeMessage)) == ErrTypeMessage) {
     res_.SetRes(CmdRes::kMultiKey);
   } else if (s_.IsCorruption() && s_.ToString() == "Corruption: value is not a vaild float") {
@@ -513,7 +528,6 @@ void HMsetCmd::Do() {
   s_ = db_->storage()->HMSet(key_, fvs_);
   if (s_.ok()) {
     res_.SetRes(CmdRes::kOk);
-    AddSlotKey("h", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -525,6 +539,24 @@ void HMsetCmd::DoThroughDB() {
   Do();
 }
 
+bool HMsetCmd::StageWrite(storage::StagedWrite* write) {
+  write->type = storage::StagedWrite::kHMSet;
+  write->key = key_;
+  write->fvs = fvs_;
+  return true;
+}
+
+void HMsetCmd::FinishStagedWrite(const storage::StagedWrite& write) {
+  s_ = write.status;
+  if (s_.ok()) {
+    res_.SetRes(CmdRes::kOk);
+  } else if (s_.IsInvalidArgument()) {
+    res_.SetRes(CmdRes::kMultiKey);
+  } else {
+    res_.SetRes(CmdRes::kErrOther, s_.ToString());
+  }
+}
+
 void HMsetCmd::DoUpdateCache() {
   if (s_.ok()) {
     db_->cache()->HMSetxx(key_, fvs_);
@@ -546,7 +578,6 @@ void HSetnxCmd::Do() {
   s_ = db_->storage()->HSetnx(key_, field_, value_, &ret);
   if (s_.ok()) {
     res_.AppendContent(":" + std::to_string(ret));
-    AddSlotKey("h", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
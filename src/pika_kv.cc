@@ -89,7 +89,6 @@ void SetCmd::Do() {
     } else {
       if (res == 1) {
         res_.SetRes(CmdRes::kOk);
-        AddSlotKey("k", key_, db_);
       } else {
         res_.AppendStringLen(-1);
       }
@@ -105,6 +104,25 @@ void SetCmd::DoThroughDB() {
   Do();
 }
 
+bool SetCmd::StageWrite(storage::StagedWrite* write) {
+  if (condition_ != SetCmd::kNONE) {
+    return false;
+  }
+  write->type = storage::StagedWrite::kSet;
+  write->key = key_;
+  write->value = value_;
+  return true;
+}
+
+void SetCmd::FinishStagedWrite(const storage::StagedWrite& write) {
+  s_ = write.status;
+  if (s_.ok()) {
+    res_.SetRes(CmdRes::kOk);
+  } else {
+    res_.SetRes(CmdRes::kErrOther, s_.ToString());
+  }
+}
+
 void SetCmd::DoUpdateCache() {
   if (SetCmd::kNX == condition_ || IsTooLargeKey(g_pika_conf->max_key_size_in_cache())) {
     return;
@@ -158,10 +176,16 @@ void GetCmd::DoInitial() {
 }
 
 void GetCmd::Do() {
-  s_ = db_->storage()->GetWithTTL(key_, &value_, &ttl_millsec_);
+  // the reply is built from the value pinned by rocksdb, value_ only
+  // keeps a copy when the cache is updated with it afterwards
+  rocksdb::PinnableSlice pinned_value;
+  rocksdb::Slice value;
+  s_ = db_->storage()->GetWithTTL(key_, &pinned_value, &value, &ttl_millsec_);
   if (s_.ok()) {
-    res_.AppendStringLenUint64(value_.size());
-    res_.AppendContent(value_);
+    res_.AppendStringSlice(value);
+    if (PIKA_CACHE_NONE != g_pika_conf->cache_mode()) {
+      value_.assign(value.data(), value.size());
+    }
   } else if (s_.IsNotFound()) {
     res_.AppendStringLen(-1);
   } else if (s_.IsInvalidArgument()) {
@@ -209,10 +233,6 @@ void DelCmd::Do() {
   if (count >= 0) {
     res_.AppendInteger(count);
     s_ = rocksdb::Status::OK();
-    std::vector<std::string>::const_iterator it;
-    for (it = keys_.begin(); it != keys_.end(); it++) {
-      RemSlotKey(*it, db_);
-    }
   } else {
     res_.SetRes(CmdRes::kErrOther, "delete error");
     s_ = rocksdb::Status::Corruption("delete error");
@@ -263,7 +283,6 @@ void IncrCmd::Do() {
   s_ = db_->storage()->Incrby(key_, 1, &new_value_, &expired_timestamp_millsec_);
   if (s_.ok()) {
     res_.AppendContent(":" + std::to_string(new_value_));
-    AddSlotKey("k", key_, db_);
   } else if (s_.IsCorruption() && s_.ToString() == "Corruption: Value is not a integer") {
     res_.SetRes(CmdRes::kInvalidInt);
   } else if (s_.IsInvalidArgument() && s_.ToString().substr(0, std::char_traits<char>::length(ErrTypeMessage)) == ErrTypeMessage) {
@@ -327,7 +346,6 @@ void IncrbyCmd::Do() {
   s_ = db_->storage()->Incrby(key_, by_, &new_value_, &expired_timestamp_millsec_);
   if (s_.ok()) {
     res_.AppendContent(":" + std::to_string(new_value_));
-    AddSlotKey("k", key_, db_);
   } else if (s_.IsCorruption() && s_.ToString() == "Corruption: Value is not a integer") {
     res_.SetRes(CmdRes::kInvalidInt);
   } else if (s_.IsInvalidArgument() && s_.ToString().substr(0, std::char_traits<char>::length(ErrTypeMessage)) == ErrTypeMessage) {
@@ -393,7 +411,6 @@ void IncrbyfloatCmd::Do() {
   if (s_.ok()) {
     res_.AppendStringLenUint64(new_value_.size());
     res_.AppendContent(new_value_);
-    AddSlotKey("k", key_, db_);
   } else if (s_.IsCorruption() && s_.ToString() == "Corruption: Value is not a vaild float") {
     res_.SetRes(CmdRes::kInvalidFloat);
   } else if (s_.IsInvalidArgument() && s_.ToString().substr(0, std::char_traits<char>::length(ErrTypeMessage)) == ErrTypeMessage) {
@@ -492,7 +509,6 @@ void DecrbyCmd::DoInitial() {
 void DecrbyCmd::Do() {
   s_ = db_->storage()->Decrby(key_, by_, &new_value_);
   if (s_.ok()) {
-    AddSlotKey("k", key_, db_);
     res_.AppendContent(":" + std::to_string(new_value_));
   } else if (s_.IsCorruption() && s_.ToString() == "Corruption: Value is not a integer") {
     res_.SetRes(CmdRes::kInvalidInt);
@@ -534,7 +550,6 @@ void GetsetCmd::Do() {
       res_.AppendStringLenUint64(old_value.size());
       res_.AppendContent(old_value);
     }
-    AddSlotKey("k", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -566,7 +581,6 @@ void AppendCmd::Do() {
   s_ = db_->storage()->Append(key_, value_, &new_len, &expired_timestamp_millsec_, new_value_);
   if (s_.ok() || s_.IsNotFound()) {
     res_.AppendInteger(new_len);
-    AddSlotKey("k", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -811,7 +825,6 @@ void SetnxCmd::Do() {
   s_ = db_->storage()->Setnx(key_, value_, &success_);
   if (s_.ok()) {
     res_.AppendInteger(success_);
-    AddSlotKey("k", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -855,7 +868,6 @@ void SetexCmd::Do() {
   s_ = db_->storage()->Setex(key_, value_, ttl_sec_ * 1000);
   if (s_.ok()) {
     res_.SetRes(CmdRes::kOk);
-    AddSlotKey("k", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -997,10 +1009,6 @@ void MsetCmd::Do() {
   s_ = db_->storage()->MSet(kvs_);
   if (s_.ok()) {
     res_.SetRes(CmdRes::kOk);
-    std::vector<storage::KeyValue>::const_iterator it;
-    for (it = kvs_.begin(); it != kvs_.end(); it++) {
-      AddSlotKey("k", it->key, db_);
-    }
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -1082,10 +1090,6 @@ void MsetnxCmd::Do() {
   rocksdb::Status s = db_->storage()->MSetnx(kvs_, &success_);
   if (s.ok()) {
     res_.AppendInteger(success_);
-    std::vector<storage::KeyValue>::const_iterator it;
-    for (it = kvs_.begin(); it != kvs_.end(); it++) {
-      AddSlotKey("k", it->key, db_);
-    }
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -1191,7 +1195,6 @@ void SetrangeCmd::Do() {
   s_ = db_->storage()->Setrange(key_, offset_, value_, &new_len);
   if (s_.ok()) {
     res_.AppendInteger(new_len);
-    AddSlotKey("k", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -89,7 +89,6 @@ void LInsertCmd::Do() {
   s_ = db_->storage()->LInsert(key_, dir_, pivot_, value_, &llen);
   if (s_.ok() || s_.IsNotFound()) {
     res_.AppendInteger(llen);
-    AddSlotKey("l", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -268,7 +267,6 @@ void LPushCmd::Do() {
   s_ = db_->storage()->LPush(key_, values_, &llen);
   if (s_.ok()) {
     res_.AppendInteger(static_cast<int64_t>(llen));
-    AddSlotKey("l", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -468,7 +466,6 @@ void LPushxCmd::Do() {
   s_ = db_->storage()->LPushx(key_, values_, &llen);
   if (s_.ok() || s_.IsNotFound()) {
     res_.AppendInteger(static_cast<int64_t>(llen));
-    AddSlotKey("l", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -600,7 +597,6 @@ void LSetCmd::Do() {
   s_ = db_->storage()->LSet(key_, index_, value_);
   if (s_.ok()) {
     res_.SetRes(CmdRes::kOk);
-    AddSlotKey("l", key_, db_);
   } else if (s_.IsNotFound()) {
     res_.SetRes(CmdRes::kNotFound);
   } else if (s_.IsCorruption() && s_.ToString() == "Corruption: index out of range") {
@@ -801,7 +797,6 @@ void RPopLPushCmd::Do() {
   std::string value;
   s_ = db_->storage()->RPoplpush(source_, receiver_, &value);
   if (s_.ok()) {
-    AddSlotKey("k", receiver_, db_);
     res_.AppendString(value);
     value_poped_from_source_ = value;
     is_write_binlog_ = true;
@@ -865,7 +860,6 @@ void RPushCmd::Do() {
   s_ = db_->storage()->RPush(key_, values_, &llen);
   if (s_.ok()) {
     res_.AppendInteger(static_cast<int64_t>(llen));
-    AddSlotKey("l", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -906,7 +900,6 @@ void RPushxCmd::Do() {
   s_ = db_->storage()->RPushx(key_, values_, &llen);
   if (s_.ok() || s_.IsNotFound()) {
     res_.AppendInteger(static_cast<int64_t>(llen));
-    AddSlotKey("l", key_, db_);
   } else if (s_.IsInvalidArgument()) {
     res_.SetRes(CmdRes::kMultiKey);
   } else {
@@ -708,9 +708,8 @@ void PikaMigrateThread::GetMigrateStatus(std::string *ip, int64_t* port, int64_t
   *slot = slot_id_;
   std::unique_lock lq(mgrtkeys_queue_mutex_);
   int64_t migrating_keys_num = static_cast<int32_t>(mgrtkeys_queue_.size());
-  std::string slotKey = GetSlotKey(static_cast<int32_t>(slot_id_));
-  int32_t slot_size = 0;
-  rocksdb::Status s = db_->storage()->SCard(slotKey, &slot_size);
+  int64_t slot_size = 0;
+  rocksdb::Status s = db_->storage()->SlotIndexCount(static_cast<uint32_t>(slot_id_), &slot_size);
   if (s.ok()) {
     *remained = slot_size + migrating_keys_num;
   } else {
@@ -798,30 +797,25 @@ bool PikaMigrateThread::IsMigrating(std::pair<const char, std::string> &kpair) {
   return false;
 }
 
-void PikaMigrateThread::ReadSlotKeys(const std::string &slotKey, int64_t need_read_num, int64_t &real_read_num,
-                                     int32_t *finish) {
+void PikaMigrateThread::ReadSlotKeys(int64_t need_read_num, int64_t &real_read_num, int32_t *finish) {
   real_read_num = 0;
   std::string key;
   char key_type;
-  int32_t is_member = 0;
   std::vector<std::string> members;
 
-  rocksdb::Status s = db_->storage()->SScan(slotKey, cursor_, "*", need_read_num, &members, &cursor_);
+  // the scan reads a snapshot of the slot index, every member is indexed
+  rocksdb::Status s = db_->storage()->SlotIndexScan(static_cast<uint32_t>(slot_id_), cursor_, "*", need_read_num,
+                                                    &members, &cursor_);
   if (s.ok() && 0 < members.size()) {
     for (const auto &member : members) {
-      db_->storage()->SIsmember(slotKey, member, &is_member);
-      if (is_member) {
-        key = member;
-        key_type = key.at(0);
-        key.erase(key.begin());
-        std::pair<const char, std::string> kpair = std::make_pair(key_type, key);
-        if (mgrtkeys_map_.find(kpair) == mgrtkeys_map_.end()) {
-          mgrtkeys_queue_.emplace_back(kpair);
-          mgrtkeys_map_[kpair] = INVALID_STR;
-          ++real_read_num;
-        }
-      } else {
-        LOG(INFO) << "PikaMigrateThread::ReadSlotKeys key " << member << " not found in" << slotKey;
+      key = member;
+      key_type = key.at(0);
+      key.erase(key.begin());
+      std::pair<const char, std::string> kpair = std::make_pair(key_type, key);
+      if (mgrtkeys_map_.find(kpair) == mgrtkeys_map_.end()) {
+        mgrtkeys_queue_.emplace_back(kpair);
+        mgrtkeys_map_[kpair] = INVALID_STR;
+        ++real_read_num;
       }
     }
   }
@@ -881,9 +875,8 @@ void *PikaMigrateThread::ThreadMain() {
     return nullptr;
   }
 
-  std::string slotKey = GetSlotKey(static_cast<int32_t>(slot_id_));
-  int32_t slot_size = 0;
-  db_->storage()->SCard(slotKey, &slot_size);
+  int64_t slot_size = 0;
+  db_->storage()->SlotIndexCount(static_cast<uint32_t>(slot_id_), &slot_size);
 
   while (!should_exit_) {
     // Waiting migrate task
@@ -922,7 +915,7 @@ void *PikaMigrateThread::ThreadMain() {
         }
       } else {
         int64_t need_read_num = (0 < round_remained_keys - dispatch_num) ? dispatch_num : round_remained_keys;
-        ReadSlotKeys(slotKey, need_read_num, real_read_num, &is_finish);
+        ReadSlotKeys(need_read_num, real_read_num, &is_finish);
         round_remained_keys -= need_read_num;
         send_num_ += static_cast<int32_t>(real_read_num);
       }
@@ -961,8 +954,8 @@ void *PikaMigrateThread::ThreadMain() {
     }
 
     // check slot migrate finish
-    int32_t slot_remained_keys = 0;
-    db_->storage()->SCard(slotKey, &slot_remained_keys);
+    int64_t slot_remained_keys = 0;
+    db_->storage()->SlotIndexCount(static_cast<uint32_t>(slot_id_), &slot_remained_keys);
     if (0 == slot_remained_keys) {
       LOG(INFO) << "PikaMigrateThread::ThreadMain slot_size:" << slot_size << " moved_num:" << moved_num_;
       if (slot_size != moved_num_) {
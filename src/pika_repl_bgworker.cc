@@ -5,6 +5,9 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <unordered_set>
+
 #include "include/pika_repl_bgworker.h"
 #include "include/pika_cmd_table_manager.h"
 #include "include/pika_rm.h"
@@ -194,7 +197,7 @@ int PikaReplBgWorker::HandleWriteBinlog(net::RedisParser* parser, const net::Red
     return -1;
   }
 
-  g_pika_server->UpdateQueryNumAndExecCountDB(worker->db_name_, opt, c_ptr->is_write());
+  g_pika_server->UpdateQueryNumAndExecCountDB(worker->db_name_, c_ptr->GetCmdId(), c_ptr->is_write());
 
   std::shared_ptr<SyncMasterDB> db =
       g_pika_rm->GetSyncMasterDBByName(DBInfo(worker->db_name_));
@@ -206,25 +209,151 @@ int PikaReplBgWorker::HandleWriteBinlog(net::RedisParser* parser, const net::Red
   return 0;
 }
 
-void PikaReplBgWorker::HandleBGWorkerWriteDB(void* arg) {
-  std::unique_ptr<ReplClientWriteDBTaskArg> task_arg(static_cast<ReplClientWriteDBTaskArg*>(arg));
-  const std::shared_ptr<Cmd> c_ptr = task_arg->cmd_ptr;
-  WriteDBInSyncWay(c_ptr);
+void PikaReplBgWorker::HandleBGWorkerWriteDBBatch(void* arg) {
+  auto queue = static_cast<ReplWriteDBQueue*>(arg);
+  size_t max_batch_size = std::max(g_pika_conf->slave_apply_batch_size(), 1);
+  std::vector<std::shared_ptr<Cmd>> cmds;
+  {
+    std::lock_guard l(queue->mu);
+    while (!queue->items.empty() && cmds.size() < max_batch_size) {
+      cmds.push_back(std::move(queue->items.front().cmd_ptr));
+      queue->items.pop_front();
+    }
+  }
+
+  size_t staged_cmds = WriteDBInBatch(cmds);
+  queue->client->FinishWriteDBBatch(cmds, staged_cmds);
+
+  // yield the thread between batches, the next one is scheduled behind
+  std::lock_guard l(queue->mu);
+  if (queue->items.empty()) {
+    queue->scheduled = false;
+  } else {
+    queue->worker->Schedule(&PikaReplBgWorker::HandleBGWorkerWriteDBBatch, queue);
+  }
 }
 
-void PikaReplBgWorker::WriteDBInSyncWay(const std::shared_ptr<Cmd>& c_ptr) {
-  const PikaCmdArgsType& argv = c_ptr->argv();
+bool PikaReplBgWorker::CanApplyInBatch(const std::shared_ptr<Cmd>& c_ptr) {
+  return c_ptr->is_write() && !c_ptr->IsSuspend() && c_ptr->name() != kCmdNameFlushdb &&
+         c_ptr->name() != kCmdNameFlushall && c_ptr->name() != kCmdNameExec;
+}
 
-  uint64_t start_us = 0;
-  if (g_pika_conf->slowlog_slower_than() >= 0) {
-    start_us = pstd::NowMicros();
+size_t PikaReplBgWorker::WriteDBInBatch(const std::vector<std::shared_ptr<Cmd>>& cmds) {
+  // A run holds commands of one db on disjoint keys, they are applied
+  // within one record lock and DB lock window. A command sharing a key with
+  // the run starts a new run, so every key sees its commands in replication
+  // order.
+  std::vector<std::shared_ptr<Cmd>> run;
+  std::vector<std::string> run_keys;
+  std::unordered_set<std::string> run_key_set;
+  size_t staged_cmds = 0;
+  auto apply_run = [&run, &run_keys, &run_key_set, &staged_cmds]() {
+    if (run.size() == 1) {
+      WriteDBInSyncWay(run.front());
+    } else if (!run.empty()) {
+      std::shared_ptr<DB> db = run.front()->GetDB();
+      pstd::lock::MultiRecordLock record_lock(db->LockMgr());
+      record_lock.Lock(run_keys);
+      db->DBLockShared();
+      staged_cmds += ApplyRun(run);
+      db->DBUnlockShared();
+      FailWatchedTxns(run);
+      record_lock.Unlock(run_keys);
+    }
+    run.clear();
+    run_keys.clear();
+    run_key_set.clear();
+  };
+
+  for (const auto& c_ptr : cmds) {
+    if (!CanApplyInBatch(c_ptr)) {
+      apply_run();
+      WriteDBInSyncWay(c_ptr);
+      continue;
+    }
+    std::vector<std::string> keys = c_ptr->current_key();
+    bool conflict = !run.empty() && run.front()->GetDB() != c_ptr->GetDB();
+    for (const auto& key : keys) {
+      conflict = conflict || run_key_set.count(key) != 0;
+    }
+    if (conflict) {
+      apply_run();
+    }
+    for (auto& key : keys) {
+      if (run_key_set.insert(key).second) {
+        run_keys.push_back(std::move(key));
+      }
+    }
+    run.push_back(c_ptr);
   }
+  apply_run();
+  return staged_cmds;
+}
+
+size_t PikaReplBgWorker::ApplyRun(const std::vector<std::shared_ptr<Cmd>>& run) {
+  // The commands that stage their writes share one WriteBatch per instance,
+  // the others are applied one by one. The keys of a run are disjoint, so
+  // the order between the two does not matter.
+  std::vector<storage::StagedWrite> writes;
+  std::vector<std::shared_ptr<Cmd>> staged;
+  for (const auto& c_ptr : run) {
+    storage::StagedWrite write;
+    if (c_ptr->StageWrite(&write)) {
+      writes.push_back(std::move(write));
+      staged.push_back(c_ptr);
+    } else {
+      ApplyCmd(c_ptr);
+    }
+  }
+  if (staged.size() < 2) {
+    for (const auto& c_ptr : staged) {
+      ApplyCmd(c_ptr);
+    }
+    return 0;
+  }
+
+  std::shared_ptr<DB> db = run.front()->GetDB();
+  rocksdb::Status s = db->storage()->ApplyStagedWrites(&writes);
+  if (!s.ok()) {
+    LOG(WARNING) << db->GetDBName() << " failed to apply " << writes.size() << " replicated writes: " << s.ToString();
+  }
+  bool update_cache =
+      PIKA_CACHE_NONE != g_pika_conf->cache_mode() && db->cache()->CacheStatus() == PIKA_CACHE_STATUS_OK;
+  for (size_t idx = 0; idx < staged.size(); ++idx) {
+    staged[idx]->FinishStagedWrite(writes[idx]);
+    if (update_cache && staged[idx]->IsNeedCacheDo() && staged[idx]->IsNeedUpdateCache()) {
+      staged[idx]->DoUpdateCache();
+    }
+  }
+  return staged.size();
+}
+
+void PikaReplBgWorker::WriteDBInSyncWay(const std::shared_ptr<Cmd>& c_ptr) {
   // Add read lock for no suspend command
   pstd::lock::MultiRecordLock record_lock(c_ptr->GetDB()->LockMgr());
   record_lock.Lock(c_ptr->current_key());
   if (!c_ptr->IsSuspend()) {
     c_ptr->GetDB()->DBLockShared();
   }
+  ApplyCmd(c_ptr);
+  if (!c_ptr->IsSuspend()) {
+    c_ptr->GetDB()->DBUnlockShared();
+  }
+
+  if (c_ptr->name() != kCmdNameFlushdb
+      && c_ptr->name() != kCmdNameFlushall
+      && c_ptr->name() != kCmdNameExec) {
+    FailWatchedTxns({c_ptr});
+  }
+
+  record_lock.Unlock(c_ptr->current_key());
+}
+
+void PikaReplBgWorker::ApplyCmd(const std::shared_ptr<Cmd>& c_ptr) {
+  uint64_t start_us = 0;
+  if (g_pika_conf->slowlog_slower_than() >= 0) {
+    start_us = pstd::NowMicros();
+  }
   if (c_ptr->IsNeedCacheDo()
       && PIKA_CACHE_NONE != g_pika_conf->cache_mode()
       && c_ptr->GetDB()->cache()->CacheStatus() == PIKA_CACHE_STATUS_OK) {
@@ -239,32 +368,12 @@ void PikaReplBgWorker::WriteDBInSyncWay(const std::shared_ptr<Cmd>& c_ptr) {
   } else {
     c_ptr->Do();
   }
-  if (!c_ptr->IsSuspend()) {
-    c_ptr->GetDB()->DBUnlockShared();
-  }
 
-  if (c_ptr->res().ok()
-      && c_ptr->is_write()
-      && c_ptr->name() != kCmdNameFlushdb
-      && c_ptr->name() != kCmdNameFlushall
-      && c_ptr->name() != kCmdNameExec) {
-    auto table_keys = c_ptr->current_key();
-    for (auto& key : table_keys) {
-      key = c_ptr->db_name().append(key);
-    }
-    auto dispatcher = dynamic_cast<net::DispatchThread*>(g_pika_server->pika_dispatch_thread()->server_thread());
-    auto involved_conns = dispatcher->GetInvolvedTxn(table_keys);
-    for (auto& conn : involved_conns) {
-      auto c = std::dynamic_pointer_cast<PikaClientConn>(conn);
-      c->SetTxnWatchFailState(true);
-    }
-  }
-
-  record_lock.Unlock(c_ptr->current_key());
   if (g_pika_conf->slowlog_slower_than() >= 0) {
     auto start_time = static_cast<int32_t>(start_us / 1000000);
     auto duration = static_cast<int64_t>(pstd::NowMicros() - start_us);
     if (duration > g_pika_conf->slowlog_slower_than()) {
+      const PikaCmdArgsType& argv = c_ptr->argv();
       g_pika_server->SlowlogPushEntry(argv, start_time, duration);
       if (g_pika_conf->slowlog_write_errorlog()) {
         LOG(ERROR) << "command: " << argv[0] << ", start_time(s): " << start_time << ", duration(us): " << duration;
@@ -272,3 +381,24 @@ void PikaReplBgWorker::WriteDBInSyncWay(const std::shared_ptr<Cmd>& c_ptr) {
     }
   }
 }
+
+void PikaReplBgWorker::FailWatchedTxns(const std::vector<std::shared_ptr<Cmd>>& cmds) {
+  std::vector<std::string> table_keys;
+  for (const auto& c_ptr : cmds) {
+    if (!c_ptr->res().ok() || !c_ptr->is_write()) {
+      continue;
+    }
+    for (const auto& key : c_ptr->current_key()) {
+      table_keys.push_back(c_ptr->db_name().append(key));
+    }
+  }
+  if (table_keys.empty()) {
+    return;
+  }
+  auto dispatcher = dynamic_cast<net::DispatchThread*>(g_pika_server->pika_dispatch_thread()->server_thread());
+  auto involved_conns = dispatcher->GetInvolvedTxn(table_keys);
+  for (auto& conn : involved_conns) {
+    auto c = std::dynamic_pointer_cast<PikaClientConn>(conn);
+    c->SetTxnWatchFailState(true);
+  }
+}
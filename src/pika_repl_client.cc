@@ -9,6 +9,7 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 
+#include <algorithm>
 #include <utility>
 
 #include "net/include/net_cli.h"
@@ -40,6 +41,10 @@ PikaReplClient::PikaReplClient(int cron_interval, int keepalive_timeout) {
       auto new_db_worker = std::make_unique<PikaReplBgWorker>(PIKA_SYNC_BUFFER_SIZE);
       std::string db_worker_name = "ReplWriteDBWorker" + std::to_string(i);
       new_db_worker->SetThreadName(db_worker_name);
+      auto new_db_queue = std::make_unique<ReplWriteDBQueue>();
+      new_db_queue->client = this;
+      new_db_queue->worker = new_db_worker.get();
+      write_db_queues_.emplace_back(std::move(new_db_queue));
       write_db_workers_.emplace_back(std::move(new_db_worker));
   }
 }
@@ -82,8 +87,10 @@ int PikaReplClient::Stop() {
   // or some data will be loss
   bool all_write_db_task_done = true;
   do {
-    for (auto &db_worker: write_db_workers_) {
-      if (db_worker->TaskQueueSize() != 0) {
+    for (auto &db_queue: write_db_queues_) {
+      std::unique_lock l(db_queue->mu);
+      if (db_queue->scheduled) {
+        l.unlock();
         all_write_db_task_done = false;
         std::this_thread::sleep_for(std::chrono::microseconds(300));
         break;
@@ -122,13 +129,47 @@ void PikaReplClient::ScheduleWriteDBTask(const std::shared_ptr<Cmd>& cmd_ptr, co
   const PikaCmdArgsType& argv = cmd_ptr->argv();
   std::string dispatch_key = argv.size() >= 2 ? argv[1] : argv[0];
   size_t index = GetHashIndexByKey(dispatch_key);
-  auto task_arg = new ReplClientWriteDBTaskArg(cmd_ptr);
+  ReplWriteDBQueue* queue = write_db_queues_[index].get();
 
   IncrAsyncWriteDBTaskCount(db_name, 1);
-  std::function<void()> task_finish_call_back = [this, db_name]() { this->DecrAsyncWriteDBTaskCount(db_name, 1); };
+  std::lock_guard l(queue->mu);
+  queue->items.push_back({cmd_ptr, pstd::NowMicros()});
+  // the running drain task picks the command up, commands queued while a
+  // batch is applied go into the next batch
+  if (!queue->scheduled) {
+    queue->scheduled = true;
+    write_db_workers_[index]->Schedule(&PikaReplBgWorker::HandleBGWorkerWriteDBBatch, static_cast<void*>(queue));
+  }
+}
+
+void PikaReplClient::FinishWriteDBBatch(const std::vector<std::shared_ptr<Cmd>>& cmds, size_t staged_cmds) {
+  for (const auto& c_ptr : cmds) {
+    DecrAsyncWriteDBTaskCount(c_ptr->db_name(), 1);
+  }
+  applied_cmds_.fetch_add(cmds.size(), std::memory_order_relaxed);
+  applied_batches_.fetch_add(1, std::memory_order_relaxed);
+  staged_cmds_.fetch_add(staged_cmds, std::memory_order_relaxed);
+  uint64_t max_batch_size = max_batch_size_.load(std::memory_order_relaxed);
+  while (cmds.size() > max_batch_size &&
+         !max_batch_size_.compare_exchange_weak(max_batch_size, cmds.size(), std::memory_order_relaxed)) {
+  }
+}
 
-  write_db_workers_[index]->Schedule(&PikaReplBgWorker::HandleBGWorkerWriteDB, static_cast<void*>(task_arg),
-                                     task_finish_call_back);
+ReplApplyStats PikaReplClient::GetReplApplyStats() {
+  ReplApplyStats stats;
+  uint64_t now_us = pstd::NowMicros();
+  for (auto& db_queue : write_db_queues_) {
+    std::lock_guard l(db_queue->mu);
+    stats.pending_cmds += db_queue->items.size();
+    if (!db_queue->items.empty() && now_us > db_queue->items.front().enqueue_us) {
+      stats.lag_ms = std::max(stats.lag_ms, (now_us - db_queue->items.front().enqueue_us) / 1000);
+    }
+  }
+  stats.applied_cmds = applied_cmds_.load(std::memory_order_relaxed);
+  stats.applied_batches = applied_batches_.load(std::memory_order_relaxed);
+  stats.max_batch_size = max_batch_size_.load(std::memory_order_relaxed);
+  stats.staged_cmds = staged_cmds_.load(std::memory_order_relaxed);
+  return stats;
 }
 
 size_t PikaReplClient::GetBinlogWorkerIndexByDBName(const std::string &db_name) {
@@ -78,6 +78,7 @@ PikaServer::PikaServer()
   rsync_server_ = std::make_unique<rsync::RsyncServer>(ips, port_ + kPortShiftRsync2);
   pika_pubsub_thread_ = std::make_unique<net::PubSubThread>();
   pika_auxiliary_thread_ = std::make_unique<PikaAuxiliaryThread>();
+  pika_expire_reaper_ = std::make_unique<PikaExpireReaper>();
   pika_migrate_ = std::make_unique<PikaMigrate>();
   pika_migrate_thread_ = std::make_unique<PikaMigrateThread>();
 
@@ -130,6 +131,7 @@ PikaServer::~PikaServer() {
   bgsave_thread_.StopThread();
   key_scan_thread_.StopThread();
   pika_migrate_thread_->StopThread();
+  pika_expire_reaper_->StopThread();
 
   dbs_.clear();
 
@@ -210,6 +212,22 @@ void PikaServer::Start() {
                << (ret == net::kCreateThreadError ? ": create thread error " : ": other error");
   }
 
+  if (g_pika_conf->slotmigrate()) {
+    std::shared_lock rwl(dbs_rw_);
+    for (const auto& db_item : dbs_) {
+      Bgslotsconvert(db_item.second);
+    }
+  }
+
+  if (g_pika_conf->expire_index()) {
+    ret = pika_expire_reaper_->StartThread();
+    if (ret != net::kSuccess) {
+      dbs_.clear();
+      LOG(FATAL) << "Start ExpireReaper Thread Error: " << ret
+                 << (ret == net::kCreateThreadError ? ": create thread error " : ": other error");
+    }
+  }
+
   time(&start_time_s_);
   LOG(INFO) << "Pika Server going to start";
   rsync_server_->Start();
@@ -470,6 +488,26 @@ void PikaServer::DBSetSmallCompactionThreshold(uint32_t small_compaction_thresho
   }
 }
 
+void PikaServer::DBSetKeyspaceScanThreads(uint32_t keyspace_scan_threads) {
+  std::shared_lock rwl(dbs_rw_);
+  for (const auto& db_item : dbs_) {
+    db_item.second->DBLockShared();
+    db_item.second->storage()->SetKeyspaceScanThreads(keyspace_scan_threads);
+    db_item.second->DBUnlockShared();
+  }
+}
+
+void PikaServer::DBSetSlotIndexEnabled(bool enabled) {
+  std::shared_lock rwl(dbs_rw_);
+  // and the dbs reopened by a full sync
+  storage_options_.enable_slot_index = enabled;
+  for (const auto& db_item : dbs_) {
+    db_item.second->DBLockShared();
+    db_item.second->storage()->SetSlotIndexEnabled(enabled);
+    db_item.second->DBUnlockShared();
+  }
+}
+
 void PikaServer::DBSetSmallCompactionDurationThreshold(uint32_t small_compaction_duration_threshold) {
   std::shared_lock rwl(dbs_rw_);
   for (const auto& db_item : dbs_) {
@@ -754,6 +792,18 @@ void PikaServer::ScheduleClientPool(net::TaskFunc func, void* arg, bool is_slow_
   pika_client_processor_->SchedulePool(func, arg);
 }
 
+void PikaServer::ScheduleClientPool(net::TaskFunc func, void* arg, bool is_slow_cmd, bool is_admin_cmd, int conn_fd) {
+  if (is_slow_cmd && g_pika_conf->slow_cmd_pool()) {
+    pika_slow_cmd_thread_pool_->Schedule(func, arg, conn_fd);
+    return;
+  }
+  if (is_admin_cmd) {
+    pika_admin_cmd_thread_pool_->Schedule(func, arg, conn_fd);
+    return;
+  }
+  pika_client_processor_->SchedulePool(func, arg, conn_fd);
+}
+
 size_t PikaServer::ClientProcessorThreadPoolCurQueueSize() {
   if (!pika_client_processor_) {
     return 0;
@@ -988,11 +1038,13 @@ uint64_t PikaServer::SlowlogCount() {
 
 void PikaServer::ResetStat() {
   statistic_.server_stat.accumulative_connections.store(0);
-  statistic_.server_stat.qps.querynum.store(0);
-  statistic_.server_stat.qps.last_querynum.store(0);
+  statistic_.ResetQuerynum();
+  statistic_.server_stat.rtc_cache_hits.store(0);
+  statistic_.server_stat.rtc_cache_fallbacks.store(0);
+  statistic_.server_stat.expired_keys.store(0);
 }
 
-uint64_t PikaServer::ServerQueryNum() { return statistic_.server_stat.qps.querynum.load(); }
+uint64_t PikaServer::ServerQueryNum() { return statistic_.QueryNum(); }
 
 uint64_t PikaServer::ServerCurrentQps() { return statistic_.server_stat.qps.last_sec_querynum.load(); }
 
@@ -1002,15 +1054,52 @@ void PikaServer::incr_accumulative_connections() { ++(statistic_.server_stat.acc
 
 // only one thread invoke this right now
 void PikaServer::ResetLastSecQuerynum() {
+  statistic_.RefreshQuerynum();
   statistic_.server_stat.qps.ResetLastSecQuerynum();
   statistic_.ResetDBLastSecQuerynum();
 }
 
-void PikaServer::UpdateQueryNumAndExecCountDB(const std::string& db_name, const std::string& command, bool is_write) {
-  std::string cmd(command);
-  statistic_.server_stat.qps.querynum++;
-  statistic_.server_stat.exec_count_db[pstd::StringToUpper(cmd)]++;
-  statistic_.UpdateDBQps(db_name, command, is_write);
+void PikaServer::UpdateQueryNumAndExecCountDB(const std::string& db_name, uint32_t cmd_id, bool is_write) {
+  statistic_.UpdateQuery(db_name, cmd_id, is_write);
+}
+
+void PikaServer::UpdateCmdTimeConsuming(uint32_t cmd_id, uint64_t time_consuming) {
+  statistic_.UpdateCmdTime(cmd_id, time_consuming);
+}
+
+void PikaServer::IncrRtcCacheHits(uint64_t num) {
+  statistic_.server_stat.rtc_cache_hits.fetch_add(num, std::memory_order_relaxed);
+}
+
+void PikaServer::IncrRtcCacheFallbacks() {
+  statistic_.server_stat.rtc_cache_fallbacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t PikaServer::RtcCacheHits() { return statistic_.server_stat.rtc_cache_hits.load(); }
+
+uint64_t PikaServer::RtcCacheFallbacks() { return statistic_.server_stat.rtc_cache_fallbacks.load(); }
+
+void PikaServer::ReapExpiredKeys(int64_t count_per_db) {
+  std::shared_lock l(dbs_rw_);
+  for (const auto& db_item : dbs_) {
+    int64_t reaped_num = 0;
+    Status s = db_item.second->ReapExpiredKeys(count_per_db, &reaped_num);
+    if (!s.ok()) {
+      LOG(WARNING) << db_item.first << " reap expired keys failed, " << s.ToString();
+    }
+    statistic_.server_stat.expired_keys.fetch_add(reaped_num, std::memory_order_relaxed);
+  }
+}
+
+uint64_t PikaServer::ExpiredKeys() { return statistic_.server_stat.expired_keys.load(); }
+
+int64_t PikaServer::ExpireReaperLagMs() {
+  int64_t lag_ms = 0;
+  std::shared_lock l(dbs_rw_);
+  for (const auto& db_item : dbs_) {
+    lag_ms = std::max(lag_ms, db_item.second->ExpireReaperLagMs());
+  }
+  return lag_ms;
 }
 
 size_t PikaServer::NetInputBytes() { return g_network_statistic->NetInputBytes(); }
@@ -1041,12 +1130,15 @@ float PikaServer::InstantaneousOutputReplKbps() {
 
 std::unordered_map<std::string, uint64_t> PikaServer::ServerExecCountDB() {
   std::unordered_map<std::string, uint64_t> res;
-  for (auto& cmd : statistic_.server_stat.exec_count_db) {
-    res[cmd.first] = cmd.second.load();
+  for (const auto& cmd : statistic_.CmdStats()) {
+    std::string cmd_name = cmd.first;
+    res[pstd::StringToUpper(cmd_name)] = cmd.second.exec_count;
   }
   return res;
 }
 
+std::unordered_map<std::string, CmdStatistic> PikaServer::ServerCmdStats() { return statistic_.CmdStats(); }
+
 std::unordered_map<std::string, QpsStatistic> PikaServer::ServerAllDBStat() { return statistic_.AllDBStat(); }
 
 int PikaServer::SendToPeer() { return g_pika_rm->ConsumeWriteQueue(); }
@@ -1482,21 +1574,27 @@ void PikaServer::InitStorageOptions() {
   // For Storage small compaction
   storage_options_.statistics_max_size = g_pika_conf->max_cache_statistic_keys();
   storage_options_.small_compaction_threshold = g_pika_conf->small_compaction_threshold();
-
-  // rocksdb blob
-  if (g_pika_conf->enable_blob_files()) {
-    storage_options_.options.enable_blob_files = g_pika_conf->enable_blob_files();
-    storage_options_.options.min_blob_size = g_pika_conf->min_blob_size();
-    storage_options_.options.blob_file_size = g_pika_conf->blob_file_size();
-    storage_options_.options.blob_compression_type = PikaConf::GetCompression(g_pika_conf->blob_compression_type());
-    storage_options_.options.enable_blob_garbage_collection = g_pika_conf->enable_blob_garbage_collection();
-    storage_options_.options.blob_garbage_collection_age_cutoff = g_pika_conf->blob_garbage_collection_age_cutoff();
-    storage_options_.options.blob_garbage_collection_force_threshold =
-        g_pika_conf->blob_garbage_collection_force_threshold();
-    if (g_pika_conf->blob_cache() > 0) {  // blob cache less than 0，not open cache
-      storage_options_.options.blob_cache =
-          rocksdb::NewLRUCache(g_pika_conf->blob_cache(), static_cast<int>(g_pika_conf->blob_num_shard_bits()));
-    }
+  storage_options_.zset_rank_index_threshold = g_pika_conf->zset_rank_index_threshold();
+  storage_options_.sets_sample_cache_size = g_pika_conf->sets_sample_cache_size();
+  storage_options_.list_chunk_max_elements = g_pika_conf->list_chunk_max_elements();
+  storage_options_.inline_collection_max_entries = g_pika_conf->inline_collection_max_entries();
+  storage_options_.enable_expire_index = g_pika_conf->expire_index();
+  storage_options_.keyspace_scan_threads = g_pika_conf->keyspace_scan_threads();
+  storage_options_.enable_slot_index = g_pika_conf->slotmigrate();
+
+  // rocksdb blob, the thresholds are set even while blob files are off so
+  // that config set enable-blob-files yes starts from them
+  storage_options_.options.enable_blob_files = g_pika_conf->enable_blob_files();
+  storage_options_.options.min_blob_size = g_pika_conf->min_blob_size();
+  storage_options_.options.blob_file_size = g_pika_conf->blob_file_size();
+  storage_options_.options.blob_compression_type = PikaConf::GetCompression(g_pika_conf->blob_compression_type());
+  storage_options_.options.enable_blob_garbage_collection = g_pika_conf->enable_blob_garbage_collection();
+  storage_options_.options.blob_garbage_collection_age_cutoff = g_pika_conf->blob_garbage_collection_age_cutoff();
+  storage_options_.options.blob_garbage_collection_force_threshold =
+      g_pika_conf->blob_garbage_collection_force_threshold();
+  if (g_pika_conf->blob_cache() > 0) {  // blob cache less than 0，not open cache
+    storage_options_.options.blob_cache =
+        rocksdb::NewLRUCache(g_pika_conf->blob_cache(), static_cast<int>(g_pika_conf->blob_num_shard_bits()));
   }
 
   // for column-family options
@@ -1629,6 +1727,68 @@ void DoBgslotsreload(void* arg) {
   }
 }
 
+void PikaServer::Bgslotsconvert(const std::shared_ptr<DB>& db) {
+  LOG(INFO) << "Start converting the legacy slot sets of " << db->GetDBName();
+  bgslots_cleanup_thread_.StartThread();
+  bgslots_cleanup_thread_.Schedule(&DoBgslotsconvert, static_cast<void*>(new std::shared_ptr<DB>(db)));
+}
+
+void DoBgslotsconvert(void* arg) {
+  std::unique_ptr<std::shared_ptr<DB>> db_arg(static_cast<std::shared_ptr<DB>*>(arg));
+  std::shared_ptr<DB> db = *db_arg;
+
+  // moves the members of the _internal:slotkey:4migrate: sets into the slot index
+  int64_t converted = 0;
+  std::vector<std::string> legacy_keys;
+  for (int slot = 0; slot < g_pika_conf->default_slot_num(); ++slot) {
+    std::string slot_key = GetSlotKey(slot);
+    std::vector<std::string> members;
+    int64_t cursor = 0;
+    bool found = false;
+    do {
+      rocksdb::Status s = db->storage()->SScan(slot_key, cursor, "*", 1000, &members, &cursor);
+      if (!s.ok()) {
+        break;
+      }
+      found = true;
+      for (const auto& member : members) {
+        if (member.empty()) {
+          continue;
+        }
+        // the sets may still list keys deleted long ago
+        std::string key = member.substr(1);
+        storage::DataType type;
+        s = db->storage()->GetType(key, type);
+        if (s.ok() && type != storage::DataType::kNones) {
+          AddSlotKey(std::string(1, storage::DataTypeToTag(type)), key, db);
+          converted++;
+        }
+      }
+    } while (cursor != 0);
+    if (found) {
+      legacy_keys.push_back(slot_key);
+    }
+  }
+  // the tag sets only exist next to the slot sets
+  if (legacy_keys.empty()) {
+    return;
+  }
+
+  std::vector<std::string> keys;
+  int64_t cursor = 0;
+  do {
+    cursor = db->storage()->Scan(storage::DataType::kSets, cursor, SlotTagPrefix + "*", 1000, &keys);
+    legacy_keys.insert(legacy_keys.end(), keys.begin(), keys.end());
+    keys.clear();
+  } while (cursor > 0);
+  for (size_t start = 0; start < legacy_keys.size(); start += 1000) {
+    size_t end = std::min(legacy_keys.size(), start + 1000);
+    db->storage()->Del(std::vector<std::string>(legacy_keys.begin() + start, legacy_keys.begin() + end));
+  }
+  LOG(INFO) << "Finish converting the legacy slot sets of " << db->GetDBName() << ", " << converted
+            << " keys indexed, " << legacy_keys.size() << " sets deleted";
+}
+
 void PikaServer::Bgslotscleanup(std::vector<int> cleanupSlots, const std::shared_ptr<DB>& db) {
   // Only one thread can go through
   {
@@ -1716,6 +1876,39 @@ void DoBgslotscleanup(void* arg) {
   std::vector<std::string> keys;
   int64_t cursor_ret = -1;
   std::vector<int> cleanupSlots(cleanup.cleanup_slots);
+  if (g_pika_conf->slotmigrate()) {
+    // the slot index lists the keys of every slot, no keyspace scan needed
+    for (int cleanupSlot : cleanupSlots) {
+      std::vector<std::string> members;
+      int64_t next_cursor = 0;
+      bool failed = false;
+      do {
+        // DeleteKey drops the index entries, so the scan restarts from the front
+        rocksdb::Status s = cleanup.db->storage()->SlotIndexScan(static_cast<uint32_t>(cleanupSlot), 0, "*",
+                                                                 cleanup.count, &members, &next_cursor);
+        if (!s.ok()) {
+          LOG(WARNING) << "slots clean scan slot " << cleanupSlot << " error: " << s.ToString();
+          break;
+        }
+        for (const auto& member : members) {
+          if (DeleteKey(member.substr(1), member[0], cleanup.db) < 0) {
+            LOG(WARNING) << "slots clean del for slot " << cleanupSlot << " key " << member.substr(1) << " error";
+            failed = true;
+            continue;
+          }
+          // DeleteKey drops the entry under the slot the key hashes to now,
+          // the scan only moves on once the scanned entry is gone
+          s = cleanup.db->storage()->SlotIndexDel(static_cast<uint32_t>(cleanupSlot), member.substr(1));
+          if (!s.ok() && !s.IsNotFound()) {
+            LOG(WARNING) << "slots clean del index for slot " << cleanupSlot << " key " << member.substr(1)
+                         << " error: " << s.ToString();
+            failed = true;
+          }
+        }
+      } while (!members.empty() && !failed && p->GetSlotscleaningup());
+    }
+    cursor_ret = 0;
+  }
   while (cursor_ret != 0 && p->GetSlotscleaningup()) {
     cursor_ret = g_pika_server->bgslots_cleanup_.db->storage()->Scan(storage::DataType::kAll, cleanup.cursor, cleanup.pattern, cleanup.count, &keys);
 
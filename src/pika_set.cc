@@ -31,7 +31,6 @@ void SAddCmd::Do() {
     res_.SetRes(CmdRes::kErrOther, s_.ToString());
     return;
   }
-  AddSlotKey("s", key_, db_);
   res_.AppendInteger(count);
 }
 
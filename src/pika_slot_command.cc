@@ -625,28 +625,9 @@ static int SlotsMgrtOne(const std::string &host, const int port, int timeout, co
 }
 
 void RemSlotKeyByType(const std::string& type, const std::string& key, const std::shared_ptr<DB>& db) {
-  uint32_t crc;
-  int hastag;
-  uint32_t slotNum = GetSlotsID(g_pika_conf->default_slot_num(), key, &crc, &hastag);
-
-  std::string slot_key = GetSlotKey(slotNum);
-  int32_t res = 0;
-
-  std::vector<std::string> members;
-  members.emplace_back(type + key);
-  rocksdb::Status s = db->storage()->SRem(slot_key, members, &res);
-  if (!s.ok()) {
-    LOG(ERROR) << "srem key[" << key << "] from slotKey[" << slot_key << "] failed, error: " << s.ToString();
-    return;
-  }
-
-  if (hastag) {
-    std::string tag_key = GetSlotsTagKey(crc);
-    s = db->storage()->SRem(tag_key, members, &res);
-    if (!s.ok()) {
-      LOG(ERROR) << "srem key[" << key << "] from tagKey[" << tag_key << "] failed, error: " << s.ToString();
-      return;
-    }
+  rocksdb::Status s = db->storage()->SlotIndexDel(key);
+  if (!s.ok() && !s.IsNotFound()) {
+    LOG(ERROR) << "del key[" << key << "] from slot index failed, error: " << s.ToString();
   }
 }
 
@@ -669,11 +650,10 @@ static int SlotsMgrtTag(const std::string& host, const int port, int timeout, co
     return SlotsMgrtOne(host, port, timeout, key, type, detail, db);
   }
 
-  std::string tag_key = GetSlotsTagKey(crc);
   std::vector<std::string> members;
 
   // get all keys that have the same crc
-  rocksdb::Status s = db->storage()->SMembers(tag_key, &members);
+  rocksdb::Status s = db->storage()->SlotIndexTagKeys(key, &members);
   if (!s.ok()) {
     return -1;
   }
@@ -712,49 +692,14 @@ void AddSlotKey(const std::string& type, const std::string& key, const std::shar
     return;
   }
 
-  rocksdb::Status s;
-  int32_t res = -1;
-  uint32_t crc;
-  int hastag;
-  uint32_t slotID = GetSlotsID(g_pika_conf->default_slot_num(), key, &crc, &hastag);
-  std::string slot_key = GetSlotKey(slotID);
-  std::vector<std::string> members;
-  members.emplace_back(type + key);
-  s = db->storage()->SAdd(slot_key, members, &res);
-  if (!s.ok()) {
-    LOG(ERROR) << "sadd key[" << key << "] to slotKey[" << slot_key << "] failed, error: " << s.ToString();
+  if (type.empty()) {
     return;
   }
-
-  // if res == 0, indicate the key is existed; may return,
-  // prevent write slot_key success, but write tag_key failed, so always write tag_key
-  if (hastag) {
-    std::string tag_key = GetSlotsTagKey(crc);
-    s = db->storage()->SAdd(tag_key, members, &res);
-    if (!s.ok()) {
-      LOG(ERROR) << "sadd key[" << key << "] to tagKey[" << tag_key << "] failed, error: " << s.ToString();
-      return;
-    }
-  }
-}
-
-// del key from slotkey
-void RemSlotKey(const std::string& key, const std::shared_ptr<DB>& db) {
-  if (g_pika_conf->slotmigrate() != true) {
-    return;
-  }
-  std::string type;
-  if (GetKeyType(key, type, db) < 0) {
-    LOG(WARNING) << "SRem key: " << key << " from slotKey error";
-    return;
-  }
-  std::string slotKey = GetSlotKey(GetSlotID(g_pika_conf->default_slot_num(), key));
-  int32_t count = 0;
-  std::vector<std::string> members(1, type + key);
-  rocksdb::Status s = db->storage()->SRem(slotKey, members, &count);
-  if (!s.ok()) {
-    LOG(WARNING) << "SRem key: " << key << " from slotKey, error: " << s.ToString();
-    return;
+  // the writes keep the index of the keys, this indexes the ones written
+  // while slotmigrate was off, a key gone since is skipped
+  rocksdb::Status s = db->storage()->SlotIndexAdd(key, type[0]);
+  if (!s.ok() && !s.IsNotFound()) {
+    LOG(ERROR) << "add key[" << key << "] to slot index failed, error: " << s.ToString();
   }
 }
 
@@ -783,22 +728,8 @@ std::string GetSlotsTagKey(uint32_t crc) {
 
 // delete key from db && cache
 int DeleteKey(const std::string& key, const char key_type, const std::shared_ptr<DB>& db) {
-  int32_t res = 0;
-  std::string slotKey = GetSlotKey(GetSlotID(g_pika_conf->default_slot_num(), key));
-
-  // delete slotkey
   std::vector<std::string> members;
   members.emplace_back(key_type + key);
-  rocksdb::Status s = db->storage()->SRem(slotKey, members, &res);
-  if (!s.ok()) {
-    if (s.IsNotFound()) {
-      LOG(INFO) << "Del key Srem key " << key << " not found";
-      return 0;
-    } else {
-      LOG(WARNING) << "Del key Srem key: " << key << " from slotKey, error: " << strerror(errno);
-      return -1;
-    }
-  }
 
   // delete from cache
   if (PIKA_CACHE_NONE != g_pika_conf->cache_mode()
@@ -816,6 +747,14 @@ int DeleteKey(const std::string& key, const char key_type, const std::shared_ptr
     return -1;
   }
 
+  // the delete dropped the index entries of a stored key, this drops the
+  // ones left by a key that was gone already
+  rocksdb::Status s = db->storage()->SlotIndexDel(key);
+  if (!s.ok() && !s.IsNotFound()) {
+    LOG(WARNING) << "Del key: " << key << " from slot index, error: " << s.ToString();
+    return -1;
+  }
+
   return 1;
 }
 
@@ -879,14 +818,14 @@ void SlotsMgrtTagSlotCmd::Do() {
     return;
   }
 
-  int32_t len = 0;
+  int64_t len = 0;
   int ret = 0;
   std::string detail;
-  std::string slot_key = GetSlotKey(static_cast<int32_t>(slot_id_));
 
-  // first, get the count of slot_key, prevent to sscan key very slowly when the key is not found
-  rocksdb::Status s = db_->storage()->SCard(slot_key, &len);
-  if (len < 0) {
+  // first, get the count of the slot, prevent to scan the slot index when it is empty
+  rocksdb::Status s = db_->storage()->SlotIndexCount(static_cast<uint32_t>(slot_id_), &len);
+  if (!s.ok()) {
+    len = -1;
     detail = "Get the len of slot Error";
   }
   // mutex between SlotsMgrtTagSlotCmd、SlotsMgrtTagOneCmd and migrator_thread
@@ -894,7 +833,7 @@ void SlotsMgrtTagSlotCmd::Do() {
     g_pika_server->pika_migrate_->CleanMigrateClient();
     int64_t next_cursor = 0;
     std::vector<std::string> members;
-    rocksdb::Status s = db_->storage()->SScan(slot_key, 0, "*", 1, &members, &next_cursor);
+    rocksdb::Status s = db_->storage()->SlotIndexScan(static_cast<uint32_t>(slot_id_), 0, "*", 1, &members, &next_cursor);
     if (s.ok()) {
       for (const auto &member : members) {
         std::string key = member;
@@ -1030,13 +969,10 @@ void SlotsMgrtTagOneCmd::Do() {
     // else need to migrate
   } else {
     // key is tag_key, check the number of the tag_key
-    std::string tag_key = GetSlotsTagKey(crc);
-    s = db_->storage()->SCard(tag_key, &len);
-    if (s.IsNotFound()) {
-      res_.AppendInteger(0);
-      return;
-    }
-    if (!s.ok() || len == -1) {
+    std::vector<std::string> tag_keys;
+    s = db_->storage()->SlotIndexTagKeys(key_, &tag_keys);
+    len = static_cast<int32_t>(tag_keys.size());
+    if (!s.ok()) {
       res_.SetRes(CmdRes::kErrOther, "can't get the number of tag_key");
       return;
     }
@@ -1143,19 +1079,17 @@ void SlotsInfoCmd::Do() {
   memset(slots_slot, 0, slotNum);
   memset(slots_size, 0, slotNum);
   int n = 0;
-  int32_t len = 0;
-  std::string slot_key;
+  int64_t len = 0;
 
   for (auto i = static_cast<int32_t>(begin_); i < end_; i++) {
-    slot_key = GetSlotKey(i);
     len = 0;
-    rocksdb::Status s = db_->storage()->SCard(slot_key, &len);
+    rocksdb::Status s = db_->storage()->SlotIndexCount(static_cast<uint32_t>(i), &len);
     if (!s.ok() || len == 0) {
       continue;
     }
 
     slots_slot[n] = i;
-    slots_size[n] = len;
+    slots_size[n] = static_cast<int>(len);
     n++;
   }
 
@@ -1229,10 +1163,9 @@ void SlotsMgrtTagSlotAsyncCmd::Do() {
     return;
   }
 
-  int32_t remained = 0;
-  std::string slotKey = GetSlotKey(static_cast<int32_t>(slot_id_));
-  storage::Status status = db_->storage()->SCard(slotKey, &remained);
-  if (status.IsNotFound()) {
+  int64_t remained = 0;
+  storage::Status status = db_->storage()->SlotIndexCount(static_cast<uint32_t>(slot_id_), &remained);
+  if (status.ok() && remained == 0) {
     LOG(INFO) << "find no record in slot " << slot_id_;
     res_.AppendArrayLen(2);
     res_.AppendInteger(0);
@@ -1317,18 +1250,27 @@ void SlotsDelCmd::DoInitial() {
 }
 
 void SlotsDelCmd::Do() {
-  std::vector<std::string> keys;
+  // drops the index of every given slot, the reply counts the slots that
+  // had keys like the number of legacy slot sets deleted
+  int64_t count = 0;
   std::vector<std::string>::const_iterator iter;
   for (iter = slots_.begin(); iter != slots_.end(); iter++) {
-    keys.emplace_back(SlotKeyPrefix + *iter);
-  }
-  std::map<storage::DataType, rocksdb::Status> type_status;
-  int64_t count = db_->storage()->Del(keys);
-  if (count >= 0) {
-    res_.AppendInteger(count);
-  } else {
-    res_.SetRes(CmdRes::kErrOther, "SlotsDel error");
+    int64_t slot_id = 0;
+    if (!pstd::string2int(iter->data(), iter->size(), &slot_id) || slot_id < 0 ||
+        slot_id >= g_pika_conf->default_slot_num()) {
+      continue;
+    }
+    int64_t slot_keys = 0;
+    rocksdb::Status s = db_->storage()->SlotIndexDelSlot(static_cast<uint32_t>(slot_id), &slot_keys);
+    if (!s.ok()) {
+      res_.SetRes(CmdRes::kErrOther, "SlotsDel error");
+      return;
+    }
+    if (slot_keys > 0) {
+      count++;
+    }
   }
+  res_.AppendInteger(count);
   return;
 }
 
@@ -1362,8 +1304,8 @@ void SlotsScanCmd::DoInitial() {
     res_.SetRes(CmdRes::kWrongNum, kCmdNameSlotsScan);
     return;
   }
-  key_ = SlotKeyPrefix + argv_[1];
-  if (std::stoll(argv_[1].data()) < 0 || std::stoll(argv_[1].data()) >= g_pika_conf->default_slot_num()) {
+  if (!pstd::string2int(argv_[1].data(), argv_[1].size(), &slot_id_) || slot_id_ < 0 ||
+      slot_id_ >= g_pika_conf->default_slot_num()) {
     res_.SetRes(CmdRes::kWrongNum, kCmdNameSlotsScan);
     return;
   }
@@ -1401,7 +1343,8 @@ void SlotsScanCmd::DoInitial() {
 
 void SlotsScanCmd::Do() {
   std::vector<std::string> members;
-  rocksdb::Status s = db_->storage()->SScan(key_, cursor_, pattern_, count_, &members, &cursor_);
+  rocksdb::Status s =
+      db_->storage()->SlotIndexScan(static_cast<uint32_t>(slot_id_), cursor_, pattern_, count_, &members, &cursor_);
 
   if (members.size() <= 0) {
     cursor_ = 0;
@@ -22,6 +22,12 @@ extern std::unique_ptr<PikaReplicaManager> g_pika_rm;
 StableLog::StableLog(std::string db_name, std::string log_path)
     : purging_(false), db_name_(std::move(db_name)), log_path_(std::move(log_path)) {
   stable_logger_ = std::make_shared<Binlog>(log_path_, g_pika_conf->binlog_file_size());
+  std::string sync_policy = g_pika_conf->binlog_sync_policy();
+  if (sync_policy == "batch") {
+    stable_logger_->SetSyncPolicy(BinlogSyncPolicy::kBatch, g_pika_conf->binlog_sync_interval_ms());
+  } else if (sync_policy == "interval") {
+    stable_logger_->SetSyncPolicy(BinlogSyncPolicy::kInterval, g_pika_conf->binlog_sync_interval_ms());
+  }
   std::map<uint32_t, std::string> binlogs;
   if (!GetBinlogFiles(&binlogs)) {
     LOG(FATAL) << log_path_ << " Could not get binlog files!";
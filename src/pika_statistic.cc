@@ -5,6 +5,8 @@
 
 #include "include/pika_statistic.h"
 
+#include <algorithm>
+
 #include "pstd/include/env.h"
 
 #include "include/pika_command.h"
@@ -30,13 +32,6 @@ QpsStatistic::QpsStatistic(const QpsStatistic& other) {
   last_time_us = other.last_time_us.load();
 }
 
-void QpsStatistic::IncreaseQueryNum(bool is_write) {
-  querynum++;
-  if (is_write) {
-    write_querynum++;
-  }
-}
-
 void QpsStatistic::ResetLastSecQuerynum() {
   uint64_t last_query = last_querynum.load();
   uint64_t last_write_query = last_write_querynum.load();
@@ -66,9 +61,88 @@ void QpsStatistic::ResetLastSecQuerynum() {
 
 /* Statistic */
 
-Statistic::Statistic() {
-  pthread_rwlockattr_t db_stat_rw_attr;
-  pthread_rwlockattr_init(&db_stat_rw_attr);
+void Statistic::Init(const CmdTable& cmd_table, int db_num) {
+  uint32_t cmd_num = 0;
+  for (const auto& cmd : cmd_table) {
+    cmd_num = std::max(cmd_num, cmd.second->GetCmdId() + 1);
+  }
+  cmd_names_.assign(cmd_num, "");
+  for (const auto& cmd : cmd_table) {
+    cmd_names_[cmd.second->GetCmdId()] = cmd.first;
+  }
+  db_num_ = static_cast<size_t>(std::max(db_num, 0));
+  cmd_counters_ = std::make_unique<pstd::ThreadCounters>(cmd_num * kCmdFieldNum);
+  // one more slot for the names of no DB
+  db_counters_ = std::make_unique<pstd::ThreadCounters>((db_num_ + 1) * kDBFieldNum);
+}
+
+size_t Statistic::DBIndex(const std::string& db_name) const {
+  // "db<index>", parsed in place since it runs for every command
+  if (db_name.size() < 3 || db_name.size() > 5 || db_name[0] != 'd' || db_name[1] != 'b') {
+    return db_num_;
+  }
+  size_t index = 0;
+  for (size_t i = 2; i < db_name.size(); ++i) {
+    if (db_name[i] < '0' || db_name[i] > '9') {
+      return db_num_;
+    }
+    index = index * 10 + (db_name[i] - '0');
+  }
+  return index < db_num_ ? index : db_num_;
+}
+
+void Statistic::UpdateQuery(const std::string& db_name, uint32_t cmd_id, bool is_write) {
+  if (!cmd_counters_) {
+    return;
+  }
+  if (cmd_id < cmd_names_.size()) {
+    cmd_counters_->Add(cmd_id * kCmdFieldNum + kExecCount, 1);
+  }
+  size_t db_index = DBIndex(db_name);
+  db_counters_->Add(db_index * kDBFieldNum + kQuerynum, 1);
+  if (is_write) {
+    db_counters_->Add(db_index * kDBFieldNum + kWriteQuerynum, 1);
+  }
+}
+
+void Statistic::UpdateCmdTime(uint32_t cmd_id, uint64_t time_consuming) {
+  if (!cmd_counters_ || cmd_id >= cmd_names_.size()) {
+    return;
+  }
+  cmd_counters_->Add(cmd_id * kCmdFieldNum + kCalls, 1);
+  cmd_counters_->Add(cmd_id * kCmdFieldNum + kTimeConsuming, time_consuming);
+}
+
+uint64_t Statistic::QueryNum() const {
+  if (!db_counters_) {
+    return 0;
+  }
+  std::vector<uint64_t> counts;
+  db_counters_->SumAll(&counts);
+  uint64_t querynum = 0;
+  for (size_t db_index = 0; db_index <= db_num_; ++db_index) {
+    querynum += counts[db_index * kDBFieldNum + kQuerynum];
+  }
+  return querynum;
+}
+
+std::unordered_map<std::string, CmdStatistic> Statistic::CmdStats() const {
+  std::unordered_map<std::string, CmdStatistic> stats;
+  if (!cmd_counters_) {
+    return stats;
+  }
+  std::vector<uint64_t> counts;
+  cmd_counters_->SumAll(&counts);
+  for (size_t cmd_id = 0; cmd_id < cmd_names_.size(); ++cmd_id) {
+    if (cmd_names_[cmd_id].empty()) {
+      continue;
+    }
+    CmdStatistic& stat = stats[cmd_names_[cmd_id]];
+    stat.exec_count = counts[cmd_id * kCmdFieldNum + kExecCount];
+    stat.calls = counts[cmd_id * kCmdFieldNum + kCalls];
+    stat.time_consuming = counts[cmd_id * kCmdFieldNum + kTimeConsuming];
+  }
+  return stats;
 }
 
 QpsStatistic Statistic::DBStat(const std::string& db_name) {
@@ -81,26 +155,28 @@ std::unordered_map<std::string, QpsStatistic> Statistic::AllDBStat() {
   return db_stat;
 }
 
-void Statistic::UpdateDBQps(const std::string& db_name, const std::string& command, bool is_write) {
-  bool db_exist = true;
-  std::unordered_map<std::string, QpsStatistic>::iterator iter;
-  {
-    std::shared_lock l(db_stat_rw);
-    auto search = db_stat.find(db_name);
-    if (search == db_stat.end()) {
-      db_exist = false;
-    } else {
-      iter = search;
-    }
+void Statistic::RefreshQuerynum() {
+  if (!db_counters_) {
+    return;
   }
-  if (db_exist) {
-    iter->second.IncreaseQueryNum(is_write);
-  } else {
-    {
-      std::lock_guard l(db_stat_rw);
-      db_stat[db_name].IncreaseQueryNum(is_write);
+  std::vector<uint64_t> counts;
+  db_counters_->SumAll(&counts);
+  uint64_t querynum = 0;
+  uint64_t write_querynum = 0;
+  std::lock_guard l(db_stat_rw);
+  for (size_t db_index = 0; db_index <= db_num_; ++db_index) {
+    uint64_t db_querynum = counts[db_index * kDBFieldNum + kQuerynum];
+    uint64_t db_write_querynum = counts[db_index * kDBFieldNum + kWriteQuerynum];
+    querynum += db_querynum;
+    write_querynum += db_write_querynum;
+    if (db_index < db_num_) {
+      QpsStatistic& stat = db_stat["db" + std::to_string(db_index)];
+      stat.querynum.store(db_querynum);
+      stat.write_querynum.store(db_write_querynum);
     }
   }
+  server_stat.qps.querynum.store(querynum);
+  server_stat.qps.write_querynum.store(write_querynum);
 }
 
 void Statistic::ResetDBLastSecQuerynum() {
@@ -109,3 +185,21 @@ void Statistic::ResetDBLastSecQuerynum() {
     stat.second.ResetLastSecQuerynum();
   }
 }
+
+void Statistic::ResetQuerynum() {
+  if (db_counters_) {
+    db_counters_->Reset();
+  }
+  // the db_stat numbers come from the same counters
+  std::lock_guard l(db_stat_rw);
+  for (auto& stat : db_stat) {
+    stat.second.querynum.store(0);
+    stat.second.write_querynum.store(0);
+    stat.second.last_querynum.store(0);
+    stat.second.last_write_querynum.store(0);
+  }
+  server_stat.qps.querynum.store(0);
+  server_stat.qps.write_querynum.store(0);
+  server_stat.qps.last_querynum.store(0);
+  server_stat.qps.last_write_querynum.store(0);
+}
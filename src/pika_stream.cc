@@ -252,7 +252,6 @@ void XAddCmd::Do() {
   }
 
   res_.AppendString(args_.id.ToString());
-  AddSlotKey("m", key_, db_);
 }
 
 void XRangeCmd::DoInitial() {
@@ -0,0 +1,75 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pstd/include/pstd_bit.h"
+
+// Throughput of the bit kernels at every level this CPU supports, over one
+// bitmap of the given size (64MB by default):
+//   count  BITCOUNT
+//   and    one BITOP AND step, the other ops run at the same speed
+//   not    BITOP NOT
+//   pos    BITPOS 1 over a bitmap that is clear up to its last byte
+//
+// usage: ./bit_bench [bitmap_mb] [rounds]
+
+using namespace pstd;
+
+namespace {
+
+template <typename Func>
+void Bench(const std::string& name, size_t bytes, size_t rounds, Func func) {
+  auto start = std::chrono::steady_clock::now();
+  uint64_t check = 0;
+  for (size_t round = 0; round < rounds; ++round) {
+    check += func();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  double mb_per_sec = static_cast<double>(bytes * rounds) / static_cast<double>(elapsed.count());
+  std::cout << "    " << name << ": " << static_cast<uint64_t>(mb_per_sec) << " MB/s (check " << check << ")"
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t bitmap_mb = argc > 1 ? std::stoul(argv[1]) : 64;
+  size_t rounds = argc > 2 ? std::stoul(argv[2]) : 10;
+  size_t bytes = bitmap_mb * 1024 * 1024;
+
+  std::mt19937_64 rnd(301);
+  std::vector<unsigned char> a(bytes);
+  std::vector<unsigned char> b(bytes);
+  for (size_t i = 0; i < bytes; ++i) {
+    a[i] = static_cast<unsigned char>(rnd());
+    b[i] = static_cast<unsigned char>(rnd());
+  }
+  std::vector<unsigned char> sparse(bytes, 0);
+  sparse[bytes - 1] = 1;
+
+  std::cout << "bitmap " << bitmap_mb << " MB, best level " << BitKernelLevelName(BestBitKernelLevel()) << std::endl;
+  for (auto level : {BitKernelLevel::kScalar, BitKernelLevel::kSSE42, BitKernelLevel::kAVX2, BitKernelLevel::kAVX512}) {
+    if (!BitKernelLevelSupported(level)) {
+      continue;
+    }
+    std::cout << "  " << BitKernelLevelName(level) << std::endl;
+    Bench("count", bytes, rounds, [&]() { return BitCount(level, a.data(), bytes); });
+    Bench("and", bytes, rounds, [&]() {
+      BitAnd(level, a.data(), b.data(), bytes);
+      return a[0];
+    });
+    Bench("not", bytes, rounds, [&]() {
+      BitNot(level, a.data(), bytes);
+      return a[0];
+    });
+    Bench("pos", bytes, rounds, [&]() { return BitPos(level, sparse.data(), bytes, 1); });
+  }
+  return 0;
+}
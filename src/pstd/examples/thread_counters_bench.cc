@@ -0,0 +1,138 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "pstd/include/pstd_string.h"
+#include "pstd/include/thread_counters.h"
+
+// Cost per request of the command statistics with many worker threads:
+//   shared    what a request used to do: an upper cased copy of the command
+//             name for the exec count map, a DB qps lookup under a shared
+//             lock and two lookups of the name in the commandstats map, all
+//             on atomics every worker writes
+//   thread    adds to per-thread counters indexed by command id and DB
+//
+// usage: ./thread_counters_bench [threads] [requests_per_thread]
+
+using namespace pstd;
+
+namespace {
+
+const char* kCmdNames[] = {"get", "set", "hget", "hset", "mget", "incr", "lpush", "zadd"};
+const size_t kCmdNum = sizeof(kCmdNames) / sizeof(kCmdNames[0]);
+const size_t kDBNum = 1;
+
+struct SharedStat {
+  std::unordered_map<std::string, std::atomic<uint64_t>> exec_count;
+  std::shared_mutex db_rw;
+  std::unordered_map<std::string, std::atomic<uint64_t>> db_querynum;
+  std::unordered_map<std::string, std::atomic<uint64_t>> db_write_querynum;
+  std::unordered_map<std::string, std::atomic<uint64_t>> calls;
+  std::unordered_map<std::string, std::atomic<uint64_t>> usec;
+
+  SharedStat() {
+    for (const char* name : kCmdNames) {
+      std::string upper(name);
+      exec_count[StringToUpper(upper)] = 0;
+      calls[name] = 0;
+      usec[name] = 0;
+    }
+    db_querynum["db0"] = 0;
+    db_write_querynum["db0"] = 0;
+  }
+
+  void Update(const std::string& db_name, const std::string& opt, bool is_write, uint64_t time) {
+    std::string cmd(opt);
+    exec_count[StringToUpper(cmd)]++;
+    {
+      std::shared_lock l(db_rw);
+      db_querynum.find(db_name)->second++;
+      if (is_write) {
+        db_write_querynum.find(db_name)->second++;
+      }
+    }
+    calls[opt].fetch_add(1);
+    usec[opt].fetch_add(time);
+  }
+};
+
+// exec count, calls and usec per command, then querynum and writes per DB
+struct ThreadStat {
+  ThreadCounters cmd_counters{kCmdNum * 3};
+  ThreadCounters db_counters{kDBNum * 2};
+
+  void Update(size_t db_index, size_t cmd_id, bool is_write, uint64_t time) {
+    cmd_counters.Add(cmd_id * 3, 1);
+    db_counters.Add(db_index * 2, 1);
+    if (is_write) {
+      db_counters.Add(db_index * 2 + 1, 1);
+    }
+    cmd_counters.Add(cmd_id * 3 + 1, 1);
+    cmd_counters.Add(cmd_id * 3 + 2, time);
+  }
+};
+
+template <typename Func>
+void Bench(const std::string& name, size_t thread_num, size_t requests, Func func) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&func, t, requests]() {
+      for (size_t i = 0; i < requests; ++i) {
+        func((i + t) % kCmdNum, i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  // every thread runs its requests one after another
+  double ns_per_request = static_cast<double>(elapsed.count()) / static_cast<double>(requests);
+  std::cout << "  " << name << ": " << ns_per_request << " ns per request per thread, "
+            << static_cast<uint64_t>(static_cast<double>(thread_num * requests) * 1e9 /
+                                     static_cast<double>(elapsed.count()))
+            << " requests/s" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t thread_num = argc > 1 ? std::stoul(argv[1]) : std::max(1U, std::thread::hardware_concurrency());
+  size_t requests = argc > 2 ? std::stoul(argv[2]) : 2000000;
+  std::cout << thread_num << " threads, " << requests << " requests per thread" << std::endl;
+
+  SharedStat shared_stat;
+  const std::string db_name = "db0";
+  std::vector<std::string> opts(kCmdNames, kCmdNames + kCmdNum);
+  Bench("shared", thread_num, requests, [&](size_t cmd_id, size_t i) {
+    shared_stat.Update(db_name, opts[cmd_id], cmd_id % 2 == 1, i & 0xff);
+  });
+
+  ThreadStat thread_stat;
+  Bench("thread", thread_num, requests, [&](size_t cmd_id, size_t i) {
+    thread_stat.Update(0, cmd_id, cmd_id % 2 == 1, i & 0xff);
+  });
+
+  uint64_t shared_calls = 0;
+  for (const auto& call : shared_stat.calls) {
+    shared_calls += call.second.load();
+  }
+  uint64_t thread_calls = 0;
+  for (size_t cmd_id = 0; cmd_id < kCmdNum; ++cmd_id) {
+    thread_calls += thread_stat.cmd_counters.Sum(cmd_id * 3 + 1);
+  }
+  std::cout << "  calls counted: shared " << shared_calls << ", thread " << thread_calls << std::endl;
+  return 0;
+}
@@ -28,6 +28,9 @@ class LockMgr : public pstd::noncopyable {
   // for calling UnLock() on this key.
   Status TryLock(const std::string& key);
 
+  // Lock key if no one holds it, Busy otherwise. Same UnLock() as TryLock().
+  Status LockIfFree(const std::string& key);
+
   // Unlock a key locked by TryLock().
   void UnLock(const std::string& key);
 
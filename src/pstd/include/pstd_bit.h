@@ -0,0 +1,50 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __PSTD_BIT_H__
+#define __PSTD_BIT_H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pstd {
+
+/*
+ * Bit kernels over byte strings for BITCOUNT, BITOP and BITPOS.
+ *
+ * Every kernel has a scalar version and, on x86_64, SSE4.2 (POPCNT), AVX2
+ * and AVX-512 (VPOPCNTDQ) versions. The plain functions use the best level
+ * the CPU supports, it is detected once. The versions taking a level run
+ * that level, it must be supported, they are for tests and benchmarks.
+ *
+ * Bits are numbered the redis way, bit 0 is the most significant bit of the
+ * first byte.
+ */
+enum class BitKernelLevel { kScalar = 0, kSSE42, kAVX2, kAVX512 };
+
+BitKernelLevel BestBitKernelLevel();
+bool BitKernelLevelSupported(BitKernelLevel level);
+const char* BitKernelLevelName(BitKernelLevel level);
+
+// Number of set bits
+uint64_t BitCount(const unsigned char* s, size_t bytes);
+// dst[i] op= src[i] for i in [0, bytes)
+void BitAnd(unsigned char* dst, const unsigned char* src, size_t bytes);
+void BitOr(unsigned char* dst, const unsigned char* src, size_t bytes);
+void BitXor(unsigned char* dst, const unsigned char* src, size_t bytes);
+void BitNot(unsigned char* dst, size_t bytes);
+// Position of the first bit equal to bit (0 or 1), -1 if there is none
+int64_t BitPos(const unsigned char* s, size_t bytes, int bit);
+
+uint64_t BitCount(BitKernelLevel level, const unsigned char* s, size_t bytes);
+void BitAnd(BitKernelLevel level, unsigned char* dst, const unsigned char* src, size_t bytes);
+void BitOr(BitKernelLevel level, unsigned char* dst, const unsigned char* src, size_t bytes);
+void BitXor(BitKernelLevel level, unsigned char* dst, const unsigned char* src, size_t bytes);
+void BitNot(BitKernelLevel level, unsigned char* dst, size_t bytes);
+int64_t BitPos(BitKernelLevel level, const unsigned char* s, size_t bytes, int bit);
+
+}  // namespace pstd
+
+#endif  // __PSTD_BIT_H__
@@ -0,0 +1,67 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __PSTD_INCLUDE_THREAD_COUNTERS_H__
+#define __PSTD_INCLUDE_THREAD_COUNTERS_H__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "pstd/include/noncopyable.h"
+
+namespace pstd {
+
+/*
+ * A fixed number of counters that many threads add to. Every thread adds to
+ * its own copy of the counters, on cache lines no other thread writes, with
+ * a plain load and store. Reading sums the copies of all the threads, the
+ * copy of a thread that exited keeps counting in the sums.
+ *
+ * Add costs a thread local lookup and one store, Sum and Reset take a mutex
+ * and walk every thread's copy, they are meant for the reporting side.
+ */
+class ThreadCounters : public pstd::noncopyable {
+ public:
+  explicit ThreadCounters(size_t size);
+  ~ThreadCounters();
+
+  size_t size() const { return size_; }
+
+  void Add(size_t index, uint64_t value) {
+    std::atomic<uint64_t>& counter = LocalCounters()[index];
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  uint64_t Sum(size_t index) const;
+  // sums->at(i) is Sum(i)
+  void SumAll(std::vector<uint64_t>* sums) const;
+  // the sums start from zero again, the threads adding meanwhile are not
+  // blocked and their adds after the reset count
+  void Reset();
+
+ private:
+  struct Shard;
+
+  std::atomic<uint64_t>* LocalCounters();
+  std::atomic<uint64_t>* NewShard();
+  uint64_t SumLocked(size_t index) const;
+  void SumAllLocked(std::vector<uint64_t>* sums) const;
+
+  const size_t size_;
+  // tells the instances apart in the thread local shard tables
+  const uint64_t id_;
+
+  mutable std::mutex mu_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // the sums at the last Reset
+  std::vector<uint64_t> base_;
+};
+
+}  // namespace pstd
+
+#endif  // __PSTD_INCLUDE_THREAD_COUNTERS_H__
@@ -87,6 +87,24 @@ Status LockMgr::TryLock(const std::string& key) {
 #endif
 }
 
+Status LockMgr::LockIfFree(const std::string& key) {
+#ifdef LOCKLESS
+  return Status::OK();
+#else
+  size_t stripe_num = lock_map_->GetStripe(key);
+  assert(lock_map_->lock_map_stripes_.size() > stripe_num);
+  auto stripe = lock_map_->lock_map_stripes_.at(stripe_num);
+
+  Status result = stripe->stripe_mutex->Lock();
+  if (!result.ok()) {
+    return result;
+  }
+  result = AcquireLocked(stripe, key);
+  stripe->stripe_mutex->UnLock();
+  return result;
+#endif
+}
+
 // Helper function for TryLock().
 Status LockMgr::Acquire(const std::shared_ptr<LockMapStripe>& stripe, const std::string& key) {
   Status result;
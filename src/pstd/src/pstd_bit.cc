@@ -0,0 +1,384 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "pstd/include/pstd_bit.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PSTD_BIT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace pstd {
+
+namespace {
+
+struct BitKernels {
+  uint64_t (*count)(const unsigned char* s, size_t bytes);
+  void (*bit_and)(unsigned char* dst, const unsigned char* src, size_t bytes);
+  void (*bit_or)(unsigned char* dst, const unsigned char* src, size_t bytes);
+  void (*bit_xor)(unsigned char* dst, const unsigned char* src, size_t bytes);
+  void (*bit_not)(unsigned char* dst, size_t bytes);
+  // first block holding a byte other than skip, the scalar kernel finishes it
+  size_t (*skip_bytes)(const unsigned char* s, size_t bytes, unsigned char skip);
+};
+
+inline uint64_t LoadWord(const unsigned char* s) {
+  uint64_t word;
+  memcpy(&word, s, sizeof(word));
+  return word;
+}
+
+inline void StoreWord(unsigned char* s, uint64_t word) { memcpy(s, &word, sizeof(word)); }
+
+/*
+ * Scalar kernels, eight bytes at a time
+ */
+uint64_t CountScalar(const unsigned char* s, size_t bytes) {
+  uint64_t count = 0;
+  size_t i = 0;
+  for (; i + 8 <= bytes; i += 8) {
+    count += __builtin_popcountll(LoadWord(s + i));
+  }
+  for (; i < bytes; ++i) {
+    count += __builtin_popcount(s[i]);
+  }
+  return count;
+}
+
+#define PSTD_BIT_SCALAR_OP(name, op)                                       \
+  void name(unsigned char* dst, const unsigned char* src, size_t bytes) { \
+    size_t i = 0;                                                          \
+    for (; i + 8 <= bytes; i += 8) {                                       \
+      StoreWord(dst + i, LoadWord(dst + i) op LoadWord(src + i));          \
+    }                                                                      \
+    for (; i < bytes; ++i) {                                               \
+      dst[i] = static_cast<unsigned char>(dst[i] op src[i]);               \
+    }                                                                      \
+  }
+
+PSTD_BIT_SCALAR_OP(AndScalar, &)
+PSTD_BIT_SCALAR_OP(OrScalar, |)
+PSTD_BIT_SCALAR_OP(XorScalar, ^)
+
+void NotScalar(unsigned char* dst, size_t bytes) {
+  size_t i = 0;
+  for (; i + 8 <= bytes; i += 8) {
+    StoreWord(dst + i, ~LoadWord(dst + i));
+  }
+  for (; i < bytes; ++i) {
+    dst[i] = static_cast<unsigned char>(~dst[i]);
+  }
+}
+
+size_t SkipScalar(const unsigned char* s, size_t bytes, unsigned char skip) {
+  uint64_t skip_word = skip == 0 ? 0 : ~static_cast<uint64_t>(0);
+  size_t i = 0;
+  while (i + 8 <= bytes && LoadWord(s + i) == skip_word) {
+    i += 8;
+  }
+  return i;
+}
+
+int64_t FinishBitPos(const unsigned char* s, size_t bytes, int bit, size_t from) {
+  unsigned char skip = bit == 0 ? 0xff : 0;
+  for (size_t i = from; i < bytes; ++i) {
+    if (s[i] != skip) {
+      unsigned int byte = bit == 0 ? static_cast<unsigned char>(~s[i]) : s[i];
+      return static_cast<int64_t>(i * 8) + __builtin_clz(byte) - 24;
+    }
+  }
+  return -1;
+}
+
+const BitKernels kScalarKernels = {CountScalar, AndScalar, OrScalar, XorScalar, NotScalar, SkipScalar};
+
+#ifdef PSTD_BIT_X86
+
+/*
+ * SSE4.2: hardware POPCNT on words, 16 byte logic ops
+ */
+__attribute__((target("sse4.2,popcnt"))) uint64_t CountSSE42(const unsigned char* s, size_t bytes) {
+  uint64_t c0 = 0;
+  uint64_t c1 = 0;
+  uint64_t c2 = 0;
+  uint64_t c3 = 0;
+  size_t i = 0;
+  for (; i + 32 <= bytes; i += 32) {
+    c0 += _mm_popcnt_u64(LoadWord(s + i));
+    c1 += _mm_popcnt_u64(LoadWord(s + i + 8));
+    c2 += _mm_popcnt_u64(LoadWord(s + i + 16));
+    c3 += _mm_popcnt_u64(LoadWord(s + i + 24));
+  }
+  return c0 + c1 + c2 + c3 + CountScalar(s + i, bytes - i);
+}
+
+#define PSTD_BIT_SSE_OP(name, intrinsic, scalar)                                                           \
+  __attribute__((target("sse4.2"))) void name(unsigned char* dst, const unsigned char* src, size_t bytes) { \
+    size_t i = 0;                                                                                          \
+    for (; i + 16 <= bytes; i += 16) {                                                                     \
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));                              \
+      __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));                              \
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), intrinsic(a, b));                              \
+    }                                                                                                      \
+    scalar(dst + i, src + i, bytes - i);                                                                   \
+  }
+
+PSTD_BIT_SSE_OP(AndSSE42, _mm_and_si128, AndScalar)
+PSTD_BIT_SSE_OP(OrSSE42, _mm_or_si128, OrScalar)
+PSTD_BIT_SSE_OP(XorSSE42, _mm_xor_si128, XorScalar)
+
+__attribute__((target("sse4.2"))) void NotSSE42(unsigned char* dst, size_t bytes) {
+  const __m128i ones = _mm_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 16 <= bytes; i += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(a, ones));
+  }
+  NotScalar(dst + i, bytes - i);
+}
+
+__attribute__((target("sse4.2"))) size_t SkipSSE42(const unsigned char* s, size_t bytes, unsigned char skip) {
+  const __m128i skip_v = _mm_set1_epi8(static_cast<char>(skip));
+  size_t i = 0;
+  for (; i + 16 <= bytes; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, skip_v)) != 0xffff) {
+      return i;
+    }
+  }
+  return i + SkipScalar(s + i, bytes - i, skip);
+}
+
+/*
+ * AVX2: nibble lookup popcount (vpshufb), summed with vpsadbw
+ */
+__attribute__((target("avx2"))) uint64_t CountAVX2(const unsigned char* s, size_t bytes) {
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i total = zero;
+  size_t i = 0;
+  while (i + 32 <= bytes) {
+    // a byte counter gains at most 8 per round, flush before it overflows
+    __m256i acc = zero;
+    for (int round = 0; round < 31 && i + 32 <= bytes; ++round, i += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+      __m256i lo = _mm256_and_si256(v, low_mask);
+      __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+      acc = _mm256_add_epi8(acc, _mm256_shuffle_epi8(lookup, lo));
+      acc = _mm256_add_epi8(acc, _mm256_shuffle_epi8(lookup, hi));
+    }
+    total = _mm256_add_epi64(total, _mm256_sad_epu8(acc, zero));
+  }
+  uint64_t count = static_cast<uint64_t>(_mm256_extract_epi64(total, 0)) +
+                   static_cast<uint64_t>(_mm256_extract_epi64(total, 1)) +
+                   static_cast<uint64_t>(_mm256_extract_epi64(total, 2)) +
+                   static_cast<uint64_t>(_mm256_extract_epi64(total, 3));
+  return count + CountScalar(s + i, bytes - i);
+}
+
+#define PSTD_BIT_AVX2_OP(name, intrinsic, scalar)                                                        \
+  __attribute__((target("avx2"))) void name(unsigned char* dst, const unsigned char* src, size_t bytes) { \
+    size_t i = 0;                                                                                        \
+    for (; i + 32 <= bytes; i += 32) {                                                                   \
+      __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));                         \
+      __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));                         \
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), intrinsic(a, b));                         \
+    }                                                                                                    \
+    scalar(dst + i, src + i, bytes - i);                                                                 \
+  }
+
+PSTD_BIT_AVX2_OP(AndAVX2, _mm256_and_si256, AndScalar)
+PSTD_BIT_AVX2_OP(OrAVX2, _mm256_or_si256, OrScalar)
+PSTD_BIT_AVX2_OP(XorAVX2, _mm256_xor_si256, XorScalar)
+
+__attribute__((target("avx2"))) void NotAVX2(unsigned char* dst, size_t bytes) {
+  const __m256i ones = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 32 <= bytes; i += 32) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(a, ones));
+  }
+  NotScalar(dst + i, bytes - i);
+}
+
+__attribute__((target("avx2"))) size_t SkipAVX2(const unsigned char* s, size_t bytes, unsigned char skip) {
+  const __m256i skip_v = _mm256_set1_epi8(static_cast<char>(skip));
+  size_t i = 0;
+  for (; i + 32 <= bytes; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+    if (static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, skip_v))) != 0xffffffffU) {
+      return i;
+    }
+  }
+  return i + SkipScalar(s + i, bytes - i, skip);
+}
+
+/*
+ * AVX-512: VPOPCNTQ on 64 byte blocks
+ */
+#define PSTD_BIT_AVX512_TARGET __attribute__((target("avx512f,avx512bw,avx512vpopcntdq")))
+
+PSTD_BIT_AVX512_TARGET uint64_t CountAVX512(const unsigned char* s, size_t bytes) {
+  __m512i total = _mm512_setzero_si512();
+  size_t i = 0;
+  for (; i + 64 <= bytes; i += 64) {
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_loadu_si512(s + i)));
+  }
+  uint64_t lanes[8];
+  _mm512_storeu_si512(lanes, total);
+  uint64_t count = 0;
+  for (uint64_t lane : lanes) {
+    count += lane;
+  }
+  return count + CountScalar(s + i, bytes - i);
+}
+
+#define PSTD_BIT_AVX512_OP(name, intrinsic, scalar)                                            \
+  PSTD_BIT_AVX512_TARGET void name(unsigned char* dst, const unsigned char* src, size_t bytes) { \
+    size_t i = 0;                                                                              \
+    for (; i + 64 <= bytes; i += 64) {                                                         \
+      __m512i a = _mm512_loadu_si512(dst + i);                                                 \
+      __m512i b = _mm512_loadu_si512(src + i);                                                 \
+      _mm512_storeu_si512(dst + i, intrinsic(a, b));                                           \
+    }                                                                                          \
+    scalar(dst + i, src + i, bytes - i);                                                       \
+  }
+
+PSTD_BIT_AVX512_OP(AndAVX512, _mm512_and_si512, AndScalar)
+PSTD_BIT_AVX512_OP(OrAVX512, _mm512_or_si512, OrScalar)
+PSTD_BIT_AVX512_OP(XorAVX512, _mm512_xor_si512, XorScalar)
+
+PSTD_BIT_AVX512_TARGET void NotAVX512(unsigned char* dst, size_t bytes) {
+  const __m512i ones = _mm512_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 64 <= bytes; i += 64) {
+    _mm512_storeu_si512(dst + i, _mm512_xor_si512(_mm512_loadu_si512(dst + i), ones));
+  }
+  NotScalar(dst + i, bytes - i);
+}
+
+PSTD_BIT_AVX512_TARGET size_t SkipAVX512(const unsigned char* s, size_t bytes, unsigned char skip) {
+  const __m512i skip_v = _mm512_set1_epi8(static_cast<char>(skip));
+  size_t i = 0;
+  for (; i + 64 <= bytes; i += 64) {
+    if (_mm512_cmpneq_epi8_mask(_mm512_loadu_si512(s + i), skip_v) != 0) {
+      return i;
+    }
+  }
+  return i + SkipScalar(s + i, bytes - i, skip);
+}
+
+const BitKernels kSSE42Kernels = {CountSSE42, AndSSE42, OrSSE42, XorSSE42, NotSSE42, SkipSSE42};
+const BitKernels kAVX2Kernels = {CountAVX2, AndAVX2, OrAVX2, XorAVX2, NotAVX2, SkipAVX2};
+const BitKernels kAVX512Kernels = {CountAVX512, AndAVX512, OrAVX512, XorAVX512, NotAVX512, SkipAVX512};
+
+#endif  // PSTD_BIT_X86
+
+BitKernelLevel DetectBitKernelLevel() {
+#ifdef PSTD_BIT_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512vpopcntdq")) {
+    return BitKernelLevel::kAVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return BitKernelLevel::kAVX2;
+  }
+  if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+    return BitKernelLevel::kSSE42;
+  }
+#endif
+  return BitKernelLevel::kScalar;
+}
+
+const BitKernels& KernelsOf(BitKernelLevel level) {
+  switch (level) {
+#ifdef PSTD_BIT_X86
+    case BitKernelLevel::kAVX512:
+      return kAVX512Kernels;
+    case BitKernelLevel::kAVX2:
+      return kAVX2Kernels;
+    case BitKernelLevel::kSSE42:
+      return kSSE42Kernels;
+#endif
+    default:
+      return kScalarKernels;
+  }
+}
+
+const BitKernels& BestKernels() {
+  static const BitKernels& kernels = KernelsOf(BestBitKernelLevel());
+  return kernels;
+}
+
+int64_t BitPosWith(const BitKernels& kernels, const unsigned char* s, size_t bytes, int bit) {
+  size_t from = kernels.skip_bytes(s, bytes, bit == 0 ? 0xff : 0);
+  return FinishBitPos(s, bytes, bit, from);
+}
+
+}  // namespace
+
+BitKernelLevel BestBitKernelLevel() {
+  static const BitKernelLevel level = DetectBitKernelLevel();
+  return level;
+}
+
+bool BitKernelLevelSupported(BitKernelLevel level) {
+  return static_cast<int>(level) <= static_cast<int>(BestBitKernelLevel());
+}
+
+const char* BitKernelLevelName(BitKernelLevel level) {
+  switch (level) {
+    case BitKernelLevel::kScalar:
+      return "scalar";
+    case BitKernelLevel::kSSE42:
+      return "sse4.2";
+    case BitKernelLevel::kAVX2:
+      return "avx2";
+    case BitKernelLevel::kAVX512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+uint64_t BitCount(const unsigned char* s, size_t bytes) { return BestKernels().count(s, bytes); }
+
+void BitAnd(unsigned char* dst, const unsigned char* src, size_t bytes) { BestKernels().bit_and(dst, src, bytes); }
+
+void BitOr(unsigned char* dst, const unsigned char* src, size_t bytes) { BestKernels().bit_or(dst, src, bytes); }
+
+void BitXor(unsigned char* dst, const unsigned char* src, size_t bytes) { BestKernels().bit_xor(dst, src, bytes); }
+
+void BitNot(unsigned char* dst, size_t bytes) { BestKernels().bit_not(dst, bytes); }
+
+int64_t BitPos(const unsigned char* s, size_t bytes, int bit) { return BitPosWith(BestKernels(), s, bytes, bit); }
+
+uint64_t BitCount(BitKernelLevel level, const unsigned char* s, size_t bytes) {
+  return KernelsOf(level).count(s, bytes);
+}
+
+void BitAnd(BitKernelLevel level, unsigned char* dst, const unsigned char* src, size_t bytes) {
+  KernelsOf(level).bit_and(dst, src, bytes);
+}
+
+void BitOr(BitKernelLevel level, unsigned char* dst, const unsigned char* src, size_t bytes) {
+  KernelsOf(level).bit_or(dst, src, bytes);
+}
+
+void BitXor(BitKernelLevel level, unsigned char* dst, const unsigned char* src, size_t bytes) {
+  KernelsOf(level).bit_xor(dst, src, bytes);
+}
+
+void BitNot(BitKernelLevel level, unsigned char* dst, size_t bytes) { KernelsOf(level).bit_not(dst, bytes); }
+
+int64_t BitPos(BitKernelLevel level, const unsigned char* s, size_t bytes, int bit) {
+  return BitPosWith(KernelsOf(level), s, bytes, bit);
+}
+
+}  // namespace pstd
@@ -0,0 +1,122 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "pstd/include/thread_counters.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <unordered_map>
+
+namespace pstd {
+
+namespace {
+
+const size_t kCacheLineSize = 64;
+const size_t kCountersPerLine = kCacheLineSize / sizeof(std::atomic<uint64_t>);
+
+std::atomic<uint64_t> next_id{0};
+
+// The shards of this thread per instance id. The shards are owned by their
+// instance, an entry of a destroyed instance is never looked up again since
+// ids are not reused.
+struct LocalShards {
+  uint64_t last_id = UINT64_MAX;
+  std::atomic<uint64_t>* last_counters = nullptr;
+  std::unordered_map<uint64_t, std::atomic<uint64_t>*> counters;
+};
+
+thread_local LocalShards local_shards;
+
+}  // namespace
+
+// One flat array of counters per thread, it starts on a cache line and is
+// padded to whole lines so no other shard shares its lines
+struct ThreadCounters::Shard {
+  explicit Shard(size_t size) {
+    size_t padded = std::max<size_t>(1, (size + kCountersPerLine - 1) / kCountersPerLine) * kCountersPerLine;
+    void* memory = std::aligned_alloc(kCacheLineSize, padded * sizeof(std::atomic<uint64_t>));
+    if (memory == nullptr) {
+      throw std::bad_alloc();
+    }
+    counters_ = static_cast<std::atomic<uint64_t>*>(memory);
+    for (size_t index = 0; index < padded; ++index) {
+      new (&counters_[index]) std::atomic<uint64_t>(0);
+    }
+  }
+  ~Shard() { std::free(counters_); }
+  Shard(const Shard&) = delete;
+  Shard& operator=(const Shard&) = delete;
+
+  std::atomic<uint64_t>* counters() { return counters_; }
+
+ private:
+  std::atomic<uint64_t>* counters_ = nullptr;
+};
+
+ThreadCounters::ThreadCounters(size_t size)
+    : size_(size), id_(next_id.fetch_add(1, std::memory_order_relaxed)), base_(size, 0) {}
+
+ThreadCounters::~ThreadCounters() = default;
+
+std::atomic<uint64_t>* ThreadCounters::LocalCounters() {
+  // a thread mostly adds to one instance at a time
+  if (local_shards.last_id == id_) {
+    return local_shards.last_counters;
+  }
+  std::atomic<uint64_t>*& counters = local_shards.counters[id_];
+  if (counters == nullptr) {
+    counters = NewShard();
+  }
+  local_shards.last_id = id_;
+  local_shards.last_counters = counters;
+  return counters;
+}
+
+std::atomic<uint64_t>* ThreadCounters::NewShard() {
+  auto shard = std::make_unique<Shard>(size_);
+  std::atomic<uint64_t>* counters = shard->counters();
+  std::lock_guard l(mu_);
+  shards_.push_back(std::move(shard));
+  return counters;
+}
+
+uint64_t ThreadCounters::SumLocked(size_t index) const {
+  uint64_t sum = 0;
+  for (const auto& shard : shards_) {
+    sum += shard->counters()[index].load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+uint64_t ThreadCounters::Sum(size_t index) const {
+  std::lock_guard l(mu_);
+  return SumLocked(index) - base_[index];
+}
+
+void ThreadCounters::SumAllLocked(std::vector<uint64_t>* sums) const {
+  sums->assign(size_, 0);
+  for (const auto& shard : shards_) {
+    const std::atomic<uint64_t>* counters = shard->counters();
+    for (size_t index = 0; index < size_; ++index) {
+      (*sums)[index] += counters[index].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void ThreadCounters::SumAll(std::vector<uint64_t>* sums) const {
+  std::lock_guard l(mu_);
+  SumAllLocked(sums);
+  for (size_t index = 0; index < size_; ++index) {
+    (*sums)[index] -= base_[index];
+  }
+}
+
+void ThreadCounters::Reset() {
+  std::lock_guard l(mu_);
+  SumAllLocked(&base_);
+}
+
+}  // namespace pstd
@@ -0,0 +1,157 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "pstd/include/pstd_bit.h"
+
+namespace pstd {
+
+class BitTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    for (auto level : {BitKernelLevel::kScalar, BitKernelLevel::kSSE42, BitKernelLevel::kAVX2,
+                       BitKernelLevel::kAVX512}) {
+      if (BitKernelLevelSupported(level)) {
+        levels.push_back(level);
+      }
+    }
+  }
+
+  std::vector<unsigned char> RandomBytes(size_t len) {
+    std::vector<unsigned char> bytes(len);
+    for (auto& byte : bytes) {
+      byte = static_cast<unsigned char>(rnd() & 0xff);
+    }
+    return bytes;
+  }
+
+  static uint64_t RefCount(const unsigned char* s, size_t bytes) {
+    uint64_t count = 0;
+    for (size_t i = 0; i < bytes * 8; ++i) {
+      count += (s[i / 8] >> (7 - i % 8)) & 1;
+    }
+    return count;
+  }
+
+  static int64_t RefPos(const unsigned char* s, size_t bytes, int bit) {
+    for (size_t i = 0; i < bytes * 8; ++i) {
+      if (static_cast<int>((s[i / 8] >> (7 - i % 8)) & 1) == bit) {
+        return static_cast<int64_t>(i);
+      }
+    }
+    return -1;
+  }
+
+  std::vector<BitKernelLevel> levels;
+  std::mt19937 rnd{20240601};
+};
+
+// Every length up to a few vector widths, at every misalignment
+TEST_F(BitTest, BitCount) {
+  for (size_t len = 0; len <= 300; ++len) {
+    for (size_t shift = 0; shift < 8; ++shift) {
+      auto bytes = RandomBytes(len + shift);
+      const unsigned char* s = bytes.data() + shift;
+      uint64_t expect = RefCount(s, len);
+      for (auto level : levels) {
+        ASSERT_EQ(BitCount(level, s, len), expect) << BitKernelLevelName(level) << " len " << len;
+      }
+      ASSERT_EQ(BitCount(s, len), expect);
+    }
+  }
+
+  // Long enough to flush the byte counters of the AVX2 kernel many times
+  auto bytes = RandomBytes(1 << 20);
+  std::fill(bytes.begin() + 4096, bytes.begin() + 8192, 0xff);
+  uint64_t expect = RefCount(bytes.data(), bytes.size());
+  for (auto level : levels) {
+    ASSERT_EQ(BitCount(level, bytes.data(), bytes.size()), expect) << BitKernelLevelName(level);
+  }
+}
+
+TEST_F(BitTest, BitOp) {
+  for (size_t len = 0; len <= 300; ++len) {
+    for (size_t shift = 0; shift < 8; shift += 3) {
+      auto a = RandomBytes(len + shift);
+      auto b = RandomBytes(len + shift);
+      std::vector<unsigned char> and_expect(len);
+      std::vector<unsigned char> or_expect(len);
+      std::vector<unsigned char> xor_expect(len);
+      std::vector<unsigned char> not_expect(len);
+      for (size_t i = 0; i < len; ++i) {
+        and_expect[i] = a[shift + i] & b[shift + i];
+        or_expect[i] = a[shift + i] | b[shift + i];
+        xor_expect[i] = a[shift + i] ^ b[shift + i];
+        not_expect[i] = static_cast<unsigned char>(~a[shift + i]);
+      }
+      for (auto level : levels) {
+        auto dst = a;
+        BitAnd(level, dst.data() + shift, b.data() + shift, len);
+        ASSERT_TRUE(std::equal(and_expect.begin(), and_expect.end(), dst.begin() + shift))
+            << BitKernelLevelName(level) << " len " << len;
+        dst = a;
+        BitOr(level, dst.data() + shift, b.data() + shift, len);
+        ASSERT_TRUE(std::equal(or_expect.begin(), or_expect.end(), dst.begin() + shift))
+            << BitKernelLevelName(level) << " len " << len;
+        dst = a;
+        BitXor(level, dst.data() + shift, b.data() + shift, len);
+        ASSERT_TRUE(std::equal(xor_expect.begin(), xor_expect.end(), dst.begin() + shift))
+            << BitKernelLevelName(level) << " len " << len;
+        dst = a;
+        BitNot(level, dst.data() + shift, len);
+        ASSERT_TRUE(std::equal(not_expect.begin(), not_expect.end(), dst.begin() + shift))
+            << BitKernelLevelName(level) << " len " << len;
+        // bytes around the range are untouched
+        ASSERT_TRUE(std::equal(a.begin(), a.begin() + shift, dst.begin()));
+      }
+    }
+  }
+}
+
+// The only set (or clear) bit at every position of buffers of every length
+TEST_F(BitTest, BitPos) {
+  for (size_t len = 0; len <= 200; ++len) {
+    for (int bit = 0; bit <= 1; ++bit) {
+      std::vector<unsigned char> bytes(len, bit == 0 ? 0xff : 0);
+      for (auto level : levels) {
+        ASSERT_EQ(BitPos(level, bytes.data(), len, bit), -1) << BitKernelLevelName(level) << " len " << len;
+      }
+      for (size_t pos = 0; pos < len * 8; ++pos) {
+        bytes[pos / 8] ^= static_cast<unsigned char>(0x80 >> (pos % 8));
+        for (auto level : levels) {
+          ASSERT_EQ(BitPos(level, bytes.data(), len, bit), static_cast<int64_t>(pos))
+              << BitKernelLevelName(level) << " len " << len;
+        }
+        bytes[pos / 8] ^= static_cast<unsigned char>(0x80 >> (pos % 8));
+      }
+    }
+  }
+
+  for (size_t len = 0; len <= 300; ++len) {
+    for (size_t shift = 0; shift < 8; ++shift) {
+      auto bytes = RandomBytes(len + shift);
+      // mostly skipped bytes with a few random ones
+      for (size_t i = 0; i < bytes.size(); ++i) {
+        if (rnd() % 64 != 0) {
+          bytes[i] = i % 2 == 0 ? 0 : bytes[i];
+        }
+      }
+      const unsigned char* s = bytes.data() + shift;
+      for (int bit = 0; bit <= 1; ++bit) {
+        int64_t expect = RefPos(s, len, bit);
+        for (auto level : levels) {
+          ASSERT_EQ(BitPos(level, s, len, bit), expect) << BitKernelLevelName(level) << " len " << len;
+        }
+        ASSERT_EQ(BitPos(s, len, bit), expect);
+      }
+    }
+  }
+}
+
+}  // namespace pstd
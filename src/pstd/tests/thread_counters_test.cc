@@ -0,0 +1,92 @@
+// Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "pstd/include/thread_counters.h"
+
+namespace pstd {
+
+TEST(ThreadCountersTest, SingleThread) {
+  ThreadCounters counters(10);
+  ASSERT_EQ(counters.size(), 10);
+  for (size_t index = 0; index < 10; ++index) {
+    ASSERT_EQ(counters.Sum(index), 0);
+  }
+  counters.Add(0, 1);
+  counters.Add(0, 2);
+  counters.Add(9, 5);
+  ASSERT_EQ(counters.Sum(0), 3);
+  ASSERT_EQ(counters.Sum(1), 0);
+  ASSERT_EQ(counters.Sum(9), 5);
+
+  std::vector<uint64_t> sums;
+  counters.SumAll(&sums);
+  ASSERT_EQ(sums.size(), 10);
+  ASSERT_EQ(sums[0], 3);
+  ASSERT_EQ(sums[9], 5);
+}
+
+TEST(ThreadCountersTest, ManyThreads) {
+  const size_t thread_num = 8;
+  const uint64_t adds = 100000;
+  ThreadCounters counters(3);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&counters, t, adds]() {
+      for (uint64_t i = 0; i < adds; ++i) {
+        counters.Add(0, 1);
+        counters.Add(1 + t % 2, 2);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // the counts of exited threads are kept
+  ASSERT_EQ(counters.Sum(0), thread_num * adds);
+  ASSERT_EQ(counters.Sum(1), thread_num / 2 * adds * 2);
+  ASSERT_EQ(counters.Sum(2), thread_num / 2 * adds * 2);
+}
+
+TEST(ThreadCountersTest, Reset) {
+  ThreadCounters counters(2);
+  counters.Add(0, 7);
+  std::thread other([&counters]() { counters.Add(1, 3); });
+  other.join();
+  counters.Reset();
+  ASSERT_EQ(counters.Sum(0), 0);
+  ASSERT_EQ(counters.Sum(1), 0);
+
+  counters.Add(0, 1);
+  std::thread again([&counters]() { counters.Add(1, 4); });
+  again.join();
+  ASSERT_EQ(counters.Sum(0), 1);
+  ASSERT_EQ(counters.Sum(1), 4);
+}
+
+TEST(ThreadCountersTest, Instances) {
+  // one thread adding to many instances keeps them apart
+  ThreadCounters first(1);
+  ThreadCounters second(1);
+  for (int i = 0; i < 10; ++i) {
+    first.Add(0, 1);
+    second.Add(0, 2);
+  }
+  ASSERT_EQ(first.Sum(0), 10);
+  ASSERT_EQ(second.Sum(0), 20);
+  {
+    ThreadCounters gone(1);
+    gone.Add(0, 1);
+  }
+  ThreadCounters third(1);
+  third.Add(0, 1);
+  ASSERT_EQ(third.Sum(0), 1);
+  ASSERT_EQ(first.Sum(0), 10);
+}
+
+}  // namespace pstd
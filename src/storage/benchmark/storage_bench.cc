@@ -226,6 +226,244 @@ void BenchScan() {
   std::cout << "Test case 3, Scan " << kv_num << " Cost: " << cost << "s" << std::endl;
 }
 
+void BenchMGet() {
+  printf("====== MGet ======\n");
+  storage::StorageOptions storage_options;
+  storage_options.options.create_if_missing = true;
+  storage::Storage db;
+  storage::Status s = db.Open(storage_options, "./db");
+
+  if (!s.ok()) {
+    printf("Open db failed, error: %s\n", s.ToString().c_str());
+    return;
+  }
+
+  const size_t total_keys = 1000000;
+  const std::string mget_value(128, 'v');
+  std::vector<storage::KeyValue> kvs;
+  for (size_t i = 0; i < total_keys; ++i) {
+    kvs.push_back({"MGET_KEY_" + std::to_string(i), mget_value});
+    if (kvs.size() == 1000) {
+      db.MSet(kvs);
+      kvs.clear();
+    }
+  }
+
+  // Compare the batched MGet (one MultiGet per rocksdb instance) with the
+  // same keys read one by one through Get
+  const size_t rounds = 2000;
+  std::vector<std::string> keys;
+  std::vector<storage::ValueStatus> vss;
+  for (size_t batch_size : {1, 10, 50, 100, 200, 500}) {
+    auto start = system_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+      keys.clear();
+      for (size_t i = 0; i < batch_size; ++i) {
+        keys.push_back("MGET_KEY_" + std::to_string((r * 7919 + i * 104729) % total_keys));
+      }
+      db.MGet(keys, &vss);
+    }
+    auto end = system_clock::now();
+    auto batched_cost = duration_cast<microseconds>(end - start).count();
+
+    std::string value;
+    start = system_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+      keys.clear();
+      for (size_t i = 0; i < batch_size; ++i) {
+        keys.push_back("MGET_KEY_" + std::to_string((r * 7919 + i * 104729) % total_keys));
+      }
+      for (const auto& k : keys) {
+        db.Get(k, &value);
+      }
+    }
+    end = system_clock::now();
+    auto serial_cost = duration_cast<microseconds>(end - start).count();
+
+    std::cout << "MGet batch size " << batch_size << ", " << rounds << " rounds, MultiGet cost: " << batched_cost
+              << "us, serial Get cost: " << serial_cost << "us, avg per key: "
+              << static_cast<double>(batched_cost) / (rounds * batch_size) << "us vs "
+              << static_cast<double>(serial_cost) / (rounds * batch_size) << "us" << std::endl;
+  }
+}
+
+void BenchPinnedGet() {
+  printf("====== Pinned Get ======\n");
+  storage::StorageOptions storage_options;
+  storage_options.options.create_if_missing = true;
+  storage::Storage db;
+  storage::Status s = db.Open(storage_options, "./db");
+
+  if (!s.ok()) {
+    printf("Open db failed, error: %s\n", s.ToString().c_str());
+    return;
+  }
+
+  // Compare Get into a string with Get through a pinned slice, the reply
+  // buffer stands for the RESP reply both end up in
+  const size_t keys_per_size = 1000;
+  const size_t rounds = 100;
+  for (size_t value_size : {64, 1024, 4096, 16384, 65536}) {
+    const std::string prefix = "PINNED_KEY_" + std::to_string(value_size) + "_";
+    const std::string pinned_value_data(value_size, 'v');
+    for (size_t i = 0; i < keys_per_size; ++i) {
+      db.Set(prefix + std::to_string(i), pinned_value_data);
+    }
+
+    std::string reply;
+    std::string value;
+    auto start = system_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+      for (size_t i = 0; i < keys_per_size; ++i) {
+        db.Get(prefix + std::to_string(i), &value);
+        reply.assign(value);
+      }
+    }
+    auto end = system_clock::now();
+    auto copied_cost = duration_cast<microseconds>(end - start).count();
+
+    rocksdb::PinnableSlice pinned_value;
+    Slice pinned;
+    start = system_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+      for (size_t i = 0; i < keys_per_size; ++i) {
+        db.Get(prefix + std::to_string(i), &pinned_value, &pinned);
+        reply.assign(pinned.data(), pinned.size());
+        pinned_value.Reset();
+      }
+    }
+    end = system_clock::now();
+    auto pinned_cost = duration_cast<microseconds>(end - start).count();
+
+    std::cout << "Get value size " << value_size << ", " << rounds * keys_per_size
+              << " reads, string cost: " << copied_cost << "us, pinned cost: " << pinned_cost << "us, avg per read: "
+              << static_cast<double>(copied_cost) / (rounds * keys_per_size) << "us vs "
+              << static_cast<double>(pinned_cost) / (rounds * keys_per_size) << "us" << std::endl;
+  }
+}
+
+void BenchSetAlgebra() {
+  printf("====== Set Algebra ======\n");
+  storage::StorageOptions storage_options;
+  storage_options.options.create_if_missing = true;
+  storage::Storage db;
+  storage::Status s = db.Open(storage_options, "./db");
+
+  if (!s.ok()) {
+    printf("Open db failed, error: %s\n", s.ToString().c_str());
+    return;
+  }
+
+  // The keys share a hash tag so every command is combined inside one
+  // instance. large holds members 0..large_size, half the members of
+  // medium and all of small are in it as well
+  const size_t large_size = 1000000;
+  const size_t medium_size = 100000;
+  const size_t small_size = 10;
+  const std::string large_key = "{SET_ALGEBRA}_LARGE";
+  const std::string medium_key = "{SET_ALGEBRA}_MEDIUM";
+  const std::string small_key = "{SET_ALGEBRA}_SMALL";
+  int32_t ret = 0;
+  std::vector<std::string> members;
+  for (size_t i = 0; i < large_size; ++i) {
+    members.push_back("MEMBER_" + std::to_string(i));
+    if (members.size() == 1000) {
+      db.SAdd(large_key, members, &ret);
+      members.clear();
+    }
+  }
+  for (size_t i = 0; i < medium_size; ++i) {
+    members.push_back("MEMBER_" + std::to_string(i * 2 + (i % 2) * large_size));
+    if (members.size() == 1000) {
+      db.SAdd(medium_key, members, &ret);
+      members.clear();
+    }
+  }
+  for (size_t i = 0; i < small_size; ++i) {
+    members.push_back("MEMBER_" + std::to_string(i * 7919));
+  }
+  db.SAdd(small_key, members, &ret);
+
+  struct AlgebraCase {
+    std::string name;
+    std::function<storage::Status(std::vector<std::string>*)> run;
+    size_t rounds;
+  };
+  std::vector<AlgebraCase> cases = {
+      {"SINTER small large", [&](auto* out) { return db.SInter({small_key, large_key}, out); }, 1000},
+      {"SINTER large small", [&](auto* out) { return db.SInter({large_key, small_key}, out); }, 1000},
+      {"SINTER medium large", [&](auto* out) { return db.SInter({medium_key, large_key}, out); }, 10},
+      {"SDIFF small large", [&](auto* out) { return db.SDiff({small_key, large_key}, out); }, 1000},
+      {"SDIFF medium large", [&](auto* out) { return db.SDiff({medium_key, large_key}, out); }, 10},
+      {"SDIFF large medium", [&](auto* out) { return db.SDiff({large_key, medium_key}, out); }, 3},
+      {"SUNION small medium", [&](auto* out) { return db.SUnion({small_key, medium_key}, out); }, 10},
+      {"SUNION medium large", [&](auto* out) { return db.SUnion({medium_key, large_key}, out); }, 3},
+  };
+  std::vector<std::string> out;
+  for (const auto& algebra_case : cases) {
+    auto start = system_clock::now();
+    for (size_t r = 0; r < algebra_case.rounds; ++r) {
+      out.clear();
+      algebra_case.run(&out);
+    }
+    auto end = system_clock::now();
+    auto cost = duration_cast<microseconds>(end - start).count();
+    std::cout << algebra_case.name << ", " << algebra_case.rounds << " rounds, " << out.size()
+              << " members, avg cost: " << static_cast<double>(cost) / algebra_case.rounds << "us" << std::endl;
+  }
+}
+
+void BenchSRandmember() {
+  printf("====== SRandmember ======\n");
+  storage::StorageOptions storage_options;
+  storage_options.options.create_if_missing = true;
+  storage::Storage db;
+  storage::Status s = db.Open(storage_options, "./db");
+
+  if (!s.ok()) {
+    printf("Open db failed, error: %s\n", s.ToString().c_str());
+    return;
+  }
+
+  // The cost should follow count and stay flat across set sizes
+  int32_t ret = 0;
+  std::vector<std::string> members;
+  std::vector<std::string> out;
+  for (size_t set_size : {10000, 100000, 1000000}) {
+    const std::string key = "SRANDMEMBER_" + std::to_string(set_size);
+    for (size_t i = 0; i < set_size; ++i) {
+      members.push_back("MEMBER_" + std::to_string(i));
+      if (members.size() == 1000) {
+        db.SAdd(key, members, &ret);
+        members.clear();
+      }
+    }
+    db.SAdd(key, members, &ret);
+    members.clear();
+
+    const size_t rounds = 1000;
+    for (int32_t count : {1, 10, 100, -100}) {
+      auto start = system_clock::now();
+      for (size_t r = 0; r < rounds; ++r) {
+        db.SRandmember(key, count, &out);
+      }
+      auto end = system_clock::now();
+      auto cost = duration_cast<microseconds>(end - start).count();
+      std::cout << "SRANDMEMBER " << set_size << " members, count " << count
+                << ", avg cost: " << static_cast<double>(cost) / rounds << "us" << std::endl;
+    }
+    auto start = system_clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+      out.clear();
+      db.SPop(key, &out, 1);
+    }
+    auto end = system_clock::now();
+    auto cost = duration_cast<microseconds>(end - start).count();
+    std::cout << "SPOP " << set_size << " members, count 1, avg cost: "
+              << static_cast<double>(cost) / rounds << "us" << std::endl;
+  }
+}
+
 int main(int argc, char** argv) {
   // keys
   BenchSet();
@@ -235,4 +473,14 @@ int main(int argc, char** argv) {
 
   // Iterator
   BenchScan();
+
+  // batched reads
+  BenchMGet();
+
+  // pinned point reads
+  BenchPinnedGet();
+
+  // sets
+  BenchSetAlgebra();
+  BenchSRandmember();
 }
@@ -53,6 +53,7 @@ using Status = rocksdb::Status;
 using Slice = rocksdb::Slice;
 
 class Redis;
+class KeyspaceScanPool;
 enum class OptionType;
 
 struct StreamAddTrimArgs;
@@ -74,6 +75,20 @@ struct StorageOptions {
   bool enable_db_statistics = false;
   size_t small_compaction_threshold = 5000;
   size_t small_compaction_duration_threshold = 10000;
+  // zsets with at least this many members get a rank index, 0 disables it
+  size_t zset_rank_index_threshold = 0;
+  // bytes of the SRANDMEMBER/SPOP sample indexes cached per instance
+  size_t sets_sample_cache_size = 32 << 20;
+  // threads of one full keyspace scan (KEYS, key counting, pattern deletes)
+  size_t keyspace_scan_threads = 4;
+  // keeps keys with a TTL in expire_index_cf ordered by expiration time
+  bool enable_expire_index = false;
+  // keeps the codis slot index of the keys in slot_index_cf
+  bool enable_slot_index = false;
+  // lists created while it is not 0 keep their elements in chunks of up to this many
+  size_t list_chunk_max_elements = 0;
+  // hashes and sets created while it is not 0 keep up to this many entries in their meta
+  size_t inline_collection_max_entries = 0;
   Status ResetOptions(const OptionType& option_type, const std::unordered_map<std::string, std::string>& options_map);
 };
 
@@ -140,6 +155,22 @@ struct ScoreMember {
   bool operator==(const ScoreMember& sm) const { return (sm.score == score && sm.member == member); }
 };
 
+/*
+ * A write of a replicated command that is applied in one WriteBatch with the
+ * writes of other keys, see Storage::ApplyStagedWrites. kSet is SET without
+ * options, kHSet and kHMSet are HSET and HMSET, kHSet has one field value.
+ */
+struct StagedWrite {
+  enum Type { kSet, kHSet, kHMSet };
+  Type type = kSet;
+  std::string key;
+  std::string value;
+  std::vector<FieldValue> fvs;
+  // set by ApplyStagedWrites, ret is the reply of HSET
+  Status status;
+  int32_t ret = 0;
+};
+
 enum BeforeOrAfter { Before, After };
 
 enum class OptionType {
@@ -156,7 +187,9 @@ enum BitOpType { kBitOpAnd = 1, kBitOpOr, kBitOpXor, kBitOpNot, kBitOpDefault };
 enum Operation {
   kNone = 0,
   kCleanAll,
-  kCompactRange
+  kCompactRange,
+  kReconcileKeyCounters,
+  kBackfillExpireIndex
 };
 
 struct BGTask {
@@ -185,6 +218,40 @@ class Storage {
 
   std::unique_ptr<Redis>& GetDBInstance(const std::string& key);
 
+  // Group keys by the rocksdb instance they are routed to, inst_key_positions
+  // holds the position of every grouped key in the original request
+  void GroupKeysByInstance(const std::vector<std::string>& keys,
+                           std::vector<std::vector<size_t>>* inst_key_positions,
+                           std::vector<std::vector<Slice>>* inst_keys);
+  std::vector<std::vector<KeyValue>> GroupKeyValuesByInstance(const std::vector<KeyValue>& kvs);
+  // The instance all of keys are routed to, nullptr when they span several
+  Redis* SingleInstanceOf(const std::vector<std::string>& keys);
+
+  int GetSlotNum() const { return slot_num_; }
+
+  // Codis slot index kept by pika for slot migration, every key is indexed
+  // under its slot and, if it has a hash tag, under its tag. Members are
+  // the key type tag followed by the key, like the legacy slot sets.
+  // While it is enabled the writes of the keys keep it, see
+  // slot_index_counts.h. SlotIndexAdd indexes a stored key written while
+  // it was off, type is ignored, the index keeps the type of the meta.
+  Status SlotIndexAdd(const std::string& key, char type);
+  // Drops the entries of a key that is gone, NotFound if key is not
+  // indexed, Busy if it is stored, its writes keep the entries
+  Status SlotIndexDel(const std::string& key);
+  // Same under slot_id, which a scan of the slot found even if key hashes
+  // to another slot now
+  Status SlotIndexDel(uint32_t slot_id, const std::string& key);
+  // Scans the keys of the slot the way SScan scans a set
+  Status SlotIndexScan(uint32_t slot_id, int64_t cursor, const std::string& pattern, int64_t count,
+                       std::vector<std::string>* type_keys, int64_t* next_cursor);
+  // every key sharing the hash tag of key
+  Status SlotIndexTagKeys(const std::string& key, std::vector<std::string>* type_keys);
+  Status SlotIndexCount(uint32_t slot_id, int64_t* count);
+  // Drops the entries the slot has for keys that are gone, count is the
+  // number of entries dropped
+  Status SlotIndexDelSlot(uint32_t slot_id, int64_t* count);
+
   // Strings Commands
 
   // Set key to hold the string value. if key
@@ -202,6 +269,12 @@ class Storage {
   // the special value nil is returned. If the key has no ttl, ttl is -1
   Status GetWithTTL(const Slice& key, std::string* value, int64_t* ttl_millsec);
 
+  // Get and GetWithTTL without copying the value out of rocksdb, value
+  // points into pinned_value, usually a block cache entry, and is valid
+  // until pinned_value is reset or destroyed. Release it before Close
+  Status Get(const Slice& key, rocksdb::PinnableSlice* pinned_value, Slice* value);
+  Status GetWithTTL(const Slice& key, rocksdb::PinnableSlice* pinned_value, Slice* value, int64_t* ttl_millsec);
+
   // Atomically sets key to value and returns the old value stored at key
   // Returns an error when key exists but does not hold a string value.
   Status GetSet(const Slice& key, const Slice& value, std::string* old_value);
@@ -213,7 +286,8 @@ class Storage {
   Status GetBit(const Slice& key, int64_t offset, int32_t* ret);
 
   // Sets the given keys to their respective values
-  // MSET replaces existing values with new values
+  // MSET replaces existing values with new values, the keys of one
+  // rocksdb instance are written atomically with a single WriteBatch
   Status MSet(const std::vector<KeyValue>& kvs);
 
   // Returns the values of all specified keys. For every key
@@ -1070,6 +1144,12 @@ class Storage {
   // HyperLogLog structures.
   Status PfMerge(const std::vector<std::string>& keys, std::string& value_to_dest);
 
+  // Applies the writes of every instance with one WriteBatch under the
+  // record locks of all their keys, the keys must be distinct. Sets the
+  // status of each write, a write that fails its checks is left out and the
+  // others are applied. Returns the first failed batch write
+  Status ApplyStagedWrites(std::vector<StagedWrite>* writes);
+
   // Admin Commands
   Status StartBGThread();
   Status RunBGTask();
@@ -1083,14 +1163,35 @@ class Storage {
   Status SetMaxCacheStatisticKeys(uint32_t max_cache_statistic_keys);
   Status SetSmallCompactionThreshold(uint32_t small_compaction_threshold);
   Status SetSmallCompactionDurationThreshold(uint32_t small_compaction_duration_threshold);
+  void SetKeyspaceScanThreads(size_t keyspace_scan_threads);
+  size_t GetKeyspaceScanThreads() const;
+  // the threads of the full keyspace scans, see keyspace_scan.h
+  KeyspaceScanPool* GetKeyspaceScanPool() const { return keyspace_scan_pool_.get(); }
+  // the keys written while it is off are indexed by SlotIndexAdd
+  void SetSlotIndexEnabled(bool enabled);
 
   std::string GetCurrentTaskType();
   Status GetUsage(const std::string& property, uint64_t* result);
   Status GetUsage(const std::string& property, std::map<int, uint64_t>* type_result);
   uint64_t GetProperty(const std::string& property);
 
+  // full scan of every instance, also resets the keyspace counters
   Status GetKeyNum(std::vector<KeyInfo>* key_infos);
   Status StopScanKeyNum();
+  // the incrementally maintained keyspace counters, keys whose TTL passed
+  // count until they are reclaimed, avg_ttl is not tracked. Incomplete until
+  // every instance finished its first full scan
+  Status GetKeyCounters(std::vector<KeyInfo>* key_infos);
+
+  // Active expiration, needs enable_expire_index. Collects at most count
+  // keys whose TTL passed, the oldest first. lag is how long ago the oldest
+  // of them expired, 0 when none did
+  Status ScanExpiredKeys(int64_t count, std::vector<std::string>* keys, int64_t* lag_millsec);
+  // deletes the keys that are still expired, reaped gets the deleted ones.
+  // The caller keeps other writers of these keys away until it replicated
+  // the deletes
+  Status ReapExpiredKeys(const std::vector<std::string>& keys, std::vector<std::string>* reaped);
+  bool ExpireIndexEnabled() const { return enable_expire_index_; }
 
   rocksdb::DB* GetDBByIndex(int index);
 
@@ -1129,6 +1230,10 @@ class Storage {
 
   // For scan keys in data base
   std::atomic<bool> scan_keynum_exit_ = {false};
+  std::unique_ptr<KeyspaceScanPool> keyspace_scan_pool_;
+  bool enable_expire_index_ = false;
+  // the instance slot_id is routed to
+  std::unique_ptr<Redis>& GetSlotInstance(uint32_t slot_id);
   Status MGetWithTTL(const Slice& key, std::string* value, int64_t* ttl_millsec);
 };
 
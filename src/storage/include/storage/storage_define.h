@@ -44,6 +44,10 @@ enum ColumnFamilyIndex {
   kZsetsDataCF = 4,
   kZsetsScoreCF = 5,
   kStreamsDataCF = 6,
+  kZsetsRankCF = 7,
+  kSlotIndexCF = 8,
+  kKeyCountCF = 9,
+  kExpireIndexCF = 10,
 };
 
 const static char kNeedTransformCharacter = '\u0000';
@@ -13,6 +13,7 @@
 #include "glog/logging.h"
 #include "rocksdb/compaction_filter.h"
 #include "src/base_data_key_format.h"
+#include "src/base_key_format.h"
 #include "src/base_value_format.h"
 #include "src/base_meta_value_format.h"
 #include "src/lists_meta_value_format.h"
@@ -20,14 +21,39 @@
 #include "src/strings_value_format.h"
 #include "src/zsets_data_key_format.h"
 #include "src/debug.h"
+#include "src/key_counters.h"
+#include "src/lock_mgr.h"
+#include "src/slot_index_counts.h"
 
 namespace storage {
 
 class BaseMetaFilter : public rocksdb::CompactionFilter {
  public:
-  BaseMetaFilter() = default;
+  BaseMetaFilter(rocksdb::DB* db = nullptr, std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr = nullptr,
+                 KeyCounters* key_counters = nullptr, SlotIndexCounts* slot_index_counts = nullptr,
+                 LockMgr* lock_mgr = nullptr)
+      : db_(db), cf_handles_ptr_(cf_handles_ptr), key_counters_(key_counters), slot_index_counts_(slot_index_counts),
+        lock_mgr_(lock_mgr) {}
+
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
+    if (IsMetaMarker(key) || !ShouldDrop(key, value)) {
+      return false;
+    }
+    if (key_counters_ != nullptr) {
+      return CountDropped(key, value);
+    }
+    return true;
+  }
+
+  // FilterBlobByKey is left undetermined: the ttl and type of a meta are in
+  // its value, rocksdb reads a string moved to a blob file back and calls
+  // Filter with it
+
+  const char* Name() const override { return "BaseMetaFilter"; }
+
+ private:
+  bool ShouldDrop(const rocksdb::Slice& key, const rocksdb::Slice& value) const {
     auto cur_time = pstd::NowMillis();
     /*
      * For the filtering of meta information, because the field designs of string
@@ -94,17 +120,76 @@ class BaseMetaFilter : public rocksdb::CompactionFilter {
     }
   }
 
-  const char* Name() const override { return "BaseMetaFilter"; }
+  // Only the current meta of a key leaves the keyspace and slot counters,
+  // an older one was already replaced by a write that counted the
+  // difference. The current one is dropped only while no writer holds its
+  // record lock, the filter can't wait for a writer stalled on this very
+  // compaction. False keeps the meta for a later compaction.
+  bool CountDropped(const rocksdb::Slice& key, const rocksdb::Slice& value) const {
+    // opening or closing the database
+    if (db_ == nullptr || cf_handles_ptr_ == nullptr || cf_handles_ptr_->empty() || lock_mgr_ == nullptr) {
+      return false;
+    }
+    std::string user_key = ParsedBaseMetaKey(key).Key().ToString();
+    if (!lock_mgr_->LockIfFree(user_key).ok()) {
+      return false;
+    }
+    std::string cur_value;
+    Status s = db_->Get(default_read_options_, (*cf_handles_ptr_)[0], key, &cur_value);
+    bool drop = true;
+    if (s.ok() && value == Slice(cur_value)) {
+      if (key_counters_->DroppedFull()) {
+        drop = false;
+      } else if (key_counters_->AddDropped(key, value)) {
+        KeyCounters::Deltas deltas{};
+        KeyCounters::CountMeta(value, -1, &deltas);
+        key_counters_->Apply(deltas);
+        key_counters_->AddPending(deltas);
+        if (slot_index_counts_ != nullptr) {
+          slot_index_counts_->AddDropped(key, value);
+        }
+      }
+    } else if (!s.ok() && !s.IsNotFound()) {
+      drop = false;
+    }
+    lock_mgr_->UnLock(user_key);
+    return drop;
+  }
+
+  rocksdb::DB* db_ = nullptr;
+  std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr_ = nullptr;
+  KeyCounters* key_counters_ = nullptr;
+  SlotIndexCounts* slot_index_counts_ = nullptr;
+  LockMgr* lock_mgr_ = nullptr;
+  rocksdb::ReadOptions default_read_options_;
 };
 
 class BaseMetaFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-  BaseMetaFilterFactory() = default;
+  BaseMetaFilterFactory(rocksdb::DB** db_ptr = nullptr, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr = nullptr,
+                        KeyCounters* key_counters = nullptr, SlotIndexCounts* slot_index_counts = nullptr,
+                        LockMgr* lock_mgr = nullptr)
+      : db_ptr_(db_ptr), cf_handles_ptr_(handles_ptr), key_counters_(key_counters),
+        slot_index_counts_(slot_index_counts), lock_mgr_(lock_mgr) {}
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context& context) override {
-    return std::unique_ptr<rocksdb::CompactionFilter>(new BaseMetaFilter());
+    rocksdb::DB* db = db_ptr_ != nullptr ? *db_ptr_ : nullptr;
+    // the metas dropped by the compactions installed since the last one
+    if (db != nullptr && key_counters_ != nullptr && lock_mgr_ != nullptr && cf_handles_ptr_ != nullptr &&
+        !cf_handles_ptr_->empty()) {
+      key_counters_->SweepDropped(db, (*cf_handles_ptr_)[0], lock_mgr_);
+    }
+    return std::unique_ptr<rocksdb::CompactionFilter>(
+        new BaseMetaFilter(db, cf_handles_ptr_, key_counters_, slot_index_counts_, lock_mgr_));
   }
   const char* Name() const override { return "BaseMetaFilterFactory"; }
+
+ private:
+  rocksdb::DB** db_ptr_ = nullptr;
+  std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr_ = nullptr;
+  KeyCounters* key_counters_ = nullptr;
+  SlotIndexCounts* slot_index_counts_ = nullptr;
+  LockMgr* lock_mgr_ = nullptr;
 };
 
 class BaseDataFilter : public rocksdb::CompactionFilter {
@@ -194,22 +279,17 @@ class BaseDataFilter : public rocksdb::CompactionFilter {
     }
   }
 
-  /*
-  // Only judge by meta value ttl
-  virtual rocksdb::CompactionFilter::Decision FilterBlobByKey(int level, const Slice& key,
-      uint64_t expire_time, std::string* new_value, std::string* skip_until) const override {
-    UNUSED(level);
-    UNUSED(expire_time);
-    UNUSED(new_value);
+  // A data key is dropped by its version and the meta of its key, so a
+  // value moved to a blob file is never read back to decide
+  rocksdb::CompactionFilter::Decision FilterBlobByKey(int level, const Slice& key, std::string* new_value,
+                                                      std::string* skip_until) const override {
     UNUSED(skip_until);
-    bool unused_value_changed;
-    bool should_remove = Filter(level, key, Slice{}, new_value, &unused_value_changed);
-    if (should_remove) {
-      return CompactionFilter::Decision::kRemove;
+    bool unused_value_changed = false;
+    if (Filter(level, key, Slice{}, new_value, &unused_value_changed)) {
+      return rocksdb::CompactionFilter::Decision::kRemove;
     }
-    return CompactionFilter::Decision::kKeep;
+    return rocksdb::CompactionFilter::Decision::kKeep;
   }
-  */
 
   const char* Name() const override { return "BaseDataFilter"; }
 
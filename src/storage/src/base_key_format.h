@@ -6,6 +6,8 @@
 #ifndef SRC_BASE_KEY_FORMAT_H_
 #define SRC_BASE_KEY_FORMAT_H_
 
+#include <string>
+
 #include "storage/storage_define.h"
 
 namespace storage {
@@ -95,5 +97,16 @@ protected:
 using ParsedBaseMetaKey = ParsedBaseKey;
 using BaseMetaKey = BaseKey;
 
+/*
+ * Reserved keys of the meta cf, the markers of an instance. Every meta key
+ * starts with the zeroed reserve1 of BaseKey, these start with 0xff, sort
+ * after all of them and are no meta, the scans of the meta cf skip them.
+ */
+const char kMetaMarkerPrefix = '\xff';
+
+inline std::string MetaMarkerKey(const std::string& name) { return std::string(1, kMetaMarkerPrefix) + name; }
+
+inline bool IsMetaMarker(const Slice& meta_key) { return !meta_key.empty() && meta_key[0] == kMetaMarkerPrefix; }
+
 }  //  namespace storage
 #endif  // SRC_BASE_KEY_FORMAT_H_
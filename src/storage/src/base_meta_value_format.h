@@ -157,6 +157,8 @@ class ParsedBaseMetaValue : public ParsedInternalValue {
     this->SetCount(0);
     this->SetEtime(0);
     this->SetCtime(0);
+    this->SetRankIndexed(false);
+    this->SetInline(false);
     return this->UpdateVersion();
   }
 
@@ -209,8 +211,41 @@ class ParsedBaseMetaValue : public ParsedInternalValue {
     return version_;
   }
 
+  // zsets only, zset_rank_cf holds the rank index of the current version
+  bool RankIndexed() { return (reserve_[0] & kRankIndexedFlag) != 0; }
+
+  void SetRankIndexed(bool indexed) {
+    if (indexed) {
+      reserve_[0] = static_cast<char>(reserve_[0] | kRankIndexedFlag);
+    } else {
+      reserve_[0] = static_cast<char>(reserve_[0] & ~kRankIndexedFlag);
+    }
+    if (value_) {
+      char* dst = const_cast<char*>(value_->data()) + value_->size() - kBaseMetaValueSuffixLength + kVersionLength;
+      *dst = reserve_[0];
+    }
+  }
+
+  // hashes and sets only, the entries are in the user value, see
+  // inline_collection_format.h
+  bool Inline() { return (reserve_[0] & kInlineFlag) != 0; }
+
+  void SetInline(bool is_inline) {
+    if (is_inline) {
+      reserve_[0] = static_cast<char>(reserve_[0] | kInlineFlag);
+    } else {
+      reserve_[0] = static_cast<char>(reserve_[0] & ~kInlineFlag);
+    }
+    if (value_) {
+      char* dst = const_cast<char*>(value_->data()) + value_->size() - kBaseMetaValueSuffixLength + kVersionLength;
+      *dst = reserve_[0];
+    }
+  }
+
  private:
   static const size_t kBaseMetaValueSuffixLength = kVersionLength + kSuffixReserveLength + 2 * kTimestampLength;
+  static const char kRankIndexedFlag = 0x01;
+  static const char kInlineFlag = 0x02;
   int32_t count_ = 0;
 };
 
@@ -0,0 +1,91 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_EXPIRE_INDEX_FORMAT_H_
+#define SRC_EXPIRE_INDEX_FORMAT_H_
+
+#include <string>
+
+#include "rocksdb/slice.h"
+
+#include "src/base_meta_value_format.h"
+#include "src/lists_meta_value_format.h"
+#include "src/strings_value_format.h"
+
+namespace storage {
+
+using Slice = rocksdb::Slice;
+
+/*
+ * Expiry index, stored in expire_index_cf when enable_expire_index is on
+ *
+ * | 'e' | etime | meta key |  =>  | |     every key with a TTL
+ * | 'b' |                  =>  | 1 |     the metas written before are indexed
+ * |  1B |   8B  |
+ *
+ * etime is the expiration time in milliseconds, big endian, so the entries
+ * are sorted by the time their keys expire. meta key is the encoded key of
+ * the meta cf. An entry can outlive its key (the meta compaction filter
+ * drops expired metas without a write), readers check it against the meta.
+ */
+const char kExpireIndexEntry = 'e';
+const char kExpireIndexBackfilled = 'b';
+const size_t kExpireIndexPrefixLength = 9;
+
+inline std::string ExpireIndexPrefix(uint64_t etime) {
+  std::string prefix(kExpireIndexPrefixLength, kExpireIndexEntry);
+  for (size_t idx = 0; idx < sizeof(uint64_t); ++idx) {
+    prefix[kExpireIndexPrefixLength - 1 - idx] = static_cast<char>((etime >> (idx * 8)) & 0xff);
+  }
+  return prefix;
+}
+
+inline std::string ExpireIndexKey(uint64_t etime, const Slice& meta_key) {
+  std::string index_key = ExpireIndexPrefix(etime);
+  index_key.append(meta_key.data(), meta_key.size());
+  return index_key;
+}
+
+// false for anything but an entry
+inline bool ParseExpireIndexKey(const Slice& index_key, uint64_t* etime, Slice* meta_key) {
+  if (index_key.size() <= kExpireIndexPrefixLength || index_key[0] != kExpireIndexEntry) {
+    return false;
+  }
+  uint64_t time = 0;
+  for (size_t idx = 1; idx < kExpireIndexPrefixLength; ++idx) {
+    time = (time << 8) | static_cast<uint8_t>(index_key[idx]);
+  }
+  *etime = time;
+  *meta_key = Slice(index_key.data() + kExpireIndexPrefixLength, index_key.size() - kExpireIndexPrefixLength);
+  return true;
+}
+
+// when meta_value expires, 0 for never
+inline uint64_t MetaEtime(const Slice& meta_value) {
+  if (meta_value.empty()) {
+    return 0;
+  }
+  switch (static_cast<DataType>(static_cast<uint8_t>(meta_value[0]))) {
+    case DataType::kStrings: {
+      ParsedStringsValue parsed_strings_value(meta_value);
+      return parsed_strings_value.Etime();
+    }
+    case DataType::kHashes:
+    case DataType::kSets:
+    case DataType::kZSets: {
+      ParsedBaseMetaValue parsed_meta_value(meta_value);
+      return parsed_meta_value.Etime();
+    }
+    case DataType::kLists: {
+      ParsedListsMetaValue parsed_lists_meta_value(meta_value);
+      return parsed_lists_meta_value.Etime();
+    }
+    default:
+      return 0;
+  }
+}
+
+}  //  namespace storage
+#endif  // SRC_EXPIRE_INDEX_FORMAT_H_
@@ -0,0 +1,163 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_INLINE_COLLECTION_FORMAT_H_
+#define SRC_INLINE_COLLECTION_FORMAT_H_
+
+#include <map>
+#include <string>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+#include "src/base_meta_value_format.h"
+#include "src/coding.h"
+
+namespace storage {
+
+using Slice = rocksdb::Slice;
+using Status = rocksdb::Status;
+
+/*
+ * Inline hashes and sets, written while inline_collection_max_entries is not 0
+ *
+ * A hash or set of at most inline_collection_max_entries entries and
+ * kInlineCollectionMaxBytes bytes keeps its entries in the user value of its
+ * meta, after the count, and has no data keys. The inline flag of the meta
+ * tells them apart:
+ * hashes: | count | field size | field | value size | value | ...
+ * sets:   | count | member size | member | ...
+ *         |  4B   |     4B     |
+ *
+ * Commands read and write the data cf as usual, Redis::GetCollectionData and
+ * Redis::NewCollectionIterator serve the entries of an inline collection as
+ * data keys of its version, and WriteWithKeyCounters folds the data keys
+ * written for it back into its meta. A collection becomes inline when it is
+ * created with a new version, and goes back to data keys for good once it
+ * grows past the limits.
+ */
+// the entries of an inline collection take at most this many bytes
+const size_t kInlineCollectionMaxBytes = 1024;
+const size_t kInlineCollectionSizeLength = sizeof(uint32_t);
+
+class InlineCollection {
+ public:
+  // the data cf of the collections that can be inline, -1 for the others
+  static int DataCF(DataType type) {
+    switch (type) {
+      case DataType::kHashes:
+        return kHashesDataCF;
+      case DataType::kSets:
+        return kSetsDataCF;
+      default:
+        return -1;
+    }
+  }
+
+  static bool IsInline(const Slice& meta_value) {
+    if (meta_value.empty() || DataCF(static_cast<DataType>(static_cast<uint8_t>(meta_value[0]))) < 0) {
+      return false;
+    }
+    ParsedBaseMetaValue parsed_meta_value(meta_value);
+    return parsed_meta_value.Inline();
+  }
+
+  // field -> value, the values of sets are empty
+  static bool Decode(const Slice& meta_value, std::map<std::string, std::string>* entries) {
+    entries->clear();
+    ParsedBaseMetaValue parsed_meta_value(meta_value);
+    bool with_values = static_cast<DataType>(static_cast<uint8_t>(meta_value[0])) == DataType::kHashes;
+    Slice user_value = parsed_meta_value.UserValue();
+    if (user_value.size() < sizeof(int32_t)) {
+      return false;
+    }
+    const char* ptr = user_value.data() + sizeof(int32_t);
+    const char* end = user_value.data() + user_value.size();
+    Slice field;
+    Slice value;
+    while (ptr < end) {
+      if (!DecodeEntry(&ptr, end, &field) || (with_values && !DecodeEntry(&ptr, end, &value))) {
+        return false;
+      }
+      (*entries)[field.ToString()] = value.ToString();
+    }
+    return true;
+  }
+
+  // walks the entries without decoding them all, NotFound without field
+  static Status Find(const Slice& meta_value, const Slice& field, std::string* value) {
+    ParsedBaseMetaValue parsed_meta_value(meta_value);
+    bool with_values = static_cast<DataType>(static_cast<uint8_t>(meta_value[0])) == DataType::kHashes;
+    Slice user_value = parsed_meta_value.UserValue();
+    if (user_value.size() < sizeof(int32_t)) {
+      return Status::Corruption("inline collection");
+    }
+    const char* ptr = user_value.data() + sizeof(int32_t);
+    const char* end = user_value.data() + user_value.size();
+    Slice entry_field;
+    Slice entry_value;
+    while (ptr < end) {
+      if (!DecodeEntry(&ptr, end, &entry_field) || (with_values && !DecodeEntry(&ptr, end, &entry_value))) {
+        return Status::Corruption("inline collection");
+      }
+      if (entry_field == field) {
+        value->assign(entry_value.data(), entry_value.size());
+        return Status::OK();
+      }
+    }
+    return Status::NotFound();
+  }
+
+  static std::string Encode(DataType type, const std::map<std::string, std::string>& entries) {
+    std::string payload;
+    for (const auto& entry : entries) {
+      AppendEntry(entry.first, &payload);
+      if (type == DataType::kHashes) {
+        AppendEntry(entry.second, &payload);
+      }
+    }
+    return payload;
+  }
+
+  // meta_value with payload as its entries and the inline flag set, or
+  // without entries and the flag when payload is null
+  static std::string MetaValue(const Slice& meta_value, const std::string* payload) {
+    ParsedBaseMetaValue parsed_meta_value(meta_value);
+    size_t suffix_length = meta_value.size() - kTypeLength - parsed_meta_value.UserValue().size();
+    std::string new_meta_value(meta_value.data(), kTypeLength + sizeof(int32_t));
+    if (payload != nullptr) {
+      new_meta_value.append(*payload);
+    }
+    new_meta_value.append(meta_value.data() + meta_value.size() - suffix_length, suffix_length);
+    ParsedBaseMetaValue new_parsed_meta_value(&new_meta_value);
+    new_parsed_meta_value.SetInline(payload != nullptr);
+    return new_meta_value;
+  }
+
+ private:
+  static void AppendEntry(const std::string& data, std::string* payload) {
+    char buf[kInlineCollectionSizeLength];
+    EncodeFixed32(buf, static_cast<uint32_t>(data.size()));
+    payload->append(buf, sizeof(buf));
+    payload->append(data);
+  }
+
+  static bool DecodeEntry(const char** ptr, const char* end, Slice* data) {
+    if (static_cast<size_t>(end - *ptr) < kInlineCollectionSizeLength) {
+      return false;
+    }
+    uint32_t size = DecodeFixed32(*ptr);
+    *ptr += kInlineCollectionSizeLength;
+    if (static_cast<size_t>(end - *ptr) < size) {
+      return false;
+    }
+    *data = Slice(*ptr, size);
+    *ptr += size;
+    return true;
+  }
+};
+
+}  //  namespace storage
+#endif  // SRC_INLINE_COLLECTION_FORMAT_H_
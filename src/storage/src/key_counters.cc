@@ -0,0 +1,277 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/key_counters.h"
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+#include "src/base_key_format.h"
+#include "src/base_meta_value_format.h"
+#include "src/coding.h"
+#include "src/lists_meta_value_format.h"
+#include "src/pika_stream_meta_value.h"
+#include "src/strings_value_format.h"
+
+namespace storage {
+
+namespace {
+
+const char kFieldTags[] = {'k', 'e', 'i'};
+const char* kReconciledMarker = "reconciled";
+// the filter keeps the metas it would drop beyond this many until a sweep
+const size_t kMaxDroppedMetas = 1 << 20;
+
+// KeyInfo users expect strings, hashes, lists, zsets, sets, streams
+const DataType kKeyInfoOrder[] = {DataType::kStrings, DataType::kHashes, DataType::kLists,
+                                  DataType::kZSets,   DataType::kSets,   DataType::kStreams};
+
+std::string EncodeCount(int64_t count) {
+  char buf[sizeof(int64_t)];
+  EncodeFixed64(buf, static_cast<uint64_t>(count));
+  return std::string(buf, sizeof(buf));
+}
+
+int64_t DecodeCount(const Slice& value) {
+  if (value.size() != sizeof(int64_t)) {
+    return 0;
+  }
+  return static_cast<int64_t>(DecodeFixed64(value.data()));
+}
+
+size_t HashMeta(const Slice& meta_value) {
+  return std::hash<std::string_view>{}(std::string_view(meta_value.data(), meta_value.size()));
+}
+
+}  // namespace
+
+void KeyCounters::CountMeta(const Slice& meta_value, int64_t sign, Deltas* deltas) {
+  if (meta_value.empty()) {
+    return;
+  }
+  auto type = static_cast<DataType>(static_cast<uint8_t>(meta_value[0]));
+  bool live = true;
+  bool with_ttl = false;
+  switch (type) {
+    case DataType::kStrings: {
+      ParsedStringsValue parsed_strings_value(meta_value);
+      with_ttl = !parsed_strings_value.IsPermanentSurvival();
+      break;
+    }
+    case DataType::kHashes:
+    case DataType::kSets:
+    case DataType::kZSets: {
+      ParsedBaseMetaValue parsed_meta_value(meta_value);
+      live = parsed_meta_value.Count() != 0;
+      with_ttl = !parsed_meta_value.IsPermanentSurvival();
+      break;
+    }
+    case DataType::kLists: {
+      ParsedListsMetaValue parsed_lists_meta_value(meta_value);
+      live = parsed_lists_meta_value.Count() != 0;
+      with_ttl = !parsed_lists_meta_value.IsPermanentSurvival();
+      break;
+    }
+    case DataType::kStreams: {
+      ParsedStreamMetaValue parsed_stream_meta_value(meta_value);
+      live = parsed_stream_meta_value.length() != 0;
+      break;
+    }
+    default:
+      return;
+  }
+
+  int base = static_cast<int>(type) * kFieldNum;
+  if (!live) {
+    (*deltas)[base + kInvalidKeys] += sign;
+    return;
+  }
+  (*deltas)[base + kKeys] += sign;
+  if (with_ttl) {
+    (*deltas)[base + kExpires] += sign;
+  }
+}
+
+std::string KeyCounters::CounterKey(int counter) {
+  std::string key(1, DataTypeTag[counter / kFieldNum]);
+  key.append(1, kFieldTags[counter % kFieldNum]);
+  return key;
+}
+
+Status KeyCounters::Read(rocksdb::DB* db, const rocksdb::ReadOptions& read_options, rocksdb::ColumnFamilyHandle* cf,
+                         Deltas* counts) {
+  std::string value;
+  for (int counter = 0; counter < kCounterNum; ++counter) {
+    Status s = db->Get(read_options, cf, CounterKey(counter), &value);
+    if (s.IsNotFound()) {
+      (*counts)[counter] = 0;
+    } else if (s.ok()) {
+      (*counts)[counter] = DecodeCount(value);
+    } else {
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
+Status KeyCounters::Load(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* cf, bool* reconciled) {
+  std::string value;
+  Status s = db->Get(rocksdb::ReadOptions(), cf, kReconciledMarker, &value);
+  if (!s.ok() && !s.IsNotFound()) {
+    return s;
+  }
+  *reconciled = s.ok();
+  Deltas counts{};
+  s = Read(db, rocksdb::ReadOptions(), cf, &counts);
+  if (!s.ok()) {
+    return s;
+  }
+  for (int counter = 0; counter < kCounterNum; ++counter) {
+    counters_[counter] = counts[counter];
+  }
+  return Status::OK();
+}
+
+void KeyCounters::AddToBatch(const Deltas& deltas, rocksdb::ColumnFamilyHandle* cf, rocksdb::WriteBatch* batch) {
+  for (int counter = 0; counter < kCounterNum; ++counter) {
+    if (deltas[counter] != 0) {
+      batch->Merge(cf, CounterKey(counter), EncodeCount(deltas[counter]));
+    }
+  }
+}
+
+void KeyCounters::AddMarkerToBatch(rocksdb::ColumnFamilyHandle* cf, rocksdb::WriteBatch* batch) {
+  batch->Put(cf, kReconciledMarker, "1");
+}
+
+void KeyCounters::Apply(const Deltas& deltas) {
+  for (int counter = 0; counter < kCounterNum; ++counter) {
+    if (deltas[counter] != 0) {
+      counters_[counter].fetch_add(deltas[counter], std::memory_order_relaxed);
+    }
+  }
+}
+
+void KeyCounters::AddPending(const Deltas& deltas) {
+  std::lock_guard l(pending_mutex_);
+  for (int counter = 0; counter < kCounterNum; ++counter) {
+    pending_[counter] += deltas[counter];
+  }
+  has_pending_ = true;
+}
+
+KeyCounters::Deltas KeyCounters::TakePending() {
+  Deltas pending{};
+  // writes check the flag alone until the compaction filter drops a meta
+  if (!has_pending_.load(std::memory_order_relaxed)) {
+    return pending;
+  }
+  std::lock_guard l(pending_mutex_);
+  pending.swap(pending_);
+  has_pending_ = false;
+  return pending;
+}
+
+bool KeyCounters::AddDropped(const Slice& meta_key, const Slice& meta_value) {
+  size_t hash = HashMeta(meta_value);
+  std::lock_guard l(dropped_mutex_);
+  auto [iter, inserted] = dropped_.try_emplace(meta_key.ToString(), hash);
+  if (!inserted) {
+    if (iter->second == hash) {
+      return false;
+    }
+    iter->second = hash;
+  }
+  has_dropped_ = true;
+  return true;
+}
+
+bool KeyCounters::IsDropped(const Slice& meta_key, const Slice& meta_value) {
+  // writes check the flag alone while no compaction dropped a meta
+  if (meta_value.empty() || !has_dropped_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  std::lock_guard l(dropped_mutex_);
+  auto iter = dropped_.find(meta_key.ToString());
+  return iter != dropped_.end() && iter->second == HashMeta(meta_value);
+}
+
+void KeyCounters::EraseDropped(const Slice& meta_key) {
+  std::lock_guard l(dropped_mutex_);
+  dropped_.erase(meta_key.ToString());
+  has_dropped_ = !dropped_.empty();
+}
+
+bool KeyCounters::DroppedFull() {
+  std::lock_guard l(dropped_mutex_);
+  return dropped_.size() >= kMaxDroppedMetas;
+}
+
+/*
+ * A dropped meta is gone once its compaction is installed. Under the record
+ * lock no writer holds it from an earlier read, and the later ones read
+ * what the compaction left. A meta still there belongs to a compaction
+ * running or failed, it stays recorded.
+ */
+void KeyCounters::SweepDropped(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* cf, LockMgr* lock_mgr) {
+  if (!has_dropped_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::vector<std::pair<std::string, size_t>> dropped;
+  {
+    std::lock_guard l(dropped_mutex_);
+    dropped.assign(dropped_.begin(), dropped_.end());
+  }
+  rocksdb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  std::string meta_value;
+  for (const auto& [meta_key, hash] : dropped) {
+    std::string key = ParsedBaseMetaKey(meta_key).Key().ToString();
+    if (!lock_mgr->LockIfFree(key).ok()) {
+      continue;
+    }
+    Status s = db->Get(read_options, cf, meta_key, &meta_value);
+    if (s.IsNotFound() || (s.ok() && HashMeta(meta_value) != hash)) {
+      std::lock_guard l(dropped_mutex_);
+      auto iter = dropped_.find(meta_key);
+      if (iter != dropped_.end() && iter->second == hash) {
+        dropped_.erase(iter);
+      }
+      has_dropped_ = !dropped_.empty();
+    }
+    lock_mgr->UnLock(key);
+  }
+}
+
+void KeyCounters::GetKeyInfos(std::vector<KeyInfo>* key_infos) const {
+  key_infos->assign(DataTypeNum, KeyInfo());
+  for (int idx = 0; idx < DataTypeNum; ++idx) {
+    int base = static_cast<int>(kKeyInfoOrder[idx]) * kFieldNum;
+    (*key_infos)[idx].keys = static_cast<uint64_t>(std::max<int64_t>(0, counters_[base + kKeys].load()));
+    (*key_infos)[idx].expires = static_cast<uint64_t>(std::max<int64_t>(0, counters_[base + kExpires].load()));
+    (*key_infos)[idx].invaild_keys =
+        static_cast<uint64_t>(std::max<int64_t>(0, counters_[base + kInvalidKeys].load()));
+  }
+}
+
+KeyCounters::Deltas KeyCounters::Snapshot() const {
+  Deltas counts{};
+  for (int counter = 0; counter < kCounterNum; ++counter) {
+    counts[counter] = counters_[counter].load();
+  }
+  return counts;
+}
+
+bool KeyCountMergeOperator::Merge(const Slice& key, const Slice* existing_value, const Slice& value,
+                                  std::string* new_value, rocksdb::Logger* logger) const {
+  int64_t count = existing_value != nullptr ? DecodeCount(*existing_value) : 0;
+  // two's complement wraps, negative deltas subtract
+  count = static_cast<int64_t>(static_cast<uint64_t>(count) + static_cast<uint64_t>(DecodeCount(value)));
+  *new_value = EncodeCount(count);
+  return true;
+}
+
+}  //  namespace storage
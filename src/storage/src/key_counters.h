@@ -0,0 +1,112 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_KEY_COUNTERS_H_
+#define SRC_KEY_COUNTERS_H_
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb/db.h"
+#include "rocksdb/merge_operator.h"
+#include "rocksdb/write_batch.h"
+
+#include "src/base_value_format.h"
+#include "src/lock_mgr.h"
+#include "storage/storage.h"
+
+namespace storage {
+
+using Status = rocksdb::Status;
+using Slice = rocksdb::Slice;
+
+/*
+ * Keyspace counters of one instance, per data type: keys, keys with a TTL
+ * and invalid keys (emptied collections waiting for compaction).
+ *
+ * A meta value is counted without looking at the clock, a key that expired
+ * stays a key with a TTL until a write or the compaction filter reclaims
+ * it. Writes add the difference between the old and the new metas they
+ * write to the same WriteBatch, as merges into key_count_cf, so the
+ * counters on disk always match the data. The metas dropped by the meta
+ * compaction filter are counted in memory at once and written with the
+ * next batch.
+ *
+ * A meta the filter drops stays readable until the compaction is
+ * installed, a writer may replace it meanwhile. The filter only drops a
+ * current meta whose record lock is free and records it as dropped under
+ * that lock. The writers that read it after look it up in WriteWithKeyCounters
+ * and don't take it off a second time. The record stays until the meta is
+ * gone, see SweepDropped.
+ *
+ * key_count_cf holds | type tag | field | => | count (8B) |, and a marker
+ * written by the first full scan of the meta cf.
+ */
+class KeyCounters {
+ public:
+  enum Field { kKeys = 0, kExpires = 1, kInvalidKeys = 2, kFieldNum = 3 };
+  static const int kCounterNum = DataTypeNum * kFieldNum;
+  using Deltas = std::array<int64_t, kCounterNum>;
+
+  // adds sign times the counts of meta_value to deltas
+  static void CountMeta(const Slice& meta_value, int64_t sign, Deltas* deltas);
+
+  // the counts stored in cf as of read_options
+  static Status Read(rocksdb::DB* db, const rocksdb::ReadOptions& read_options, rocksdb::ColumnFamilyHandle* cf,
+                     Deltas* counts);
+  // reconciled is false when the counters were never reset by a full scan
+  Status Load(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* cf, bool* reconciled);
+  // merges deltas into batch
+  static void AddToBatch(const Deltas& deltas, rocksdb::ColumnFamilyHandle* cf, rocksdb::WriteBatch* batch);
+  // marks the counters as reconciled
+  static void AddMarkerToBatch(rocksdb::ColumnFamilyHandle* cf, rocksdb::WriteBatch* batch);
+  void Apply(const Deltas& deltas);
+
+  // deltas counted in memory but not written yet
+  void AddPending(const Deltas& deltas);
+  Deltas TakePending();
+
+  // The current metas the compaction filter took off the counters, by meta
+  // key. Called under the record lock of the key. AddDropped is false when
+  // the meta was taken off already, by a compaction that was not installed
+  bool AddDropped(const Slice& meta_key, const Slice& meta_value);
+  bool IsDropped(const Slice& meta_key, const Slice& meta_value);
+  void EraseDropped(const Slice& meta_key);
+  bool DroppedFull();
+  // forgets the dropped metas that no writer can read anymore
+  void SweepDropped(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* cf, LockMgr* lock_mgr);
+
+  // in the order of KeyInfo users: strings, hashes, lists, zsets, sets, streams
+  void GetKeyInfos(std::vector<KeyInfo>* key_infos) const;
+  Deltas Snapshot() const;
+
+ private:
+  static std::string CounterKey(int counter);
+
+  std::array<std::atomic<int64_t>, kCounterNum> counters_{};
+  std::mutex pending_mutex_;
+  Deltas pending_{};
+  std::atomic<bool> has_pending_{false};
+
+  // by meta key, the hash of the meta value
+  std::mutex dropped_mutex_;
+  std::unordered_map<std::string, size_t> dropped_;
+  std::atomic<bool> has_dropped_{false};
+};
+
+// Adds up the signed 8 byte counts merged into key_count_cf
+class KeyCountMergeOperator : public rocksdb::AssociativeMergeOperator {
+ public:
+  bool Merge(const Slice& key, const Slice* existing_value, const Slice& value, std::string* new_value,
+             rocksdb::Logger* logger) const override;
+  const char* Name() const override { return "KeyCountMergeOperator"; }
+};
+
+}  //  namespace storage
+#endif  // SRC_KEY_COUNTERS_H_
@@ -0,0 +1,165 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/keyspace_scan.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "storage/storage_define.h"
+
+namespace storage {
+
+std::string PatternPrefix(const std::string& pattern) {
+  std::string prefix;
+  for (size_t idx = 0; idx < pattern.size(); ++idx) {
+    char c = pattern[idx];
+    if (c == '*' || c == '?' || c == '[') {
+      break;
+    }
+    if (c == '\\') {
+      if (idx + 1 == pattern.size()) {
+        break;
+      }
+      c = pattern[++idx];
+    }
+    prefix.push_back(c);
+  }
+  return prefix;
+}
+
+void MetaKeyPrefixBounds(const std::string& prefix, std::string* lower, std::string* upper) {
+  lower->clear();
+  upper->clear();
+  // keys holding \0 are stored escaped, they are scanned unbounded
+  if (prefix.empty() || prefix.find(kNeedTransformCharacter) != std::string::npos) {
+    return;
+  }
+  lower->assign(kPrefixReserveLength, '\0');
+  lower->append(prefix);
+
+  // the smallest key greater than every key starting with lower
+  *upper = *lower;
+  while (static_cast<uint8_t>(upper->back()) == 0xff) {
+    upper->pop_back();
+  }
+  upper->back() = static_cast<char>(static_cast<uint8_t>(upper->back()) + 1);
+}
+
+// One Run, the scan waits for it until active is 0, under the pool mutex
+struct KeyspaceScanPool::Job {
+  Job(size_t num, const std::function<Status(size_t)>& fn) : task_num(num), task(fn) {}
+
+  const size_t task_num;
+  const std::function<Status(size_t)>& task;
+  std::atomic<size_t> next_task = {0};
+  std::atomic<bool> failed = {false};
+  std::mutex error_mutex;
+  Status error;
+  size_t active = 0;
+};
+
+KeyspaceScanPool::KeyspaceScanPool(size_t threads) : threads_(std::max<size_t>(1, threads)) {}
+
+KeyspaceScanPool::~KeyspaceScanPool() {
+  std::lock_guard resize_lock(resize_mutex_);
+  {
+    std::lock_guard l(mutex_);
+    stop_ = true;
+  }
+  job_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void KeyspaceScanPool::SetThreads(size_t threads) {
+  threads = std::max<size_t>(1, threads);
+  std::lock_guard resize_lock(resize_mutex_);
+  {
+    std::lock_guard l(mutex_);
+    threads_ = threads;
+  }
+  if (workers_.size() < threads) {
+    // the next scan starts the missing ones
+    return;
+  }
+  job_cv_.notify_all();
+  for (size_t idx = threads - 1; idx < workers_.size(); ++idx) {
+    workers_[idx].join();
+  }
+  workers_.resize(threads - 1);
+}
+
+size_t KeyspaceScanPool::Threads() const {
+  std::lock_guard l(mutex_);
+  return threads_;
+}
+
+void KeyspaceScanPool::RunTasks(Job* job) {
+  size_t idx;
+  while (!job->failed && (idx = job->next_task.fetch_add(1)) < job->task_num) {
+    Status s = job->task(idx);
+    if (!s.ok()) {
+      std::lock_guard l(job->error_mutex);
+      if (job->error.ok()) {
+        job->error = s;
+      }
+      job->failed = true;
+    }
+  }
+}
+
+void KeyspaceScanPool::StartWorkers() {
+  std::lock_guard resize_lock(resize_mutex_);
+  size_t workers = Threads() - 1;
+  while (workers_.size() < workers) {
+    workers_.emplace_back(&KeyspaceScanPool::WorkerLoop, this, workers_.size());
+  }
+}
+
+void KeyspaceScanPool::WorkerLoop(size_t worker_id) {
+  std::unique_lock l(mutex_);
+  while (true) {
+    job_cv_.wait(l, [&] { return stop_ || worker_id + 1 >= threads_ || !jobs_.empty(); });
+    if (stop_ || worker_id + 1 >= threads_) {
+      return;
+    }
+    std::shared_ptr<Job> job = jobs_.front();
+    ++job->active;
+    l.unlock();
+    RunTasks(job.get());
+    l.lock();
+    --job->active;
+    // every task of the job is taken, the next one goes first
+    if (!jobs_.empty() && jobs_.front() == job) {
+      jobs_.pop_front();
+    }
+    done_cv_.notify_all();
+  }
+}
+
+Status KeyspaceScanPool::Run(size_t task_num, const std::function<Status(size_t)>& task) {
+  auto job = std::make_shared<Job>(task_num, task);
+  if (task_num > 1 && Threads() > 1) {
+    StartWorkers();
+    {
+      std::lock_guard l(mutex_);
+      jobs_.push_back(job);
+    }
+    job_cv_.notify_all();
+  }
+  RunTasks(job.get());
+
+  std::unique_lock l(mutex_);
+  auto iter = std::find(jobs_.begin(), jobs_.end(), job);
+  if (iter != jobs_.end()) {
+    jobs_.erase(iter);
+  }
+  done_cv_.wait(l, [&] { return job->active == 0; });
+  return job->error;
+}
+
+}  //  namespace storage
@@ -0,0 +1,86 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_KEYSPACE_SCAN_H_
+#define SRC_KEYSPACE_SCAN_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rocksdb/status.h"
+
+namespace storage {
+
+using Status = rocksdb::Status;
+
+/*
+ * Full keyspace scans (KEYS, key counting, pattern deletes) split the meta
+ * cf of every instance into key ranges at sst file boundaries, see
+ * Redis::SplitMetaRange, and run the ranges on the KeyspaceScanPool of the
+ * storage, keyspace_scan_threads threads in all. A pattern with a literal
+ * prefix only visits the keys starting with it.
+ */
+
+// [lower, upper) of the encoded meta keys of one instance, empty is unbounded
+struct MetaRange {
+  size_t inst_index = 0;
+  std::string lower;
+  std::string upper;
+};
+
+// the literal part of a glob pattern in front of its first wildcard
+std::string PatternPrefix(const std::string& pattern);
+
+// the meta keys of the user keys starting with prefix are in [lower, upper)
+void MetaKeyPrefixBounds(const std::string& prefix, std::string* lower, std::string* upper);
+
+/*
+ * The threads shared by the scans of a storage. A scan runs its tasks on
+ * the calling thread and on the threads - 1 workers of the pool, the
+ * workers take the tasks of the concurrent scans in turn. The workers are
+ * started by the first scan.
+ */
+class KeyspaceScanPool {
+ public:
+  explicit KeyspaceScanPool(size_t threads);
+  ~KeyspaceScanPool();
+
+  KeyspaceScanPool(const KeyspaceScanPool&) = delete;
+  KeyspaceScanPool& operator=(const KeyspaceScanPool&) = delete;
+
+  // the workers above the new size stop after their current task
+  void SetThreads(size_t threads);
+  size_t Threads() const;
+
+  // runs task(0) ... task(task_num - 1) and returns once none of them runs,
+  // the remaining tasks are skipped after the first failure, which is returned
+  Status Run(size_t task_num, const std::function<Status(size_t)>& task);
+
+ private:
+  struct Job;
+
+  static void RunTasks(Job* job);
+  void StartWorkers();
+  void WorkerLoop(size_t worker_id);
+
+  // taken by SetThreads and StartWorkers, before mutex_
+  std::mutex resize_mutex_;
+  mutable std::mutex mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable done_cv_;
+  std::deque<std::shared_ptr<Job>> jobs_;
+  std::vector<std::thread> workers_;
+  size_t threads_;
+  bool stop_ = false;
+};
+
+}  //  namespace storage
+#endif  //  SRC_KEYSPACE_SCAN_H_
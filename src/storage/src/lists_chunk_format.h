@@ -0,0 +1,156 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_LISTS_CHUNK_FORMAT_H_
+#define SRC_LISTS_CHUNK_FORMAT_H_
+
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+
+#include "src/coding.h"
+#include "src/lists_meta_value_format.h"
+
+namespace storage {
+
+using Slice = rocksdb::Slice;
+
+/*
+ * Chunked lists, created while list_chunk_max_elements is not 0
+ *
+ * The user value of the meta carries a chunk directory after the count,
+ * the chunks from head to tail:
+ * | count | next chunk id | chunk id | chunk size | chunk id | chunk size | ...
+ * |  8B   |      8B       |    8B    |     4B     |
+ *
+ * A chunk is stored in lists_data_cf under ListsDataKey(key, version, chunk id),
+ * its value is a BaseDataValue of the elements:
+ * | element size | element | element size | element | ...
+ * |      4B      |
+ *
+ * Chunk ids only grow within a version, the order of the chunks is the order
+ * of the directory. A legacy list has the count alone in its user value and
+ * one data key per element, it keeps that format until it is recreated.
+ */
+const size_t kListChunkIdLength = sizeof(uint64_t);
+const size_t kListChunkSizeLength = sizeof(uint32_t);
+const size_t kListChunkEntryLength = kListChunkIdLength + kListChunkSizeLength;
+const size_t kListChunkDirectoryOffset = sizeof(uint64_t) + kListChunkIdLength;
+// a chunk takes no more elements once it holds this many bytes
+const size_t kListChunkMaxBytes = 8192;
+// chunk length of the chunked lists left after list_chunk_max_elements went back to 0
+const size_t kListChunkDefaultMaxElements = 128;
+
+struct ListChunkRef {
+  uint64_t id = 0;
+  uint32_t size = 0;
+};
+
+class ListChunkDirectory {
+ public:
+  // false for the user value of a legacy list
+  static bool IsChunked(const Slice& user_value) { return user_value.size() >= kListChunkDirectoryOffset; }
+
+  bool Decode(const Slice& user_value) {
+    chunks_.clear();
+    if (!IsChunked(user_value) || (user_value.size() - kListChunkDirectoryOffset) % kListChunkEntryLength != 0) {
+      return false;
+    }
+    next_chunk_id_ = DecodeFixed64(user_value.data() + sizeof(uint64_t));
+    const char* ptr = user_value.data() + kListChunkDirectoryOffset;
+    const char* end = user_value.data() + user_value.size();
+    for (; ptr < end; ptr += kListChunkEntryLength) {
+      chunks_.push_back({DecodeFixed64(ptr), DecodeFixed32(ptr + kListChunkIdLength)});
+    }
+    return true;
+  }
+
+  std::string Encode(uint64_t count) const {
+    std::string user_value(kListChunkDirectoryOffset + chunks_.size() * kListChunkEntryLength, '\0');
+    char* dst = &user_value[0];
+    EncodeFixed64(dst, count);
+    EncodeFixed64(dst + sizeof(uint64_t), next_chunk_id_);
+    dst += kListChunkDirectoryOffset;
+    for (const auto& chunk : chunks_) {
+      EncodeFixed64(dst, chunk.id);
+      EncodeFixed32(dst + kListChunkIdLength, chunk.size);
+      dst += kListChunkEntryLength;
+    }
+    return user_value;
+  }
+
+  // the chunk holding the element at index from the head, and its offset in
+  // the chunk, false past the tail
+  bool Locate(uint64_t index, size_t* pos, uint32_t* offset) const {
+    for (size_t idx = 0; idx < chunks_.size(); ++idx) {
+      if (index < chunks_[idx].size) {
+        *pos = idx;
+        *offset = static_cast<uint32_t>(index);
+        return true;
+      }
+      index -= chunks_[idx].size;
+    }
+    return false;
+  }
+
+  uint64_t NewChunkId() { return next_chunk_id_++; }
+
+  std::vector<ListChunkRef>& chunks() { return chunks_; }
+  const std::vector<ListChunkRef>& chunks() const { return chunks_; }
+
+ private:
+  uint64_t next_chunk_id_ = 0;
+  std::vector<ListChunkRef> chunks_;
+};
+
+inline std::string EncodeListChunk(const std::vector<std::string>& elements) {
+  size_t needed = 0;
+  for (const auto& element : elements) {
+    needed += kListChunkSizeLength + element.size();
+  }
+  std::string chunk(needed, '\0');
+  char* dst = &chunk[0];
+  for (const auto& element : elements) {
+    EncodeFixed32(dst, static_cast<uint32_t>(element.size()));
+    dst += kListChunkSizeLength;
+    memcpy(dst, element.data(), element.size());
+    dst += element.size();
+  }
+  return chunk;
+}
+
+inline bool DecodeListChunk(const Slice& chunk, std::vector<std::string>* elements) {
+  elements->clear();
+  const char* ptr = chunk.data();
+  const char* end = chunk.data() + chunk.size();
+  while (ptr < end) {
+    if (static_cast<size_t>(end - ptr) < kListChunkSizeLength) {
+      return false;
+    }
+    uint32_t size = DecodeFixed32(ptr);
+    ptr += kListChunkSizeLength;
+    if (static_cast<size_t>(end - ptr) < size) {
+      return false;
+    }
+    elements->emplace_back(ptr, size);
+    ptr += size;
+  }
+  return true;
+}
+
+inline Slice ListsMetaUserValue(const Slice& meta_value) {
+  const size_t suffix_length =
+      kVersionLength + 2 * kListValueIndexLength + kSuffixReserveLength + 2 * kTimestampLength;
+  return Slice(meta_value.data() + kTypeLength, meta_value.size() - kTypeLength - suffix_length);
+}
+
+// swaps the user value of a list meta, the suffix after it is kept
+inline void ReplaceListsMetaUserValue(std::string* meta_value, const std::string& user_value) {
+  meta_value->replace(kTypeLength, ListsMetaUserValue(*meta_value).size(), user_value);
+}
+
+}  //  namespace storage
+#endif  // SRC_LISTS_CHUNK_FORMAT_H_
@@ -0,0 +1,410 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/lists_chunks.h"
+
+#include <algorithm>
+
+#include "src/base_data_value_format.h"
+#include "src/base_key_format.h"
+#include "src/lists_data_key_format.h"
+
+namespace storage {
+
+namespace {
+
+size_t ChunkBytes(const std::vector<std::string>& elements) {
+  size_t bytes = 0;
+  for (const auto& element : elements) {
+    bytes += kListChunkSizeLength + element.size();
+  }
+  return bytes;
+}
+
+// [start, stop] of a list of count elements like LRANGE takes them, false
+// for an empty range
+bool ClampRange(int64_t start, int64_t stop, uint64_t count, uint64_t* first, uint64_t* last) {
+  auto size = static_cast<int64_t>(count);
+  if (start < 0) {
+    start += size;
+  }
+  if (stop < 0) {
+    stop += size;
+  }
+  start = std::max<int64_t>(start, 0);
+  stop = std::min<int64_t>(stop, size - 1);
+  if (start > stop) {
+    return false;
+  }
+  *first = static_cast<uint64_t>(start);
+  *last = static_cast<uint64_t>(stop);
+  return true;
+}
+
+}  // namespace
+
+ListsChunks::ListsChunks(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* data_cf,
+                         const rocksdb::ReadOptions& read_options, const Slice& key, std::string* meta_value,
+                         size_t max_elements)
+    : db_(db), data_cf_(data_cf), read_options_(read_options), key_(key.ToString()), meta_value_(meta_value),
+      max_elements_(max_elements == 0 ? kListChunkDefaultMaxElements : max_elements) {}
+
+Status ListsChunks::Init() {
+  ParsedListsMetaValue parsed_lists_meta_value(meta_value_);
+  version_ = parsed_lists_meta_value.Version();
+  count_ = parsed_lists_meta_value.Count();
+  if (!directory_.Decode(ListsMetaUserValue(*meta_value_))) {
+    return Status::Corruption("broken list chunk directory");
+  }
+  return Status::OK();
+}
+
+uint64_t ListsChunks::InitialMetaValue(ParsedListsMetaValue* parsed_lists_meta_value, std::string* meta_value,
+                                       size_t max_elements) {
+  uint64_t version = parsed_lists_meta_value->InitialMetaValue();
+  if (max_elements != 0) {
+    ReplaceListsMetaUserValue(meta_value, ListChunkDirectory().Encode(0));
+  } else {
+    ReplaceListsMetaUserValue(meta_value, std::string(sizeof(uint64_t), '\0'));
+  }
+  return version;
+}
+
+std::string ListsChunks::NewMetaValue(size_t max_elements) {
+  std::string user_value =
+      max_elements != 0 ? ListChunkDirectory().Encode(0) : std::string(sizeof(uint64_t), '\0');
+  ListsMetaValue lists_meta_value(user_value);
+  lists_meta_value.UpdateVersion();
+  return lists_meta_value.Encode().ToString();
+}
+
+bool ListsChunks::IsChunked(const std::string& meta_value) {
+  return ListChunkDirectory::IsChunked(ListsMetaUserValue(meta_value));
+}
+
+std::string ListsChunks::ChunkKey(uint64_t id) const {
+  ListsDataKey lists_data_key(key_, version_, id);
+  return lists_data_key.Encode().ToString();
+}
+
+Status ListsChunks::Load(size_t pos, std::vector<std::string>** elements) {
+  uint64_t id = directory_.chunks()[pos].id;
+  auto iter = loaded_.find(id);
+  if (iter != loaded_.end()) {
+    *elements = &iter->second;
+    return Status::OK();
+  }
+  std::string chunk_value;
+  Status s = db_->Get(read_options_, data_cf_, ChunkKey(id), &chunk_value);
+  if (s.IsNotFound()) {
+    return Status::Corruption("list chunk missing");
+  } else if (!s.ok()) {
+    return s;
+  }
+  std::vector<std::string> chunk;
+  ParsedBaseDataValue parsed_value{Slice(chunk_value)};
+  if (!DecodeListChunk(parsed_value.UserValue(), &chunk) || chunk.size() != directory_.chunks()[pos].size) {
+    return Status::Corruption("broken list chunk");
+  }
+  *elements = &(loaded_[id] = std::move(chunk));
+  return Status::OK();
+}
+
+void ListsChunks::Release(size_t pos) {
+  uint64_t id = directory_.chunks()[pos].id;
+  if (dirty_.count(id) == 0) {
+    loaded_.erase(id);
+  }
+}
+
+void ListsChunks::Touch(size_t pos) {
+  auto& chunk = directory_.chunks()[pos];
+  chunk.size = static_cast<uint32_t>(loaded_[chunk.id].size());
+  dirty_.insert(chunk.id);
+}
+
+void ListsChunks::Drop(size_t pos) {
+  auto& chunks = directory_.chunks();
+  uint64_t id = chunks[pos].id;
+  loaded_.erase(id);
+  dirty_.erase(id);
+  dropped_.push_back(id);
+  chunks.erase(chunks.begin() + static_cast<int64_t>(pos));
+}
+
+bool ListsChunks::Full(const std::vector<std::string>& elements) const {
+  return elements.size() >= max_elements_ || ChunkBytes(elements) >= kListChunkMaxBytes;
+}
+
+Status ListsChunks::Push(const std::vector<std::string>& values, bool left) {
+  auto& chunks = directory_.chunks();
+  for (const auto& value : values) {
+    std::vector<std::string>* elements = nullptr;
+    size_t pos = left ? 0 : chunks.size() - 1;
+    if (!chunks.empty()) {
+      Status s = Load(pos, &elements);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    if (elements == nullptr || Full(*elements)) {
+      uint64_t id = directory_.NewChunkId();
+      pos = left ? 0 : chunks.size();
+      chunks.insert(chunks.begin() + static_cast<int64_t>(pos), ListChunkRef{id, 0});
+      elements = &loaded_[id];
+    }
+    if (left) {
+      elements->insert(elements->begin(), value);
+    } else {
+      elements->push_back(value);
+    }
+    Touch(pos);
+    count_++;
+  }
+  return Status::OK();
+}
+
+Status ListsChunks::Pop(uint64_t count, bool left, std::vector<std::string>* elements) {
+  auto& chunks = directory_.chunks();
+  while (count > 0 && !chunks.empty()) {
+    size_t pos = left ? 0 : chunks.size() - 1;
+    std::vector<std::string>* chunk = nullptr;
+    Status s = Load(pos, &chunk);
+    if (!s.ok()) {
+      return s;
+    }
+    uint64_t taken = std::min<uint64_t>(count, chunk->size());
+    for (uint64_t idx = 0; idx < taken; ++idx) {
+      if (left) {
+        elements->push_back(std::move((*chunk)[idx]));
+      } else {
+        elements->push_back(std::move((*chunk)[chunk->size() - 1 - idx]));
+      }
+    }
+    if (left) {
+      chunk->erase(chunk->begin(), chunk->begin() + static_cast<int64_t>(taken));
+    } else {
+      chunk->resize(chunk->size() - taken);
+    }
+    count -= taken;
+    count_ -= taken;
+    if (chunk->empty()) {
+      Drop(pos);
+    } else {
+      Touch(pos);
+    }
+  }
+  return Status::OK();
+}
+
+Status ListsChunks::Discard(uint64_t count, bool left) {
+  auto& chunks = directory_.chunks();
+  while (count > 0 && !chunks.empty()) {
+    size_t pos = left ? 0 : chunks.size() - 1;
+    if (chunks[pos].size <= count) {
+      count -= chunks[pos].size;
+      count_ -= chunks[pos].size;
+      Drop(pos);
+      continue;
+    }
+    std::vector<std::string>* chunk = nullptr;
+    Status s = Load(pos, &chunk);
+    if (!s.ok()) {
+      return s;
+    }
+    if (left) {
+      chunk->erase(chunk->begin(), chunk->begin() + static_cast<int64_t>(count));
+    } else {
+      chunk->resize(chunk->size() - count);
+    }
+    count_ -= count;
+    count = 0;
+    Touch(pos);
+  }
+  return Status::OK();
+}
+
+Status ListsChunks::Index(int64_t index, std::string* element) {
+  if (index < 0) {
+    index += static_cast<int64_t>(count_);
+  }
+  size_t pos = 0;
+  uint32_t offset = 0;
+  if (index < 0 || !directory_.Locate(static_cast<uint64_t>(index), &pos, &offset)) {
+    return Status::NotFound();
+  }
+  std::vector<std::string>* chunk = nullptr;
+  Status s = Load(pos, &chunk);
+  if (s.ok()) {
+    *element = (*chunk)[offset];
+  }
+  return s;
+}
+
+Status ListsChunks::Range(int64_t start, int64_t stop, std::vector<std::string>* ret) {
+  uint64_t first = 0;
+  uint64_t last = 0;
+  size_t pos = 0;
+  uint32_t offset = 0;
+  if (!ClampRange(start, stop, count_, &first, &last) || !directory_.Locate(first, &pos, &offset)) {
+    return Status::OK();
+  }
+  uint64_t rest = last - first + 1;
+  for (; rest > 0 && pos < directory_.chunks().size(); ++pos, offset = 0) {
+    std::vector<std::string>* chunk = nullptr;
+    Status s = Load(pos, &chunk);
+    if (!s.ok()) {
+      return s;
+    }
+    for (; offset < chunk->size() && rest > 0; ++offset, --rest) {
+      ret->push_back((*chunk)[offset]);
+    }
+    Release(pos);
+  }
+  return Status::OK();
+}
+
+Status ListsChunks::Set(int64_t index, const Slice& value) {
+  if (index < 0) {
+    index += static_cast<int64_t>(count_);
+  }
+  size_t pos = 0;
+  uint32_t offset = 0;
+  if (index < 0 || !directory_.Locate(static_cast<uint64_t>(index), &pos, &offset)) {
+    return Status::Corruption("index out of range");
+  }
+  std::vector<std::string>* chunk = nullptr;
+  Status s = Load(pos, &chunk);
+  if (!s.ok()) {
+    return s;
+  }
+  (*chunk)[offset] = value.ToString();
+  Touch(pos);
+  return Status::OK();
+}
+
+Status ListsChunks::Insert(BeforeOrAfter before_or_after, const Slice& pivot, const Slice& value) {
+  auto& chunks = directory_.chunks();
+  for (size_t pos = 0; pos < chunks.size(); ++pos) {
+    std::vector<std::string>* chunk = nullptr;
+    Status s = Load(pos, &chunk);
+    if (!s.ok()) {
+      return s;
+    }
+    auto iter = std::find_if(chunk->begin(), chunk->end(),
+                             [&pivot](const std::string& element) { return pivot.compare(element) == 0; });
+    if (iter == chunk->end()) {
+      Release(pos);
+      continue;
+    }
+    if (before_or_after == After) {
+      ++iter;
+    }
+    chunk->insert(iter, value.ToString());
+    count_++;
+    if (chunk->size() > 1 && (chunk->size() > max_elements_ || ChunkBytes(*chunk) > kListChunkMaxBytes)) {
+      // the second half moves to a new chunk after this one
+      uint64_t id = directory_.NewChunkId();
+      auto half = static_cast<int64_t>(chunk->size() / 2);
+      std::vector<std::string> second(std::make_move_iterator(chunk->begin() + half),
+                                      std::make_move_iterator(chunk->end()));
+      chunk->resize(half);
+      chunks.insert(chunks.begin() + static_cast<int64_t>(pos) + 1, ListChunkRef{id, 0});
+      loaded_[id] = std::move(second);
+      Touch(pos + 1);
+    }
+    Touch(pos);
+    return Status::OK();
+  }
+  return Status::NotFound();
+}
+
+Status ListsChunks::Remove(int64_t count, const Slice& value, uint64_t* removed) {
+  *removed = 0;
+  auto& chunks = directory_.chunks();
+  bool from_head = count >= 0;
+  uint64_t rest = count < 0 ? -count : count;
+  auto matches = [&value](const std::string& element) { return value.compare(element) == 0; };
+  size_t pos = from_head ? 0 : chunks.size();
+  while ((count == 0 || rest > 0) && (from_head ? pos < chunks.size() : pos > 0)) {
+    if (!from_head) {
+      --pos;
+    }
+    std::vector<std::string>* chunk = nullptr;
+    Status s = Load(pos, &chunk);
+    if (!s.ok()) {
+      return s;
+    }
+    uint64_t erased = 0;
+    if (from_head) {
+      for (auto iter = chunk->begin(); iter != chunk->end() && (count == 0 || rest > 0);) {
+        if (matches(*iter)) {
+          iter = chunk->erase(iter);
+          ++erased;
+          if (count != 0) {
+            --rest;
+          }
+        } else {
+          ++iter;
+        }
+      }
+    } else {
+      for (size_t idx = chunk->size(); idx > 0 && rest > 0; --idx) {
+        if (matches((*chunk)[idx - 1])) {
+          chunk->erase(chunk->begin() + static_cast<int64_t>(idx) - 1);
+          ++erased;
+          --rest;
+        }
+      }
+    }
+    count_ -= erased;
+    *removed += erased;
+    if (erased == 0) {
+      Release(pos);
+    } else if (chunk->empty()) {
+      // the next chunk moves to pos
+      Drop(pos);
+      continue;
+    } else {
+      Touch(pos);
+    }
+    if (from_head) {
+      ++pos;
+    }
+  }
+  return Status::OK();
+}
+
+Status ListsChunks::Trim(int64_t start, int64_t stop) {
+  uint64_t first = 0;
+  uint64_t last = 0;
+  if (!ClampRange(start, stop, count_, &first, &last)) {
+    return Discard(count_, true);
+  }
+  uint64_t tail = count_ - 1 - last;
+  Status s = Discard(first, true);
+  if (s.ok()) {
+    s = Discard(tail, false);
+  }
+  return s;
+}
+
+void ListsChunks::Flush(rocksdb::WriteBatch* batch, rocksdb::ColumnFamilyHandle* meta_cf) {
+  for (const auto id : dropped_) {
+    batch->Delete(data_cf_, ChunkKey(id));
+  }
+  for (const auto id : dirty_) {
+    std::string chunk = EncodeListChunk(loaded_[id]);
+    BaseDataValue chunk_value(chunk);
+    batch->Put(data_cf_, ChunkKey(id), chunk_value.Encode());
+  }
+  dropped_.clear();
+  dirty_.clear();
+  ReplaceListsMetaUserValue(meta_value_, directory_.Encode(count_));
+  BaseMetaKey base_meta_key(key_);
+  batch->Put(meta_cf, base_meta_key.Encode(), *meta_value_);
+}
+
+}  //  namespace storage
@@ -0,0 +1,94 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_LISTS_CHUNKS_H_
+#define SRC_LISTS_CHUNKS_H_
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "rocksdb/db.h"
+#include "rocksdb/write_batch.h"
+
+#include "src/lists_chunk_format.h"
+#include "storage/storage.h"
+
+namespace storage {
+
+using Status = rocksdb::Status;
+using Slice = rocksdb::Slice;
+
+/*
+ * The elements of one chunked list, see lists_chunk_format.h.
+ *
+ * A command reads the chunks it needs through the directory, so LINDEX and
+ * LSET read one chunk and LRANGE the chunks of its range. Edits change the
+ * chunks in memory, Flush then writes the changed chunks and the meta into
+ * the WriteBatch of the command. Pushes fill the head or tail chunk up to
+ * max_elements elements or kListChunkMaxBytes bytes, an insert splits a full
+ * chunk in two.
+ */
+class ListsChunks {
+ public:
+  // meta_value is a chunked list meta of the key, it is kept up to date by Flush
+  ListsChunks(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* data_cf, const rocksdb::ReadOptions& read_options,
+              const Slice& key, std::string* meta_value, size_t max_elements);
+
+  // Corruption for a broken directory
+  Status Init();
+
+  uint64_t Count() const { return count_; }
+
+  // LPUSH / RPUSH order, every value becomes the new head or tail
+  Status Push(const std::vector<std::string>& values, bool left);
+  Status Pop(uint64_t count, bool left, std::vector<std::string>* elements);
+  // NotFound out of range
+  Status Index(int64_t index, std::string* element);
+  Status Range(int64_t start, int64_t stop, std::vector<std::string>* ret);
+  // Corruption("index out of range") out of range, like the legacy format
+  Status Set(int64_t index, const Slice& value);
+  // NotFound without the pivot
+  Status Insert(BeforeOrAfter before_or_after, const Slice& pivot, const Slice& value);
+  Status Remove(int64_t count, const Slice& value, uint64_t* removed);
+  Status Trim(int64_t start, int64_t stop);
+
+  // Puts the changed chunks and the meta into batch
+  void Flush(rocksdb::WriteBatch* batch, rocksdb::ColumnFamilyHandle* meta_cf);
+
+  // A list created now is chunked while max_elements is not 0
+  static uint64_t InitialMetaValue(ParsedListsMetaValue* parsed_lists_meta_value, std::string* meta_value,
+                                   size_t max_elements);
+  static std::string NewMetaValue(size_t max_elements);
+  static bool IsChunked(const std::string& meta_value);
+
+ private:
+  Status Load(size_t pos, std::vector<std::string>** elements);
+  // forgets an unchanged chunk read by a scan
+  void Release(size_t pos);
+  void Touch(size_t pos);
+  void Drop(size_t pos);
+  bool Full(const std::vector<std::string>& elements) const;
+  // drops count elements from the head or tail without reading whole chunks
+  Status Discard(uint64_t count, bool left);
+  std::string ChunkKey(uint64_t id) const;
+
+  rocksdb::DB* db_;
+  rocksdb::ColumnFamilyHandle* data_cf_;
+  rocksdb::ReadOptions read_options_;
+  std::string key_;
+  std::string* meta_value_;
+  size_t max_elements_;
+  uint64_t version_ = 0;
+  uint64_t count_ = 0;
+  ListChunkDirectory directory_;
+  std::unordered_map<uint64_t, std::vector<std::string>> loaded_;
+  std::unordered_set<uint64_t> dirty_;
+  std::vector<uint64_t> dropped_;
+};
+
+}  //  namespace storage
+#endif  // SRC_LISTS_CHUNKS_H_
@@ -103,21 +103,17 @@ class ListsDataFilter : public rocksdb::CompactionFilter {
     }
   }
 
-  /*
-  // Only judge by meta value ttl
-  virtual rocksdb::CompactionFilter::Decision FilterBlobByKey(int level, const Slice& key,
-      std::string* new_value, std::string* skip_until) const {
-    UNUSED(level);
-    UNUSED(new_value);
+  // Like BaseDataFilter, the key alone decides, list chunks in blob files
+  // are not read back
+  rocksdb::CompactionFilter::Decision FilterBlobByKey(int level, const rocksdb::Slice& key, std::string* new_value,
+                                                      std::string* skip_until) const override {
     UNUSED(skip_until);
-    bool unused_value_changed;
-    bool should_remove = Filter(level, key, Slice{}, new_value, &unused_value_changed);
-    if (should_remove) {
-      return CompactionFilter::Decision::kRemove;
+    bool unused_value_changed = false;
+    if (Filter(level, key, rocksdb::Slice{}, new_value, &unused_value_changed)) {
+      return rocksdb::CompactionFilter::Decision::kRemove;
     }
-    return CompactionFilter::Decision::kKeep;
+    return rocksdb::CompactionFilter::Decision::kKeep;
   }
-  */
 
   const char* Name() const override { return "ListsDataFilter"; }
 
@@ -37,6 +37,13 @@ static bool strToUint32(const std::string& value, uint32_t* num, int base = 10)
   return true;
 }
 
+// strToDouble may throw exception
+static bool strToDouble(const std::string& value, double* num) {
+  size_t end;
+  *num = std::stod(value, &end);
+  return end >= value.size();
+}
+
 // strToBool may throw exception
 static bool strToBool(const std::string& value, bool* boolVal, int base = 10) {
   if (value != "true" && value != "false") {
@@ -88,6 +95,14 @@ bool ParseOptionMember(const MemberType& member_type, const std::string& value,
       *reinterpret_cast<bool*>(member_address) = static_cast<bool>(boolVal);
       break;
     }
+    case MemberType::kDouble: {
+      double doubleVal;
+      if (!strToDouble(value, &doubleVal)) {
+        return false;
+      }
+      *reinterpret_cast<double*>(member_address) = doubleVal;
+      break;
+    }
     default: {
       return false;
     }
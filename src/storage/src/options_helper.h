@@ -19,6 +19,7 @@ enum class MemberType {
   kSizeT,
   kUnknown,
   kBool,
+  kDouble,
 };
 
 struct MemberTypeInfo {
@@ -71,6 +72,17 @@ static std::unordered_map<std::string, MemberTypeInfo> mutable_cf_options_member
     {"ttl", {offset_of(&rocksdb::AdvancedColumnFamilyOptions::ttl), MemberType::kUint64T}},
     {"periodic_compaction_seconds",
      {offset_of(&rocksdb::AdvancedColumnFamilyOptions::periodic_compaction_seconds), MemberType::kUint64T}},
+    // integrated blob files, only the column families of large values take them
+    {"enable_blob_files", {offset_of(&rocksdb::AdvancedColumnFamilyOptions::enable_blob_files), MemberType::kBool}},
+    {"min_blob_size", {offset_of(&rocksdb::AdvancedColumnFamilyOptions::min_blob_size), MemberType::kUint64T}},
+    {"blob_file_size", {offset_of(&rocksdb::AdvancedColumnFamilyOptions::blob_file_size), MemberType::kUint64T}},
+    {"enable_blob_garbage_collection",
+     {offset_of(&rocksdb::AdvancedColumnFamilyOptions::enable_blob_garbage_collection), MemberType::kBool}},
+    {"blob_garbage_collection_age_cutoff",
+     {offset_of(&rocksdb::AdvancedColumnFamilyOptions::blob_garbage_collection_age_cutoff), MemberType::kDouble}},
+    {"blob_garbage_collection_force_threshold",
+     {offset_of(&rocksdb::AdvancedColumnFamilyOptions::blob_garbage_collection_force_threshold),
+      MemberType::kDouble}},
 };
 
 extern bool ParseOptionMember(const MemberType& member_type, const std::string& value, char* member_address);
@@ -3,7 +3,13 @@
 //  LICENSE file in the root directory of this source tree. An additional grant
 //  of patent rights can be found in the PATENTS file in the same directory.
 
+#include <algorithm>
+#include <optional>
 #include <sstream>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 
 #include "rocksdb/env.h"
 
@@ -11,6 +17,13 @@
 #include "src/lists_filter.h"
 #include "src/base_filter.h"
 #include "src/zsets_filter.h"
+#include "src/lists_data_key_format.h"
+#include "src/zsets_data_key_format.h"
+#include "src/zsets_rank_index.h"
+#include "src/scope_record_lock.h"
+#include "src/scope_snapshot.h"
+#include "src/expire_index_format.h"
+#include "src/slot_index_format.h"
 
 namespace storage {
 
@@ -26,6 +39,19 @@ rocksdb::Comparator* ZSetsScoreKeyComparator() {
   return &zsets_score_key_compare;
 }
 
+namespace {
+
+// Strings, hash fields, list elements and stream messages can be large,
+// the values of the other column families are empty or a few bytes and
+// stay in the LSM
+bool TakesBlobFiles(size_t cf_index) {
+  return cf_index == kMetaCF || cf_index == kHashesDataCF || cf_index == kListsDataCF || cf_index == kStreamsDataCF;
+}
+
+bool IsBlobOption(const std::string& name) { return name.find("blob") != std::string::npos; }
+
+}  // namespace
+
 Redis::Redis(Storage* const s, int32_t index)
     : storage_(s), index_(index),
       lock_mgr_(std::make_shared<LockMgr>(1000, 0, std::make_shared<MutexFactoryImpl>())),
@@ -34,6 +60,7 @@ Redis::Redis(Storage* const s, int32_t index)
   statistics_store_ = std::make_unique<LRUCache<std::string, KeyStatistics>>();
   scan_cursors_store_ = std::make_unique<LRUCache<std::string, std::string>>();
   spop_counts_store_ = std::make_unique<LRUCache<std::string, size_t>>();
+  sets_sample_store_ = std::make_unique<LRUCache<std::string, std::shared_ptr<SetsSampleIndex>>>();
   default_compact_range_options_.exclusive_manual_compaction = false;
   default_compact_range_options_.change_level = true;
   spop_counts_store_->SetCapacity(1000);
@@ -60,6 +87,13 @@ Redis::~Redis() {
 Status Redis::Open(const StorageOptions& storage_options, const std::string& db_path) {
   statistics_store_->SetCapacity(storage_options.statistics_max_size);
   small_compaction_threshold_ = storage_options.small_compaction_threshold;
+  zset_rank_index_threshold_ = storage_options.zset_rank_index_threshold;
+  sets_sample_store_->SetCapacity(storage_options.sets_sample_cache_size);
+  expire_index_enabled_ = storage_options.enable_expire_index;
+  list_chunk_max_elements_ = storage_options.list_chunk_max_elements;
+  inline_collection_max_entries_ = storage_options.inline_collection_max_entries;
+  slot_index_counts_.SetSlotNum(storage_->GetSlotNum());
+  slot_index_counts_.SetEnabled(storage_options.enable_slot_index);
 
   rocksdb::BlockBasedTableOptions table_ops(storage_options.table_options);
   table_ops.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, true));
@@ -79,7 +113,8 @@ Status Redis::Open(const StorageOptions& storage_options, const std::string& db_
    */
   // meta & string column-family options
   rocksdb::ColumnFamilyOptions meta_cf_ops(storage_options.options);
-  meta_cf_ops.compaction_filter_factory = std::make_shared<MetaFilterFactory>();
+  meta_cf_ops.compaction_filter_factory =
+      std::make_shared<MetaFilterFactory>(&db_, &handles_, &key_counters_, &slot_index_counts_, lock_mgr_.get());
   rocksdb::BlockBasedTableOptions meta_table_ops(table_ops);
 
   rocksdb::BlockBasedTableOptions string_table_ops(table_ops);
@@ -120,18 +155,24 @@ Status Redis::Open(const StorageOptions& storage_options, const std::string& db_
   // zset column-family options
   rocksdb::ColumnFamilyOptions zset_data_cf_ops(storage_options.options);
   rocksdb::ColumnFamilyOptions zset_score_cf_ops(storage_options.options);
+  rocksdb::ColumnFamilyOptions zset_rank_cf_ops(storage_options.options);
   zset_data_cf_ops.compaction_filter_factory = std::make_shared<ZSetsDataFilterFactory>(&db_, &handles_, DataType::kZSets);
   zset_score_cf_ops.compaction_filter_factory = std::make_shared<ZSetsScoreFilterFactory>(&db_, &handles_, DataType::kZSets);
   zset_score_cf_ops.comparator = ZSetsScoreKeyComparator();
+  zset_rank_cf_ops.compaction_filter_factory =
+      std::make_shared<ZSetsScoreFilterFactory>(&db_, &handles_, DataType::kZSets, true);
+  zset_rank_cf_ops.comparator = ZSetsScoreKeyComparator();
 
   rocksdb::BlockBasedTableOptions zset_meta_cf_table_ops(table_ops);
   rocksdb::BlockBasedTableOptions zset_data_cf_table_ops(table_ops);
   rocksdb::BlockBasedTableOptions zset_score_cf_table_ops(table_ops);
+  rocksdb::BlockBasedTableOptions zset_rank_cf_table_ops(table_ops);
   if (!storage_options.share_block_cache && storage_options.block_cache_size > 0) {
     zset_data_cf_table_ops.block_cache = rocksdb::NewLRUCache(storage_options.block_cache_size);
   }
   zset_data_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(zset_data_cf_table_ops));
   zset_score_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(zset_score_cf_table_ops));
+  zset_rank_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(zset_rank_cf_table_ops));
 
   // stream column-family options
   rocksdb::ColumnFamilyOptions stream_data_cf_ops(storage_options.options);
@@ -142,6 +183,24 @@ Status Redis::Open(const StorageOptions& storage_options, const std::string& db_
   }
   stream_data_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(stream_data_cf_table_ops));
 
+  // codis slot index column-family options, the writes of the keys keep the
+  // entries, no compaction filter, the slot counts are merged
+  rocksdb::ColumnFamilyOptions slot_index_cf_ops(storage_options.options);
+  slot_index_cf_ops.merge_operator = std::make_shared<KeyCountMergeOperator>();
+  rocksdb::BlockBasedTableOptions slot_index_cf_table_ops(table_ops);
+  slot_index_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(slot_index_cf_table_ops));
+
+  // keyspace counters column-family options
+  rocksdb::ColumnFamilyOptions key_count_cf_ops(storage_options.options);
+  key_count_cf_ops.merge_operator = std::make_shared<KeyCountMergeOperator>();
+  rocksdb::BlockBasedTableOptions key_count_cf_table_ops(table_ops);
+  key_count_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(key_count_cf_table_ops));
+
+  // expiry index column-family options, the reaper drops the entries
+  rocksdb::ColumnFamilyOptions expire_index_cf_ops(storage_options.options);
+  rocksdb::BlockBasedTableOptions expire_index_cf_table_ops(table_ops);
+  expire_index_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(expire_index_cf_table_ops));
+
   std::vector<rocksdb::ColumnFamilyDescriptor> column_families;
   // meta & string cf
   column_families.emplace_back(rocksdb::kDefaultColumnFamilyName, meta_cf_ops);
@@ -156,7 +215,257 @@ Status Redis::Open(const StorageOptions& storage_options, const std::string& db_
   column_families.emplace_back("zset_score_cf", zset_score_cf_ops);
   // stream CF
   column_families.emplace_back("stream_data_cf", stream_data_cf_ops);
-  return rocksdb::DB::Open(db_ops, db_path, column_families, &handles_, &db_);
+  // zset rank index CF, after the stream CF to keep the existing indexes
+  column_families.emplace_back("zset_rank_cf", zset_rank_cf_ops);
+  // codis slot index CF
+  column_families.emplace_back("slot_index_cf", slot_index_cf_ops);
+  // keyspace counters CF
+  column_families.emplace_back("key_count_cf", key_count_cf_ops);
+  // expiry index CF
+  column_families.emplace_back("expire_index_cf", expire_index_cf_ops);
+  for (size_t idx = 0; idx < column_families.size(); ++idx) {
+    if (!TakesBlobFiles(idx)) {
+      column_families[idx].options.enable_blob_files = false;
+    }
+  }
+  Status s = rocksdb::DB::Open(db_ops, db_path, column_families, &handles_, &db_);
+  if (!s.ok()) {
+    return s;
+  }
+  s = LoadKeyCounters();
+  if (!s.ok()) {
+    return s;
+  }
+  s = LoadInlineCollections();
+  if (!s.ok()) {
+    return s;
+  }
+  return LoadExpireIndex();
+}
+
+Status Redis::LoadKeyCounters() {
+  bool reconciled = false;
+  Status s = key_counters_.Load(db_, handles_[kKeyCountCF], &reconciled);
+  if (!s.ok() || reconciled) {
+    key_counters_reconciled_ = reconciled;
+    return s;
+  }
+
+  // a new instance has nothing to count, an older one waits for a full scan
+  rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[kMetaCF]);
+  iter->SeekToFirst();
+  bool empty = !iter->Valid() || IsMetaMarker(iter->key());
+  s = iter->status();
+  delete iter;
+  if (!s.ok() || !empty) {
+    return s;
+  }
+  rocksdb::WriteBatch batch;
+  KeyCounters::AddMarkerToBatch(handles_[kKeyCountCF], &batch);
+  s = db_->Write(default_write_options_, &batch);
+  key_counters_reconciled_ = s.ok();
+  return s;
+}
+
+namespace {
+
+// The writes of a batch to the meta cf, in batch order. The slices point
+// into the batch, it must not change while they are used. The batch has the
+// id rocksdb gave the meta cf
+class MetaWriteCollector : public rocksdb::WriteBatch::Handler {
+ public:
+  struct MetaWrite {
+    Slice key;
+    Slice value;  // empty for a delete
+  };
+
+  explicit MetaWriteCollector(uint32_t meta_cf_id) : meta_cf_id_(meta_cf_id) {}
+
+  Status PutCF(uint32_t column_family_id, const Slice& key, const Slice& value) override {
+    if (column_family_id == meta_cf_id_) {
+      writes.push_back({key, value});
+    }
+    return Status::OK();
+  }
+  Status DeleteCF(uint32_t column_family_id, const Slice& key) override {
+    if (column_family_id == meta_cf_id_) {
+      writes.push_back({key, Slice()});
+    }
+    return Status::OK();
+  }
+  Status SingleDeleteCF(uint32_t column_family_id, const Slice& key) override {
+    return DeleteCF(column_family_id, key);
+  }
+  Status MergeCF(uint32_t column_family_id, const Slice& key, const Slice& value) override {
+    return Status::OK();
+  }
+
+  std::vector<MetaWrite> writes;
+
+ private:
+  uint32_t meta_cf_id_;
+};
+
+std::string_view ToView(const Slice& slice) { return {slice.data(), slice.size()}; }
+
+}  // namespace
+
+/*
+ * The callers hold the record locks of the keys they write, so the metas
+ * they pass in old_metas are the ones the batch replaces. A meta the caller
+ * did not pass is read here, it is served from the memtable or the block
+ * cache.
+ */
+Status Redis::WriteWithKeyCounters(rocksdb::WriteBatch* batch, const std::vector<OldMeta>& old_metas) {
+  std::unordered_map<std::string, std::string> stored_metas;
+  Status s;
+  if (inline_collections_) {
+    s = FoldInlineCollections(batch, old_metas, &stored_metas);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  MetaWriteCollector collector(handles_[kMetaCF]->GetID());
+  s = batch->Iterate(&collector);
+  if (!s.ok()) {
+    return s;
+  }
+
+  // by meta key, the meta each key has before the write seen last
+  std::unordered_map<std::string_view, Slice> known;
+  known.reserve(old_metas.size() + collector.writes.size());
+  for (const auto& [key, value] : old_metas) {
+    known.emplace(ToView(key), value);
+  }
+  for (const auto& [key, value] : stored_metas) {
+    known.emplace(key, value);
+  }
+
+  KeyCounters::Deltas deltas{};
+  SlotIndexCounts::Deltas slot_deltas;
+  bool slot_index_enabled = slot_index_counts_.Enabled();
+  std::string old_value;
+  // cf index, key, value of the index puts, the deletes have no value
+  std::vector<std::tuple<size_t, std::string, std::optional<char>>> index_writes;
+  std::vector<std::string> dropped_metas;
+  for (const auto& write : collector.writes) {
+    Slice old_meta;
+    auto iter = known.find(ToView(write.key));
+    if (iter != known.end()) {
+      old_meta = iter->second;
+    } else {
+      s = db_->Get(default_read_options_, handles_[kMetaCF], write.key, &old_value);
+      if (s.ok()) {
+        old_meta = old_value;
+      } else if (!s.IsNotFound()) {
+        return s;
+      }
+    }
+    // the compaction filter took the meta off already, see key_counters.h
+    Slice counted_meta = old_meta;
+    if (key_counters_.IsDropped(write.key, old_meta)) {
+      counted_meta = Slice();
+      dropped_metas.push_back(write.key.ToString());
+    }
+    KeyCounters::CountMeta(counted_meta, -1, &deltas);
+    KeyCounters::CountMeta(write.value, 1, &deltas);
+    if (expire_index_enabled_) {
+      uint64_t old_etime = MetaEtime(old_meta);
+      uint64_t new_etime = MetaEtime(write.value);
+      if (old_etime != new_etime) {
+        if (old_etime != 0) {
+          index_writes.emplace_back(kExpireIndexCF, ExpireIndexKey(old_etime, write.key), std::nullopt);
+        }
+        if (new_etime != 0) {
+          index_writes.emplace_back(kExpireIndexCF, ExpireIndexKey(new_etime, write.key), '\0');
+        }
+      }
+    }
+    if (slot_index_enabled) {
+      char old_type = SlotIndexCounts::IndexType(counted_meta);
+      char new_type = SlotIndexCounts::IndexType(write.value);
+      if (old_type != new_type) {
+        std::string user_key = ParsedBaseMetaKey(write.key).Key().ToString();
+        uint32_t crc = 0;
+        int hastag = 0;
+        uint32_t slot_id = GetSlotsID(slot_index_counts_.SlotNum(), user_key, &crc, &hastag);
+        std::optional<char> type;
+        if (new_type != 0) {
+          type = new_type;
+        }
+        index_writes.emplace_back(kSlotIndexCF, SlotIndexKey(kSlotIndexSlotEntry, slot_id, user_key), type);
+        if (hastag != 0) {
+          index_writes.emplace_back(kSlotIndexCF, SlotIndexKey(kSlotIndexTagEntry, crc, user_key), type);
+        }
+        if (old_type == 0) {
+          slot_deltas[slot_id] += 1;
+        } else if (new_type == 0) {
+          slot_deltas[slot_id] -= 1;
+        }
+      }
+    }
+    known[ToView(write.key)] = write.value;
+  }
+  // appended once the slices into the batch are no longer used
+  for (const auto& [cf, index_key, value] : index_writes) {
+    if (!value.has_value()) {
+      batch->Delete(handles_[cf], index_key);
+    } else if (cf == kExpireIndexCF) {
+      batch->Put(handles_[cf], index_key, Slice());
+    } else {
+      batch->Put(handles_[cf], index_key, Slice(&value.value(), 1));
+    }
+  }
+
+  // the metas dropped by compactions since the last write
+  KeyCounters::Deltas pending = key_counters_.TakePending();
+  KeyCounters::Deltas persisted = deltas;
+  for (int counter = 0; counter < KeyCounters::kCounterNum; ++counter) {
+    persisted[counter] += pending[counter];
+  }
+  KeyCounters::AddToBatch(persisted, handles_[kKeyCountCF], batch);
+  // and the slot counts of the metas it dropped
+  SlotIndexCounts::Deltas slot_pending = slot_index_counts_.TakePending();
+  SlotIndexCounts::Deltas slot_persisted = slot_pending;
+  for (const auto& [slot_id, delta] : slot_deltas) {
+    slot_persisted[slot_id] += delta;
+  }
+  SlotIndexCounts::AddToBatch(slot_persisted, handles_[kSlotIndexCF], batch);
+  s = db_->Write(default_write_options_, batch);
+  if (s.ok()) {
+    key_counters_.Apply(deltas);
+    for (const auto& meta_key : dropped_metas) {
+      key_counters_.EraseDropped(meta_key);
+    }
+  } else {
+    key_counters_.AddPending(pending);
+    slot_index_counts_.AddPending(slot_pending);
+  }
+  return s;
+}
+
+Status Redis::PutMeta(const Slice& key, const Slice& old_value, const Slice& value) {
+  rocksdb::WriteBatch batch;
+  batch.Put(handles_[kMetaCF], key, value);
+  return WriteWithKeyCounters(&batch, {{key, old_value}});
+}
+
+Status Redis::DeleteMeta(const Slice& key, const Slice& old_value) {
+  rocksdb::WriteBatch batch;
+  batch.Delete(handles_[kMetaCF], key);
+  return WriteWithKeyCounters(&batch, {{key, old_value}});
+}
+
+Status Redis::PutMeta(const Slice& key, const Slice& value) {
+  rocksdb::WriteBatch batch;
+  batch.Put(handles_[kMetaCF], key, value);
+  return WriteWithKeyCounters(&batch);
+}
+
+Status Redis::DeleteMeta(const Slice& key) {
+  rocksdb::WriteBatch batch;
+  batch.Delete(handles_[kMetaCF], key);
+  return WriteWithKeyCounters(&batch);
 }
 
 Status Redis::GetScanStartPoint(const DataType& type, const Slice& key, const Slice& pattern, int64_t cursor, std::string* start_point) {
@@ -200,6 +509,10 @@ Status Redis::CompactRange(const rocksdb::Slice* begin, const rocksdb::Slice* en
   db_->CompactRange(default_compact_range_options_, handles_[kZsetsDataCF], begin, end);
   db_->CompactRange(default_compact_range_options_, handles_[kZsetsScoreCF], begin, end);
   db_->CompactRange(default_compact_range_options_, handles_[kStreamsDataCF], begin, end);
+  db_->CompactRange(default_compact_range_options_, handles_[kZsetsRankCF], begin, end);
+  db_->CompactRange(default_compact_range_options_, handles_[kSlotIndexCF], begin, end);
+  db_->CompactRange(default_compact_range_options_, handles_[kKeyCountCF], begin, end);
+  db_->CompactRange(default_compact_range_options_, handles_[kExpireIndexCF], begin, end);
   return Status::OK();
 }
 
@@ -260,9 +573,20 @@ Status Redis::SetOptions(const OptionType& option_type, const std::unordered_map
   if (handles_.empty()) {
     return db_->SetOptions(db_->DefaultColumnFamily(), options);
   }
+  // blob options only go to the column families taking blob files
+  std::unordered_map<std::string, std::string> lsm_options;
+  for (const auto& option : options) {
+    if (!IsBlobOption(option.first)) {
+      lsm_options.insert(option);
+    }
+  }
   Status s;
-  for (auto handle : handles_) {
-    s = db_->SetOptions(handle, options);
+  for (size_t idx = 0; idx < handles_.size(); ++idx) {
+    const auto& cf_options = TakesBlobFiles(idx) ? options : lsm_options;
+    if (cf_options.empty()) {
+      continue;
+    }
+    s = db_->SetOptions(handles_[idx], cf_options);
     if (!s.ok()) {
       break;
     }
@@ -372,7 +696,7 @@ void Redis::GetRocksDBInfo(std::string& info, const char* prefix) {
 
     // blob files
     write_aggregated_int_property(rocksdb::DB::Properties::kNumBlobFiles, "num_blob_files");
-    write_aggregated_int_property(rocksdb::DB::Properties::kBlobStats, "blob_stats");
+    write_aggregated_int_property(rocksdb::DB::Properties::kLiveBlobFileGarbageSize, "live_blob_file_garbage_size");
     write_aggregated_int_property(rocksdb::DB::Properties::kTotalBlobFileSize, "total_blob_file_size");
     write_aggregated_int_property(rocksdb::DB::Properties::kLiveBlobFileSize, "live_blob_file_size");
 
@@ -491,34 +815,255 @@ Status Redis::GetProperty(const std::string& property, uint64_t* out) {
   return Status::OK();
 }
 
+void Redis::MultiGetMeta(const std::vector<Slice>& keys, std::vector<std::string>* values,
+                         std::vector<Status>* statuses) {
+  size_t num_keys = keys.size();
+  values->clear();
+  values->resize(num_keys);
+  statuses->clear();
+  statuses->resize(num_keys);
+  if (num_keys == 0) {
+    return;
+  }
+
+  // BaseMetaKey::Encode returns a slice into its own buffer, so the
+  // encoded keys have to be owned here until MultiGet returns
+  std::vector<std::string> encoded_keys;
+  encoded_keys.reserve(num_keys);
+  for (const auto& key : keys) {
+    BaseMetaKey base_meta_key(key);
+    encoded_keys.emplace_back(base_meta_key.Encode().ToString());
+  }
+  std::vector<rocksdb::Slice> key_slices(encoded_keys.begin(), encoded_keys.end());
+  std::vector<rocksdb::PinnableSlice> pinnable_values(num_keys);
+
+  // MultiGet sorts the batch by the column family comparator itself and
+  // issues the data block reads of one sst file together, async_io lets
+  // those reads overlap when rocksdb is built with coroutine support
+  rocksdb::ReadOptions read_options(default_read_options_);
+  read_options.async_io = true;
+  db_->MultiGet(read_options, handles_[kMetaCF], num_keys, key_slices.data(), pinnable_values.data(),
+                statuses->data(), false);
+
+  for (size_t idx = 0; idx < num_keys; ++idx) {
+    if ((*statuses)[idx].ok()) {
+      (*values)[idx].assign(pinnable_values[idx].data(), pinnable_values[idx].size());
+    }
+  }
+}
+
+namespace {
+
+// strings, hashes, lists, zsets, sets, streams
+const DataType kKeyInfoTypes[] = {DataType::kStrings, DataType::kHashes, DataType::kLists,
+                                  DataType::kZSets,   DataType::kSets,   DataType::kStreams};
+
+// what ScanKeyNum found in one range of the meta cf
+struct KeyNumPart {
+  std::vector<KeyInfo> key_infos = std::vector<KeyInfo>(DataTypeNum);
+  uint64_t ttl_sums[DataTypeNum] = {0};
+  KeyCounters::Deltas counts{};
+};
+
+// the metas a compaction took off the counters are not counted again
+Status CountMetaRange(rocksdb::DB* db, rocksdb::ReadOptions read_options, rocksdb::ColumnFamilyHandle* cf,
+                      const MetaRange& range, pstd::TimeType curtime, KeyCounters* key_counters, KeyNumPart* part) {
+  int key_info_index[DataTypeNum];
+  for (int idx = 0; idx < DataTypeNum; ++idx) {
+    key_info_index[static_cast<int>(kKeyInfoTypes[idx])] = idx;
+  }
+  Slice lower(range.lower);
+  Slice upper(range.upper);
+  read_options.iterate_lower_bound = range.lower.empty() ? nullptr : &lower;
+  read_options.iterate_upper_bound = range.upper.empty() ? nullptr : &upper;
+
+  std::unique_ptr<rocksdb::Iterator> iter(db->NewIterator(read_options, cf));
+  for (range.lower.empty() ? iter->SeekToFirst() : iter->Seek(lower); iter->Valid(); iter->Next()) {
+    Slice meta_value = iter->value();
+    auto type = static_cast<DataType>(static_cast<uint8_t>(meta_value[0]));
+    if (static_cast<int>(type) >= DataTypeNum) {
+      continue;
+    }
+    if (!key_counters->IsDropped(iter->key(), meta_value)) {
+      KeyCounters::CountMeta(meta_value, 1, &part->counts);
+    }
+
+    KeyInfo& key_info = part->key_infos[key_info_index[static_cast<int>(type)]];
+    bool invalid = false;
+    uint64_t etime = 0;
+    switch (type) {
+      case DataType::kStrings: {
+        ParsedStringsValue parsed_strings_value(meta_value);
+        invalid = parsed_strings_value.IsStale();
+        etime = parsed_strings_value.Etime();
+        break;
+      }
+      case DataType::kLists: {
+        ParsedListsMetaValue parsed_lists_meta_value(meta_value);
+        invalid = parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.Count() == 0;
+        etime = parsed_lists_meta_value.Etime();
+        break;
+      }
+      case DataType::kStreams: {
+        ParsedStreamMetaValue parsed_stream_meta_value(meta_value);
+        invalid = parsed_stream_meta_value.length() == 0;
+        break;
+      }
+      default: {
+        ParsedBaseMetaValue parsed_meta_value(meta_value);
+        invalid = parsed_meta_value.IsStale() || parsed_meta_value.Count() == 0;
+        etime = parsed_meta_value.Etime();
+        break;
+      }
+    }
+    if (invalid) {
+      key_info.invaild_keys++;
+    } else {
+      key_info.keys++;
+      if (etime != 0) {
+        key_info.expires++;
+        part->ttl_sums[static_cast<int>(type)] += etime - curtime;
+      }
+    }
+  }
+  return iter->status();
+}
+
+}  // namespace
+
+void Redis::SplitMetaRange(const std::string& lower, const std::string& upper, size_t max_ranges,
+                           std::vector<MetaRange>* ranges) {
+  // the smallest keys of the meta cf sst files in the range, by size
+  std::vector<rocksdb::LiveFileMetaData> files;
+  std::vector<std::pair<std::string, uint64_t>> file_starts;
+  uint64_t total_size = 0;
+  if (max_ranges > 1) {
+    db_->GetLiveFilesMetaData(&files);
+  }
+  for (const auto& file : files) {
+    if (file.column_family_name != rocksdb::kDefaultColumnFamilyName || file.smallestkey <= lower ||
+        (!upper.empty() && file.smallestkey >= upper)) {
+      continue;
+    }
+    file_starts.emplace_back(file.smallestkey, file.size);
+    total_size += file.size;
+  }
+  std::sort(file_starts.begin(), file_starts.end());
+
+  std::vector<std::string> boundaries;
+  uint64_t step = std::max<uint64_t>(1, total_size / std::max<size_t>(1, max_ranges));
+  uint64_t size = 0;
+  uint64_t next_boundary = step;
+  for (const auto& file_start : file_starts) {
+    if (boundaries.size() + 1 >= max_ranges) {
+      break;
+    }
+    if (size >= next_boundary && (boundaries.empty() || boundaries.back() != file_start.first)) {
+      boundaries.push_back(file_start.first);
+      next_boundary = size + step;
+    }
+    size += file_start.second;
+  }
+
+  std::string range_lower = lower;
+  for (auto& boundary : boundaries) {
+    ranges->push_back({static_cast<size_t>(index_), range_lower, boundary});
+    range_lower = std::move(boundary);
+  }
+  ranges->push_back({static_cast<size_t>(index_), range_lower, upper});
+}
+
+Status Redis::ScanMetaRangeKeys(const DataType& type, const std::string& pattern, const MetaRange& range,
+                                std::vector<std::string>* keys) {
+  Slice lower(range.lower);
+  Slice upper(range.upper);
+  std::unique_ptr<TypeIterator> iter(CreateIterator(type, pattern, range.lower.empty() ? nullptr : &lower,
+                                                    range.upper.empty() ? nullptr : &upper));
+  if (iter == nullptr) {
+    return Status::InvalidArgument("invalid data type");
+  }
+  if (range.lower.empty()) {
+    iter->SeekToFirst();
+  } else {
+    iter->Seek(range.lower);
+  }
+  for (; iter->Valid(); iter->Next()) {
+    keys->push_back(iter->Key());
+  }
+  return iter->status();
+}
+
 Status Redis::ScanKeyNum(std::vector<KeyInfo>* key_infos) {
-  key_infos->resize(DataTypeNum);
-  rocksdb::Status s;
-  s = ScanStringsKeyNum(&((*key_infos)[0]));
-  if (!s.ok()) {
-    return s;
+  std::lock_guard l(key_counters_scan_mutex_);
+  // compaction deltas must be in the counters record the scan compares with
+  KeyCounters::Deltas pending = key_counters_.TakePending();
+  if (pending != KeyCounters::Deltas{}) {
+    rocksdb::WriteBatch batch;
+    KeyCounters::AddToBatch(pending, handles_[kKeyCountCF], &batch);
+    Status s = db_->Write(default_write_options_, &batch);
+    if (!s.ok()) {
+      key_counters_.AddPending(pending);
+      return s;
+    }
   }
-  s = ScanHashesKeyNum(&((*key_infos)[1]));
+
+  rocksdb::ReadOptions iterator_options;
+  const rocksdb::Snapshot* snapshot;
+  ScopeSnapshot ss(db_, &snapshot);
+  iterator_options.snapshot = snapshot;
+  iterator_options.fill_cache = false;
+
+  pstd::TimeType curtime = pstd::NowMillis();
+
+  size_t threads = storage_->GetKeyspaceScanThreads();
+  std::vector<MetaRange> ranges;
+  SplitMetaRange("", "", threads, &ranges);
+  std::vector<KeyNumPart> parts(ranges.size());
+  Status s = storage_->GetKeyspaceScanPool()->Run(ranges.size(), [&](size_t idx) {
+    return CountMetaRange(db_, iterator_options, handles_[kMetaCF], ranges[idx], curtime, &key_counters_,
+                          &parts[idx]);
+  });
   if (!s.ok()) {
     return s;
   }
-  s = ScanListsKeyNum(&((*key_infos)[2]));
-  if (!s.ok()) {
-    return s;
+
+  key_infos->assign(DataTypeNum, KeyInfo());
+  uint64_t ttl_sums[DataTypeNum] = {0};
+  KeyCounters::Deltas counts{};
+  for (const auto& part : parts) {
+    for (int idx = 0; idx < DataTypeNum; ++idx) {
+      (*key_infos)[idx] = (*key_infos)[idx] + part.key_infos[idx];
+      ttl_sums[idx] += part.ttl_sums[idx];
+    }
+    for (int counter = 0; counter < KeyCounters::kCounterNum; ++counter) {
+      counts[counter] += part.counts[counter];
+    }
   }
-  s = ScanZsetsKeyNum(&((*key_infos)[3]));
-  if (!s.ok()) {
-    return s;
+  for (int idx = 0; idx < DataTypeNum; ++idx) {
+    KeyInfo& key_info = (*key_infos)[idx];
+    key_info.avg_ttl = key_info.expires != 0 ? ttl_sums[static_cast<int>(kKeyInfoTypes[idx])] / key_info.expires : 0;
   }
-  s = ScanSetsKeyNum(&((*key_infos)[4]));
+
+  // reset the counters to the scan, the writes after the snapshot merge
+  // their deltas on top of the correction
+  KeyCounters::Deltas stored{};
+  s = KeyCounters::Read(db_, iterator_options, handles_[kKeyCountCF], &stored);
   if (!s.ok()) {
     return s;
   }
-  s = ScanStreamsKeyNum(&((*key_infos)[5]));
+  KeyCounters::Deltas correction{};
+  for (int counter = 0; counter < KeyCounters::kCounterNum; ++counter) {
+    correction[counter] = counts[counter] - stored[counter];
+  }
+  rocksdb::WriteBatch batch;
+  KeyCounters::AddToBatch(correction, handles_[kKeyCountCF], &batch);
+  KeyCounters::AddMarkerToBatch(handles_[kKeyCountCF], &batch);
+  s = db_->Write(default_write_options_, &batch);
   if (!s.ok()) {
     return s;
   }
-
+  key_counters_.Apply(correction);
+  key_counters_reconciled_ = true;
   return Status::OK();
 }
 
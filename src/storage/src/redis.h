@@ -6,8 +6,11 @@
 #ifndef SRC_REDIS_H_
 #define SRC_REDIS_H_
 
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "rocksdb/db.h"
@@ -15,8 +18,11 @@
 #include "rocksdb/status.h"
 
 #include "src/debug.h"
+#include "src/key_counters.h"
+#include "src/keyspace_scan.h"
 #include "src/lock_mgr.h"
 #include "src/lru_cache.h"
+#include "src/slot_index_counts.h"
 #include "src/mutex_impl.h"
 #include "src/type_iterator.h"
 #include "src/custom_comparator.h"
@@ -39,6 +45,7 @@ class Redis {
   virtual ~Redis();
 
   rocksdb::DB* GetDB() { return db_; }
+  std::shared_ptr<LockMgr> GetLockMgr() { return lock_mgr_; }
 
   struct KeyStatistics {
     size_t window_size;
@@ -108,13 +115,35 @@ class Redis {
 
   virtual Status GetProperty(const std::string& property, uint64_t* out);
 
+  // Fetch the meta values of a batch of keys with a single rocksdb MultiGet,
+  // values[i] and statuses[i] correspond to keys[i]
+  void MultiGetMeta(const std::vector<Slice>& keys, std::vector<std::string>* values,
+                    std::vector<Status>* statuses);
+
+  // full scan of the meta cf, also resets the keyspace counters to what it found
   Status ScanKeyNum(std::vector<KeyInfo>* key_info);
-  Status ScanStringsKeyNum(KeyInfo* key_info);
-  Status ScanHashesKeyNum(KeyInfo* key_info);
-  Status ScanListsKeyNum(KeyInfo* key_info);
-  Status ScanZsetsKeyNum(KeyInfo* key_info);
-  Status ScanSetsKeyNum(KeyInfo* key_info);
-  Status ScanStreamsKeyNum(KeyInfo* key_info);
+  // appends at most max_ranges ranges covering [lower, upper) of the meta cf,
+  // split at sst file boundaries into ranges of about the same size
+  void SplitMetaRange(const std::string& lower, const std::string& upper, size_t max_ranges,
+                      std::vector<MetaRange>* ranges);
+  Status ScanMetaRangeKeys(const DataType& type, const std::string& pattern, const MetaRange& range,
+                           std::vector<std::string>* keys);
+  // keyspace counters, see key_counters.h
+  void GetKeyCounters(std::vector<KeyInfo>* key_infos) const { key_counters_.GetKeyInfos(key_infos); }
+  bool KeyCountersReconciled() const { return key_counters_reconciled_; }
+  void SetSlotIndexEnabled(bool enabled) { slot_index_counts_.SetEnabled(enabled); }
+
+  // Expiry index, see expire_index_format.h. keys gets at most count keys
+  // that expired before now_millsec, the oldest first, and the entries of
+  // keys that are gone or got another TTL are dropped on the way.
+  // oldest_etime is when the first of keys expired, 0 for none
+  Status ScanExpiredKeys(uint64_t now_millsec, int64_t count, std::vector<std::string>* keys,
+                         uint64_t* oldest_etime);
+  // deletes the keys that are still expired
+  Status ReapExpiredKeys(const std::vector<Slice>& keys, std::vector<std::string>* reaped);
+  // indexes the metas written while the index was off
+  Status BackfillExpireIndex();
+  bool ExpireIndexBackfilled() const { return expire_index_backfilled_; }
 
   // Keys Commands
   virtual Status StringsExpire(const Slice& key, int64_t ttl_millsec, std::string&& prefetch_meta = {});
@@ -154,10 +183,17 @@ class Redis {
   Status BitOp(BitOpType op, const std::string& dest_key, const std::vector<std::string>& src_keys, std::string &value_to_dest, int64_t* ret);
   Status Decrby(const Slice& key, int64_t value, int64_t* ret);
   Status Get(const Slice& key, std::string* value);
+  // value points into pinned_value, the string is parsed where rocksdb
+  // pinned it without being copied out
+  Status Get(const Slice& key, rocksdb::PinnableSlice* pinned_value, Slice* value);
   Status HyperloglogGet(const Slice& key, std::string* value);
   Status MGet(const Slice& key, std::string* value);
   Status GetWithTTL(const Slice& key, std::string* value, int64_t* ttl_millsec);
+  Status GetWithTTL(const Slice& key, rocksdb::PinnableSlice* pinned_value, Slice* value, int64_t* ttl_millsec);
   Status MGetWithTTL(const Slice& key, std::string* value, int64_t* ttl_millsec);
+  // Batched variants, all keys are read from the meta cf with one MultiGet
+  Status MGet(const std::vector<Slice>& keys, std::vector<ValueStatus>* vss);
+  Status MGetWithTTL(const std::vector<Slice>& keys, std::vector<ValueStatus>* vss);
   Status GetBit(const Slice& key, int64_t offset, int32_t* ret);
   Status Getrange(const Slice& key, int64_t start_offset, int64_t end_offset, std::string* ret);
   Status GetrangeWithValue(const Slice& key, int64_t start_offset, int64_t end_offset,
@@ -167,6 +203,11 @@ class Redis {
   Status Incrbyfloat(const Slice& key, const Slice& value, std::string* ret, int64_t* expired_timestamp_sec);
   Status MSet(const std::vector<KeyValue>& kvs);
   Status MSetnx(const std::vector<KeyValue>& kvs, int32_t* ret);
+  // The caller must hold the record locks of all keys, see GetLockMgr
+  Status AnyKeyExistsWithoutLock(const std::vector<KeyValue>& kvs, bool* exists);
+  Status MSetWithoutLock(const std::vector<KeyValue>& kvs);
+  // The writes of distinct keys in one batch, see Storage::ApplyStagedWrites
+  Status ApplyStagedWrites(const std::vector<StagedWrite*>& writes);
   Status Set(const Slice& key, const Slice& value);
   Status HyperloglogSet(const Slice& key, const Slice& value);
   Status Setxx(const Slice& key, const Slice& value, int32_t* ret, int64_t ttl_millsec = 0);
@@ -184,7 +225,9 @@ class Redis {
   Status PKSetexAt(const Slice& key, const Slice& value, int64_t time_stamp_millsec_);
 
   Status Exists(const Slice& key);
+  Status Exists(const std::vector<Slice>& keys, int64_t* count);
   Status Del(const Slice& key);
+  Status Del(const std::vector<Slice>& keys, int64_t* count);
   Status Expire(const Slice& key, int64_t ttl_millsec);
   Status Expireat(const Slice& key, int64_t timestamp_millsec);
   Status Persist(const Slice& key);
@@ -206,6 +249,11 @@ class Redis {
   Status HMGet(const Slice& key, const std::vector<std::string>& fields, std::vector<ValueStatus>* vss);
   Status HMSet(const Slice& key, const std::vector<FieldValue>& fvs);
   Status HSet(const Slice& key, const Slice& field, const Slice& value, int32_t* res);
+  // Adds the writes of HMSET to batch, the caller holds the record lock of
+  // key. old_meta is the meta they replace, new_fields the number of fields
+  // the hash did not have
+  Status HMSetToBatch(const Slice& key, const std::vector<FieldValue>& fvs, rocksdb::WriteBatch* batch,
+                      std::string* old_meta, int32_t* new_fields, uint32_t* statistic);
   Status HSetnx(const Slice& key, const Slice& field, const Slice& value, int32_t* ret);
   Status HVals(const Slice& key, std::vector<std::string>* values);
   Status HStrlen(const Slice& key, const Slice& field, int32_t* len);
@@ -238,7 +286,9 @@ class Redis {
   }
 
   std::vector<rocksdb::ColumnFamilyHandle*> GetZsetCFHandles() {
-    return {handles_.begin() + kMetaCF, handles_.begin() + kZsetsScoreCF + 1};
+    std::vector<rocksdb::ColumnFamilyHandle*> cfhds(handles_.begin() + kMetaCF, handles_.begin() + kZsetsScoreCF + 1);
+    cfhds.push_back(handles_[kZsetsRankCF]);
+    return cfhds;
   }
 
   std::vector<rocksdb::ColumnFamilyHandle*> GetStreamCFHandles() {
@@ -246,6 +296,14 @@ class Redis {
   }
   void GetRocksDBInfo(std::string &info, const char *prefix);
 
+  // Codis slot index, see slot_index_format.h
+  Status SlotIndexAdd(uint32_t slot_id, bool has_tag, uint32_t crc, const Slice& key);
+  Status SlotIndexDel(uint32_t slot_id, bool has_tag, uint32_t crc, const Slice& key);
+  Status SlotIndexScan(uint32_t slot_id, int64_t cursor, const std::string& pattern, int64_t count,
+                       std::vector<std::string>* type_keys, int64_t* next_cursor);
+  Status SlotIndexTagKeys(uint32_t crc, std::vector<std::string>* type_keys);
+  Status SlotIndexCount(uint32_t slot_id, int64_t* count);
+
   // Sets Commands
   Status SAdd(const Slice& key, const std::vector<std::string>& members, int32_t* ret);
   Status SCard(const Slice& key, int32_t* ret, std::string&& prefetch_meta = {});
@@ -392,12 +450,12 @@ class Redis {
     return nullptr;
   }
 
-  enum DataType GetMetaValueType(const std::string &meta_value) {
+  enum DataType GetMetaValueType(const Slice& meta_value) {
     DataType meta_type = static_cast<enum DataType>(static_cast<uint8_t>(meta_value[0]));
     return meta_type;
   }
 
-  inline bool ExpectedMetaValue(enum DataType type, const std::string &meta_value) {
+  inline bool ExpectedMetaValue(enum DataType type, const Slice& meta_value) {
     auto meta_type = static_cast<enum DataType>(static_cast<uint8_t>(meta_value[0]));
     if (type == meta_type) {
       return true;
@@ -405,7 +463,7 @@ class Redis {
     return false;
   }
 
-  inline bool ExpectedStale(const std::string &meta_value) {
+  inline bool ExpectedStale(const Slice& meta_value) {
     auto meta_type = static_cast<enum DataType>(static_cast<uint8_t>(meta_value[0]));
     switch (meta_type) {
       case DataType::kZSets:
@@ -485,9 +543,119 @@ private:
   std::unique_ptr<LRUCache<std::string, std::string>> scan_cursors_store_;
   std::unique_ptr<LRUCache<std::string, size_t>> spop_counts_store_;
 
+  // Sparse ranks of the members of a large set. SRANDMEMBER and SPOP seek
+  // to the closest member before a random rank and step from there instead
+  // of walking the set from its first member
+  struct SetsSampleIndex {
+    uint64_t version = 0;
+    int32_t count = 0;
+    // ranks[i] members of the set are before members[i]
+    std::vector<std::string> members;
+    std::vector<int32_t> ranks;
+  };
+  // by set key, charged by the bytes of the members and ranks kept
+  std::unique_ptr<LRUCache<std::string, std::shared_ptr<SetsSampleIndex>>> sets_sample_store_;
+  Status GetSetsSampleIndex(const Slice& key, const std::string& meta_value, std::shared_ptr<SetsSampleIndex>* index);
+  void UpdateSetsSampleIndex(const Slice& key, uint64_t version, std::vector<std::string> popped);
+  // count members of the set, distinct unless repeats is set
+  Status SampleSetsMembers(const Slice& key, const std::string& meta_value, int32_t count, bool repeats,
+                           std::vector<std::string>* members);
+
+  // Every write to the meta cf goes through these, they add the keyspace
+  // counter deltas and the expiry index updates of the batch to the batch.
+  // old_metas are the metas the batch replaces as the writer read them under
+  // the record locks, by meta key, empty for the keys that had none. Only
+  // the metas missing there are read back
+  using OldMeta = std::pair<Slice, Slice>;
+  Status WriteWithKeyCounters(rocksdb::WriteBatch* batch, const std::vector<OldMeta>& old_metas = {});
+  Status PutMeta(const Slice& key, const Slice& old_value, const Slice& value);
+  Status DeleteMeta(const Slice& key, const Slice& old_value);
+  // for the writers that did not read the meta
+  Status PutMeta(const Slice& key, const Slice& value);
+  Status DeleteMeta(const Slice& key);
+  Status LoadKeyCounters();
+
+  KeyCounters key_counters_;
+  std::atomic_bool key_counters_reconciled_ = {false};
+  std::mutex key_counters_scan_mutex_;
+  SlotIndexCounts slot_index_counts_;
+
+  Status LoadExpireIndex();
+  bool expire_index_enabled_ = false;
+  std::atomic_bool expire_index_backfilled_ = {false};
+
   Status GetScanStartPoint(const DataType& type, const Slice& key, const Slice& pattern, int64_t cursor, std::string* start_point);
   Status StoreScanNextPoint(const DataType& type, const Slice& key, const Slice& pattern, int64_t cursor, const std::string& next_point);
 
+  // For zset rank index, 0 disables it
+  std::atomic_uint64_t zset_rank_index_threshold_ = {0};
+  Status ZsetsBuildRankIndexIfNeeded(const Slice& key, ParsedZSetsMetaValue* parsed_zsets_meta_value,
+                                     const std::string& meta_value);
+  Status ZsetsSeekToRank(const Slice& key, uint64_t version, bool rank_indexed, const rocksdb::ReadOptions& read_options,
+                         rocksdb::Iterator* iter, int32_t rank);
+  Status ZsetsRankOfMember(const Slice& key, uint64_t version, const rocksdb::ReadOptions& read_options,
+                           const Slice& member, int32_t* rank);
+  // ZUNIONSTORE and ZINTERSTORE write their destination as a new version,
+  // the members go out in bounded batches ahead of the meta that makes them
+  // visible. The compaction filters keep them while the stored meta is a
+  // zset without a TTL, any other stored meta is replaced by a pending one
+  // before the first batch, see ZsetsStoreFlush
+  struct ZsetsStore {
+    rocksdb::WriteBatch batch;
+    // of the new version
+    std::string meta_value;
+    uint64_t version = 0;
+    // as the store found it and as stored now
+    std::string found_meta;
+    std::string old_meta;
+    bool pending = false;
+  };
+  Status ZsetsStoreBegin(const Slice& destination, ZsetsStore* store, uint32_t* statistic);
+  Status ZsetsStoreMember(const Slice& destination, const std::string& member, double score, ZsetsStore* store);
+  Status ZsetsStoreFlush(const Slice& destination, ZsetsStore* store);
+  Status ZsetsStoreEnd(const Slice& destination, size_t count, ZsetsStore* store);
+  // puts back the meta a failed store replaced
+  void ZsetsStoreAbort(const Slice& destination, ZsetsStore* store);
+
+  // Lists created while it is not 0 are chunked, see lists_chunk_format.h
+  size_t list_chunk_max_elements_ = 0;
+  Status PushListChunks(const Slice& key, std::string* meta_value, const std::vector<std::string>& values, bool left,
+                        rocksdb::WriteBatch* batch, uint64_t* len);
+
+  // Hashes and sets created while it is not 0 keep up to this many entries
+  // in their meta, see inline_collection_format.h
+  size_t inline_collection_max_entries_ = 0;
+  // inline collections may exist, their writes go through FoldInlineCollections
+  bool inline_collections_ = false;
+  Status LoadInlineCollections();
+  Status FoldInlineCollections(rocksdb::WriteBatch* batch, const std::vector<OldMeta>& old_metas,
+                               std::unordered_map<std::string, std::string>* stored_metas);
+  // The data cf of hashes and sets is read through these, they also serve
+  // the entries of an inline collection. meta_value is the meta of the
+  // collection the caller read
+  Status GetCollectionData(const rocksdb::ReadOptions& read_options, ColumnFamilyIndex cf,
+                           const std::string& meta_value, const Slice& data_key, std::string* value);
+  rocksdb::Iterator* NewCollectionIterator(const rocksdb::ReadOptions& read_options, ColumnFamilyIndex cf,
+                                           const Slice& key, const std::string& meta_value);
+
+  // The set algebra of SDIFF, SINTER, SUNION and their store variants over
+  // the live non empty sets read at one snapshot with their metas, the
+  // members come out in member order
+  Status SetsInter(const rocksdb::ReadOptions& read_options, const std::vector<KeyVersion>& sets,
+                   const std::vector<std::string>& metas, std::vector<std::string>* members);
+  Status SetsUnion(const rocksdb::ReadOptions& read_options, const std::vector<KeyVersion>& sets,
+                   const std::vector<std::string>& metas, std::vector<std::string>* members);
+  Status SetsDiff(const rocksdb::ReadOptions& read_options, const KeyVersion& first, const std::string& first_meta,
+                  const std::vector<KeyVersion>& sets, const std::vector<std::string>& metas,
+                  std::vector<std::string>* members);
+  Status ProbeSetsMembers(const rocksdb::ReadOptions& read_options, const KeyVersion& set,
+                          const std::string& meta_value, const std::vector<std::string>& members,
+                          std::vector<bool>* found);
+
+  // Pins the live string value of key, NotFound for other types unless
+  // wrongtype_error, then they are InvalidArgument
+  Status PinStringsValue(const Slice& key, rocksdb::PinnableSlice* pinned_value, bool wrongtype_error);
+
   // For Statistics
   std::atomic_uint64_t small_compaction_threshold_;
   std::atomic_uint64_t small_compaction_duration_threshold_;
@@ -0,0 +1,242 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "src/base_key_format.h"
+#include "src/expire_index_format.h"
+#include "src/redis.h"
+#include "src/scope_record_lock.h"
+
+namespace storage {
+
+namespace {
+
+const size_t kBackfillBatchSize = 1000;
+
+std::string BackfilledMarker() { return std::string(1, kExpireIndexBackfilled); }
+
+// same rule as the meta compaction filter, a collection whose version is
+// not in the past yet was just recreated and is kept
+bool ReapableMeta(const Slice& meta_value, uint64_t now_millsec) {
+  uint64_t etime = MetaEtime(meta_value);
+  if (etime == 0 || etime >= now_millsec) {
+    return false;
+  }
+  switch (static_cast<DataType>(static_cast<uint8_t>(meta_value[0]))) {
+    case DataType::kHashes:
+    case DataType::kSets:
+    case DataType::kZSets: {
+      ParsedBaseMetaValue parsed_meta_value(meta_value);
+      return parsed_meta_value.Version() < now_millsec;
+    }
+    case DataType::kLists: {
+      ParsedListsMetaValue parsed_lists_meta_value(meta_value);
+      return parsed_lists_meta_value.Version() < now_millsec;
+    }
+    default:
+      return true;
+  }
+}
+
+}  // namespace
+
+Status Redis::LoadExpireIndex() {
+  std::string value;
+  Status s = db_->Get(default_read_options_, handles_[kExpireIndexCF], BackfilledMarker(), &value);
+  if (!s.ok() && !s.IsNotFound()) {
+    return s;
+  }
+  if (!expire_index_enabled_) {
+    // the writes from now on are not indexed, enabling it again backfills
+    expire_index_backfilled_ = false;
+    return s.ok() ? db_->Delete(default_write_options_, handles_[kExpireIndexCF], BackfilledMarker()) : Status::OK();
+  }
+  if (s.ok()) {
+    expire_index_backfilled_ = true;
+    return s;
+  }
+
+  // a new instance has nothing to index
+  rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[kMetaCF]);
+  iter->SeekToFirst();
+  bool empty = !iter->Valid() || IsMetaMarker(iter->key());
+  s = iter->status();
+  delete iter;
+  if (!s.ok() || !empty) {
+    return s;
+  }
+  s = db_->Put(default_write_options_, handles_[kExpireIndexCF], BackfilledMarker(), "1");
+  expire_index_backfilled_ = s.ok();
+  return s;
+}
+
+/*
+ * Every meta written since the instance opened is indexed by its write, so
+ * the metas are indexed without locks. A meta changed meanwhile leaves an
+ * entry for its old TTL behind, which the scan drops.
+ */
+Status Redis::BackfillExpireIndex() {
+  if (!expire_index_enabled_ || expire_index_backfilled_) {
+    return Status::OK();
+  }
+  rocksdb::ReadOptions iterator_options;
+  iterator_options.fill_cache = false;
+  rocksdb::WriteBatch batch;
+  uint64_t indexed = 0;
+  Status s;
+  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    uint64_t etime = MetaEtime(iter->value());
+    if (etime == 0) {
+      continue;
+    }
+    batch.Put(handles_[kExpireIndexCF], ExpireIndexKey(etime, iter->key()), Slice());
+    ++indexed;
+    if (batch.Count() >= kBackfillBatchSize) {
+      s = db_->Write(default_write_options_, &batch);
+      if (!s.ok()) {
+        break;
+      }
+      batch.Clear();
+    }
+  }
+  if (s.ok()) {
+    s = iter->status();
+  }
+  delete iter;
+  if (!s.ok()) {
+    return s;
+  }
+  batch.Put(handles_[kExpireIndexCF], BackfilledMarker(), "1");
+  s = db_->Write(default_write_options_, &batch);
+  if (s.ok()) {
+    expire_index_backfilled_ = true;
+    LOG(INFO) << "instance " << index_ << " indexed " << indexed << " keys with a TTL";
+  }
+  return s;
+}
+
+Status Redis::ScanExpiredKeys(uint64_t now_millsec, int64_t count, std::vector<std::string>* keys,
+                              uint64_t* oldest_etime) {
+  *oldest_etime = 0;
+  if (!expire_index_enabled_ || count <= 0) {
+    return Status::OK();
+  }
+
+  // the entries of keys that expired before now, IsStale is etime < now
+  std::string lower = ExpireIndexPrefix(0);
+  std::string upper = ExpireIndexPrefix(now_millsec);
+  rocksdb::Slice upper_bound(upper);
+  rocksdb::ReadOptions iterator_options;
+  iterator_options.iterate_upper_bound = &upper_bound;
+  std::vector<std::string> dropped_entries;
+  std::string meta_value;
+  uint64_t etime = 0;
+  Slice meta_key;
+  Status s;
+  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[kExpireIndexCF]);
+  for (iter->Seek(lower); iter->Valid() && count > 0; iter->Next()) {
+    if (!ParseExpireIndexKey(iter->key(), &etime, &meta_key)) {
+      break;
+    }
+    count--;
+    s = db_->Get(default_read_options_, handles_[kMetaCF], meta_key, &meta_value);
+    if (!s.ok() && !s.IsNotFound()) {
+      break;
+    }
+    if (s.ok() && MetaEtime(meta_value) == etime) {
+      if (ReapableMeta(meta_value, now_millsec)) {
+        if (*oldest_etime == 0) {
+          *oldest_etime = etime;
+        }
+        ParsedBaseMetaKey parsed_meta_key(meta_key);
+        keys->push_back(parsed_meta_key.Key().ToString());
+      }
+      continue;
+    }
+    dropped_entries.push_back(iter->key().ToString());
+  }
+  if (s.ok() || s.IsNotFound()) {
+    s = iter->status();
+  }
+  delete iter;
+  if (!s.ok()) {
+    return s;
+  }
+
+  // the key may be written meanwhile, check again under its lock
+  for (const auto& index_key : dropped_entries) {
+    ParseExpireIndexKey(index_key, &etime, &meta_key);
+    ParsedBaseMetaKey parsed_meta_key(meta_key);
+    ScopeRecordLock l(lock_mgr_, parsed_meta_key.Key());
+    s = db_->Get(default_read_options_, handles_[kMetaCF], meta_key, &meta_value);
+    if (s.ok() && MetaEtime(meta_value) == etime) {
+      continue;
+    }
+    if (!s.ok() && !s.IsNotFound()) {
+      return s;
+    }
+    s = db_->Delete(default_write_options_, handles_[kExpireIndexCF], index_key);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
+Status Redis::ReapExpiredKeys(const std::vector<Slice>& keys, std::vector<std::string>* reaped) {
+  std::vector<std::string> lock_keys;
+  std::unordered_set<std::string> seen;
+  for (const auto& key : keys) {
+    if (seen.insert(key.ToString()).second) {
+      lock_keys.push_back(key.ToString());
+    }
+  }
+  MultiScopeRecordLock ml(lock_mgr_, lock_keys);
+
+  uint64_t now_millsec = pstd::NowMillis();
+  rocksdb::WriteBatch batch;
+  std::vector<std::string> deleted;
+  std::vector<std::pair<std::string, std::string>> deleted_metas;
+  std::string meta_value;
+  for (const auto& key : lock_keys) {
+    BaseMetaKey base_meta_key(key);
+    Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+    if (s.IsNotFound()) {
+      continue;
+    } else if (!s.ok()) {
+      return s;
+    }
+    if (!ReapableMeta(meta_value, now_millsec)) {
+      continue;
+    }
+    // the data of a collection goes with its meta, like for a compacted meta
+    batch.Delete(handles_[kMetaCF], base_meta_key.Encode());
+    deleted.push_back(key);
+    deleted_metas.emplace_back(base_meta_key.Encode().ToString(), meta_value);
+  }
+  if (deleted.empty()) {
+    return Status::OK();
+  }
+  std::vector<OldMeta> old_metas;
+  old_metas.reserve(deleted_metas.size());
+  for (const auto& [meta_key, old_meta] : deleted_metas) {
+    old_metas.emplace_back(meta_key, old_meta);
+  }
+  Status s = WriteWithKeyCounters(&batch, old_metas);
+  if (!s.ok()) {
+    return s;
+  }
+  reaped->insert(reaped->end(), deleted.begin(), deleted.end());
+  return Status::OK();
+}
+
+}  //  namespace storage
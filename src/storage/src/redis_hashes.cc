@@ -19,45 +19,6 @@
 #include "storage/util.h"
 
 namespace storage {
-Status Redis::ScanHashesKeyNum(KeyInfo* key_info) {
-  uint64_t keys = 0;
-  uint64_t expires = 0;
-  uint64_t ttl_sum = 0;
-  uint64_t invaild_keys = 0;
-
-  rocksdb::ReadOptions iterator_options;
-  const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
-  iterator_options.snapshot = snapshot;
-  iterator_options.fill_cache = false;
-
-  pstd::TimeType curtime = pstd::NowMillis();
-
-  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kHashes, iter->value().ToString())) {
-      continue;
-    }
-    ParsedHashesMetaValue parsed_hashes_meta_value(iter->value());
-    if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.Count() == 0) {
-      invaild_keys++;
-    } else {
-      keys++;
-      if (!parsed_hashes_meta_value.IsPermanentSurvival()) {
-        expires++;
-        ttl_sum += parsed_hashes_meta_value.Etime() - curtime;
-      }
-    }
-  }
-  delete iter;
-
-  key_info->keys = keys;
-  key_info->expires = expires;
-  key_info->avg_ttl = (expires != 0) ? ttl_sum / expires : 0;
-  key_info->invaild_keys = invaild_keys;
-  return Status::OK();
-}
-
 Status Redis::HDel(const Slice& key, const std::vector<std::string>& fields, int32_t* ret) {
   uint32_t statistic = 0;
   std::vector<std::string> filtered_fields;
@@ -83,6 +44,7 @@ Status Redis::HDel(const Slice& key, const std::vector<std::string>& fields, int
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kHashes, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -103,7 +65,7 @@ Status Redis::HDel(const Slice& key, const std::vector<std::string>& fields, int
       version = parsed_hashes_meta_value.Version();
       for (const auto& field : filtered_fields) {
         HashesDataKey hashes_data_key(key, version, field);
-        s = db_->Get(read_options, handles_[kHashesDataCF], hashes_data_key.Encode(), &data_value);
+        s = GetCollectionData(read_options, kHashesDataCF, meta_value, hashes_data_key.Encode(), &data_value);
         if (s.ok()) {
           del_cnt++;
           statistic++;
@@ -127,7 +89,7 @@ Status Redis::HDel(const Slice& key, const std::vector<std::string>& fields, int
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kHashes, key.ToString(), statistic);
   return s;
 }
@@ -166,7 +128,7 @@ Status Redis::HGet(const Slice& key, const Slice& field, std::string* value) {
     } else {
       version = parsed_hashes_meta_value.Version();
       HashesDataKey data_key(key, version, field);
-      s = db_->Get(read_options, handles_[kHashesDataCF], data_key.Encode(), value);
+      s = GetCollectionData(read_options, kHashesDataCF, meta_value, data_key.Encode(), value);
       if (s.ok()) {
         ParsedBaseDataValue parsed_internal_value(value);
         parsed_internal_value.StripSuffix();
@@ -208,7 +170,7 @@ Status Redis::HGetall(const Slice& key, std::vector<FieldValue>* fvs) {
       HashesDataKey hashes_data_key(key, version, "");
       Slice prefix = hashes_data_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewCollectionIterator(read_options, kHashesDataCF, key, meta_value);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
         ParsedBaseDataValue parsed_internal_value(iter->value());
@@ -260,7 +222,7 @@ Status Redis::HGetallWithTTL(const Slice& key, std::vector<FieldValue>* fvs, int
       HashesDataKey hashes_data_key(key, version, "");
       Slice prefix = hashes_data_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewCollectionIterator(read_options, kHashesDataCF, key, meta_value);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
         ParsedBaseDataValue parsed_internal_value(iter->value());
@@ -285,6 +247,7 @@ Status Redis::HIncrby(const Slice& key, const Slice& field, int64_t value, int64
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   char value_buf[32] = {0};
   char meta_value_buf[4] = {0};
   if (s.ok() && !ExpectedMetaValue(DataType::kHashes, meta_value)) {
@@ -312,7 +275,7 @@ Status Redis::HIncrby(const Slice& key, const Slice& field, int64_t value, int64
     } else {
       version = parsed_hashes_meta_value.Version();
       HashesDataKey hashes_data_key(key, version, field);
-      s = db_->Get(default_read_options_, handles_[kHashesDataCF], hashes_data_key.Encode(), &old_value);
+      s = GetCollectionData(default_read_options_, kHashesDataCF, meta_value, hashes_data_key.Encode(), &old_value);
       if (s.ok()) {
         ParsedBaseDataValue parsed_internal_value(&old_value);
         parsed_internal_value.StripSuffix();
@@ -356,7 +319,7 @@ Status Redis::HIncrby(const Slice& key, const Slice& field, int64_t value, int64
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kHashes, key.ToString(), statistic);
   return s;
 }
@@ -379,6 +342,7 @@ Status Redis::HIncrbyfloat(const Slice& key, const Slice& field, const Slice& by
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   char meta_value_buf[4] = {0};
   if (s.ok() && !ExpectedMetaValue(DataType::kHashes, meta_value)) {
     if (ExpectedStale(meta_value)) {
@@ -405,7 +369,7 @@ Status Redis::HIncrbyfloat(const Slice& key, const Slice& field, const Slice& by
     } else {
       version = parsed_hashes_meta_value.Version();
       HashesDataKey hashes_data_key(key, version, field);
-      s = db_->Get(default_read_options_, handles_[kHashesDataCF], hashes_data_key.Encode(), &old_value_str);
+      s = GetCollectionData(default_read_options_, kHashesDataCF, meta_value, hashes_data_key.Encode(), &old_value_str);
       if (s.ok()) {
         long double total;
         long double old_value;
@@ -448,7 +412,7 @@ Status Redis::HIncrbyfloat(const Slice& key, const Slice& field, const Slice& by
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kHashes, key.ToString(), statistic);
   return s;
 }
@@ -485,7 +449,7 @@ Status Redis::HKeys(const Slice& key, std::vector<std::string>* fields) {
       HashesDataKey hashes_data_key(key, version, "");
       Slice prefix = hashes_data_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewCollectionIterator(read_options, kHashesDataCF, key, meta_value);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
         fields->push_back(parsed_hashes_data_key.field().ToString());
@@ -567,7 +531,7 @@ Status Redis::HMGet(const Slice& key, const std::vector<std::string>& fields, st
       version = parsed_hashes_meta_value.Version();
       for (const auto& field : fields) {
         HashesDataKey hashes_data_key(key, version, field);
-        s = db_->Get(read_options, handles_[kHashesDataCF], hashes_data_key.Encode(), &value);
+        s = GetCollectionData(read_options, kHashesDataCF, meta_value, hashes_data_key.Encode(), &value);
         if (s.ok()) {
           ParsedBaseDataValue parsed_internal_value(&value);
           parsed_internal_value.StripSuffix();
@@ -590,7 +554,24 @@ Status Redis::HMGet(const Slice& key, const std::vector<std::string>& fields, st
 }
 
 Status Redis::HMSet(const Slice& key, const std::vector<FieldValue>& fvs) {
+  rocksdb::WriteBatch batch;
+  ScopeRecordLock l(lock_mgr_, key);
+
+  std::string old_meta;
+  int32_t new_fields = 0;
   uint32_t statistic = 0;
+  Status s = HMSetToBatch(key, fvs, &batch, &old_meta, &new_fields, &statistic);
+  if (!s.ok()) {
+    return s;
+  }
+  BaseMetaKey base_meta_key(key);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
+  UpdateSpecificKeyStatistics(DataType::kHashes, key.ToString(), statistic);
+  return s;
+}
+
+Status Redis::HMSetToBatch(const Slice& key, const std::vector<FieldValue>& fvs, rocksdb::WriteBatch* batch,
+                           std::string* old_meta, int32_t* new_fields, uint32_t* statistic) {
   std::unordered_set<std::string> fields;
   std::vector<FieldValue> filtered_fvs;
   for (auto iter = fvs.rbegin(); iter != fvs.rend(); ++iter) {
@@ -601,14 +582,12 @@ Status Redis::HMSet(const Slice& key, const std::vector<FieldValue>& fvs) {
     }
   }
 
-  rocksdb::WriteBatch batch;
-  ScopeRecordLock l(lock_mgr_, key);
-
   uint64_t version = 0;
   std::string meta_value;
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  *old_meta = meta_value;
   char meta_value_buf[4] = {0};
   if (s.ok() && !ExpectedMetaValue(DataType::kHashes, meta_value)) {
     if (ExpectedStale(meta_value)) {
@@ -628,12 +607,13 @@ Status Redis::HMSet(const Slice& key, const std::vector<FieldValue>& fvs) {
         return Status::InvalidArgument("hash size overflow");
       }
       parsed_hashes_meta_value.SetCount(static_cast<int32_t>(filtered_fvs.size()));
-      batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      batch->Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
       for (const auto& fv : filtered_fvs) {
         HashesDataKey hashes_data_key(key, version, fv.field);
         BaseDataValue inter_value(fv.value);
-        batch.Put(handles_[kHashesDataCF], hashes_data_key.Encode(), inter_value.Encode());
+        batch->Put(handles_[kHashesDataCF], hashes_data_key.Encode(), inter_value.Encode());
       }
+      *new_fields = static_cast<int32_t>(filtered_fvs.size());
     } else {
       int32_t count = 0;
       std::string data_value;
@@ -641,13 +621,13 @@ Status Redis::HMSet(const Slice& key, const std::vector<FieldValue>& fvs) {
       for (const auto& fv : filtered_fvs) {
         HashesDataKey hashes_data_key(key, version, fv.field);
         BaseDataValue inter_value(fv.value);
-        s = db_->Get(default_read_options_, handles_[kHashesDataCF], hashes_data_key.Encode(), &data_value);
+        s = GetCollectionData(default_read_options_, kHashesDataCF, meta_value, hashes_data_key.Encode(), &data_value);
         if (s.ok()) {
-          statistic++;
-          batch.Put(handles_[kHashesDataCF], hashes_data_key.Encode(), inter_value.Encode());
+          (*statistic)++;
+          batch->Put(handles_[kHashesDataCF], hashes_data_key.Encode(), inter_value.Encode());
         } else if (s.IsNotFound()) {
           count++;
-          batch.Put(handles_[kHashesDataCF], hashes_data_key.Encode(), inter_value.Encode());
+          batch->Put(handles_[kHashesDataCF], hashes_data_key.Encode(), inter_value.Encode());
         } else {
           return s;
         }
@@ -656,22 +636,24 @@ Status Redis::HMSet(const Slice& key, const std::vector<FieldValue>& fvs) {
         return Status::InvalidArgument("hash size overflow");
       }
       parsed_hashes_meta_value.ModifyCount(count);
-      batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      batch->Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      *new_fields = count;
     }
   } else if (s.IsNotFound()) {
     EncodeFixed32(meta_value_buf, filtered_fvs.size());
     HashesMetaValue hashes_meta_value(DataType::kHashes, Slice(meta_value_buf, 4));
     version = hashes_meta_value.UpdateVersion();
-    batch.Put(handles_[kMetaCF], base_meta_key.Encode(), hashes_meta_value.Encode());
+    batch->Put(handles_[kMetaCF], base_meta_key.Encode(), hashes_meta_value.Encode());
     for (const auto& fv : filtered_fvs) {
       HashesDataKey hashes_data_key(key, version, fv.field);
       BaseDataValue inter_value(fv.value);
-      batch.Put(handles_[kHashesDataCF], hashes_data_key.Encode(), inter_value.Encode());
+      batch->Put(handles_[kHashesDataCF], hashes_data_key.Encode(), inter_value.Encode());
     }
+    *new_fields = static_cast<int32_t>(filtered_fvs.size());
+  } else {
+    return s;
   }
-  s = db_->Write(default_write_options_, &batch);
-  UpdateSpecificKeyStatistics(DataType::kHashes, key.ToString(), statistic);
-  return s;
+  return Status::OK();
 }
 
 Status Redis::HSet(const Slice& key, const Slice& field, const Slice& value, int32_t* res) {
@@ -684,6 +666,7 @@ Status Redis::HSet(const Slice& key, const Slice& field, const Slice& value, int
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   char meta_value_buf[4] = {0};
   if (s.ok() && !ExpectedMetaValue(DataType::kHashes, meta_value)) {
     if (ExpectedStale(meta_value)) {
@@ -709,7 +692,7 @@ Status Redis::HSet(const Slice& key, const Slice& field, const Slice& value, int
       version = parsed_hashes_meta_value.Version();
       std::string data_value;
       HashesDataKey hashes_data_key(key, version, field);
-      s = db_->Get(default_read_options_, handles_[kHashesDataCF], hashes_data_key.Encode(), &data_value);
+      s = GetCollectionData(default_read_options_, kHashesDataCF, meta_value, hashes_data_key.Encode(), &data_value);
       if (s.ok()) {
         *res = 0;
         if (data_value == value.ToString()) {
@@ -744,7 +727,7 @@ Status Redis::HSet(const Slice& key, const Slice& field, const Slice& value, int
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kHashes, key.ToString(), statistic);
   return s;
 }
@@ -759,6 +742,7 @@ Status Redis::HSetnx(const Slice& key, const Slice& field, const Slice& value, i
   BaseMetaKey base_meta_key(key);
   BaseDataValue internal_value(value);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   char meta_value_buf[4] = {0};
   if (s.ok() && !ExpectedMetaValue(DataType::kHashes, meta_value)) {
     if (ExpectedStale(meta_value)) {
@@ -783,7 +767,7 @@ Status Redis::HSetnx(const Slice& key, const Slice& field, const Slice& value, i
       version = parsed_hashes_meta_value.Version();
       HashesDataKey hashes_data_key(key, version, field);
       std::string data_value;
-      s = db_->Get(default_read_options_, handles_[kHashesDataCF], hashes_data_key.Encode(), &data_value);
+      s = GetCollectionData(default_read_options_, kHashesDataCF, meta_value, hashes_data_key.Encode(), &data_value);
       if (s.ok()) {
         *ret = 0;
       } else if (s.IsNotFound()) {
@@ -809,7 +793,7 @@ Status Redis::HSetnx(const Slice& key, const Slice& field, const Slice& value, i
   } else {
     return s;
   }
-  return db_->Write(default_write_options_, &batch);
+  return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
 }
 
 Status Redis::HVals(const Slice& key, std::vector<std::string>* values) {
@@ -844,7 +828,7 @@ Status Redis::HVals(const Slice& key, std::vector<std::string>* values) {
       HashesDataKey hashes_data_key(key, version, "");
       Slice prefix = hashes_data_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewCollectionIterator(read_options, kHashesDataCF, key, meta_value);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedBaseDataValue parsed_internal_value(iter->value());
         values->push_back(parsed_internal_value.UserValue().ToString());
@@ -920,7 +904,7 @@ Status Redis::HScan(const Slice& key, int64_t cursor, const std::string& pattern
       HashesDataKey hashes_start_data_key(key, version, start_point);
       std::string prefix = hashes_data_prefix.EncodeSeekKey().ToString();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      rocksdb::Iterator* iter = NewCollectionIterator(read_options, kHashesDataCF, key, meta_value);
       for (iter->Seek(hashes_start_data_key.Encode()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
@@ -984,7 +968,7 @@ Status Redis::HScanx(const Slice& key, const std::string& start_field, const std
       HashesDataKey hashes_start_data_key(key, version, start_field);
       std::string prefix = hashes_data_prefix.EncodeSeekKey().ToString();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      rocksdb::Iterator* iter = NewCollectionIterator(read_options, kHashesDataCF, key, meta_value);
       for (iter->Seek(hashes_start_data_key.Encode()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
@@ -1053,7 +1037,7 @@ Status Redis::PKHScanRange(const Slice& key, const Slice& field_start, const std
       HashesDataKey hashes_start_data_key(key, version, field_start);
       std::string prefix = hashes_data_prefix.EncodeSeekKey().ToString();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      rocksdb::Iterator* iter = NewCollectionIterator(read_options, kHashesDataCF, key, meta_value);
       for (iter->Seek(start_no_limit ? prefix : hashes_start_data_key.Encode());
            iter->Valid() && remain > 0 && iter->key().starts_with(prefix); iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
@@ -1126,7 +1110,7 @@ Status Redis::PKHRScanRange(const Slice& key, const Slice& field_start, const st
       HashesDataKey hashes_start_data_key(key, start_key_version, start_key_field);
       std::string prefix = hashes_data_prefix.EncodeSeekKey().ToString();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      rocksdb::Iterator* iter = NewCollectionIterator(read_options, kHashesDataCF, key, meta_value);
       for (iter->SeekForPrev(hashes_start_data_key.Encode().ToString());
            iter->Valid() && remain > 0 && iter->key().starts_with(prefix); iter->Prev()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
@@ -1186,10 +1170,10 @@ Status Redis::HashesExpire(const Slice& key, int64_t ttl_millsec, std::string&&
 
     if (ttl_millsec > 0) {
       parsed_hashes_meta_value.SetRelativeTimestamp(ttl_millsec);
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
     } else {
       parsed_hashes_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
     }
   }
   return s;
@@ -1225,7 +1209,7 @@ Status Redis::HashesDel(const Slice& key, std::string&& prefetch_meta) {
     } else {
       uint32_t statistic = parsed_hashes_meta_value.Count();
       parsed_hashes_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
       UpdateSpecificKeyStatistics(DataType::kHashes, key.ToString(), statistic);
     }
   }
@@ -1265,7 +1249,7 @@ Status Redis::HashesExpireat(const Slice& key, int64_t timestamp_millsec, std::s
       } else {
         parsed_hashes_meta_value.InitialMetaValue();
       }
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
     }
   }
   return s;
@@ -1304,7 +1288,7 @@ Status Redis::HashesPersist(const Slice& key, std::string&& prefetch_meta) {
         return Status::NotFound("Not have an associated timeout");
       } else {
         parsed_hashes_meta_value.SetEtime(0);
-        s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+        s = PutMeta(base_meta_key.Encode(), meta_value);
       }
     }
   }
@@ -1365,7 +1349,7 @@ void Redis::ScanHashes() {
   LOG(INFO) << "***************" << "rocksdb instance: " << index_ << " Hashes Meta Data***************";
   auto meta_iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
   for (meta_iter->SeekToFirst(); meta_iter->Valid(); meta_iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kHashes, meta_iter->value().ToString())) {
+    if (!ExpectedMetaValue(DataType::kHashes, meta_iter->value())) {
       continue;
     }
     ParsedHashesMetaValue parsed_hashes_meta_value(meta_iter->value());
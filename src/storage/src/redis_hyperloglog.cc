@@ -134,7 +134,7 @@ Status Redis::HyperloglogGet(const Slice &key, std::string* value) {
 
     BaseKey base_key(key);
     Status s = db_->Get(default_read_options_, base_key.Encode(), value);
-    std::string meta_value = *value;
+    const std::string& meta_value = *value;
     if (!s.ok()) {
         return s;
     }
@@ -167,7 +167,7 @@ Status Redis::HyperloglogSet(const Slice &key, const Slice &value) {
     ScopeRecordLock l(lock_mgr_, key);
 
     BaseKey base_key(key);
-    return db_->Put(default_write_options_, base_key.Encode(), hyperloglog_value.Encode());
+    return PutMeta(base_key.Encode(), hyperloglog_value.Encode());
 }
 
 }  // namespace storage
\ No newline at end of file
@@ -0,0 +1,373 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/base_data_key_format.h"
+#include "src/base_data_value_format.h"
+#include "src/base_key_format.h"
+#include "src/inline_collection_format.h"
+#include "src/redis.h"
+
+namespace storage {
+
+namespace {
+
+// written once inline collections were enabled, in the meta cf, older
+// instances have it in key_count_cf
+const char* kInlineCollectionsMarker = "inline";
+
+// The entries of an inline collection as the data keys of its version
+class InlineCollectionIterator : public rocksdb::Iterator {
+ public:
+  InlineCollectionIterator(std::vector<std::pair<std::string, std::string>>&& entries, const Status& status)
+      : entries_(std::move(entries)), pos_(entries_.size()), status_(status) {
+    std::sort(entries_.begin(), entries_.end(),
+              [](const auto& a, const auto& b) { return Slice(a.first).compare(Slice(b.first)) < 0; });
+  }
+
+  bool Valid() const override { return pos_ < entries_.size(); }
+  void SeekToFirst() override { pos_ = 0; }
+  void SeekToLast() override { pos_ = entries_.empty() ? 0 : entries_.size() - 1; }
+  void Seek(const Slice& target) override {
+    pos_ = std::lower_bound(entries_.begin(), entries_.end(), target,
+                            [](const auto& entry, const Slice& t) { return Slice(entry.first).compare(t) < 0; }) -
+           entries_.begin();
+  }
+  void SeekForPrev(const Slice& target) override {
+    size_t upper = std::upper_bound(entries_.begin(), entries_.end(), target,
+                                    [](const Slice& t, const auto& entry) { return t.compare(Slice(entry.first)) < 0; }) -
+                   entries_.begin();
+    pos_ = upper == 0 ? entries_.size() : upper - 1;
+  }
+  void Next() override { ++pos_; }
+  void Prev() override { pos_ = pos_ == 0 ? entries_.size() : pos_ - 1; }
+  Slice key() const override { return entries_[pos_].first; }
+  Slice value() const override { return entries_[pos_].second; }
+  Status status() const override { return status_; }
+
+ private:
+  std::vector<std::pair<std::string, std::string>> entries_;
+  size_t pos_;
+  Status status_;
+};
+
+// The writes of a batch, in batch order. The slices point into the batch
+struct BatchOp {
+  enum Type { kPut, kDelete, kSingleDelete, kMerge, kDeleteRange };
+  Type type;
+  // the index in handles_ of the column family written
+  int cf;
+  Slice key;
+  Slice value;
+};
+
+// The batch has the ids rocksdb gave the column families, not their
+// indexes in handles_
+class BatchOpCollector : public rocksdb::WriteBatch::Handler {
+ public:
+  explicit BatchOpCollector(const std::vector<rocksdb::ColumnFamilyHandle*>& handles) {
+    for (size_t idx = 0; idx < handles.size(); ++idx) {
+      cf_indexes_[handles[idx]->GetID()] = static_cast<int>(idx);
+    }
+  }
+
+  Status PutCF(uint32_t column_family_id, const Slice& key, const Slice& value) override {
+    return Add(BatchOp::kPut, column_family_id, key, value);
+  }
+  Status DeleteCF(uint32_t column_family_id, const Slice& key) override {
+    return Add(BatchOp::kDelete, column_family_id, key, Slice());
+  }
+  Status SingleDeleteCF(uint32_t column_family_id, const Slice& key) override {
+    return Add(BatchOp::kSingleDelete, column_family_id, key, Slice());
+  }
+  Status MergeCF(uint32_t column_family_id, const Slice& key, const Slice& value) override {
+    return Add(BatchOp::kMerge, column_family_id, key, value);
+  }
+  Status DeleteRangeCF(uint32_t column_family_id, const Slice& begin_key, const Slice& end_key) override {
+    return Add(BatchOp::kDeleteRange, column_family_id, begin_key, end_key);
+  }
+
+  std::vector<BatchOp> ops;
+
+ private:
+  Status Add(BatchOp::Type type, uint32_t column_family_id, const Slice& key, const Slice& value) {
+    auto iter = cf_indexes_.find(column_family_id);
+    if (iter == cf_indexes_.end()) {
+      return Status::InvalidArgument("write to an unknown column family");
+    }
+    ops.push_back({type, iter->second, key, value});
+    return Status::OK();
+  }
+
+  std::unordered_map<uint32_t, int> cf_indexes_;
+};
+
+// What the batch does to one hash or set
+struct CollectionWrite {
+  // the last write of the meta, -1 when the batch only writes data keys
+  int64_t meta_op = -1;
+  std::vector<size_t> data_ops;
+};
+
+struct AppendedPut {
+  int cf;
+  std::string key;
+  std::string value;
+};
+
+DataType MetaType(const Slice& meta_value) {
+  return meta_value.empty() ? DataType::kNones : static_cast<DataType>(static_cast<uint8_t>(meta_value[0]));
+}
+
+}  // namespace
+
+Status Redis::LoadInlineCollections() {
+  std::string marker_key = MetaMarkerKey(kInlineCollectionsMarker);
+  // no meta type, the scans of the meta cf skip it
+  std::string marker_value(1, static_cast<char>(DataType::kNones));
+  std::string value;
+  Status s = db_->Get(default_read_options_, handles_[kMetaCF], marker_key, &value);
+  if (!s.ok() && !s.IsNotFound()) {
+    return s;
+  }
+  bool marked = s.ok();
+  if (!marked) {
+    s = db_->Get(default_read_options_, handles_[kKeyCountCF], kInlineCollectionsMarker, &value);
+    if (!s.ok() && !s.IsNotFound()) {
+      return s;
+    }
+    if (s.ok()) {
+      rocksdb::WriteBatch batch;
+      batch.Put(handles_[kMetaCF], marker_key, marker_value);
+      batch.Delete(handles_[kKeyCountCF], kInlineCollectionsMarker);
+      s = db_->Write(default_write_options_, &batch);
+      if (!s.ok()) {
+        return s;
+      }
+      marked = true;
+    }
+  }
+  if (inline_collection_max_entries_ != 0 && !marked) {
+    s = db_->Put(default_write_options_, handles_[kMetaCF], marker_key, marker_value);
+    if (!s.ok()) {
+      return s;
+    }
+    marked = true;
+  }
+  // the inline collections written before still need the write path
+  inline_collections_ = marked;
+  return Status::OK();
+}
+
+Status Redis::GetCollectionData(const rocksdb::ReadOptions& read_options, ColumnFamilyIndex cf,
+                                const std::string& meta_value, const Slice& data_key, std::string* value) {
+  if (!InlineCollection::IsInline(meta_value)) {
+    return db_->Get(read_options, handles_[cf], data_key, value);
+  }
+  ParsedBaseDataKey parsed_data_key(data_key);
+  ParsedBaseMetaValue parsed_meta_value(Slice{meta_value});
+  if (parsed_data_key.Version() != parsed_meta_value.Version()) {
+    return Status::NotFound();
+  }
+  std::string user_value;
+  Status s = InlineCollection::Find(meta_value, parsed_data_key.Data(), &user_value);
+  if (s.ok()) {
+    BaseDataValue data_value(user_value);
+    *value = data_value.Encode().ToString();
+  }
+  return s;
+}
+
+rocksdb::Iterator* Redis::NewCollectionIterator(const rocksdb::ReadOptions& read_options, ColumnFamilyIndex cf,
+                                                const Slice& key, const std::string& meta_value) {
+  if (!InlineCollection::IsInline(meta_value)) {
+    return db_->NewIterator(read_options, handles_[cf]);
+  }
+  std::map<std::string, std::string> entries;
+  std::vector<std::pair<std::string, std::string>> data;
+  if (!InlineCollection::Decode(meta_value, &entries)) {
+    return new InlineCollectionIterator(std::move(data), Status::Corruption("inline collection"));
+  }
+  ParsedBaseMetaValue parsed_meta_value(Slice{meta_value});
+  data.reserve(entries.size());
+  for (const auto& entry : entries) {
+    BaseDataKey data_key(key, parsed_meta_value.Version(), entry.first);
+    BaseDataValue data_value(entry.second);
+    data.emplace_back(data_key.Encode().ToString(), data_value.Encode().ToString());
+  }
+  return new InlineCollectionIterator(std::move(data), Status::OK());
+}
+
+/*
+ * A meta of a new version comes with all the data keys of that version in
+ * the same batch, so the batch alone tells whether the collection fits
+ * inline. The data keys written for an inline collection change its entries
+ * instead, and a collection that outgrew the limits gets all its entries
+ * back as data keys. The stored metas come from old_metas, the ones missing
+ * there are read and go to stored_metas, by meta key, empty for the missing
+ * ones.
+ */
+Status Redis::FoldInlineCollections(rocksdb::WriteBatch* batch, const std::vector<OldMeta>& old_metas,
+                                    std::unordered_map<std::string, std::string>* stored_metas) {
+  BatchOpCollector collector(handles_);
+  Status s = batch->Iterate(&collector);
+  if (!s.ok()) {
+    return s;
+  }
+  const std::vector<BatchOp>& ops = collector.ops;
+
+  std::unordered_map<std::string, CollectionWrite> writes;
+  for (size_t idx = 0; idx < ops.size(); ++idx) {
+    const BatchOp& op = ops[idx];
+    if (op.cf == kMetaCF) {
+      bool collection = op.type == BatchOp::kPut && InlineCollection::DataCF(MetaType(op.value)) >= 0;
+      // -2 for a meta deleted or replaced by another type, nothing to fold
+      writes[op.key.ToString()].meta_op = collection ? static_cast<int64_t>(idx) : -2;
+    } else if ((op.cf == kHashesDataCF || op.cf == kSetsDataCF) &&
+               (op.type == BatchOp::kPut || op.type == BatchOp::kDelete || op.type == BatchOp::kSingleDelete)) {
+      ParsedBaseDataKey parsed_data_key(op.key);
+      BaseMetaKey base_meta_key(parsed_data_key.Key());
+      writes[base_meta_key.Encode().ToString()].data_ops.push_back(idx);
+    }
+  }
+  if (writes.empty()) {
+    return Status::OK();
+  }
+
+  std::vector<bool> folded(ops.size(), false);
+  std::unordered_map<size_t, std::string> replaced_metas;
+  std::vector<AppendedPut> appended;
+  for (auto& [meta_key, write] : writes) {
+    if (write.meta_op == -2) {
+      continue;
+    }
+    auto old_meta = std::find_if(old_metas.begin(), old_metas.end(),
+                                 [&meta_key](const OldMeta& meta) { return meta.first == Slice(meta_key); });
+    Slice stored_meta;
+    if (old_meta != old_metas.end()) {
+      stored_meta = old_meta->second;
+    } else {
+      std::string& read_meta = (*stored_metas)[meta_key];
+      s = db_->Get(default_read_options_, handles_[kMetaCF], meta_key, &read_meta);
+      if (s.IsNotFound()) {
+        read_meta.clear();
+      } else if (!s.ok()) {
+        return s;
+      }
+      stored_meta = read_meta;
+    }
+    bool stored_inline = InlineCollection::IsInline(stored_meta);
+    Slice meta_value;
+    if (write.meta_op >= 0) {
+      meta_value = ops[write.meta_op].value;
+    } else if (stored_inline) {
+      meta_value = stored_meta;
+    } else {
+      continue;
+    }
+
+    DataType type = MetaType(meta_value);
+    ParsedBaseMetaValue parsed_meta_value(meta_value);
+    uint64_t version = parsed_meta_value.Version();
+    std::map<std::string, std::string> entries;
+    bool same_version = MetaType(stored_meta) == type && ParsedBaseMetaValue(Slice{stored_meta}).Version() == version;
+    if (same_version && stored_inline) {
+      if (!InlineCollection::Decode(stored_meta, &entries)) {
+        return Status::Corruption("inline collection");
+      }
+    } else if (same_version) {
+      // a collection with data keys keeps them
+      continue;
+    }
+
+    std::vector<size_t> entry_ops;
+    for (size_t idx : write.data_ops) {
+      const BatchOp& op = ops[idx];
+      ParsedBaseDataKey parsed_data_key(op.key);
+      if (op.cf != InlineCollection::DataCF(type) || parsed_data_key.Version() != version) {
+        continue;
+      }
+      if (op.type == BatchOp::kPut) {
+        ParsedBaseDataValue parsed_data_value(op.value);
+        entries[parsed_data_key.Data().ToString()] =
+            type == DataType::kHashes ? parsed_data_value.UserValue().ToString() : std::string();
+      } else {
+        entries.erase(parsed_data_key.Data().ToString());
+      }
+      entry_ops.push_back(idx);
+    }
+
+    std::string payload = InlineCollection::Encode(type, entries);
+    bool fits = !entries.empty() && entries.size() <= inline_collection_max_entries_ &&
+                entries.size() == static_cast<size_t>(parsed_meta_value.Count()) &&
+                payload.size() <= kInlineCollectionMaxBytes;
+    if (fits || stored_inline) {
+      for (size_t idx : entry_ops) {
+        folded[idx] = true;
+      }
+    }
+    if (!fits && stored_inline) {
+      ParsedBaseMetaKey parsed_meta_key(meta_key);
+      for (const auto& entry : entries) {
+        BaseDataKey data_key(parsed_meta_key.Key(), version, entry.first);
+        BaseDataValue data_value(entry.second);
+        appended.push_back({InlineCollection::DataCF(type), data_key.Encode().ToString(),
+                            data_value.Encode().ToString()});
+      }
+    }
+    std::string new_meta_value = InlineCollection::MetaValue(meta_value, fits ? &payload : nullptr);
+    if (write.meta_op < 0) {
+      appended.push_back({kMetaCF, meta_key, std::move(new_meta_value)});
+    } else if (Slice(new_meta_value) != meta_value) {
+      replaced_metas[static_cast<size_t>(write.meta_op)] = std::move(new_meta_value);
+    }
+  }
+  if (replaced_metas.empty() && appended.empty()) {
+    return Status::OK();
+  }
+
+  rocksdb::WriteBatch rebuilt;
+  for (size_t idx = 0; idx < ops.size(); ++idx) {
+    const BatchOp& op = ops[idx];
+    rocksdb::ColumnFamilyHandle* handle = handles_[op.cf];
+    auto iter = replaced_metas.find(idx);
+    if (folded[idx]) {
+      continue;
+    } else if (iter != replaced_metas.end()) {
+      rebuilt.Put(handle, op.key, iter->second);
+      continue;
+    }
+    switch (op.type) {
+      case BatchOp::kPut:
+        rebuilt.Put(handle, op.key, op.value);
+        break;
+      case BatchOp::kDelete:
+        rebuilt.Delete(handle, op.key);
+        break;
+      case BatchOp::kSingleDelete:
+        rebuilt.SingleDelete(handle, op.key);
+        break;
+      case BatchOp::kMerge:
+        rebuilt.Merge(handle, op.key, op.value);
+        break;
+      case BatchOp::kDeleteRange:
+        rebuilt.DeleteRange(handle, op.key, op.value);
+        break;
+    }
+  }
+  for (const auto& put : appended) {
+    rebuilt.Put(handles_[put.cf], put.key, put.value);
+  }
+  *batch = std::move(rebuilt);
+  return Status::OK();
+}
+
+}  //  namespace storage
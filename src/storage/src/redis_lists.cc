@@ -3,6 +3,7 @@
 //  LICENSE file in the root directory of this source tree. An additional grant
 //  of patent rights can be found in the PATENTS file in the same directory.
 
+#include <algorithm>
 #include <memory>
 
 #include <fmt/core.h>
@@ -10,6 +11,7 @@
 
 #include "pstd/include/pika_codis_slot.h"
 #include "src/base_data_value_format.h"
+#include "src/lists_chunks.h"
 #include "src/lists_filter.h"
 #include "src/redis.h"
 #include "src/scope_record_lock.h"
@@ -18,45 +20,6 @@
 #include "src/debug.h"
 
 namespace storage {
-Status Redis::ScanListsKeyNum(KeyInfo* key_info) {
-  uint64_t keys = 0;
-  uint64_t expires = 0;
-  uint64_t ttl_sum = 0;
-  uint64_t invaild_keys = 0;
-
-  rocksdb::ReadOptions iterator_options;
-  const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
-  iterator_options.snapshot = snapshot;
-  iterator_options.fill_cache = false;
-
-  pstd::TimeType curtime = pstd::NowMillis();
-
-  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kLists, iter->value().ToString())) {
-      continue;
-    }
-    ParsedListsMetaValue parsed_lists_meta_value(iter->value());
-    if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.Count() == 0) {
-      invaild_keys++;
-    } else {
-      keys++;
-      if (!parsed_lists_meta_value.IsPermanentSurvival()) {
-        expires++;
-        ttl_sum += parsed_lists_meta_value.Etime() - curtime;
-      }
-    }
-  }
-  delete iter;
-
-  key_info->keys = keys;
-  key_info->expires = expires;
-  key_info->avg_ttl = (expires != 0) ? ttl_sum / expires : 0;
-  key_info->invaild_keys = invaild_keys;
-  return Status::OK();
-}
-
 Status Redis::LIndex(const Slice& key, int64_t index, std::string* element) {
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
@@ -84,6 +47,13 @@ Status Redis::LIndex(const Slice& key, int64_t index, std::string* element) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      ListsChunks chunks(db_, handles_[kListsDataCF], read_options, key, &meta_value, list_chunk_max_elements_);
+      s = chunks.Init();
+      if (s.ok()) {
+        s = chunks.Index(index, element);
+      }
+      return s;
     } else {
       uint64_t target_index =
           index >= 0 ? parsed_lists_meta_value.LeftIndex() + index + 1 : parsed_lists_meta_value.RightIndex() + index;
@@ -111,6 +81,7 @@ Status Redis::LInsert(const Slice& key, const BeforeOrAfter& before_or_after, co
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -127,6 +98,22 @@ Status Redis::LInsert(const Slice& key, const BeforeOrAfter& before_or_after, co
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      ListsChunks chunks(db_, handles_[kListsDataCF], default_read_options_, key, &meta_value,
+                         list_chunk_max_elements_);
+      s = chunks.Init();
+      if (s.ok()) {
+        s = chunks.Insert(before_or_after, pivot, value);
+      }
+      if (s.IsNotFound()) {
+        *ret = -1;
+        return s;
+      } else if (!s.ok()) {
+        return s;
+      }
+      chunks.Flush(&batch, handles_[kMetaCF]);
+      *ret = static_cast<int64_t>(chunks.Count());
+      return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
     } else {
       bool find_pivot = false;
       uint64_t pivot_index = 0;
@@ -207,7 +194,7 @@ Status Redis::LInsert(const Slice& key, const BeforeOrAfter& before_or_after, co
         BaseDataValue i_val(value);
         batch.Put(handles_[kListsDataCF], lists_target_key.Encode(), i_val.Encode());
         *ret = static_cast<int32_t>(parsed_lists_meta_value.Count());
-        return db_->Write(default_write_options_, &batch);
+        return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
       }
     }
   } else if (s.IsNotFound()) {
@@ -262,6 +249,7 @@ Status Redis::LPop(const Slice& key, int64_t count, std::vector<std::string>* el
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -278,6 +266,18 @@ Status Redis::LPop(const Slice& key, int64_t count, std::vector<std::string>* el
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      ListsChunks chunks(db_, handles_[kListsDataCF], default_read_options_, key, &meta_value,
+                         list_chunk_max_elements_);
+      s = chunks.Init();
+      if (s.ok()) {
+        s = chunks.Pop(static_cast<uint64_t>(std::max<int64_t>(count, 0)), true, elements);
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      statistic = elements->size();
+      chunks.Flush(&batch, handles_[kMetaCF]);
     } else {
       auto size = static_cast<int64_t>(parsed_lists_meta_value.Count());
       uint64_t version = parsed_lists_meta_value.Version();
@@ -300,7 +300,7 @@ Status Redis::LPop(const Slice& key, int64_t count, std::vector<std::string>* el
     }
   }
   if (batch.Count() != 0U) {
-    s = db_->Write(default_write_options_, &batch);
+    s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
     if (s.ok()) {
       batch.Clear();
     }
@@ -320,6 +320,7 @@ Status Redis::LPush(const Slice& key, const std::vector<std::string>& values, ui
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -333,10 +334,14 @@ Status Redis::LPush(const Slice& key, const std::vector<std::string>& values, ui
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.Count() == 0) {
-      version = parsed_lists_meta_value.InitialMetaValue();
+      version = ListsChunks::InitialMetaValue(&parsed_lists_meta_value, &meta_value, list_chunk_max_elements_);
     } else {
       version = parsed_lists_meta_value.Version();
     }
+    if (ListsChunks::IsChunked(meta_value)) {
+      s = PushListChunks(key, &meta_value, values, true, &batch, ret);
+      return s.ok() ? WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}}) : s;
+    }
     for (const auto& value : values) {
       index = parsed_lists_meta_value.LeftIndex();
       parsed_lists_meta_value.ModifyLeftIndex(1);
@@ -347,6 +352,10 @@ Status Redis::LPush(const Slice& key, const std::vector<std::string>& values, ui
     }
     batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
     *ret = parsed_lists_meta_value.Count();
+  } else if (s.IsNotFound() && list_chunk_max_elements_ != 0) {
+    meta_value = ListsChunks::NewMetaValue(list_chunk_max_elements_);
+    s = PushListChunks(key, &meta_value, values, true, &batch, ret);
+    return s.ok() ? WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}}) : s;
   } else if (s.IsNotFound()) {
     char str[8];
     EncodeFixed64(str, values.size());
@@ -364,7 +373,7 @@ Status Redis::LPush(const Slice& key, const std::vector<std::string>& values, ui
   } else {
     return s;
   }
-  return db_->Write(default_write_options_, &batch);
+  return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
 }
 
 Status Redis::LPushx(const Slice& key, const std::vector<std::string>& values, uint64_t* len) {
@@ -376,6 +385,7 @@ Status Redis::LPushx(const Slice& key, const std::vector<std::string>& values, u
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -392,6 +402,9 @@ Status Redis::LPushx(const Slice& key, const std::vector<std::string>& values, u
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      s = PushListChunks(key, &meta_value, values, true, &batch, len);
+      return s.ok() ? WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}}) : s;
     } else {
       uint64_t version = parsed_lists_meta_value.Version();
       for (const auto& value : values) {
@@ -404,7 +417,7 @@ Status Redis::LPushx(const Slice& key, const std::vector<std::string>& values, u
       }
       batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
       *len = parsed_lists_meta_value.Count();
-      return db_->Write(default_write_options_, &batch);
+      return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
     }
   }
   return s;
@@ -436,6 +449,13 @@ Status Redis::LRange(const Slice& key, int64_t start, int64_t stop, std::vector<
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      ListsChunks chunks(db_, handles_[kListsDataCF], read_options, key, &meta_value, list_chunk_max_elements_);
+      s = chunks.Init();
+      if (s.ok()) {
+        s = chunks.Range(start, stop, ret);
+      }
+      return s;
     } else {
       uint64_t version = parsed_lists_meta_value.Version();
       uint64_t origin_left_index = parsed_lists_meta_value.LeftIndex() + 1;
@@ -506,6 +526,15 @@ Status Redis::LRangeWithTTL(const Slice& key, int64_t start, int64_t stop, std::
         *ttl_millsec = *ttl_millsec - curtime >= 0 ? *ttl_millsec - curtime : -2;
       }
 
+      if (ListsChunks::IsChunked(meta_value)) {
+        ListsChunks chunks(db_, handles_[kListsDataCF], read_options, key, &meta_value, list_chunk_max_elements_);
+        s = chunks.Init();
+        if (s.ok()) {
+          s = chunks.Range(start, stop, ret);
+        }
+        return s;
+      }
+
       uint64_t version = parsed_lists_meta_value.Version();
       uint64_t origin_left_index = parsed_lists_meta_value.LeftIndex() + 1;
       uint64_t origin_right_index = parsed_lists_meta_value.RightIndex() - 1;
@@ -549,6 +578,7 @@ Status Redis::LRem(const Slice& key, int64_t count, const Slice& value, uint64_t
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -565,6 +595,20 @@ Status Redis::LRem(const Slice& key, int64_t count, const Slice& value, uint64_t
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      ListsChunks chunks(db_, handles_[kListsDataCF], default_read_options_, key, &meta_value,
+                         list_chunk_max_elements_);
+      s = chunks.Init();
+      if (s.ok()) {
+        s = chunks.Remove(count, value, ret);
+      }
+      if (!s.ok()) {
+        return s;
+      } else if (*ret == 0) {
+        return Status::NotFound();
+      }
+      chunks.Flush(&batch, handles_[kMetaCF]);
+      return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
     } else {
       uint64_t current_index;
       std::vector<uint64_t> target_index;
@@ -665,7 +709,7 @@ Status Redis::LRem(const Slice& key, int64_t count, const Slice& value, uint64_t
           batch.Delete(handles_[kListsDataCF], lists_data_key.Encode());
         }
         *ret = target_index.size();
-        return db_->Write(default_write_options_, &batch);
+        return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
       }
     }
   } else if (s.IsNotFound()) {
@@ -681,6 +725,7 @@ Status Redis::LSet(const Slice& key, int64_t index, const Slice& value) {
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -697,6 +742,22 @@ Status Redis::LSet(const Slice& key, int64_t index, const Slice& value) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      ListsChunks chunks(db_, handles_[kListsDataCF], default_read_options_, key, &meta_value,
+                         list_chunk_max_elements_);
+      s = chunks.Init();
+      if (s.ok()) {
+        s = chunks.Set(index, value);
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      rocksdb::WriteBatch batch;
+      chunks.Flush(&batch, handles_[kMetaCF]);
+      s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
+      statistic++;
+      UpdateSpecificKeyStatistics(DataType::kLists, key.ToString(), statistic);
+      return s;
     } else {
       uint64_t version = parsed_lists_meta_value.Version();
       uint64_t target_index =
@@ -725,6 +786,7 @@ Status Redis::LTrim(const Slice& key, int64_t start, int64_t stop) {
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -742,6 +804,19 @@ Status Redis::LTrim(const Slice& key, int64_t start, int64_t stop) {
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      ListsChunks chunks(db_, handles_[kListsDataCF], default_read_options_, key, &meta_value,
+                         list_chunk_max_elements_);
+      s = chunks.Init();
+      if (s.ok()) {
+        uint64_t origin_count = chunks.Count();
+        s = chunks.Trim(start, stop);
+        statistic = static_cast<uint32_t>(origin_count - chunks.Count());
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      chunks.Flush(&batch, handles_[kMetaCF]);
     } else {
       uint64_t origin_left_index = parsed_lists_meta_value.LeftIndex() + 1;
       uint64_t origin_right_index = parsed_lists_meta_value.RightIndex() - 1;
@@ -782,7 +857,7 @@ Status Redis::LTrim(const Slice& key, int64_t start, int64_t stop) {
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kLists, key.ToString(), statistic);
   return s;
 }
@@ -798,6 +873,7 @@ Status Redis::RPop(const Slice& key, int64_t count, std::vector<std::string>* el
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -814,6 +890,18 @@ Status Redis::RPop(const Slice& key, int64_t count, std::vector<std::string>* el
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      ListsChunks chunks(db_, handles_[kListsDataCF], default_read_options_, key, &meta_value,
+                         list_chunk_max_elements_);
+      s = chunks.Init();
+      if (s.ok()) {
+        s = chunks.Pop(static_cast<uint64_t>(std::max<int64_t>(count, 0)), false, elements);
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      statistic = elements->size();
+      chunks.Flush(&batch, handles_[kMetaCF]);
     } else {
       auto size = static_cast<int64_t>(parsed_lists_meta_value.Count());
       uint64_t version = parsed_lists_meta_value.Version();
@@ -836,7 +924,7 @@ Status Redis::RPop(const Slice& key, int64_t count, std::vector<std::string>* el
     }
   }
   if (batch.Count() != 0U) {
-    s = db_->Write(default_write_options_, &batch);
+    s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
     if (s.ok()) {
       batch.Clear();
     }
@@ -855,6 +943,7 @@ Status Redis::RPoplpush(const Slice& source, const Slice& destination, std::stri
     std::string meta_value;
     BaseMetaKey base_source(source);
     s = db_->Get(default_read_options_, handles_[kMetaCF], base_source.Encode(), &meta_value);
+    std::string old_meta = meta_value;
     if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
       if (ExpectedStale(meta_value)) {
         s = Status::NotFound();
@@ -871,6 +960,26 @@ Status Redis::RPoplpush(const Slice& source, const Slice& destination, std::stri
         return Status::NotFound("Stale");
       } else if (parsed_lists_meta_value.Count() == 0) {
         return Status::NotFound();
+      } else if (ListsChunks::IsChunked(meta_value)) {
+        // the tail moves to the head of the same list
+        ListsChunks chunks(db_, handles_[kListsDataCF], default_read_options_, source, &meta_value,
+                           list_chunk_max_elements_);
+        std::vector<std::string> elements;
+        s = chunks.Init();
+        if (s.ok()) {
+          s = chunks.Pop(1, false, &elements);
+        }
+        if (s.ok()) {
+          s = chunks.Push(elements, true);
+        }
+        if (!s.ok()) {
+          return s;
+        }
+        *element = elements.front();
+        chunks.Flush(&batch, handles_[kMetaCF]);
+        s = WriteWithKeyCounters(&batch, {{base_source.Encode(), old_meta}});
+        UpdateSpecificKeyStatistics(DataType::kLists, source.ToString(), 1);
+        return s;
       } else {
         std::string target;
         uint64_t version = parsed_lists_meta_value.Version();
@@ -892,7 +1001,7 @@ Status Redis::RPoplpush(const Slice& source, const Slice& destination, std::stri
             parsed_lists_meta_value.ModifyRightIndex(-1);
             parsed_lists_meta_value.ModifyLeftIndex(1);
             batch.Put(handles_[kMetaCF], base_source.Encode(), meta_value);
-            s = db_->Write(default_write_options_, &batch);
+            s = WriteWithKeyCounters(&batch, {{base_source.Encode(), old_meta}});
             UpdateSpecificKeyStatistics(DataType::kLists, source.ToString(), statistic);
             return s;
           }
@@ -906,10 +1015,12 @@ Status Redis::RPoplpush(const Slice& source, const Slice& destination, std::stri
   }
 
   uint64_t version;
+  uint64_t len = 0;
   std::string target;
   std::string source_meta_value;
   BaseMetaKey base_source(source);
   s = db_->Get(default_read_options_, handles_[kMetaCF], base_source.Encode(), &source_meta_value);
+  std::string old_source_meta = source_meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, source_meta_value)) {
     if (ExpectedStale(source_meta_value)) {
       s = Status::NotFound();
@@ -926,6 +1037,21 @@ Status Redis::RPoplpush(const Slice& source, const Slice& destination, std::stri
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(source_meta_value)) {
+      ListsChunks chunks(db_, handles_[kListsDataCF], default_read_options_, source, &source_meta_value,
+                         list_chunk_max_elements_);
+      std::vector<std::string> elements;
+      s = chunks.Init();
+      if (s.ok()) {
+        s = chunks.Pop(1, false, &elements);
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      BaseDataValue i_val(elements.front());
+      target = i_val.Encode().ToString();
+      statistic++;
+      chunks.Flush(&batch, handles_[kMetaCF]);
     } else {
       version = parsed_lists_meta_value.Version();
       uint64_t last_node_index = parsed_lists_meta_value.RightIndex() - 1;
@@ -945,9 +1071,12 @@ Status Redis::RPoplpush(const Slice& source, const Slice& destination, std::stri
     return s;
   }
 
+  // target is encoded for the legacy format, chunks keep the element alone
+  std::string target_value = ParsedBaseDataValue{Slice(target)}.UserValue().ToString();
   std::string destination_meta_value;
   BaseMetaKey base_destination(destination);
   s = db_->Get(default_read_options_, handles_[kMetaCF], base_destination.Encode(), &destination_meta_value);
+  std::string old_destination_meta = destination_meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, destination_meta_value)) {
     if (ExpectedStale(destination_meta_value)) {
       s = Status::NotFound();
@@ -961,16 +1090,30 @@ Status Redis::RPoplpush(const Slice& source, const Slice& destination, std::stri
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&destination_meta_value);
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.Count() == 0) {
-      version = parsed_lists_meta_value.InitialMetaValue();
+      version = ListsChunks::InitialMetaValue(&parsed_lists_meta_value, &destination_meta_value,
+                                              list_chunk_max_elements_);
     } else {
       version = parsed_lists_meta_value.Version();
     }
-    uint64_t target_index = parsed_lists_meta_value.LeftIndex();
-    ListsDataKey lists_data_key(destination, version, target_index);
-    batch.Put(handles_[kListsDataCF], lists_data_key.Encode(), target);
-    parsed_lists_meta_value.ModifyCount(1);
-    parsed_lists_meta_value.ModifyLeftIndex(1);
-    batch.Put(handles_[kMetaCF], base_destination.Encode(), destination_meta_value);
+    if (ListsChunks::IsChunked(destination_meta_value)) {
+      s = PushListChunks(destination, &destination_meta_value, {target_value}, true, &batch, &len);
+      if (!s.ok()) {
+        return s;
+      }
+    } else {
+      uint64_t target_index = parsed_lists_meta_value.LeftIndex();
+      ListsDataKey lists_data_key(destination, version, target_index);
+      batch.Put(handles_[kListsDataCF], lists_data_key.Encode(), target);
+      parsed_lists_meta_value.ModifyCount(1);
+      parsed_lists_meta_value.ModifyLeftIndex(1);
+      batch.Put(handles_[kMetaCF], base_destination.Encode(), destination_meta_value);
+    }
+  } else if (s.IsNotFound() && list_chunk_max_elements_ != 0) {
+    destination_meta_value = ListsChunks::NewMetaValue(list_chunk_max_elements_);
+    s = PushListChunks(destination, &destination_meta_value, {target_value}, true, &batch, &len);
+    if (!s.ok()) {
+      return s;
+    }
   } else if (s.IsNotFound()) {
     char str[8];
     EncodeFixed64(str, 1);
@@ -985,7 +1128,8 @@ Status Redis::RPoplpush(const Slice& source, const Slice& destination, std::stri
     return s;
   }
 
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_source.Encode(), old_source_meta},
+                                    {base_destination.Encode(), old_destination_meta}});
   UpdateSpecificKeyStatistics(DataType::kLists, source.ToString(), statistic);
   if (s.ok()) {
     ParsedBaseDataValue parsed_value(&target);
@@ -1005,6 +1149,7 @@ Status Redis::RPush(const Slice& key, const std::vector<std::string>& values, ui
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -1018,10 +1163,14 @@ Status Redis::RPush(const Slice& key, const std::vector<std::string>& values, ui
   if (s.ok()) {
     ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
     if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.Count() == 0) {
-      version = parsed_lists_meta_value.InitialMetaValue();
+      version = ListsChunks::InitialMetaValue(&parsed_lists_meta_value, &meta_value, list_chunk_max_elements_);
     } else {
       version = parsed_lists_meta_value.Version();
     }
+    if (ListsChunks::IsChunked(meta_value)) {
+      s = PushListChunks(key, &meta_value, values, false, &batch, ret);
+      return s.ok() ? WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}}) : s;
+    }
     for (const auto& value : values) {
       index = parsed_lists_meta_value.RightIndex();
       parsed_lists_meta_value.ModifyRightIndex(1);
@@ -1032,6 +1181,10 @@ Status Redis::RPush(const Slice& key, const std::vector<std::string>& values, ui
     }
     batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
     *ret = parsed_lists_meta_value.Count();
+  } else if (s.IsNotFound() && list_chunk_max_elements_ != 0) {
+    meta_value = ListsChunks::NewMetaValue(list_chunk_max_elements_);
+    s = PushListChunks(key, &meta_value, values, false, &batch, ret);
+    return s.ok() ? WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}}) : s;
   } else if (s.IsNotFound()) {
     char str[8];
     EncodeFixed64(str, values.size());
@@ -1049,7 +1202,7 @@ Status Redis::RPush(const Slice& key, const std::vector<std::string>& values, ui
   } else {
     return s;
   }
-  return db_->Write(default_write_options_, &batch);
+  return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
 }
 
 Status Redis::RPushx(const Slice& key, const std::vector<std::string>& values, uint64_t* len) {
@@ -1061,6 +1214,7 @@ Status Redis::RPushx(const Slice& key, const std::vector<std::string>& values, u
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kLists, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -1077,6 +1231,9 @@ Status Redis::RPushx(const Slice& key, const std::vector<std::string>& values, u
       return Status::NotFound("Stale");
     } else if (parsed_lists_meta_value.Count() == 0) {
       return Status::NotFound();
+    } else if (ListsChunks::IsChunked(meta_value)) {
+      s = PushListChunks(key, &meta_value, values, false, &batch, len);
+      return s.ok() ? WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}}) : s;
     } else {
       uint64_t version = parsed_lists_meta_value.Version();
       for (const auto& value : values) {
@@ -1089,12 +1246,27 @@ Status Redis::RPushx(const Slice& key, const std::vector<std::string>& values, u
       }
       batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
       *len = parsed_lists_meta_value.Count();
-      return db_->Write(default_write_options_, &batch);
+      return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
     }
   }
   return s;
 }
 
+Status Redis::PushListChunks(const Slice& key, std::string* meta_value, const std::vector<std::string>& values,
+                             bool left, rocksdb::WriteBatch* batch, uint64_t* len) {
+  ListsChunks chunks(db_, handles_[kListsDataCF], default_read_options_, key, meta_value, list_chunk_max_elements_);
+  Status s = chunks.Init();
+  if (s.ok()) {
+    s = chunks.Push(values, left);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  chunks.Flush(batch, handles_[kMetaCF]);
+  *len = chunks.Count();
+  return s;
+}
+
 Status Redis::ListsExpire(const Slice& key, int64_t ttl_millsec, std::string&& prefetch_meta) {
   std::string meta_value(std::move(prefetch_meta));
   ScopeRecordLock l(lock_mgr_, key);
@@ -1126,10 +1298,10 @@ Status Redis::ListsExpire(const Slice& key, int64_t ttl_millsec, std::string&& p
 
     if (ttl_millsec > 0) {
       parsed_lists_meta_value.SetRelativeTimestamp(ttl_millsec);
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
     } else {
       parsed_lists_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
     }
   }
   return s;
@@ -1165,7 +1337,7 @@ Status Redis::ListsDel(const Slice& key, std::string&& prefetch_meta) {
     } else {
       uint64_t statistic = parsed_lists_meta_value.Count();
       parsed_lists_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
       UpdateSpecificKeyStatistics(DataType::kLists, key.ToString(), statistic);
     }
   }
@@ -1205,7 +1377,7 @@ Status Redis::ListsExpireat(const Slice& key, int64_t timestamp_millsec, std::st
       } else {
         parsed_lists_meta_value.InitialMetaValue();
       }
-      return db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      return PutMeta(base_meta_key.Encode(), meta_value);
     }
   }
   return s;
@@ -1244,7 +1416,7 @@ Status Redis::ListsPersist(const Slice& key, std::string&& prefetch_meta) {
         return Status::NotFound("Not have an associated timeout");
       } else {
         parsed_lists_meta_value.SetEtime(0);
-        return db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+        return PutMeta(base_meta_key.Encode(), meta_value);
       }
     }
   }
@@ -1306,7 +1478,7 @@ void Redis::ScanLists() {
   LOG(INFO) << "*************** " << "rocksdb instance: " << index_ << " List Meta ***************";
   auto meta_iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
   for (meta_iter->SeekToFirst(); meta_iter->Valid(); meta_iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kLists, meta_iter->value().ToString())) {
+    if (!ExpectedMetaValue(DataType::kLists, meta_iter->value())) {
       continue;
     }
     ParsedListsMetaValue parsed_lists_meta_value(meta_iter->value());
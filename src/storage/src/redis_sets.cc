@@ -6,8 +6,11 @@
 #include "src/redis.h"
 
 #include <algorithm>
+#include <cstdlib>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <queue>
 #include <random>
 
 #include <glog/logging.h>
@@ -17,50 +20,12 @@
 #include "src/scope_snapshot.h"
 #include "src/scope_record_lock.h"
 #include "src/base_data_value_format.h"
+#include "src/inline_collection_format.h"
 #include "pstd/include/env.h"
 #include "pstd/include/pika_codis_slot.h"
 #include "storage/util.h"
 
 namespace storage {
-rocksdb::Status Redis::ScanSetsKeyNum(KeyInfo* key_info) {
-  uint64_t keys = 0;
-  uint64_t expires = 0;
-  uint64_t ttl_sum = 0;
-  uint64_t invaild_keys = 0;
-
-  rocksdb::ReadOptions iterator_options;
-  const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
-  iterator_options.snapshot = snapshot;
-  iterator_options.fill_cache = false;
-
-  pstd::TimeType curtime = pstd::NowMillis();
-
-  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kSets, iter->value().ToString())) {
-      continue;
-    }
-    ParsedSetsMetaValue parsed_sets_meta_value(iter->value());
-    if (parsed_sets_meta_value.IsStale() || parsed_sets_meta_value.Count() == 0) {
-      invaild_keys++;
-    } else {
-      keys++;
-      if (!parsed_sets_meta_value.IsPermanentSurvival()) {
-        expires++;
-        ttl_sum += parsed_sets_meta_value.Etime() - curtime;
-      }
-    }
-  }
-  delete iter;
-
-  key_info->keys = keys;
-  key_info->expires = expires;
-  key_info->avg_ttl = (expires != 0) ? ttl_sum / expires : 0;
-  key_info->invaild_keys = invaild_keys;
-  return rocksdb::Status::OK();
-}
-
 rocksdb::Status Redis::SAdd(const Slice& key, const std::vector<std::string>& members, int32_t* ret) {
   std::unordered_set<std::string> unique;
   std::vector<std::string> filtered_members;
@@ -78,6 +43,7 @@ rocksdb::Status Redis::SAdd(const Slice& key, const std::vector<std::string>& me
 
   BaseMetaKey base_meta_key(key);
   rocksdb::Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -109,7 +75,7 @@ rocksdb::Status Redis::SAdd(const Slice& key, const std::vector<std::string>& me
       version = parsed_sets_meta_value.Version();
       for (const auto& member : filtered_members) {
         SetsMemberKey sets_member_key(key, version, member);
-        s = db_->Get(default_read_options_, handles_[kSetsDataCF], sets_member_key.Encode(), &member_value);
+        s = GetCollectionData(default_read_options_, kSetsDataCF, meta_value, sets_member_key.Encode(), &member_value);
         if (s.ok()) {
         } else if (s.IsNotFound()) {
           cnt++;
@@ -145,7 +111,7 @@ rocksdb::Status Redis::SAdd(const Slice& key, const std::vector<std::string>& me
   } else {
     return s;
   }
-  return db_->Write(default_write_options_, &batch);
+  return WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
 }
 
 rocksdb::Status Redis::SCard(const Slice& key, int32_t* ret, std::string&& meta) {
@@ -181,6 +147,247 @@ rocksdb::Status Redis::SCard(const Slice& key, int32_t* ret, std::string&& meta)
   return s;
 }
 
+namespace {
+
+// members looked up in the other sets per MultiGet
+const size_t kSetsProbeBatchSize = 128;
+// SDIFF probes the sets larger than this many times its first set instead of
+// walking them
+const uint64_t kSetsProbeRatio = 8;
+
+// Walks the members of one set. Its data keys only differ in the member and
+// the all zero reserve2 after it, so they come in member order
+class SetsMemberCursor {
+ public:
+  SetsMemberCursor(rocksdb::Iterator* iter, const KeyVersion& set) : iter_(iter) {
+    SetsMemberKey sets_member_key(set.key, set.version, Slice());
+    prefix_ = sets_member_key.EncodeSeekKey().ToString();
+    iter_->Seek(prefix_);
+    Load();
+  }
+
+  bool Valid() const { return valid_; }
+  const std::string& member() const { return member_; }
+  Status status() const { return iter_->status(); }
+
+  void Next() {
+    iter_->Next();
+    Load();
+  }
+
+ private:
+  void Load() {
+    valid_ = iter_->Valid() && iter_->key().starts_with(prefix_);
+    if (valid_) {
+      ParsedSetsMemberKey parsed_sets_member_key(iter_->key());
+      member_.assign(parsed_sets_member_key.member().data(), parsed_sets_member_key.member().size());
+    }
+  }
+
+  std::unique_ptr<rocksdb::Iterator> iter_;
+  std::string prefix_;
+  std::string member_;
+  bool valid_ = false;
+};
+
+uint64_t SetsCount(const std::string& meta_value) {
+  ParsedSetsMetaValue parsed_sets_meta_value(Slice{meta_value});
+  return parsed_sets_meta_value.Count();
+}
+
+}  // namespace
+
+/*
+ * found[i] tells whether set holds members[i]. The data keys of the batch go
+ * through one MultiGet, the members of an inline set are looked up in its
+ * meta instead
+ */
+Status Redis::ProbeSetsMembers(const rocksdb::ReadOptions& read_options, const KeyVersion& set,
+                               const std::string& meta_value, const std::vector<std::string>& members,
+                               std::vector<bool>* found) {
+  found->assign(members.size(), false);
+  std::vector<std::string> encoded_keys;
+  encoded_keys.reserve(members.size());
+  for (const auto& member : members) {
+    SetsMemberKey sets_member_key(set.key, set.version, member);
+    encoded_keys.emplace_back(sets_member_key.Encode().ToString());
+  }
+
+  if (InlineCollection::IsInline(meta_value)) {
+    std::string member_value;
+    for (size_t idx = 0; idx < members.size(); ++idx) {
+      Status s = GetCollectionData(read_options, kSetsDataCF, meta_value, encoded_keys[idx], &member_value);
+      if (s.ok()) {
+        (*found)[idx] = true;
+      } else if (!s.IsNotFound()) {
+        return s;
+      }
+    }
+    return Status::OK();
+  }
+
+  std::vector<rocksdb::Slice> key_slices(encoded_keys.begin(), encoded_keys.end());
+  std::vector<rocksdb::PinnableSlice> values(members.size());
+  std::vector<Status> statuses(members.size());
+  db_->MultiGet(read_options, handles_[kSetsDataCF], members.size(), key_slices.data(), values.data(),
+                statuses.data(), false);
+  for (size_t idx = 0; idx < members.size(); ++idx) {
+    if (statuses[idx].ok()) {
+      (*found)[idx] = true;
+    } else if (!statuses[idx].IsNotFound()) {
+      return statuses[idx];
+    }
+  }
+  return Status::OK();
+}
+
+/*
+ * Walks the smallest set and probes the others from the next smallest up in
+ * batches, so the cost follows the smallest set however large the others are
+ */
+Status Redis::SetsInter(const rocksdb::ReadOptions& read_options, const std::vector<KeyVersion>& sets,
+                        const std::vector<std::string>& metas, std::vector<std::string>* members) {
+  if (sets.empty()) {
+    return Status::OK();
+  }
+  std::vector<size_t> order(sets.size());
+  for (size_t idx = 0; idx < sets.size(); ++idx) {
+    order[idx] = idx;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&metas](size_t a, size_t b) { return SetsCount(metas[a]) < SetsCount(metas[b]); });
+
+  const KeyVersion& smallest = sets[order[0]];
+  KeyStatisticsDurationGuard guard(this, DataType::kSets, smallest.key);
+  SetsMemberCursor cursor(NewCollectionIterator(read_options, kSetsDataCF, smallest.key, metas[order[0]]), smallest);
+  std::vector<std::string> candidates;
+  std::vector<bool> found;
+  while (cursor.Valid()) {
+    candidates.clear();
+    for (; cursor.Valid() && candidates.size() < kSetsProbeBatchSize; cursor.Next()) {
+      candidates.push_back(cursor.member());
+    }
+    for (size_t pos = 1; pos < order.size() && !candidates.empty(); ++pos) {
+      Status s = ProbeSetsMembers(read_options, sets[order[pos]], metas[order[pos]], candidates, &found);
+      if (!s.ok()) {
+        return s;
+      }
+      size_t kept = 0;
+      for (size_t idx = 0; idx < candidates.size(); ++idx) {
+        if (found[idx]) {
+          candidates[kept++] = std::move(candidates[idx]);
+        }
+      }
+      candidates.resize(kept);
+    }
+    std::move(candidates.begin(), candidates.end(), std::back_inserter(*members));
+  }
+  return cursor.status();
+}
+
+/*
+ * Merges the sets in member order, every member comes out once
+ */
+Status Redis::SetsUnion(const rocksdb::ReadOptions& read_options, const std::vector<KeyVersion>& sets,
+                        const std::vector<std::string>& metas, std::vector<std::string>* members) {
+  std::vector<std::unique_ptr<KeyStatisticsDurationGuard>> guards;
+  std::vector<std::unique_ptr<SetsMemberCursor>> cursors;
+  for (size_t idx = 0; idx < sets.size(); ++idx) {
+    guards.push_back(std::make_unique<KeyStatisticsDurationGuard>(this, DataType::kSets, sets[idx].key));
+    cursors.push_back(std::make_unique<SetsMemberCursor>(
+        NewCollectionIterator(read_options, kSetsDataCF, sets[idx].key, metas[idx]), sets[idx]));
+  }
+
+  auto greater = [&cursors](size_t a, size_t b) { return cursors[a]->member() > cursors[b]->member(); };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+  for (size_t idx = 0; idx < cursors.size(); ++idx) {
+    if (cursors[idx]->Valid()) {
+      heap.push(idx);
+    }
+  }
+  while (!heap.empty()) {
+    size_t idx = heap.top();
+    heap.pop();
+    if (members->empty() || members->back() != cursors[idx]->member()) {
+      members->push_back(cursors[idx]->member());
+    }
+    cursors[idx]->Next();
+    if (cursors[idx]->Valid()) {
+      heap.push(idx);
+    }
+  }
+  for (const auto& cursor : cursors) {
+    if (!cursor->status().ok()) {
+      return cursor->status();
+    }
+  }
+  return Status::OK();
+}
+
+/*
+ * Walks first, the other sets of comparable size are merged with it and the
+ * much larger ones are probed in batches, so a small first set never walks
+ * a large one
+ */
+Status Redis::SetsDiff(const rocksdb::ReadOptions& read_options, const KeyVersion& first,
+                       const std::string& first_meta, const std::vector<KeyVersion>& sets,
+                       const std::vector<std::string>& metas, std::vector<std::string>* members) {
+  uint64_t first_count = SetsCount(first_meta);
+  std::vector<std::unique_ptr<SetsMemberCursor>> merged;
+  std::vector<size_t> probed;
+  for (size_t idx = 0; idx < sets.size(); ++idx) {
+    if (SetsCount(metas[idx]) > first_count * kSetsProbeRatio) {
+      probed.push_back(idx);
+    } else {
+      merged.push_back(std::make_unique<SetsMemberCursor>(
+          NewCollectionIterator(read_options, kSetsDataCF, sets[idx].key, metas[idx]), sets[idx]));
+    }
+  }
+
+  KeyStatisticsDurationGuard guard(this, DataType::kSets, first.key);
+  SetsMemberCursor cursor(NewCollectionIterator(read_options, kSetsDataCF, first.key, first_meta), first);
+  std::vector<std::string> candidates;
+  std::vector<bool> found;
+  while (cursor.Valid()) {
+    candidates.clear();
+    for (; cursor.Valid() && candidates.size() < kSetsProbeBatchSize; cursor.Next()) {
+      const std::string& member = cursor.member();
+      bool excluded = false;
+      for (const auto& other : merged) {
+        while (other->Valid() && other->member() < member) {
+          other->Next();
+        }
+        if (other->Valid() && other->member() == member) {
+          excluded = true;
+        }
+      }
+      if (!excluded) {
+        candidates.push_back(member);
+      }
+    }
+    for (size_t pos = 0; pos < probed.size() && !candidates.empty(); ++pos) {
+      Status s = ProbeSetsMembers(read_options, sets[probed[pos]], metas[probed[pos]], candidates, &found);
+      if (!s.ok()) {
+        return s;
+      }
+      size_t kept = 0;
+      for (size_t idx = 0; idx < candidates.size(); ++idx) {
+        if (!found[idx]) {
+          candidates[kept++] = std::move(candidates[idx]);
+        }
+      }
+      candidates.resize(kept);
+    }
+    std::move(candidates.begin(), candidates.end(), std::back_inserter(*members));
+  }
+  for (const auto& other : merged) {
+    if (!other->status().ok()) {
+      return other->status();
+    }
+  }
+  return cursor.status();
+}
+
 rocksdb::Status Redis::SDiff(const std::vector<std::string>& keys, std::vector<std::string>* members) {
   if (keys.empty()) {
     return rocksdb::Status::Corruption("SDiff invalid parameter, no keys");
@@ -190,10 +397,10 @@ rocksdb::Status Redis::SDiff(const std::vector<std::string>& keys, std::vector<s
   const rocksdb::Snapshot* snapshot;
 
   std::string meta_value;
-  uint64_t version = 0;
   ScopeSnapshot ss(db_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> vaild_sets;
+  std::vector<std::string> vaild_set_metas;
   rocksdb::Status s;
 
   for (uint32_t idx = 1; idx < keys.size(); ++idx) {
@@ -213,6 +420,7 @@ rocksdb::Status Redis::SDiff(const std::vector<std::string>& keys, std::vector<s
       ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
       if (!parsed_sets_meta_value.IsStale() && parsed_sets_meta_value.Count() != 0) {
         vaild_sets.push_back({keys[idx], parsed_sets_meta_value.Version()});
+        vaild_set_metas.push_back(meta_value);
       }
     } else if (!s.IsNotFound()) {
       return s;
@@ -234,35 +442,11 @@ rocksdb::Status Redis::SDiff(const std::vector<std::string>& keys, std::vector<s
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (!parsed_sets_meta_value.IsStale() && parsed_sets_meta_value.Count() != 0) {
-      bool found;
-      Slice prefix;
-      std::string member_value;
-      version = parsed_sets_meta_value.Version();
-      SetsMemberKey sets_member_key(keys[0], version, Slice());
-      prefix = sets_member_key.EncodeSeekKey();
-      KeyStatisticsDurationGuard guard(this, DataType::kSets, keys[0]);
-      auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
-      for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
-        ParsedSetsMemberKey parsed_sets_member_key(iter->key());
-        Slice member = parsed_sets_member_key.member();
-
-        found = false;
-        for (const auto& key_version : vaild_sets) {
-          SetsMemberKey sets_member_key(key_version.key, key_version.version, member);
-          s = db_->Get(read_options, handles_[kSetsDataCF], sets_member_key.Encode(), &member_value);
-          if (s.ok()) {
-            found = true;
-            break;
-          } else if (!s.IsNotFound()) {
-            delete iter;
-            return s;
-          }
-        }
-        if (!found) {
-          members->push_back(member.ToString());
-        }
+      s = SetsDiff(read_options, {keys[0], parsed_sets_meta_value.Version()}, meta_value, vaild_sets,
+                   vaild_set_metas, members);
+      if (!s.ok()) {
+        return s;
       }
-      delete iter;
     }
   } else if (!s.IsNotFound()) {
     return s;
@@ -285,6 +469,7 @@ rocksdb::Status Redis::SDiffstore(const Slice& destination, const std::vector<st
   ScopeSnapshot ss(db_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> vaild_sets;
+  std::vector<std::string> vaild_set_metas;
   rocksdb::Status s;
 
   for (uint32_t idx = 1; idx < keys.size(); ++idx) {
@@ -304,6 +489,7 @@ rocksdb::Status Redis::SDiffstore(const Slice& destination, const std::vector<st
       ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
       if (!parsed_sets_meta_value.IsStale() && parsed_sets_meta_value.Count() != 0) {
         vaild_sets.push_back({keys[idx], parsed_sets_meta_value.Version()});
+        vaild_set_metas.push_back(meta_value);
       }
     } else if (!s.IsNotFound()) {
       return s;
@@ -326,34 +512,11 @@ rocksdb::Status Redis::SDiffstore(const Slice& destination, const std::vector<st
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (!parsed_sets_meta_value.IsStale() && parsed_sets_meta_value.Count() != 0) {
-      bool found;
-      std::string member_value;
-      version = parsed_sets_meta_value.Version();
-      SetsMemberKey sets_member_key(keys[0], version, Slice());
-      Slice prefix = sets_member_key.EncodeSeekKey();
-      KeyStatisticsDurationGuard guard(this, DataType::kSets, keys[0]);
-      auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
-      for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
-        ParsedSetsMemberKey parsed_sets_member_key(iter->key());
-        Slice member = parsed_sets_member_key.member();
-
-        found = false;
-        for (const auto& key_version : vaild_sets) {
-          SetsMemberKey sets_member_key(key_version.key, key_version.version, member);
-          s = db_->Get(read_options, handles_[kSetsDataCF], sets_member_key.Encode(), &member_value);
-          if (s.ok()) {
-            found = true;
-            break;
-          } else if (!s.IsNotFound()) {
-            delete iter;
-            return s;
-          }
-        }
-        if (!found) {
-          members.push_back(member.ToString());
-        }
+      s = SetsDiff(read_options, {keys[0], parsed_sets_meta_value.Version()}, meta_value, vaild_sets,
+                   vaild_set_metas, &members);
+      if (!s.ok()) {
+        return s;
       }
-      delete iter;
     }
   } else if (!s.IsNotFound()) {
     return s;
@@ -362,6 +525,7 @@ rocksdb::Status Redis::SDiffstore(const Slice& destination, const std::vector<st
   uint32_t statistic = 0;
   BaseMetaKey base_destination(destination);
   s = db_->Get(read_options, handles_[kMetaCF], base_destination.Encode(), &meta_value);
+  std::string old_meta = s.ok() ? meta_value : std::string();
   if (s.ok() && !ExpectedMetaValue(DataType::kSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -396,7 +560,7 @@ rocksdb::Status Redis::SDiffstore(const Slice& destination, const std::vector<st
     batch.Put(handles_[kSetsDataCF], sets_member_key.Encode(), iter_value.Encode());
   }
   *ret = static_cast<int32_t>(members.size());
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_destination.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kSets, destination.ToString(), statistic);
   value_to_dest = std::move(members);
   return s;
@@ -411,10 +575,10 @@ rocksdb::Status Redis::SInter(const std::vector<std::string>& keys, std::vector<
   const rocksdb::Snapshot* snapshot;
 
   std::string meta_value;
-  uint64_t version = 0;
   ScopeSnapshot ss(db_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> vaild_sets;
+  std::vector<std::string> vaild_set_metas;
   rocksdb::Status s;
 
   for (uint32_t idx = 1; idx < keys.size(); ++idx) {
@@ -436,6 +600,7 @@ rocksdb::Status Redis::SInter(const std::vector<std::string>& keys, std::vector<
         return rocksdb::Status::OK();
       } else {
         vaild_sets.push_back({keys[idx], parsed_sets_meta_value.Version()});
+        vaild_set_metas.push_back(meta_value);
       }
     } else if (s.IsNotFound()) {
       return rocksdb::Status::OK();
@@ -461,36 +626,12 @@ rocksdb::Status Redis::SInter(const std::vector<std::string>& keys, std::vector<
     if (parsed_sets_meta_value.IsStale() || parsed_sets_meta_value.Count() == 0) {
       return rocksdb::Status::OK();
     } else {
-      bool reliable;
-      std::string member_value;
-      version = parsed_sets_meta_value.Version();
-      SetsMemberKey sets_member_key(keys[0], version, Slice());
-      KeyStatisticsDurationGuard guard(this, DataType::kSets, keys[0]);
-      Slice prefix = sets_member_key.EncodeSeekKey();
-      auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
-      for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
-        ParsedSetsMemberKey parsed_sets_member_key(iter->key());
-        Slice member = parsed_sets_member_key.member();
-
-        reliable = true;
-        for (const auto& key_version : vaild_sets) {
-          SetsMemberKey sets_member_key(key_version.key, key_version.version, member);
-          s = db_->Get(read_options, handles_[kSetsDataCF], sets_member_key.Encode(), &member_value);
-          if (s.ok()) {
-            continue;
-          } else if (s.IsNotFound()) {
-            reliable = false;
-            break;
-          } else {
-            delete iter;
-            return s;
-          }
-        }
-        if (reliable) {
-          members->push_back(member.ToString());
-        }
+      vaild_sets.push_back({keys[0], parsed_sets_meta_value.Version()});
+      vaild_set_metas.push_back(meta_value);
+      s = SetsInter(read_options, vaild_sets, vaild_set_metas, members);
+      if (!s.ok()) {
+        return s;
       }
-      delete iter;
     }
   } else if (s.IsNotFound()) {
     return rocksdb::Status::OK();
@@ -516,6 +657,7 @@ rocksdb::Status Redis::SInterstore(const Slice& destination, const std::vector<s
   ScopeSnapshot ss(db_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> vaild_sets;
+  std::vector<std::string> vaild_set_metas;
   rocksdb::Status s;
 
   for (uint32_t idx = 1; idx < keys.size(); ++idx) {
@@ -538,6 +680,7 @@ rocksdb::Status Redis::SInterstore(const Slice& destination, const std::vector<s
         break;
       } else {
         vaild_sets.push_back({keys[idx], parsed_sets_meta_value.Version()});
+        vaild_set_metas.push_back(meta_value);
       }
     } else if (s.IsNotFound()) {
       have_invalid_sets = true;
@@ -566,36 +709,12 @@ rocksdb::Status Redis::SInterstore(const Slice& destination, const std::vector<s
       if (parsed_sets_meta_value.IsStale() || parsed_sets_meta_value.Count() == 0) {
         have_invalid_sets = true;
       } else {
-        bool reliable;
-        std::string member_value;
-        version = parsed_sets_meta_value.Version();
-        SetsMemberKey sets_member_key(keys[0], version, Slice());
-        Slice prefix = sets_member_key.EncodeSeekKey();
-        KeyStatisticsDurationGuard guard(this, DataType::kSets, keys[0]);
-        auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
-        for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
-          ParsedSetsMemberKey parsed_sets_member_key(iter->key());
-          Slice member = parsed_sets_member_key.member();
-
-          reliable = true;
-          for (const auto& key_version : vaild_sets) {
-            SetsMemberKey sets_member_key(key_version.key, key_version.version, member);
-            s = db_->Get(read_options, handles_[kSetsDataCF], sets_member_key.Encode(), &member_value);
-            if (s.ok()) {
-              continue;
-            } else if (s.IsNotFound()) {
-              reliable = false;
-              break;
-            } else {
-              delete iter;
-              return s;
-            }
-          }
-          if (reliable) {
-            members.push_back(member.ToString());
-          }
+        vaild_sets.push_back({keys[0], parsed_sets_meta_value.Version()});
+        vaild_set_metas.push_back(meta_value);
+        s = SetsInter(read_options, vaild_sets, vaild_set_metas, &members);
+        if (!s.ok()) {
+          return s;
         }
-        delete iter;
       }
     } else if (s.IsNotFound()) {
     } else {
@@ -606,6 +725,7 @@ rocksdb::Status Redis::SInterstore(const Slice& destination, const std::vector<s
   uint32_t statistic = 0;
   BaseMetaKey base_destination(destination);
   s = db_->Get(read_options, handles_[kMetaCF], base_destination.Encode(), &meta_value);
+  std::string old_meta = s.ok() ? meta_value : std::string();
   if (s.ok() && !ExpectedMetaValue(DataType::kSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -640,7 +760,7 @@ rocksdb::Status Redis::SInterstore(const Slice& destination, const std::vector<s
     batch.Put(handles_[kSetsDataCF], sets_member_key.Encode(), iter_value.Encode());
   }
   *ret = static_cast<int32_t>(members.size());
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_destination.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kSets, destination.ToString(), statistic);
   value_to_dest = std::move(members);
   return s;
@@ -678,7 +798,7 @@ rocksdb::Status Redis::SIsmember(const Slice& key, const Slice& member, int32_t*
       std::string member_value;
       version = parsed_sets_meta_value.Version();
       SetsMemberKey sets_member_key(key, version, member);
-      s = db_->Get(read_options, handles_[kSetsDataCF], sets_member_key.Encode(), &member_value);
+      s = GetCollectionData(read_options, kSetsDataCF, meta_value, sets_member_key.Encode(), &member_value);
       *ret = s.ok() ? 1 : 0;
     }
   } else if (s.IsNotFound()) {
@@ -729,7 +849,7 @@ rocksdb::Status Redis::SMembers(const Slice& key, std::vector<std::string>* memb
       SetsMemberKey sets_member_key(key, version, Slice());
       Slice prefix = sets_member_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kSets, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
+      auto iter = NewCollectionIterator(read_options, kSetsDataCF, key, meta_value);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedSetsMemberKey parsed_sets_member_key(iter->key());
         members->push_back(parsed_sets_member_key.member().ToString());
@@ -782,7 +902,7 @@ Status Redis::SMembersWithTTL(const Slice& key,
       SetsMemberKey sets_member_key(key, version, Slice());
       Slice prefix = sets_member_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kSets, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
+      auto iter = NewCollectionIterator(read_options, kSetsDataCF, key, meta_value);
       for (iter->Seek(prefix);
            iter->Valid() && iter->key().starts_with(prefix);
            iter->Next()) {
@@ -813,6 +933,7 @@ rocksdb::Status Redis::SMove(const Slice& source, const Slice& destination, cons
 
   BaseMetaKey base_source(source);
   rocksdb::Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_source.Encode(), &meta_value);
+  std::string old_source_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -833,7 +954,7 @@ rocksdb::Status Redis::SMove(const Slice& source, const Slice& destination, cons
       std::string member_value;
       version = parsed_sets_meta_value.Version();
       SetsMemberKey sets_member_key(source, version, member);
-      s = db_->Get(default_read_options_, handles_[kSetsDataCF], sets_member_key.Encode(), &member_value);
+      s = GetCollectionData(default_read_options_, kSetsDataCF, meta_value, sets_member_key.Encode(), &member_value);
       if (s.ok()) {
         *ret = 1;
         if (!parsed_sets_meta_value.CheckModifyCount(-1)) {
@@ -859,6 +980,7 @@ rocksdb::Status Redis::SMove(const Slice& source, const Slice& destination, cons
 
   BaseMetaKey base_destination(destination);
   s = db_->Get(default_read_options_, handles_[kMetaCF], base_destination.Encode(), &meta_value);
+  std::string old_destination_meta = s.ok() ? meta_value : std::string();
   if (s.ok() && !ExpectedMetaValue(DataType::kSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -882,7 +1004,7 @@ rocksdb::Status Redis::SMove(const Slice& source, const Slice& destination, cons
       std::string member_value;
       version = parsed_sets_meta_value.Version();
       SetsMemberKey sets_member_key(destination, version, member);
-      s = db_->Get(default_read_options_, handles_[kSetsDataCF], sets_member_key.Encode(), &member_value);
+      s = GetCollectionData(default_read_options_, kSetsDataCF, meta_value, sets_member_key.Encode(), &member_value);
       if (s.IsNotFound()) {
         if (!parsed_sets_meta_value.CheckModifyCount(1)) {
           return Status::InvalidArgument("set size overflow");
@@ -907,20 +1029,210 @@ rocksdb::Status Redis::SMove(const Slice& source, const Slice& destination, cons
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_source.Encode(), old_source_meta},
+                                    {base_destination.Encode(), old_destination_meta}});
   UpdateSpecificKeyStatistics(DataType::kSets, source.ToString(), 1);
   return s;
 }
 
-rocksdb::Status Redis::SPop(const Slice& key, std::vector<std::string>* members, int64_t cnt) {
-  std::default_random_engine engine;
+namespace {
+
+// sets up to this size are walked once instead of sampled by seeks
+const int32_t kSetsSampleMinSize = 1024;
+// the sample index keeps every spacing-th member, spacing is at least this
+// and grows with the set past kSetsSampleMaxMembers kept members
+const int32_t kSetsSampleMinSpacing = 64;
+const int32_t kSetsSampleMaxMembers = 16384;
+// a cached sample index serves until the count of its set drifted by this
+// fraction of it, members added or removed meanwhile just skew the sample
+const int32_t kSetsSampleDriftRatio = 8;
+// rounds of fresh ranks drawn when the ones of a drifted index collide
+const int32_t kSetsSampleRounds = 4;
+
+int32_t SetsSampleSpacing(int32_t size) {
+  auto spacing = (static_cast<int64_t>(size) + kSetsSampleMaxMembers - 1) / kSetsSampleMaxMembers;
+  return std::max(kSetsSampleMinSpacing, static_cast<int32_t>(spacing));
+}
+
+std::mt19937_64& SetsSampleEngine() {
+  thread_local std::mt19937_64 engine(std::random_device{}());
+  return engine;
+}
+
+}  // namespace
+
+Status Redis::GetSetsSampleIndex(const Slice& key, const std::string& meta_value,
+                                 std::shared_ptr<SetsSampleIndex>* index) {
+  ParsedSetsMetaValue parsed_sets_meta_value(Slice{meta_value});
+  uint64_t version = parsed_sets_meta_value.Version();
+  int32_t size = parsed_sets_meta_value.Count();
+  if (sets_sample_store_->Lookup(key.ToString(), index).ok() && (*index)->version == version &&
+      std::abs((*index)->count - size) <= (*index)->count / kSetsSampleDriftRatio) {
+    return Status::OK();
+  }
+
+  auto new_index = std::make_shared<SetsSampleIndex>();
+  new_index->version = version;
+  int32_t spacing = SetsSampleSpacing(size);
+  int32_t rank = 0;
+  SetsMemberKey sets_member_key(key, version, Slice());
+  Slice prefix = sets_member_key.EncodeSeekKey();
+  std::unique_ptr<rocksdb::Iterator> iter(NewCollectionIterator(default_read_options_, kSetsDataCF, key, meta_value));
+  for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next(), ++rank) {
+    if (rank % spacing == 0) {
+      ParsedSetsMemberKey parsed_sets_member_key(iter->key());
+      new_index->members.push_back(parsed_sets_member_key.member().ToString());
+      new_index->ranks.push_back(rank);
+    }
+  }
+  if (!iter->status().ok()) {
+    return iter->status();
+  }
+  if (new_index->members.empty()) {
+    return Status::NotFound();
+  }
+  new_index->count = rank;
+  size_t charge = key.size() + sizeof(SetsSampleIndex) + new_index->ranks.size() * sizeof(int32_t);
+  for (const auto& member : new_index->members) {
+    charge += sizeof(std::string) + member.size();
+  }
+  sets_sample_store_->Insert(key.ToString(), new_index, charge);
+  *index = std::move(new_index);
+  return Status::OK();
+}
+
+/*
+ * Keeps the ranks of a cached sample index exact across SPOP. A popped
+ * member only moves the kept members after it, a kept member that is popped
+ * itself still marks where its successor now is
+ */
+void Redis::UpdateSetsSampleIndex(const Slice& key, uint64_t version, std::vector<std::string> popped) {
+  std::shared_ptr<SetsSampleIndex> index;
+  if (!sets_sample_store_->Lookup(key.ToString(), &index).ok() || index->version != version) {
+    return;
+  }
+  std::sort(popped.begin(), popped.end());
+  size_t before = 0;
+  for (size_t idx = 0; idx < index->members.size(); ++idx) {
+    while (before < popped.size() && popped[before] < index->members[idx]) {
+      ++before;
+    }
+    index->ranks[idx] -= static_cast<int32_t>(before);
+  }
+  index->count -= static_cast<int32_t>(popped.size());
+}
+
+/*
+ * Small sets, and samples of a large part of a set, take one walk over the
+ * sorted random ranks. Otherwise every rank is reached from the closest
+ * member of the sample index before it, so the cost follows count and not
+ * the size of the set
+ */
+Status Redis::SampleSetsMembers(const Slice& key, const std::string& meta_value, int32_t count, bool repeats,
+                                std::vector<std::string>* members) {
+  ParsedSetsMetaValue parsed_sets_meta_value(Slice{meta_value});
+  uint64_t version = parsed_sets_meta_value.Version();
+  int32_t size = parsed_sets_meta_value.Count();
+  count = repeats ? count : std::min(count, size);
+  std::mt19937_64& engine = SetsSampleEngine();
+  std::uniform_int_distribution<int32_t> distribution(0, size - 1);
+  SetsMemberKey sets_member_key(key, version, Slice());
+  Slice prefix = sets_member_key.EncodeSeekKey();
+  KeyStatisticsDurationGuard guard(this, DataType::kSets, key.ToString());
+
+  std::shared_ptr<SetsSampleIndex> index;
+  bool walk = size <= kSetsSampleMinSize ||
+              static_cast<int64_t>(count) * SetsSampleSpacing(size) >= static_cast<int64_t>(size);
+  if (!walk) {
+    Status s = GetSetsSampleIndex(key, meta_value, &index);
+    if (!s.ok()) {
+      return s;
+    }
+    std::unique_ptr<rocksdb::Iterator> iter(
+        NewCollectionIterator(default_read_options_, kSetsDataCF, key, meta_value));
+    std::unordered_set<int32_t> drawn;
+    std::unordered_set<std::string> unique;
+    std::vector<int32_t> targets;
+    for (int32_t round = 0; round < kSetsSampleRounds && static_cast<int32_t>(members->size()) < count; ++round) {
+      targets.clear();
+      while (static_cast<int32_t>(members->size() + targets.size()) < count) {
+        int32_t rank = distribution(engine);
+        if (repeats || drawn.insert(rank).second) {
+          targets.push_back(rank);
+        }
+      }
+      std::sort(targets.begin(), targets.end());
+      for (int32_t rank : targets) {
+        auto checkpoint = std::upper_bound(index->ranks.begin(), index->ranks.end(), rank);
+        size_t pos = checkpoint == index->ranks.begin() ? 0 : checkpoint - index->ranks.begin() - 1;
+        SetsMemberKey start_key(key, version, index->members[pos]);
+        iter->Seek(start_key.Encode());
+        for (int32_t cur = index->ranks[pos]; cur < rank && iter->Valid() && iter->key().starts_with(prefix); ++cur) {
+          iter->Next();
+        }
+        if (!iter->Valid() || !iter->key().starts_with(prefix)) {
+          // the set shrank since the index was built
+          iter->Seek(prefix);
+          if (!iter->Valid() || !iter->key().starts_with(prefix)) {
+            return iter->status().ok() ? Status::NotFound() : iter->status();
+          }
+        }
+        ParsedSetsMemberKey parsed_sets_member_key(iter->key());
+        std::string member = parsed_sets_member_key.member().ToString();
+        if (repeats || unique.insert(member).second) {
+          members->push_back(std::move(member));
+        }
+      }
+    }
+    if (!iter->status().ok()) {
+      return iter->status();
+    }
+    if (static_cast<int32_t>(members->size()) < count) {
+      // the ranks of a drifted index kept hitting the same members
+      members->clear();
+      walk = true;
+    }
+  }
 
+  if (walk) {
+    std::vector<int32_t> targets;
+    std::unordered_set<int32_t> drawn;
+    while (static_cast<int32_t>(targets.size()) < count) {
+      int32_t rank = distribution(engine);
+      if (repeats || drawn.insert(rank).second) {
+        targets.push_back(rank);
+      }
+    }
+    std::sort(targets.begin(), targets.end());
+
+    int32_t cur_index = 0;
+    size_t idx = 0;
+    std::unique_ptr<rocksdb::Iterator> iter(
+        NewCollectionIterator(default_read_options_, kSetsDataCF, key, meta_value));
+    for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix) && idx < targets.size();
+         iter->Next(), cur_index++) {
+      ParsedSetsMemberKey parsed_sets_member_key(iter->key());
+      while (idx < targets.size() && cur_index == targets[idx]) {
+        idx++;
+        members->push_back(parsed_sets_member_key.member().ToString());
+      }
+    }
+    if (!iter->status().ok()) {
+      return iter->status();
+    }
+  }
+  std::shuffle(members->begin(), members->end(), engine);
+  return Status::OK();
+}
+
+rocksdb::Status Redis::SPop(const Slice& key, std::vector<std::string>* members, int64_t cnt) {
   std::string meta_value;
   rocksdb::WriteBatch batch;
   ScopeRecordLock l(lock_mgr_, key);
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -931,6 +1243,9 @@ rocksdb::Status Redis::SPop(const Slice& key, std::vector<std::string>* members,
           DataTypeStrings[static_cast<int>(GetMetaValueType(meta_value))]);
     }
   }
+  uint64_t version = 0;
+  bool popped_all = false;
+  std::vector<std::string> popped;
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale()) {
@@ -939,12 +1254,12 @@ rocksdb::Status Redis::SPop(const Slice& key, std::vector<std::string>* members,
       return Status::NotFound();
     } else {
       int32_t length = parsed_sets_meta_value.Count();
+      version = parsed_sets_meta_value.Version();
       if (length < cnt) {
         int32_t size = parsed_sets_meta_value.Count();
         int32_t cur_index = 0;
-        uint64_t version = parsed_sets_meta_value.Version();
         SetsMemberKey sets_member_key(key, version, Slice());
-        auto iter = db_->NewIterator(default_read_options_, handles_[kSetsDataCF]);
+        auto iter = NewCollectionIterator(default_read_options_, kSetsDataCF, key, meta_value);
         for (iter->Seek(sets_member_key.EncodeSeekKey());
             iter->Valid() && cur_index < size;
             iter->Next(), cur_index++) {
@@ -958,56 +1273,40 @@ rocksdb::Status Redis::SPop(const Slice& key, std::vector<std::string>* members,
         //parsed_sets_meta_value.ModifyCount(-cnt);
         //batch.Put(handles_[kMetaCF], key, meta_value);
         batch.Delete(handles_[kMetaCF], base_meta_key.Encode());
+        popped_all = true;
         delete iter;
 
       } else {
-        engine.seed(time(nullptr));
-        int32_t cur_index = 0;
-        int32_t size = parsed_sets_meta_value.Count();
-        int32_t target_index = -1;
-        uint64_t version = parsed_sets_meta_value.Version();
-        std::unordered_set<int32_t> sets_index;
-        int32_t modnum = size;
-
-        for (int64_t cur_round = 0;
-            cur_round < cnt;
-            cur_round++) {
-          do {
-            target_index = static_cast<int32_t>( engine() % modnum);
-          } while (sets_index.find(target_index) != sets_index.end());
-          sets_index.insert(target_index);
+        s = SampleSetsMembers(key, meta_value, static_cast<int32_t>(cnt), false, &popped);
+        if (!s.ok()) {
+          return s;
         }
-
-        SetsMemberKey sets_member_key(key, version, Slice());
-        int64_t del_count = 0;
-        KeyStatisticsDurationGuard guard(this, DataType::kSets, key.ToString());
-        auto iter = db_->NewIterator(default_read_options_, handles_[kSetsDataCF]);
-        for (iter->Seek(sets_member_key.EncodeSeekKey());
-            iter->Valid() && cur_index < size;
-            iter->Next(), cur_index++) {
-          if (del_count == cnt) {
-            break;
-          }
-          if (sets_index.find(cur_index) != sets_index.end()) {
-            del_count++;
-            batch.Delete(handles_[kSetsDataCF], iter->key());
-            ParsedSetsMemberKey parsed_sets_member_key(iter->key());
-            members->push_back(parsed_sets_member_key.member().ToString());
-          }
+        for (const auto& member : popped) {
+          SetsMemberKey sets_member_key(key, version, Slice(member));
+          batch.Delete(handles_[kSetsDataCF], sets_member_key.Encode());
         }
 
-        if (!parsed_sets_meta_value.CheckModifyCount(static_cast<int32_t>(-cnt))) {
+        auto del_count = static_cast<int32_t>(popped.size());
+        if (!parsed_sets_meta_value.CheckModifyCount(-del_count)) {
           return Status::InvalidArgument("set size overflow");
         }
-        parsed_sets_meta_value.ModifyCount(static_cast<int32_t>(-cnt));
+        parsed_sets_meta_value.ModifyCount(-del_count);
         batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
-        delete iter;
       }
     }
   } else {
     return s;
   }
-  return db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
+  if (s.ok()) {
+    if (popped_all) {
+      sets_sample_store_->Remove(key.ToString());
+    } else {
+      members->insert(members->end(), popped.begin(), popped.end());
+      UpdateSetsSampleIndex(key, version, std::move(popped));
+    }
+  }
+  return s;
 }
 
 rocksdb::Status Redis::ResetSpopCount(const std::string& key) { return spop_counts_store_->Remove(key); }
@@ -1026,15 +1325,9 @@ rocksdb::Status Redis::SRandmember(const Slice& key, int32_t count, std::vector<
   }
 
   members->clear();
-  auto last_seed = pstd::NowMicros();
-  std::default_random_engine engine;
 
   std::string meta_value;
-  rocksdb::WriteBatch batch;
   ScopeRecordLock l(lock_mgr_, key);
-  std::vector<int32_t> targets;
-  std::unordered_set<int32_t> unique;
-
 
   BaseMetaKey base_meta_key(key);
   rocksdb::Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
@@ -1054,48 +1347,10 @@ rocksdb::Status Redis::SRandmember(const Slice& key, int32_t count, std::vector<
       return rocksdb::Status::NotFound("Stale");
     } else if (parsed_sets_meta_value.Count() == 0) {
       return rocksdb::Status::NotFound();
+    } else if (count > 0) {
+      s = SampleSetsMembers(key, meta_value, count, false, members);
     } else {
-      int32_t size = parsed_sets_meta_value.Count();
-      uint64_t version = parsed_sets_meta_value.Version();
-      if (count > 0) {
-        count = count <= size ? count : size;
-        while (targets.size() < static_cast<size_t>(count)) {
-          engine.seed(last_seed);
-          last_seed = static_cast<int64_t>(engine());
-          auto pos = static_cast<int32_t>(last_seed % size);
-          if (unique.find(pos) == unique.end()) {
-            unique.insert(pos);
-            targets.push_back(pos);
-          }
-        }
-      } else {
-        count = -count;
-        while (targets.size() < static_cast<size_t>(count)) {
-          engine.seed(last_seed);
-          last_seed = static_cast<int64_t>(engine());
-          targets.push_back(static_cast<int32_t>(last_seed % size));
-        }
-      }
-      std::sort(targets.begin(), targets.end());
-
-      int32_t cur_index = 0;
-      int32_t idx = 0;
-      SetsMemberKey sets_member_key(key, version, Slice());
-      KeyStatisticsDurationGuard guard(this, DataType::kSets, key.ToString());
-      auto iter = db_->NewIterator(default_read_options_, handles_[kSetsDataCF]);
-      for (iter->Seek(sets_member_key.EncodeSeekKey()); iter->Valid() && cur_index < size; iter->Next(), cur_index++) {
-        if (static_cast<size_t>(idx) >= targets.size()) {
-          break;
-        }
-        ParsedSetsMemberKey parsed_sets_member_key(iter->key());
-        while (static_cast<size_t>(idx) < targets.size() && cur_index == targets[idx]) {
-          idx++;
-          members->push_back(parsed_sets_member_key.member().ToString());
-        }
-      }
-
-      std::shuffle(members->begin(), members->end(), engine);
-      delete iter;
+      s = SampleSetsMembers(key, meta_value, -count, true, members);
     }
   }
   return s;
@@ -1112,6 +1367,7 @@ rocksdb::Status Redis::SRem(const Slice& key, const std::vector<std::string>& me
 
   BaseMetaKey base_meta_key(key);
   rocksdb::Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -1134,7 +1390,7 @@ rocksdb::Status Redis::SRem(const Slice& key, const std::vector<std::string>& me
       version = parsed_sets_meta_value.Version();
       for (const auto& member : members) {
         SetsMemberKey sets_member_key(key, version, member);
-        s = db_->Get(default_read_options_, handles_[kSetsDataCF], sets_member_key.Encode(), &member_value);
+        s = GetCollectionData(default_read_options_, kSetsDataCF, meta_value, sets_member_key.Encode(), &member_value);
         if (s.ok()) {
           cnt++;
           statistic++;
@@ -1157,7 +1413,7 @@ rocksdb::Status Redis::SRem(const Slice& key, const std::vector<std::string>& me
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kSets, key.ToString(), statistic);
   return s;
 }
@@ -1174,6 +1430,7 @@ rocksdb::Status Redis::SUnion(const std::vector<std::string>& keys, std::vector<
   ScopeSnapshot ss(db_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> vaild_sets;
+  std::vector<std::string> vaild_set_metas;
   rocksdb::Status s;
 
   for (const auto & key : keys) {
@@ -1193,30 +1450,14 @@ rocksdb::Status Redis::SUnion(const std::vector<std::string>& keys, std::vector<
       ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
       if (!parsed_sets_meta_value.IsStale() && parsed_sets_meta_value.Count() != 0) {
         vaild_sets.push_back({key, parsed_sets_meta_value.Version()});
+        vaild_set_metas.push_back(meta_value);
       }
     } else if (!s.IsNotFound()) {
       return s;
     }
   }
 
-  Slice prefix;
-  std::map<std::string, bool> result_flag;
-  for (const auto& key_version : vaild_sets) {
-    SetsMemberKey sets_member_key(key_version.key, key_version.version, Slice());
-    prefix = sets_member_key.EncodeSeekKey();
-    KeyStatisticsDurationGuard guard(this, DataType::kSets, key_version.key);
-    auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
-    for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
-      ParsedSetsMemberKey parsed_sets_member_key(iter->key());
-      std::string member = parsed_sets_member_key.member().ToString();
-      if (result_flag.find(member) == result_flag.end()) {
-        members->push_back(member);
-        result_flag[member] = true;
-      }
-    }
-    delete iter;
-  }
-  return rocksdb::Status::OK();
+  return SetsUnion(read_options, vaild_sets, vaild_set_metas, members);
 }
 
 rocksdb::Status Redis::SUnionstore(const Slice& destination, const std::vector<std::string>& keys, std::vector<std::string>& value_to_dest, int32_t* ret) {
@@ -1234,6 +1475,7 @@ rocksdb::Status Redis::SUnionstore(const Slice& destination, const std::vector<s
   ScopeSnapshot ss(db_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> vaild_sets;
+  std::vector<std::string> vaild_set_metas;
   rocksdb::Status s;
 
   for (const auto & key : keys) {
@@ -1253,34 +1495,23 @@ rocksdb::Status Redis::SUnionstore(const Slice& destination, const std::vector<s
       ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
       if (!parsed_sets_meta_value.IsStale() && parsed_sets_meta_value.Count() != 0) {
         vaild_sets.push_back({key, parsed_sets_meta_value.Version()});
+        vaild_set_metas.push_back(meta_value);
       }
     } else if (!s.IsNotFound()) {
       return s;
     }
   }
 
-  Slice prefix;
   std::vector<std::string> members;
-  std::map<std::string, bool> result_flag;
-  for (const auto& key_version : vaild_sets) {
-    SetsMemberKey sets_member_key(key_version.key, key_version.version, Slice());
-    prefix = sets_member_key.EncodeSeekKey();
-    KeyStatisticsDurationGuard guard(this, DataType::kSets, key_version.key);
-    auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
-    for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
-      ParsedSetsMemberKey parsed_sets_member_key(iter->key());
-      std::string member = parsed_sets_member_key.member().ToString();
-      if (result_flag.find(member) == result_flag.end()) {
-        members.push_back(member);
-        result_flag[member] = true;
-      }
-    }
-    delete iter;
+  s = SetsUnion(read_options, vaild_sets, vaild_set_metas, &members);
+  if (!s.ok()) {
+    return s;
   }
 
   uint32_t statistic = 0;
   BaseMetaKey base_destination(destination);
   s = db_->Get(read_options, handles_[kMetaCF], base_destination.Encode(), &meta_value);
+  std::string old_meta = s.ok() ? meta_value : std::string();
   if (s.ok() && !ExpectedMetaValue(DataType::kSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -1315,7 +1546,7 @@ rocksdb::Status Redis::SUnionstore(const Slice& destination, const std::vector<s
     batch.Put(handles_[kSetsDataCF], sets_member_key.Encode(), i_val.Encode());
   }
   *ret = static_cast<int32_t>(members.size());
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_destination.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kSets, destination.ToString(), statistic);
   value_to_dest = std::move(members);
   return s;
@@ -1375,7 +1606,7 @@ rocksdb::Status Redis::SScan(const Slice& key, int64_t cursor, const std::string
       SetsMemberKey sets_member_key(key, version, start_point);
       std::string prefix = sets_member_prefix.EncodeSeekKey().ToString();
       KeyStatisticsDurationGuard guard(this, DataType::kSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
+      rocksdb::Iterator* iter = NewCollectionIterator(read_options, kSetsDataCF, key, meta_value);
       for (iter->Seek(sets_member_key.EncodeSeekKey()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedSetsMemberKey parsed_sets_member_key(iter->key());
@@ -1434,10 +1665,10 @@ rocksdb::Status Redis::SetsExpire(const Slice& key, int64_t ttl_millsec, std::st
 
     if (ttl_millsec > 0) {
       parsed_sets_meta_value.SetRelativeTimestamp(ttl_millsec);
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
     } else {
       parsed_sets_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
     }
   }
   return s;
@@ -1473,7 +1704,7 @@ rocksdb::Status Redis::SetsDel(const Slice& key, std::string&& prefetch_meta) {
     } else {
       uint32_t statistic = parsed_sets_meta_value.Count();
       parsed_sets_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
       UpdateSpecificKeyStatistics(DataType::kSets, key.ToString(), statistic);
     }
   }
@@ -1513,7 +1744,7 @@ rocksdb::Status Redis::SetsExpireat(const Slice& key, int64_t timestamp_millsec,
       } else {
         parsed_sets_meta_value.InitialMetaValue();
       }
-      return db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      return PutMeta(base_meta_key.Encode(), meta_value);
     }
   }
   return s;
@@ -1552,7 +1783,7 @@ rocksdb::Status Redis::SetsPersist(const Slice& key, std::string&& prefetch_meta
         return rocksdb::Status::NotFound("Not have an associated timeout");
       } else {
         parsed_sets_meta_value.SetEtime(0);
-        return db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+        return PutMeta(base_meta_key.Encode(), meta_value);
       }
     }
   }
@@ -1613,7 +1844,7 @@ void Redis::ScanSets() {
   LOG(INFO) << "***************Sets Meta Data***************";
   auto meta_iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
   for (meta_iter->SeekToFirst(); meta_iter->Valid(); meta_iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kSets, meta_iter->value().ToString())) {
+    if (!ExpectedMetaValue(DataType::kSets, meta_iter->value())) {
       continue;
     }
     ParsedSetsMetaValue parsed_sets_meta_value(meta_iter->value());
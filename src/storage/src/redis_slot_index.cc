@@ -0,0 +1,149 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <string>
+#include <vector>
+
+#include "src/base_key_format.h"
+#include "src/redis.h"
+#include "src/scope_record_lock.h"
+#include "src/scope_snapshot.h"
+#include "src/slot_index_format.h"
+#include "storage/util.h"
+
+namespace storage {
+
+/*
+ * The writes of the keys put and drop their entries while the index is on
+ * (see WriteWithKeyCounters), these two only fix up the index for the keys
+ * written while it was off and the entries left by dropped metas. They
+ * take the record lock of the key like its writes.
+ */
+Status Redis::SlotIndexAdd(uint32_t slot_id, bool has_tag, uint32_t crc, const Slice& key) {
+  ScopeRecordLock l(lock_mgr_, key);
+  BaseMetaKey base_meta_key(key);
+  std::string meta_value;
+  Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  if (!s.ok()) {
+    return s;
+  }
+  char type = SlotIndexCounts::IndexType(meta_value);
+  if (type == 0) {
+    return Status::NotFound();
+  }
+
+  std::string index_key = SlotIndexKey(kSlotIndexSlotEntry, slot_id, key);
+  std::string value;
+  s = db_->Get(default_read_options_, handles_[kSlotIndexCF], index_key, &value);
+  if (s.ok() && value.size() == 1 && value[0] == type) {
+    return s;
+  }
+  if (!s.ok() && !s.IsNotFound()) {
+    return s;
+  }
+
+  rocksdb::WriteBatch batch;
+  batch.Put(handles_[kSlotIndexCF], index_key, Slice(&type, 1));
+  if (has_tag) {
+    batch.Put(handles_[kSlotIndexCF], SlotIndexKey(kSlotIndexTagEntry, crc, key), Slice(&type, 1));
+  }
+  if (s.IsNotFound()) {
+    SlotIndexCounts::AddToBatch({{slot_id, 1}}, handles_[kSlotIndexCF], &batch);
+  }
+  return db_->Write(default_write_options_, &batch);
+}
+
+Status Redis::SlotIndexDel(uint32_t slot_id, bool has_tag, uint32_t crc, const Slice& key) {
+  ScopeRecordLock l(lock_mgr_, key);
+  std::string index_key = SlotIndexKey(kSlotIndexSlotEntry, slot_id, key);
+  std::string value;
+  Status s = db_->Get(default_read_options_, handles_[kSlotIndexCF], index_key, &value);
+  if (!s.ok()) {
+    return s;
+  }
+
+  BaseMetaKey base_meta_key(key);
+  std::string meta_value;
+  s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  if (s.ok() && SlotIndexCounts::IndexType(meta_value) != 0 &&
+      GetSlotID(slot_index_counts_.SlotNum(), key.ToString()) == slot_id) {
+    return Status::Busy("key is stored");
+  }
+  if (!s.ok() && !s.IsNotFound()) {
+    return s;
+  }
+
+  // the count went down when the meta was dropped
+  rocksdb::WriteBatch batch;
+  batch.Delete(handles_[kSlotIndexCF], index_key);
+  if (has_tag) {
+    batch.Delete(handles_[kSlotIndexCF], SlotIndexKey(kSlotIndexTagEntry, crc, key));
+  }
+  return db_->Write(default_write_options_, &batch);
+}
+
+Status Redis::SlotIndexScan(uint32_t slot_id, int64_t cursor, const std::string& pattern, int64_t count,
+                            std::vector<std::string>* type_keys, int64_t* next_cursor) {
+  *next_cursor = 0;
+  type_keys->clear();
+  if (cursor < 0) {
+    return Status::OK();
+  }
+
+  rocksdb::ReadOptions read_options;
+  const rocksdb::Snapshot* snapshot;
+  ScopeSnapshot ss(db_, &snapshot);
+  read_options.snapshot = snapshot;
+
+  std::string prefix = SlotIndexPrefix(kSlotIndexSlotEntry, slot_id);
+  std::string start_point;
+  Status s = GetScanStartPoint(DataType::kNones, prefix, pattern, cursor, &start_point);
+  if (s.IsNotFound()) {
+    cursor = 0;
+    start_point.clear();
+  }
+
+  int64_t rest = count;
+  std::string type_key;
+  rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kSlotIndexCF]);
+  for (iter->Seek(prefix + start_point); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
+       iter->Next()) {
+    Slice key = SlotIndexUserKey(iter->key());
+    type_key.assign(iter->value().data(), iter->value().size());
+    type_key.append(key.data(), key.size());
+    if (StringMatch(pattern.data(), pattern.size(), type_key.data(), type_key.size(), 0) != 0) {
+      type_keys->push_back(type_key);
+    }
+    rest--;
+  }
+  if (iter->Valid() && iter->key().starts_with(prefix)) {
+    *next_cursor = cursor + count;
+    StoreScanNextPoint(DataType::kNones, prefix, pattern, *next_cursor, SlotIndexUserKey(iter->key()).ToString());
+  }
+  s = iter->status();
+  delete iter;
+  return s;
+}
+
+Status Redis::SlotIndexTagKeys(uint32_t crc, std::vector<std::string>* type_keys) {
+  type_keys->clear();
+  std::string prefix = SlotIndexPrefix(kSlotIndexTagEntry, crc);
+  rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[kSlotIndexCF]);
+  for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    Slice key = SlotIndexUserKey(iter->key());
+    std::string type_key(iter->value().data(), iter->value().size());
+    type_key.append(key.data(), key.size());
+    type_keys->push_back(std::move(type_key));
+  }
+  Status s = iter->status();
+  delete iter;
+  return s;
+}
+
+Status Redis::SlotIndexCount(uint32_t slot_id, int64_t* count) {
+  return SlotIndexCounts::Read(db_, default_read_options_, handles_[kSlotIndexCF], slot_id, count);
+}
+
+}  //  namespace storage
@@ -41,6 +41,9 @@ Status Redis::XAdd(const Slice& key, const std::string& serialized_message, Stre
   } else if (!s.ok()) {
     return Status::Corruption("error from XADD, get stream meta failed: " + s.ToString());
   }
+  // a missing stream may still have a stale meta of another type, it is read back
+  bool found = s.ok();
+  std::string old_meta = found ? stream_meta.value() : std::string();
 
   if (stream_meta.length() == 0) {
     if (args.no_mkstream) {
@@ -91,7 +94,8 @@ Status Redis::XAdd(const Slice& key, const std::string& serialized_message, Stre
 
   // 5 update stream meta
   BaseMetaKey base_meta_key(key);
-  s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), stream_meta.value());
+  s = found ? PutMeta(base_meta_key.Encode(), old_meta, stream_meta.value())
+            : PutMeta(base_meta_key.Encode(), stream_meta.value());
   if (!s.ok()) {
     return s;
   }
@@ -108,6 +112,7 @@ Status Redis::XTrim(const Slice& key, StreamAddTrimArgs& args, int32_t& count) {
   if (!s.ok()) {
     return s;
   }
+  std::string old_meta = stream_meta.value();
 
   // 2 do the trim
   count = 0;
@@ -118,7 +123,7 @@ Status Redis::XTrim(const Slice& key, StreamAddTrimArgs& args, int32_t& count) {
 
   // 3 update stream meta
   BaseMetaKey base_meta_key(key);
-  s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), stream_meta.value());
+  s = PutMeta(base_meta_key.Encode(), old_meta, stream_meta.value());
   if (!s.ok()) {
     return s;
   }
@@ -134,6 +139,7 @@ Status Redis::XDel(const Slice& key, const std::vector<streamID>& ids, int32_t&
   if (!s.ok()) {
     return s;
   }
+  std::string old_meta = stream_meta.value();
 
   // 2 do the delete
   if (ids.size() > INT32_MAX) {
@@ -172,7 +178,7 @@ Status Redis::XDel(const Slice& key, const std::vector<streamID>& ids, int32_t&
     }
   }
 
-  return db_->Put(default_write_options_, handles_[kMetaCF], BaseMetaKey(key).Encode(), stream_meta.value());
+  return PutMeta(BaseMetaKey(key).Encode(), old_meta, stream_meta.value());
 }
 
 Status Redis::XRange(const Slice& key, const StreamScanArgs& args, std::vector<IdMessage>& field_values, std::string&& prefetch_meta) {
@@ -326,37 +332,6 @@ Status Redis::XInfo(const Slice& key, StreamInfoResult& result) {
   return Status::OK();
 }
 
-Status Redis::ScanStreamsKeyNum(KeyInfo* key_info) {
-  uint64_t keys = 0;
-  uint64_t expires = 0;
-  uint64_t ttl_sum = 0;
-  uint64_t invaild_keys = 0;
-
-  rocksdb::ReadOptions iterator_options;
-  const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
-  iterator_options.snapshot = snapshot;
-  iterator_options.fill_cache = false;
-
-  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kStreams, iter->value().ToString())) {
-      continue;
-    }
-    ParsedStreamMetaValue parsed_stream_meta_value(iter->value());
-    if (parsed_stream_meta_value.length() == 0) {
-      invaild_keys++;
-    } else {
-      keys++;
-    }
-  }
-  delete iter;
-
-  key_info->keys = keys;
-  key_info->invaild_keys = invaild_keys;
-  return Status::OK();
-}
-
 Status Redis::StreamsDel(const Slice& key, std::string&& prefetch_meta) {
   std::string meta_value(std::move(prefetch_meta));
   BaseMetaKey base_meta_key(key);
@@ -385,7 +360,7 @@ Status Redis::StreamsDel(const Slice& key, std::string&& prefetch_meta) {
     } else {
       uint32_t statistic = stream_meta_value.length();
       stream_meta_value.InitMetaValue();
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), stream_meta_value.value());
+      s = PutMeta(base_meta_key.Encode(), stream_meta_value.value());
       UpdateSpecificKeyStatistics(DataType::kStreams, key.ToString(), statistic);
     }
   }
@@ -757,7 +732,7 @@ Status Redis::DeleteStreamMessages(const rocksdb::Slice& key, const StreamMetaVa
     StreamDataKey stream_data_key(key, stream_meta.version(), sid);
     batch.Delete(handles_[kStreamsDataCF], stream_data_key.Encode());
   }
-  return db_->Write(default_write_options_, &batch);
+  return WriteWithKeyCounters(&batch);
 }
 
 inline Status Redis::SetFirstID(const rocksdb::Slice& key, StreamMetaValue& stream_meta,
@@ -6,13 +6,16 @@
 #include <iostream>
 #include <algorithm>
 #include <climits>
+#include <cstring>
 #include <limits>
 #include <memory>
+#include <unordered_set>
 
 #include <fmt/core.h>
 #include <glog/logging.h>
 
 #include "pstd/include/pika_codis_slot.h"
+#include "pstd/include/pstd_bit.h"
 #include "src/base_key_format.h"
 #include "src/scope_record_lock.h"
 #include "src/scope_snapshot.h"
@@ -21,47 +24,6 @@
 #include "storage/util.h"
 
 namespace storage {
-Status Redis::ScanStringsKeyNum(KeyInfo* key_info) {
-  uint64_t keys = 0;
-  uint64_t expires = 0;
-  uint64_t ttl_sum = 0;
-  uint64_t invaild_keys = 0;
-
-  rocksdb::ReadOptions iterator_options;
-  const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
-  iterator_options.snapshot = snapshot;
-  iterator_options.fill_cache = false;
-
-  pstd::TimeType curtime = pstd::NowMillis();
-
-  // Note: This is a string type and does not need to pass the column family as
-  // a parameter, use the default column family
-  rocksdb::Iterator* iter = db_->NewIterator(iterator_options);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kStrings, iter->value().ToString())) {
-      continue;
-    }
-    ParsedStringsValue parsed_strings_value(iter->value());
-    if (parsed_strings_value.IsStale()) {
-      invaild_keys++;
-    } else {
-      keys++;
-      if (!parsed_strings_value.IsPermanentSurvival()) {
-        expires++;
-        ttl_sum += parsed_strings_value.Etime() - curtime;
-      }
-    }
-  }
-  delete iter;
-
-  key_info->keys = keys;
-  key_info->expires = expires;
-  key_info->avg_ttl = (expires != 0) ? ttl_sum / expires : 0;
-  key_info->invaild_keys = invaild_keys;
-  return Status::OK();
-}
-
 Status Redis::Append(const Slice& key, const Slice& value, int32_t* ret, int64_t* expired_timestamp_millsec, std::string& out_new_value) {
   std::string old_value;
   *ret = 0;
@@ -85,7 +47,7 @@ Status Redis::Append(const Slice& key, const Slice& value, int32_t* ret, int64_t
     if (parsed_strings_value.IsStale()) {
       *ret = static_cast<int32_t>(value.size());
       StringsValue strings_value(value);
-      return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+      return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
     } else {
       uint64_t timestamp = parsed_strings_value.Etime();
       std::string old_user_value = parsed_strings_value.UserValue().ToString();
@@ -95,31 +57,19 @@ Status Redis::Append(const Slice& key, const Slice& value, int32_t* ret, int64_t
       strings_value.SetEtime(timestamp);
       *ret = static_cast<int32_t>(new_value.size());
       *expired_timestamp_millsec = timestamp;
-      return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+      return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
     }
   } else if (s.IsNotFound()) {
     *ret = static_cast<int32_t>(value.size());
     StringsValue strings_value(value);
     *expired_timestamp_millsec = 0;
-    return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+    return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
   }
   return s;
 }
 
 int GetBitCount(const unsigned char* value, int64_t bytes) {
-  int bit_num = 0;
-  static const unsigned char bitsinbyte[256] = {
-      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 1, 2, 2, 3, 2,
-      3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3,
-      3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5,
-      6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4,
-      3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4,
-      5, 5, 6, 5, 6, 6, 7, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6,
-      6, 7, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7, 4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8};
-  for (int i = 0; i < bytes; i++) {
-    bit_num += bitsinbyte[static_cast<unsigned int>(value[i])];
-  }
-  return bit_num;
+  return static_cast<int>(pstd::BitCount(value, static_cast<size_t>(bytes)));
 }
 
 Status Redis::BitCount(const Slice& key, int64_t start_offset, int64_t end_offset, int32_t* ret,
@@ -180,43 +130,32 @@ Status Redis::BitCount(const Slice& key, int64_t start_offset, int64_t end_offse
 }
 
 std::string BitOpOperate(BitOpType op, const std::vector<std::string>& src_values, int64_t max_len) {
-  char byte;
-  char output;
-  auto dest_value = std::make_unique<char[]>(max_len);
-  for (int64_t j = 0; j < max_len; j++) {
-    if (j < static_cast<int64_t>(src_values[0].size())) {
-      output = src_values[0][j];
-    } else {
-      output = 0;
-    }
-    if (op == kBitOpNot) {
-      output = static_cast<char>(~output);
-    }
-    for (size_t i = 1; i < src_values.size(); i++) {
-      if (static_cast<int64_t>(src_values[i].size()) - 1 >= j) {
-        byte = src_values[i][j];
-      } else {
-        byte = 0;
-      }
-      switch (op) {
-        case kBitOpNot:
-          break;
-        case kBitOpAnd:
-          output = static_cast<char>(output & byte);
-          break;
-        case kBitOpOr:
-          output = static_cast<char>(output | byte);
-          break;
-        case kBitOpXor:
-          output = static_cast<char>(output ^ byte);
-          break;
-        case kBitOpDefault:
-          break;
-      }
+  // missing bytes of shorter values count as zero
+  std::string dest_str(src_values[0], 0, std::min(static_cast<int64_t>(src_values[0].size()), max_len));
+  dest_str.resize(max_len, '\0');
+  auto dest = reinterpret_cast<unsigned char*>(dest_str.data());
+  if (op == kBitOpNot) {
+    pstd::BitNot(dest, max_len);
+    return dest_str;
+  }
+  for (size_t i = 1; i < src_values.size(); i++) {
+    auto src = reinterpret_cast<const unsigned char*>(src_values[i].data());
+    auto len = static_cast<size_t>(std::min(static_cast<int64_t>(src_values[i].size()), max_len));
+    switch (op) {
+      case kBitOpAnd:
+        pstd::BitAnd(dest, src, len);
+        memset(dest + len, 0, max_len - len);
+        break;
+      case kBitOpOr:
+        pstd::BitOr(dest, src, len);
+        break;
+      case kBitOpXor:
+        pstd::BitXor(dest, src, len);
+        break;
+      default:
+        break;
     }
-    dest_value[j] = output;
   }
-  std::string dest_str(dest_value.get(), max_len);
   return dest_str;
 }
 
@@ -271,7 +210,7 @@ Status Redis::BitOp(BitOpType op, const std::string& dest_key, const std::vector
   StringsValue strings_value(Slice(dest_value.c_str(), max_len));
   ScopeRecordLock l(lock_mgr_, dest_key);
   BaseKey base_dest_key(dest_key);
-  return db_->Put(default_write_options_, base_dest_key.Encode(), strings_value.Encode());
+  return PutMeta(base_dest_key.Encode(), strings_value.Encode());
 }
 
 Status Redis::Decrby(const Slice& key, int64_t value, int64_t* ret) {
@@ -297,7 +236,7 @@ Status Redis::Decrby(const Slice& key, int64_t value, int64_t* ret) {
       *ret = -value;
       new_value = std::to_string(*ret);
       StringsValue strings_value(new_value);
-      return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+      return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
     } else {
       uint64_t timestamp = parsed_strings_value.Etime();
       std::string old_user_value = parsed_strings_value.UserValue().ToString();
@@ -314,67 +253,18 @@ Status Redis::Decrby(const Slice& key, int64_t value, int64_t* ret) {
       new_value = std::to_string(*ret);
       StringsValue strings_value(new_value);
       strings_value.SetEtime(timestamp);
-      return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+      return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
     }
   } else if (s.IsNotFound()) {
     *ret = -value;
     new_value = std::to_string(*ret);
     StringsValue strings_value(new_value);
-    return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+    return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
   } else {
     return s;
   }
 }
 
-Status Redis::Get(const Slice& key, std::string* value) {
-  value->clear();
-
-  BaseKey base_key(key);
-  Status s = db_->Get(default_read_options_, base_key.Encode(), value);
-  std::string meta_value = *value;
-  if (s.ok() && !ExpectedMetaValue(DataType::kStrings, meta_value)) {
-    if (ExpectedStale(meta_value)) {
-      s = Status::NotFound();
-    } else {
-       return Status::InvalidArgument(
-          "WRONGTYPE, key: " + key.ToString() + ", expect type: " +
-          DataTypeStrings[static_cast<int>(DataType::kStrings)] + ", get type: " +
-          DataTypeStrings[static_cast<int>(GetMetaValueType(meta_value))]);
-    }
-  }
-  if (s.ok()) {
-    ParsedStringsValue parsed_strings_value(value);
-    if (parsed_strings_value.IsStale()) {
-      value->clear();
-      return Status::NotFound("Stale");
-    } else {
-      parsed_strings_value.StripSuffix();
-    }
-  }
-  return s;
-}
-
-Status Redis::MGet(const Slice& key, std::string* value) {
-  value->clear();
-
-  BaseKey base_key(key);
-  Status s = db_->Get(default_read_options_, base_key.Encode(), value);
-  std::string meta_value = *value;
-  if (s.ok() && !ExpectedMetaValue(DataType::kStrings, meta_value)) {
-    return Status::NotFound();
-  }
-  if (s.ok()) {
-    ParsedStringsValue parsed_strings_value(value);
-    if (parsed_strings_value.IsStale()) {
-      value->clear();
-      return Status::NotFound("Stale");
-    } else {
-      parsed_strings_value.StripSuffix();
-    }
-  }
-  return s;
-}
-
 void ClearValueAndSetTTL(std::string* value, int64_t* ttl, int64_t ttl_value) {
   value->clear();
   *ttl = ttl_value;
@@ -397,53 +287,162 @@ Status HandleParsedStringsValue(ParsedStringsValue& parsed_strings_value, std::s
   return Status::OK();
 }
 
-Status Redis::GetWithTTL(const Slice& key, std::string* value, int64_t* ttl_millsec) {
-  value->clear();
+Status Redis::PinStringsValue(const Slice& key, rocksdb::PinnableSlice* pinned_value, bool wrongtype_error) {
+  pinned_value->Reset();
   BaseKey base_key(key);
-  Status s = db_->Get(default_read_options_, base_key.Encode(), value);
-  std::string meta_value = *value;
-
-  if (s.ok() && !ExpectedMetaValue(DataType::kStrings, meta_value)) {
-    if (ExpectedStale(meta_value)) {
-      s = Status::NotFound();
-    } else {
-      return Status::InvalidArgument(
-        "WRONGTYPE, key: " + key.ToString() + ", expect type: " +
-        DataTypeStrings[static_cast<int>(DataType::kStrings)] + " get type: " +
-        DataTypeStrings[static_cast<int>(GetMetaValueType(meta_value))]);
+  Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_key.Encode(), pinned_value);
+  if (!s.ok()) {
+    return s;
+  }
+  if (!ExpectedMetaValue(DataType::kStrings, *pinned_value)) {
+    if (!wrongtype_error || ExpectedStale(*pinned_value)) {
+      pinned_value->Reset();
+      return Status::NotFound();
     }
+    return Status::InvalidArgument(
+        "WRONGTYPE, key: " + key.ToString() + ", expect type: " +
+        DataTypeStrings[static_cast<int>(DataType::kStrings)] + ", get type: " +
+        DataTypeStrings[static_cast<int>(GetMetaValueType(*pinned_value))]);
+  }
+  ParsedStringsValue parsed_strings_value(*pinned_value);
+  if (parsed_strings_value.IsStale()) {
+    pinned_value->Reset();
+    return Status::NotFound("Stale");
   }
+  return Status::OK();
+}
 
+Status Redis::Get(const Slice& key, rocksdb::PinnableSlice* pinned_value, Slice* value) {
+  *value = Slice();
+  Status s = PinStringsValue(key, pinned_value, true);
   if (s.ok()) {
-    ParsedStringsValue parsed_strings_value(value);
-    return HandleParsedStringsValue(parsed_strings_value, value, ttl_millsec);
+    ParsedStringsValue parsed_strings_value(*pinned_value);
+    *value = parsed_strings_value.UserValue();
+  }
+  return s;
+}
+
+Status Redis::GetWithTTL(const Slice& key, rocksdb::PinnableSlice* pinned_value, Slice* value,
+                         int64_t* ttl_millsec) {
+  *value = Slice();
+  Status s = PinStringsValue(key, pinned_value, true);
+  if (s.ok()) {
+    ParsedStringsValue parsed_strings_value(*pinned_value);
+    *value = parsed_strings_value.UserValue();
+    int64_t expiry_time = parsed_strings_value.Etime();
+    *ttl_millsec = (expiry_time == 0) ? -1 : CalculateTTL(expiry_time);
   } else if (s.IsNotFound()) {
-    ClearValueAndSetTTL(value, ttl_millsec, -2);
+    *ttl_millsec = -2;
   }
+  return s;
+}
 
+Status Redis::Get(const Slice& key, std::string* value) {
+  rocksdb::PinnableSlice pinned_value;
+  Slice user_value;
+  Status s = Get(key, &pinned_value, &user_value);
+  value->assign(user_value.data(), user_value.size());
   return s;
 }
 
-Status Redis::MGetWithTTL(const Slice& key, std::string* value, int64_t* ttl_millsec) {
+Status Redis::MGet(const Slice& key, std::string* value) {
   value->clear();
-  BaseKey base_key(key);
-  Status s = db_->Get(default_read_options_, base_key.Encode(), value);
-  std::string meta_value = *value;
-
-  if (s.ok() && !ExpectedMetaValue(DataType::kStrings, meta_value)) {
-    s = Status::NotFound();
+  rocksdb::PinnableSlice pinned_value;
+  Status s = PinStringsValue(key, &pinned_value, false);
+  if (s.ok()) {
+    ParsedStringsValue parsed_strings_value(pinned_value);
+    Slice user_value = parsed_strings_value.UserValue();
+    value->assign(user_value.data(), user_value.size());
   }
+  return s;
+}
+
+Status Redis::GetWithTTL(const Slice& key, std::string* value, int64_t* ttl_millsec) {
+  rocksdb::PinnableSlice pinned_value;
+  Slice user_value;
+  Status s = GetWithTTL(key, &pinned_value, &user_value, ttl_millsec);
+  value->assign(user_value.data(), user_value.size());
+  return s;
+}
 
+Status Redis::MGetWithTTL(const Slice& key, std::string* value, int64_t* ttl_millsec) {
+  value->clear();
+  rocksdb::PinnableSlice pinned_value;
+  Status s = PinStringsValue(key, &pinned_value, false);
   if (s.ok()) {
-    ParsedStringsValue parsed_strings_value(value);
-    return HandleParsedStringsValue(parsed_strings_value, value, ttl_millsec);
+    ParsedStringsValue parsed_strings_value(pinned_value);
+    Slice user_value = parsed_strings_value.UserValue();
+    value->assign(user_value.data(), user_value.size());
+    int64_t expiry_time = parsed_strings_value.Etime();
+    *ttl_millsec = (expiry_time == 0) ? -1 : CalculateTTL(expiry_time);
   } else if (s.IsNotFound()) {
-    ClearValueAndSetTTL(value, ttl_millsec, -2);
+    *ttl_millsec = -2;
   }
-
   return s;
 }
 
+Status Redis::MGet(const std::vector<Slice>& keys, std::vector<ValueStatus>* vss) {
+  vss->clear();
+  std::vector<std::string> values;
+  std::vector<Status> statuses;
+  MultiGetMeta(keys, &values, &statuses);
+
+  vss->reserve(keys.size());
+  for (size_t idx = 0; idx < keys.size(); ++idx) {
+    Status& s = statuses[idx];
+    std::string& value = values[idx];
+    if (s.ok() && !ExpectedMetaValue(DataType::kStrings, value)) {
+      s = Status::NotFound();
+    }
+    if (s.ok()) {
+      ParsedStringsValue parsed_strings_value(&value);
+      if (parsed_strings_value.IsStale()) {
+        vss->push_back({std::string(), Status::NotFound()});
+      } else {
+        parsed_strings_value.StripSuffix();
+        vss->push_back({std::move(value), Status::OK()});
+      }
+    } else if (s.IsNotFound()) {
+      vss->push_back({std::string(), Status::NotFound()});
+    } else {
+      vss->clear();
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
+Status Redis::MGetWithTTL(const std::vector<Slice>& keys, std::vector<ValueStatus>* vss) {
+  vss->clear();
+  std::vector<std::string> values;
+  std::vector<Status> statuses;
+  MultiGetMeta(keys, &values, &statuses);
+
+  vss->reserve(keys.size());
+  for (size_t idx = 0; idx < keys.size(); ++idx) {
+    Status& s = statuses[idx];
+    std::string& value = values[idx];
+    int64_t ttl_millsec = -2;
+    if (s.ok() && !ExpectedMetaValue(DataType::kStrings, value)) {
+      s = Status::NotFound();
+    }
+    if (s.ok()) {
+      ParsedStringsValue parsed_strings_value(&value);
+      if (HandleParsedStringsValue(parsed_strings_value, &value, &ttl_millsec).ok()) {
+        vss->push_back({std::move(value), Status::OK(), ttl_millsec});
+      } else {
+        vss->push_back({std::string(), Status::NotFound(), ttl_millsec});
+      }
+    } else if (s.IsNotFound()) {
+      vss->push_back({std::string(), Status::NotFound(), ttl_millsec});
+    } else {
+      vss->clear();
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
 Status Redis::GetBit(const Slice& key, int64_t offset, int32_t* ret) {
   std::string meta_value;
 
@@ -533,7 +532,7 @@ Status Redis::GetrangeWithValue(const Slice& key, int64_t start_offset, int64_t
   *ret = "";
   BaseKey base_key(key);
   Status s = db_->Get(default_read_options_, base_key.Encode(), value);
-  std::string meta_value = *value;
+  const std::string& meta_value = *value;
   if (s.ok() && !ExpectedMetaValue(DataType::kStrings, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -594,7 +593,7 @@ Status Redis::GetSet(const Slice& key, const Slice& value, std::string* old_valu
 
   BaseKey base_key(key);
   Status s = db_->Get(default_read_options_, base_key.Encode(), old_value);
-  std::string meta_value = *old_value;
+  const std::string& meta_value = *old_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kStrings, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -605,6 +604,8 @@ Status Redis::GetSet(const Slice& key, const Slice& value, std::string* old_valu
           DataTypeStrings[static_cast<int>(GetMetaValueType(meta_value))]);
     }
   }
+  // the meta as stored, old_value gets the user value
+  std::string old_meta = *old_value;
   if (s.ok()) {
     ParsedStringsValue parsed_strings_value(old_value);
     if (parsed_strings_value.IsStale()) {
@@ -616,7 +617,7 @@ Status Redis::GetSet(const Slice& key, const Slice& value, std::string* old_valu
     return s;
   }
   StringsValue strings_value(value);
-  return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+  return PutMeta(base_key.Encode(), old_meta, strings_value.Encode());
 }
 
 Status Redis::Incrby(const Slice& key, int64_t value, int64_t* ret, int64_t* expired_timestamp_millsec) {
@@ -641,7 +642,7 @@ Status Redis::Incrby(const Slice& key, int64_t value, int64_t* ret, int64_t* exp
       *ret = value;
       Int64ToStr(buf, 32, value);
       StringsValue strings_value(buf);
-      return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+      return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
     } else {
       uint64_t timestamp = parsed_strings_value.Etime();
       std::string old_user_value = parsed_strings_value.UserValue().ToString();
@@ -658,13 +659,13 @@ Status Redis::Incrby(const Slice& key, int64_t value, int64_t* ret, int64_t* exp
       StringsValue strings_value(new_value);
       strings_value.SetEtime(timestamp);
       *expired_timestamp_millsec = timestamp;
-      return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+      return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
     }
   } else if (s.IsNotFound()) {
     *ret = value;
     Int64ToStr(buf, 32, value);
     StringsValue strings_value(buf);
-    return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+    return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
   } else {
     return s;
   }
@@ -698,7 +699,7 @@ Status Redis::Incrbyfloat(const Slice& key, const Slice& value, std::string* ret
       LongDoubleToStr(long_double_by, &new_value);
       *ret = new_value;
       StringsValue strings_value(new_value);
-      return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+      return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
     } else {
       uint64_t timestamp = parsed_strings_value.Etime();
       std::string old_user_value = parsed_strings_value.UserValue().ToString();
@@ -715,13 +716,13 @@ Status Redis::Incrbyfloat(const Slice& key, const Slice& value, std::string* ret
       StringsValue strings_value(new_value);
       strings_value.SetEtime(timestamp);
       *expired_timestamp_sec = timestamp;
-      return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+      return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
     }
   } else if (s.IsNotFound()) {
     LongDoubleToStr(long_double_by, &new_value);
     *ret = new_value;
     StringsValue strings_value(new_value);
-    return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+    return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
   } else {
     return s;
   }
@@ -735,37 +736,116 @@ Status Redis::MSet(const std::vector<KeyValue>& kvs) {
   }
 
   MultiScopeRecordLock ml(lock_mgr_, keys);
-  rocksdb::WriteBatch batch;
-  for (const auto& kv : kvs) {
-    BaseKey base_key(kv.key);
-    StringsValue strings_value(kv.value);
-    batch.Put(base_key.Encode(), strings_value.Encode());
-  }
-  return db_->Write(default_write_options_, &batch);
+  return MSetWithoutLock(kvs);
 }
 
 Status Redis::MSetnx(const std::vector<KeyValue>& kvs, int32_t* ret) {
-  Status s;
-  bool exists = false;
   *ret = 0;
+  std::vector<std::string> keys;
+  keys.reserve(kvs.size());
+  for (const auto& kv : kvs) {
+    keys.push_back(kv.key);
+  }
+
+  // the existence check and the write share one locked window,
+  // otherwise a concurrent writer could create a key in between
+  MultiScopeRecordLock ml(lock_mgr_, keys);
+  bool exists = false;
+  Status s = AnyKeyExistsWithoutLock(kvs, &exists);
+  if (!s.ok() || exists) {
+    return s;
+  }
+  s = MSetWithoutLock(kvs);
+  if (s.ok()) {
+    *ret = 1;
+  }
+  return s;
+}
+
+Status Redis::AnyKeyExistsWithoutLock(const std::vector<KeyValue>& kvs, bool* exists) {
+  *exists = false;
   std::string value;
-  for (const auto & kv : kvs) {
+  for (const auto& kv : kvs) {
     BaseKey base_key(kv.key);
-    s = db_->Get(default_read_options_, base_key.Encode(), &value);
+    Status s = db_->Get(default_read_options_, base_key.Encode(), &value);
     if (!s.ok() && !s.IsNotFound()) {
       return s;
     }
     if (s.ok() && !ExpectedStale(value)) {
-      exists = true;
+      *exists = true;
       break;
     }
     // when reaches here, either s is not found or s is ok but expired
   }
-  if (!exists) {
-    s = MSet(kvs);
-    if (s.ok()) {
-      *ret = 1;
+  return Status::OK();
+}
+
+Status Redis::MSetWithoutLock(const std::vector<KeyValue>& kvs) {
+  // all keys share one WriteBatch, so they reach the WAL with a single
+  // write and readers never observe a partially applied MSET
+  rocksdb::WriteBatch batch;
+  for (const auto& kv : kvs) {
+    BaseKey base_key(kv.key);
+    StringsValue strings_value(kv.value);
+    batch.Put(base_key.Encode(), strings_value.Encode());
+  }
+  return WriteWithKeyCounters(&batch);
+}
+
+Status Redis::ApplyStagedWrites(const std::vector<StagedWrite*>& writes) {
+  std::vector<std::string> keys;
+  keys.reserve(writes.size());
+  for (const auto* write : writes) {
+    keys.push_back(write->key);
+  }
+  MultiScopeRecordLock ml(lock_mgr_, keys);
+
+  rocksdb::WriteBatch batch;
+  // meta keys and old metas of the hashes, for WriteWithKeyCounters
+  std::vector<std::string> meta_keys;
+  std::vector<std::string> old_meta_values;
+  std::vector<std::pair<StagedWrite*, uint32_t>> statistics;
+  for (auto* write : writes) {
+    if (write->type == StagedWrite::kSet) {
+      BaseKey base_key(write->key);
+      StringsValue strings_value(write->value);
+      batch.Put(handles_[kMetaCF], base_key.Encode(), strings_value.Encode());
+      write->status = Status::OK();
+      continue;
+    }
+    // a write that fails its checks takes its own puts back out
+    batch.SetSavePoint();
+    std::string old_meta;
+    int32_t new_fields = 0;
+    uint32_t statistic = 0;
+    write->status = HMSetToBatch(write->key, write->fvs, &batch, &old_meta, &new_fields, &statistic);
+    if (!write->status.ok()) {
+      batch.RollbackToSavePoint();
+      continue;
+    }
+    batch.PopSavePoint();
+    write->ret = new_fields;
+    meta_keys.push_back(BaseMetaKey(write->key).Encode().ToString());
+    old_meta_values.push_back(std::move(old_meta));
+    statistics.emplace_back(write, statistic);
+  }
+
+  std::vector<OldMeta> old_metas;
+  old_metas.reserve(meta_keys.size());
+  for (size_t idx = 0; idx < meta_keys.size(); ++idx) {
+    old_metas.emplace_back(meta_keys[idx], old_meta_values[idx]);
+  }
+  Status s = WriteWithKeyCounters(&batch, old_metas);
+  if (!s.ok()) {
+    for (auto* write : writes) {
+      if (write->status.ok()) {
+        write->status = s;
+      }
     }
+    return s;
+  }
+  for (const auto& [write, statistic] : statistics) {
+    UpdateSpecificKeyStatistics(DataType::kHashes, write->key, statistic);
   }
   return s;
 }
@@ -775,7 +855,7 @@ Status Redis::Set(const Slice& key, const Slice& value) {
   ScopeRecordLock l(lock_mgr_, key);
 
   BaseKey base_key(key);
-  return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+  return PutMeta(base_key.Encode(), strings_value.Encode());
 }
 
 Status Redis::Setxx(const Slice& key, const Slice& value, int32_t* ret, int64_t ttl_millsec) {
@@ -813,7 +893,7 @@ Status Redis::Setxx(const Slice& key, const Slice& value, int32_t* ret, int64_t
     if (ttl_millsec > 0) {
       strings_value.SetRelativeTimeInMillsec(ttl_millsec);
     }
-    return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+    return PutMeta(base_key.Encode(), old_value, strings_value.Encode());
   }
 }
 
@@ -870,7 +950,7 @@ Status Redis::SetBit(const Slice& key, int64_t offset, int32_t on, int32_t* ret)
     }
     StringsValue strings_value(data_value);
     strings_value.SetEtime(timestamp);
-    return db_->Put(rocksdb::WriteOptions(), base_key.Encode(), strings_value.Encode());
+    return PutMeta(base_key.Encode(), meta_value, strings_value.Encode());
   } else {
     return s;
   }
@@ -888,7 +968,7 @@ Status Redis::Setex(const Slice& key, const Slice& value, int64_t ttl_millsec) {
 
   BaseKey base_key(key);
   ScopeRecordLock l(lock_mgr_, key);
-  return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+  return PutMeta(base_key.Encode(), strings_value.Encode());
 }
 
 Status Redis::Setnx(const Slice& key, const Slice& value, int32_t* ret, int64_t ttl_millsec) {
@@ -911,7 +991,7 @@ Status Redis::Setnx(const Slice& key, const Slice& value, int32_t* ret, int64_t
   if (ttl_millsec > 0) {
     strings_value.SetRelativeTimeInMillsec(ttl_millsec);
   }
-  s = db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+  s = PutMeta(base_key.Encode(), old_value, strings_value.Encode());
   if (s.ok()) {
     *ret = 1;
   }
@@ -946,7 +1026,7 @@ Status Redis::Setvx(const Slice& key, const Slice& value, const Slice& new_value
         if (ttl_millsec > 0) {
           strings_value.SetRelativeTimeInMillsec(ttl_millsec);
         }
-        s = db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+        s = PutMeta(base_key.Encode(), old_value, strings_value.Encode());
         if (!s.ok()) {
           return s;
         }
@@ -988,7 +1068,7 @@ Status Redis::Delvx(const Slice& key, const Slice& value, int32_t* ret) {
     } else {
       if (value.compare(parsed_strings_value.UserValue()) == 0) {
         *ret = 1;
-        return db_->Delete(default_write_options_, base_key.Encode());
+        return DeleteMeta(base_key.Encode(), old_value);
       } else {
         *ret = -1;
       }
@@ -1019,6 +1099,8 @@ Status Redis::Setrange(const Slice& key, int64_t start_offset, const Slice& valu
         DataTypeStrings[static_cast<int>(GetMetaValueType(old_value))]);
     }
   }
+  // the meta as stored, old_value gets the user value
+  std::string old_meta = old_value;
   if (s.ok()) {
     uint64_t timestamp = 0;
     ParsedStringsValue parsed_strings_value(&old_value);
@@ -1044,13 +1126,13 @@ Status Redis::Setrange(const Slice& key, int64_t start_offset, const Slice& valu
     *ret = static_cast<int32_t>(new_value.length());
     StringsValue strings_value(new_value);
     strings_value.SetEtime(timestamp);
-    return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+    return PutMeta(base_key.Encode(), old_meta, strings_value.Encode());
   } else if (s.IsNotFound()) {
     std::string tmp(start_offset, '\0');
     new_value = tmp.append(value.data());
     *ret = static_cast<int32_t>(new_value.length());
     StringsValue strings_value(new_value);
-    return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+    return PutMeta(base_key.Encode(), old_meta, strings_value.Encode());
   }
   return s;
 }
@@ -1067,49 +1149,12 @@ Status Redis::Strlen(const Slice& key, int32_t* len) {
 }
 
 int32_t GetBitPos(const unsigned char* s, unsigned int bytes, int bit) {
-  uint64_t word = 0;
-  uint64_t skip_val = 0;
-  auto value = const_cast<unsigned char*>(s);
-  auto l = reinterpret_cast<uint64_t*>(value);
-  int pos = 0;
-  if (bit == 0) {
-    skip_val = std::numeric_limits<uint64_t>::max();
-  } else {
-    skip_val = 0;
-  }
-  // skip 8 bytes at one time, find the first int64 that should not be skipped
-  while (bytes >= sizeof(*l)) {
-    if (*l != skip_val) {
-      break;
-    }
-    l++;
-    bytes = bytes - sizeof(*l);
-    pos += static_cast<int32_t>(8 * sizeof(*l));
-  }
-  auto c = reinterpret_cast<unsigned char*>(l);
-  for (size_t j = 0; j < sizeof(*l); j++) {
-    word = word << 8;
-    if (bytes != 0U) {
-      word = word | *c;
-      c++;
-      bytes--;
-    }
+  int64_t pos = pstd::BitPos(s, bytes, bit);
+  if (pos == -1 && bit == 0) {
+    // a clear bit is found right after the end, callers check for it
+    pos = static_cast<int64_t>(bytes) * 8;
   }
-  if (bit == 1 && word == 0) {
-    return -1;
-  }
-  // set each bit of mask to 0 except msb
-  uint64_t mask = std::numeric_limits<uint64_t>::max();
-  mask = mask >> 1;
-  mask = ~(mask);
-  while (mask != 0U) {
-    if (static_cast<int>((word & mask) != 0) == bit) {
-      return pos;
-    }
-    pos++;
-    mask = mask >> 1;
-  }
-  return pos;
+  return static_cast<int32_t>(pos);
 }
 
 Status Redis::BitPos(const Slice& key, int32_t bit, int64_t* ret) {
@@ -1297,7 +1342,7 @@ Status Redis::PKSetexAt(const Slice& key, const Slice& value, int64_t time_stamp
   BaseKey base_key(key);
   ScopeRecordLock l(lock_mgr_, key);
   strings_value.SetEtime(uint64_t(time_stamp_millsec_));
-  return db_->Put(default_write_options_, base_key.Encode(), strings_value.Encode());
+  return PutMeta(base_key.Encode(), strings_value.Encode());
 }
 
 Status Redis::StringsExpire(const Slice& key, int64_t ttl_millsec, std::string&& prefetch_meta) {
@@ -1328,9 +1373,9 @@ Status Redis::StringsExpire(const Slice& key, int64_t ttl_millsec, std::string&&
     }
     if (ttl_millsec > 0) {
       parsed_strings_value.SetRelativeTimestamp(ttl_millsec);
-      return db_->Put(default_write_options_, base_key.Encode(), value);
+      return PutMeta(base_key.Encode(), value);
     } else {
-      return db_->Delete(default_write_options_, base_key.Encode());
+      return DeleteMeta(base_key.Encode());
     }
   }
   return s;
@@ -1362,7 +1407,7 @@ Status Redis::StringsDel(const Slice& key, std::string&& prefetch_meta) {
     if (parsed_strings_value.IsStale()) {
       return Status::NotFound("Stale");
     }
-    return db_->Delete(default_write_options_, base_key.Encode());
+    return DeleteMeta(base_key.Encode());
   }
   return s;
 }
@@ -1395,9 +1440,9 @@ Status Redis::StringsExpireat(const Slice& key, int64_t timestamp_millsec, std::
     } else {
       if (timestamp_millsec > 0) {
         parsed_strings_value.SetEtime(static_cast<uint64_t>(timestamp_millsec));
-        return db_->Put(default_write_options_, base_key.Encode(), value);
+        return PutMeta(base_key.Encode(), value);
       } else {
-        return db_->Delete(default_write_options_, base_key.Encode());
+        return DeleteMeta(base_key.Encode());
       }
     }
   }
@@ -1435,7 +1480,7 @@ Status Redis::StringsPersist(const Slice& key, std::string&& prefetch_meta) {
         return Status::NotFound("Not have an associated timeout");
       } else {
         parsed_strings_value.SetEtime(0);
-        return db_->Put(default_write_options_, base_key.Encode(), value);
+        return PutMeta(base_key.Encode(), value);
       }
     }
   }
@@ -1494,7 +1539,7 @@ void Redis::ScanStrings() {
   LOG(INFO) << "***************" << "rocksdb instance: " << index_ << " " << "String Data***************";
   auto iter = db_->NewIterator(iterator_options);
   for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kStrings, iter->value().ToString())) {
+    if (!ExpectedMetaValue(DataType::kStrings, iter->value())) {
       continue;
     }
     ParsedBaseKey parsed_strings_key(iter->key());
@@ -1570,6 +1615,82 @@ rocksdb::Status Redis::Del(const Slice& key) {
   return rocksdb::Status::NotFound();
 }
 
+rocksdb::Status Redis::Exists(const std::vector<Slice>& keys, int64_t* count) {
+  *count = 0;
+  std::vector<std::string> meta_values;
+  std::vector<rocksdb::Status> statuses;
+  MultiGetMeta(keys, &meta_values, &statuses);
+
+  for (size_t idx = 0; idx < keys.size(); ++idx) {
+    rocksdb::Status& s = statuses[idx];
+    if (s.IsNotFound()) {
+      continue;
+    } else if (!s.ok()) {
+      return s;
+    }
+    auto type = static_cast<DataType>(static_cast<uint8_t>(meta_values[idx][0]));
+    if (type == DataType::kStreams) {
+      // stream liveness is not encoded in the meta value, use the single key path
+      s = Exists(keys[idx]);
+      if (s.ok()) {
+        (*count)++;
+      } else if (!s.IsNotFound()) {
+        return s;
+      }
+    } else if (!ExpectedStale(meta_values[idx])) {
+      (*count)++;
+    }
+  }
+  return rocksdb::Status::OK();
+}
+
+rocksdb::Status Redis::Del(const std::vector<Slice>& keys, int64_t* count) {
+  *count = 0;
+  std::vector<std::string> meta_values;
+  std::vector<rocksdb::Status> statuses;
+  MultiGetMeta(keys, &meta_values, &statuses);
+
+  // same as the single key Del, the prefetched meta value is handed
+  // over to the type specific delete, a key repeated in the batch must
+  // only be deleted and counted once
+  std::unordered_set<std::string> deleted_keys;
+  for (size_t idx = 0; idx < keys.size(); ++idx) {
+    if (!statuses[idx].ok() || !deleted_keys.insert(keys[idx].ToString()).second) {
+      continue;
+    }
+    const Slice& key = keys[idx];
+    rocksdb::Status s;
+    auto type = static_cast<DataType>(static_cast<uint8_t>(meta_values[idx][0]));
+    switch (type) {
+      case DataType::kSets:
+        s = SetsDel(key, std::move(meta_values[idx]));
+        break;
+      case DataType::kZSets:
+        s = ZsetsDel(key, std::move(meta_values[idx]));
+        break;
+      case DataType::kHashes:
+        s = HashesDel(key, std::move(meta_values[idx]));
+        break;
+      case DataType::kLists:
+        s = ListsDel(key, std::move(meta_values[idx]));
+        break;
+      case DataType::kStrings:
+        s = StringsDel(key, std::move(meta_values[idx]));
+        break;
+      case DataType::kStreams:
+        s = StreamsDel(key, std::move(meta_values[idx]));
+        break;
+      default:
+        s = rocksdb::Status::NotFound();
+        break;
+    }
+    if (s.ok()) {
+      (*count)++;
+    }
+  }
+  return rocksdb::Status::OK();
+}
+
 rocksdb::Status Redis::Expire(const Slice& key, int64_t ttl_millsec) {
   std::string meta_value;
   BaseMetaKey base_meta_key(key);
@@ -1689,78 +1810,123 @@ rocksdb::Status Redis::IsExist(const storage::Slice& key) {
   return rocksdb::Status::NotFound();
 }
 
-/*
- * Example Delete the specified prefix key
- */
-rocksdb::Status Redis::PKPatternMatchDelWithRemoveKeys(const std::string& pattern, int64_t* ret, std::vector<std::string>* remove_keys, const int64_t& max_count) {
-  rocksdb::ReadOptions iterator_options;
-  const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
-  iterator_options.snapshot = snapshot;
-  iterator_options.fill_cache = false;
+namespace {
+
+// a matching key and the write that deletes it
+struct PatternMatchDel {
+  std::string meta_key;
+  std::string user_key;
+  std::string meta_value;  // empty deletes the meta
+};
+
+Status MatchMetaRange(rocksdb::DB* db, rocksdb::ReadOptions read_options, rocksdb::ColumnFamilyHandle* cf,
+                      const MetaRange& range, const std::string& pattern, int64_t max_count,
+                      std::vector<PatternMatchDel>* dels) {
+  Slice lower(range.lower);
+  Slice upper(range.upper);
+  read_options.iterate_lower_bound = range.lower.empty() ? nullptr : &lower;
+  read_options.iterate_upper_bound = range.upper.empty() ? nullptr : &upper;
 
-  std::string key;
   std::string meta_value;
-  int64_t total_delete = 0;
-  rocksdb::Status s;
-  rocksdb::WriteBatch batch;
-  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
-  iter->SeekToFirst();
-  while (iter->Valid() && static_cast<int64_t>(batch.Count()) < max_count) {
+  std::unique_ptr<rocksdb::Iterator> iter(db->NewIterator(read_options, cf));
+  for (range.lower.empty() ? iter->SeekToFirst() : iter->Seek(lower);
+       iter->Valid() && static_cast<int64_t>(dels->size()) < max_count; iter->Next()) {
+    if (IsMetaMarker(iter->key())) {
+      continue;
+    }
     auto meta_type = static_cast<enum DataType>(static_cast<uint8_t>(iter->value()[0]));
-    ParsedBaseMetaKey parsed_meta_key(iter->key().ToString());
-    key = iter->key().ToString();
+    ParsedBaseMetaKey parsed_meta_key(iter->key());
+    if (StringMatch(pattern.data(), pattern.size(), parsed_meta_key.Key().data(), parsed_meta_key.Key().size(), 0) ==
+        0) {
+      continue;
+    }
     meta_value = iter->value().ToString();
 
     if (meta_type == DataType::kStrings) {
       ParsedStringsValue parsed_strings_value(&meta_value);
-      if (!parsed_strings_value.IsStale() &&
-          (StringMatch(pattern.data(), pattern.size(), parsed_meta_key.Key().data(), parsed_meta_key.Key().size(), 0) != 0)) {
-        batch.Delete(key);
-        remove_keys->push_back(parsed_meta_key.Key().data());
+      if (parsed_strings_value.IsStale()) {
+        continue;
       }
+      meta_value.clear();
     } else if (meta_type == DataType::kLists) {
       ParsedListsMetaValue parsed_lists_meta_value(&meta_value);
-      if (!parsed_lists_meta_value.IsStale() && (parsed_lists_meta_value.Count() != 0U) &&
-          (StringMatch(pattern.data(), pattern.size(), parsed_meta_key.Key().data(), parsed_meta_key.Key().size(), 0) !=
-           0)) {
-        parsed_lists_meta_value.InitialMetaValue();
-        batch.Put(handles_[kMetaCF], iter->key(), meta_value);
-        remove_keys->push_back(parsed_meta_key.Key().data());
+      if (parsed_lists_meta_value.IsStale() || parsed_lists_meta_value.Count() == 0U) {
+        continue;
       }
+      parsed_lists_meta_value.InitialMetaValue();
     } else if (meta_type == DataType::kStreams) {
       StreamMetaValue stream_meta_value;
       stream_meta_value.ParseFrom(meta_value);
-      if ((stream_meta_value.length() != 0) &&
-          (StringMatch(pattern.data(), pattern.size(), parsed_meta_key.Key().data(), parsed_meta_key.Key().size(), 0) != 0)) {
-        stream_meta_value.InitMetaValue();
-        batch.Put(handles_[kMetaCF], key, stream_meta_value.value());
-        remove_keys->push_back(parsed_meta_key.Key().data());
+      if (stream_meta_value.length() == 0) {
+        continue;
       }
+      stream_meta_value.InitMetaValue();
+      meta_value = stream_meta_value.value();
     } else {
       ParsedBaseMetaValue parsed_meta_value(&meta_value);
-      if (!parsed_meta_value.IsStale() && (parsed_meta_value.Count() != 0) &&
-          (StringMatch(pattern.data(), pattern.size(), parsed_meta_key.Key().data(), parsed_meta_key.Key().size(), 0) !=
-           0)) {
-        parsed_meta_value.InitialMetaValue();
-        batch.Put(handles_[kMetaCF], iter->key(), meta_value);
-        remove_keys->push_back(parsed_meta_key.Key().data());
+      if (parsed_meta_value.IsStale() || parsed_meta_value.Count() == 0) {
+        continue;
       }
+      parsed_meta_value.InitialMetaValue();
     }
-    iter->Next();
+    dels->push_back({iter->key().ToString(), parsed_meta_key.Key().ToString(), std::move(meta_value)});
   }
-  if (batch.Count() != 0U) {
-    s = db_->Write(default_write_options_, &batch);
-    if (s.ok()) {
-      total_delete += static_cast<int64_t>(batch.Count());
-      batch.Clear();
-    } else {
-      remove_keys->erase(remove_keys->end() - batch.Count(), remove_keys->end());
+  return iter->status();
+}
+
+}  // namespace
+
+/*
+ * Example Delete the specified prefix key
+ */
+rocksdb::Status Redis::PKPatternMatchDelWithRemoveKeys(const std::string& pattern, int64_t* ret, std::vector<std::string>* remove_keys, const int64_t& max_count) {
+  *ret = 0;
+  rocksdb::ReadOptions iterator_options;
+  const rocksdb::Snapshot* snapshot;
+  ScopeSnapshot ss(db_, &snapshot);
+  iterator_options.snapshot = snapshot;
+  iterator_options.fill_cache = false;
+
+  std::string lower;
+  std::string upper;
+  MetaKeyPrefixBounds(PatternPrefix(pattern), &lower, &upper);
+  size_t threads = storage_->GetKeyspaceScanThreads();
+  std::vector<MetaRange> ranges;
+  SplitMetaRange(lower, upper, threads, &ranges);
+  // every range may find max_count keys, the first max_count in key order are deleted
+  std::vector<std::vector<PatternMatchDel>> range_dels(ranges.size());
+  rocksdb::Status s = storage_->GetKeyspaceScanPool()->Run(ranges.size(), [&](size_t idx) {
+    return MatchMetaRange(db_, iterator_options, handles_[kMetaCF], ranges[idx], pattern, max_count, &range_dels[idx]);
+  });
+  if (!s.ok()) {
+    return s;
+  }
+
+  int64_t total_delete = 0;
+  rocksdb::WriteBatch batch;
+  for (auto& dels : range_dels) {
+    for (auto& del : dels) {
+      if (total_delete == max_count) {
+        break;
+      }
+      if (del.meta_value.empty()) {
+        batch.Delete(del.meta_key);
+      } else {
+        batch.Put(handles_[kMetaCF], del.meta_key, del.meta_value);
+      }
+      remove_keys->push_back(std::move(del.user_key));
+      total_delete++;
+    }
+  }
+  if (total_delete != 0) {
+    s = WriteWithKeyCounters(&batch);
+    if (!s.ok()) {
+      remove_keys->erase(remove_keys->end() - total_delete, remove_keys->end());
+      total_delete = 0;
     }
   }
 
   *ret = total_delete;
-  delete iter;
   return s;
 }
 
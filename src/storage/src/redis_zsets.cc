@@ -10,6 +10,7 @@
 #include <map>
 #include <memory>
 #include <iostream>
+#include <queue>
 
 #include <glog/logging.h>
 #include <fmt/core.h>
@@ -20,49 +21,11 @@
 #include "src/scope_record_lock.h"
 #include "src/scope_snapshot.h"
 #include "src/zsets_filter.h"
+#include "src/zsets_rank_index.h"
 #include "src/redis.h"
 #include "storage/util.h"
 
 namespace storage {
-Status Redis::ScanZsetsKeyNum(KeyInfo* key_info) {
-  uint64_t keys = 0;
-  uint64_t expires = 0;
-  uint64_t ttl_sum = 0;
-  uint64_t invaild_keys = 0;
-
-  rocksdb::ReadOptions iterator_options;
-  const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
-  iterator_options.snapshot = snapshot;
-  iterator_options.fill_cache = false;
-
-  pstd::TimeType curtime = pstd::NowMillis();
-
-  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
-  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kZSets, iter->value().ToString())) {
-      continue;
-    }
-    ParsedZSetsMetaValue parsed_zsets_meta_value(iter->value());
-    if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.Count() == 0) {
-      invaild_keys++;
-    } else {
-      keys++;
-      if (!parsed_zsets_meta_value.IsPermanentSurvival()) {
-        expires++;
-        ttl_sum += parsed_zsets_meta_value.Etime() - curtime;
-      }
-    }
-  }
-  delete iter;
-
-  key_info->keys = keys;
-  key_info->expires = expires;
-  key_info->avg_ttl = (expires != 0) ? ttl_sum / expires : 0;
-  key_info->invaild_keys = invaild_keys;
-  return Status::OK();
-}
-
 Status Redis::ZPopMax(const Slice& key, const int64_t count, std::vector<ScoreMember>* score_members) {
   uint32_t statistic = 0;
   score_members->clear();
@@ -72,6 +35,7 @@ Status Redis::ZPopMax(const Slice& key, const int64_t count, std::vector<ScoreMe
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -94,6 +58,9 @@ Status Redis::ZPopMax(const Slice& key, const int64_t count, std::vector<ScoreMe
       uint64_t version = parsed_zsets_meta_value.Version();
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
+      bool rank_indexed = parsed_zsets_meta_value.RankIndexed();
+      ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], default_read_options_, key,
+                                version);
       rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[kZsetsScoreCF]);
       int32_t del_cnt = 0;
       for (iter->SeekForPrev(zsets_score_key.Encode()); iter->Valid() && del_cnt < num; iter->Prev()) {
@@ -105,14 +72,23 @@ Status Redis::ZPopMax(const Slice& key, const int64_t count, std::vector<ScoreMe
         ++del_cnt;
         batch.Delete(handles_[kZsetsDataCF], zsets_member_key.Encode());
         batch.Delete(handles_[kZsetsScoreCF], iter->key());
+        if (rank_indexed) {
+          rank_index.DelMember(parsed_zsets_score_key.score(), parsed_zsets_score_key.member());
+        }
       }
       delete iter;
       if (!parsed_zsets_meta_value.CheckModifyCount(-del_cnt)) {
         return Status::InvalidArgument("zset size overflow");
       }
+      if (rank_indexed) {
+        s = rank_index.Update(&batch);
+        if (!s.ok()) {
+          return s;
+        }
+      }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
-      s = db_->Write(default_write_options_, &batch);
+      s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
       UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
       return s;
     }
@@ -130,6 +106,7 @@ Status Redis::ZPopMin(const Slice& key, const int64_t count, std::vector<ScoreMe
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -152,6 +129,9 @@ Status Redis::ZPopMin(const Slice& key, const int64_t count, std::vector<ScoreMe
       uint64_t version = parsed_zsets_meta_value.Version();
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
+      bool rank_indexed = parsed_zsets_meta_value.RankIndexed();
+      ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], default_read_options_, key,
+                                version);
       rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[kZsetsScoreCF]);
       int32_t del_cnt = 0;
       for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && del_cnt < num; iter->Next()) {
@@ -163,14 +143,23 @@ Status Redis::ZPopMin(const Slice& key, const int64_t count, std::vector<ScoreMe
         ++del_cnt;
         batch.Delete(handles_[kZsetsDataCF], zsets_member_key.Encode());
         batch.Delete(handles_[kZsetsScoreCF], iter->key());
+        if (rank_indexed) {
+          rank_index.DelMember(parsed_zsets_score_key.score(), parsed_zsets_score_key.member());
+        }
       }
       delete iter;
       if (!parsed_zsets_meta_value.CheckModifyCount(-del_cnt)) {
         return Status::InvalidArgument("zset size overflow");
       }
+      if (rank_indexed) {
+        s = rank_index.Update(&batch);
+        if (!s.ok()) {
+          return s;
+        }
+      }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
-      s = db_->Write(default_write_options_, &batch);
+      s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
       UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
       return s;
     }
@@ -199,6 +188,7 @@ Status Redis::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_membe
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -218,10 +208,17 @@ Status Redis::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_membe
     } else {
       vaild = true;
       version = parsed_zsets_meta_value.Version();
+      s = ZsetsBuildRankIndexIfNeeded(key, &parsed_zsets_meta_value, meta_value);
+      if (!s.ok()) {
+        return s;
+      }
     }
 
     int32_t cnt = 0;
     std::string data_value;
+    bool rank_indexed = vaild && parsed_zsets_meta_value.RankIndexed();
+    ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], default_read_options_, key,
+                              version);
     for (const auto& sm : filtered_score_members) {
       bool not_found = true;
       ZSetsMemberKey zsets_member_key(key, version, sm.member);
@@ -239,6 +236,9 @@ Status Redis::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_membe
           } else {
             ZSetsScoreKey zsets_score_key(key, version, old_score, sm.member);
             batch.Delete(handles_[kZsetsScoreCF], zsets_score_key.Encode());
+            if (rank_indexed) {
+              rank_index.DelMember(old_score, sm.member);
+            }
             // delete old zsets_score_key and overwirte zsets_member_key
             // but in different column_families so we accumulative 1
             statistic++;
@@ -256,6 +256,9 @@ Status Redis::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_membe
       ZSetsScoreKey zsets_score_key(key, version, sm.score, sm.member);
       BaseDataValue zsets_score_i_val(Slice{});
       batch.Put(handles_[kZsetsScoreCF], zsets_score_key.Encode(), zsets_score_i_val.Encode());
+      if (rank_indexed) {
+        rank_index.AddMember(sm.score, sm.member);
+      }
       if (not_found) {
         cnt++;
       }
@@ -263,6 +266,12 @@ Status Redis::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_membe
     if (!parsed_zsets_meta_value.CheckModifyCount(cnt)) {
       return Status::InvalidArgument("zset size overflow");
     }
+    if (rank_indexed) {
+      s = rank_index.Update(&batch);
+      if (!s.ok()) {
+        return s;
+      }
+    }
     parsed_zsets_meta_value.ModifyCount(cnt);
     batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
     *ret = cnt;
@@ -287,7 +296,7 @@ Status Redis::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_membe
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
   return s;
 }
@@ -401,6 +410,9 @@ Status Redis::ZIncrby(const Slice& key, const Slice& member, double increment, d
   *ret = 0;
   uint32_t statistic = 0;
   double score = 0;
+  double old_score = 0;
+  bool score_replaced = false;
+  bool rank_indexed = false;
   char score_buf[8];
   uint64_t version = 0;
   std::string meta_value;
@@ -409,6 +421,7 @@ Status Redis::ZIncrby(const Slice& key, const Slice& member, double increment, d
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -425,6 +438,11 @@ Status Redis::ZIncrby(const Slice& key, const Slice& member, double increment, d
       version = parsed_zsets_meta_value.InitialMetaValue();
     } else {
       version = parsed_zsets_meta_value.Version();
+      s = ZsetsBuildRankIndexIfNeeded(key, &parsed_zsets_meta_value, meta_value);
+      if (!s.ok()) {
+        return s;
+      }
+      rank_indexed = parsed_zsets_meta_value.RankIndexed();
     }
     std::string data_value;
     ZSetsMemberKey zsets_member_key(key, version, member);
@@ -434,8 +452,9 @@ Status Redis::ZIncrby(const Slice& key, const Slice& member, double increment, d
       parsed_value.StripSuffix();
       uint64_t tmp = DecodeFixed64(data_value.data());
       const void* ptr_tmp = reinterpret_cast<const void*>(&tmp);
-      double old_score = *reinterpret_cast<const double*>(ptr_tmp);
+      old_score = *reinterpret_cast<const double*>(ptr_tmp);
       score = old_score + increment;
+      score_replaced = true;
       ZSetsScoreKey zsets_score_key(key, version, old_score, member);
       batch.Delete(handles_[kZsetsScoreCF], zsets_score_key.Encode());
       // delete old zsets_score_key and overwirte zsets_member_key
@@ -470,8 +489,20 @@ Status Redis::ZIncrby(const Slice& key, const Slice& member, double increment, d
   ZSetsScoreKey zsets_score_key(key, version, score, member);
   BaseDataValue zsets_score_i_val(Slice{});
   batch.Put(handles_[kZsetsScoreCF], zsets_score_key.Encode(), zsets_score_i_val.Encode());
+  if (rank_indexed) {
+    ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], default_read_options_, key,
+                              version);
+    if (score_replaced) {
+      rank_index.DelMember(old_score, member);
+    }
+    rank_index.AddMember(score, member);
+    s = rank_index.Update(&batch);
+    if (!s.ok()) {
+      return s;
+    }
+  }
   *ret = score;
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
   return s;
 }
@@ -514,18 +545,16 @@ Status Redis::ZRange(const Slice& key, int32_t start, int32_t stop, std::vector<
       if (start_index > stop_index || start_index >= count || stop_index < 0) {
         return s;
       }
-      int32_t cur_index = 0;
       ScoreMember score_member;
-      ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
-      for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
-        if (cur_index >= start_index) {
-          ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
-          score_member.score = parsed_zsets_score_key.score();
-          score_member.member = parsed_zsets_score_key.member().ToString();
-          score_members->push_back(score_member);
-        }
+      s = ZsetsSeekToRank(key, version, parsed_zsets_meta_value.RankIndexed(), read_options, iter, start_index);
+      for (int32_t cur_index = start_index; s.ok() && iter->Valid() && cur_index <= stop_index;
+           iter->Next(), ++cur_index) {
+        ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
+        score_member.score = parsed_zsets_score_key.score();
+        score_member.member = parsed_zsets_score_key.member().ToString();
+        score_members->push_back(score_member);
       }
       delete iter;
     }
@@ -582,21 +611,17 @@ Status Redis::ZRangeWithTTL(const Slice& key, int32_t start, int32_t stop, std::
           || stop_index < 0) {
         return s;
       }
-      int32_t cur_index = 0;
       ScoreMember score_member;
-      ZSetsScoreKey zsets_score_key(key, version,
-                                    std::numeric_limits<double>::lowest(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
-      for (iter->Seek(zsets_score_key.Encode());
-           iter->Valid() && cur_index <= stop_index;
+      s = ZsetsSeekToRank(key, version, parsed_zsets_meta_value.RankIndexed(), read_options, iter, start_index);
+      for (int32_t cur_index = start_index;
+           s.ok() && iter->Valid() && cur_index <= stop_index;
            iter->Next(), ++cur_index) {
-        if (cur_index >= start_index) {
-          ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
-          score_member.score = parsed_zsets_score_key.score();
-          score_member.member = parsed_zsets_score_key.member().ToString();
-          score_members->push_back(score_member);
-        }
+        ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
+        score_member.score = parsed_zsets_score_key.score();
+        score_member.member = parsed_zsets_score_key.member().ToString();
+        score_members->push_back(score_member);
       }
       delete iter;
     }
@@ -714,9 +739,12 @@ Status Redis::ZRank(const Slice& key, const Slice& member, int32_t* rank) {
       uint64_t version = parsed_zsets_meta_value.Version();
       int32_t index = 0;
       int32_t stop_index = parsed_zsets_meta_value.Count() - 1;
+      KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
+      if (parsed_zsets_meta_value.RankIndexed()) {
+        return ZsetsRankOfMember(key, version, read_options, member, rank);
+      }
       ScoreMember score_member;
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
-      KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
       for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && index <= stop_index; iter->Next(), ++index) {
         ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
@@ -755,6 +783,7 @@ Status Redis::ZRem(const Slice& key, const std::vector<std::string>& members, in
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -775,6 +804,9 @@ Status Redis::ZRem(const Slice& key, const std::vector<std::string>& members, in
       int32_t del_cnt = 0;
       std::string data_value;
       uint64_t version = parsed_zsets_meta_value.Version();
+      bool rank_indexed = parsed_zsets_meta_value.RankIndexed();
+      ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], default_read_options_, key,
+                                version);
       for (const auto& member : filtered_members) {
         ZSetsMemberKey zsets_member_key(key, version, member);
         s = db_->Get(default_read_options_, handles_[kZsetsDataCF], zsets_member_key.Encode(), &data_value);
@@ -790,6 +822,9 @@ Status Redis::ZRem(const Slice& key, const std::vector<std::string>& members, in
 
           ZSetsScoreKey zsets_score_key(key, version, score, member);
           batch.Delete(handles_[kZsetsScoreCF], zsets_score_key.Encode());
+          if (rank_indexed) {
+            rank_index.DelMember(score, member);
+          }
         } else if (!s.IsNotFound()) {
           return s;
         }
@@ -798,13 +833,19 @@ Status Redis::ZRem(const Slice& key, const std::vector<std::string>& members, in
       if (!parsed_zsets_meta_value.CheckModifyCount(-del_cnt)) {
         return Status::InvalidArgument("zset size overflow");
       }
+      if (rank_indexed) {
+        s = rank_index.Update(&batch);
+        if (!s.ok()) {
+          return s;
+        }
+      }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
     }
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
   return s;
 }
@@ -818,6 +859,7 @@ Status Redis::ZRemrangebyrank(const Slice& key, int32_t start, int32_t stop, int
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -837,7 +879,6 @@ Status Redis::ZRemrangebyrank(const Slice& key, int32_t start, int32_t stop, int
     } else {
       std::string member;
       int32_t del_cnt = 0;
-      int32_t cur_index = 0;
       int32_t count = parsed_zsets_meta_value.Count();
       uint64_t version = parsed_zsets_meta_value.Version();
       int32_t start_index = start >= 0 ? start : count + start;
@@ -847,31 +888,45 @@ Status Redis::ZRemrangebyrank(const Slice& key, int32_t start, int32_t stop, int
       if (start_index > stop_index || start_index >= count) {
         return s;
       }
-      ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
+      bool rank_indexed = parsed_zsets_meta_value.RankIndexed();
+      ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], default_read_options_, key,
+                                version);
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
       rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[kZsetsScoreCF]);
-      for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
-        if (cur_index >= start_index) {
-          ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
-          ZSetsMemberKey zsets_member_key(key, version, parsed_zsets_score_key.member());
-          batch.Delete(handles_[kZsetsDataCF], zsets_member_key.Encode());
-          batch.Delete(handles_[kZsetsScoreCF], iter->key());
-          del_cnt++;
-          statistic++;
+      s = ZsetsSeekToRank(key, version, rank_indexed, default_read_options_, iter, start_index);
+      for (int32_t cur_index = start_index; s.ok() && iter->Valid() && cur_index <= stop_index;
+           iter->Next(), ++cur_index) {
+        ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
+        ZSetsMemberKey zsets_member_key(key, version, parsed_zsets_score_key.member());
+        batch.Delete(handles_[kZsetsDataCF], zsets_member_key.Encode());
+        batch.Delete(handles_[kZsetsScoreCF], iter->key());
+        if (rank_indexed) {
+          rank_index.DelMember(parsed_zsets_score_key.score(), parsed_zsets_score_key.member());
         }
+        del_cnt++;
+        statistic++;
       }
       delete iter;
+      if (!s.ok()) {
+        return s;
+      }
       *ret = del_cnt;
       if (!parsed_zsets_meta_value.CheckModifyCount(-del_cnt)) {
         return Status::InvalidArgument("zset size overflow");
       }
+      if (rank_indexed) {
+        s = rank_index.Update(&batch);
+        if (!s.ok()) {
+          return s;
+        }
+      }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
     }
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
   return s;
 }
@@ -886,6 +941,7 @@ Status Redis::ZRemrangebyscore(const Slice& key, double min, double max, bool le
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -908,6 +964,9 @@ Status Redis::ZRemrangebyscore(const Slice& key, double min, double max, bool le
       int32_t cur_index = 0;
       int32_t stop_index = parsed_zsets_meta_value.Count() - 1;
       uint64_t version = parsed_zsets_meta_value.Version();
+      bool rank_indexed = parsed_zsets_meta_value.RankIndexed();
+      ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], default_read_options_, key,
+                                version);
       ZSetsScoreKey zsets_score_key(key, version, min, Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
       rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[kZsetsScoreCF]);
@@ -933,6 +992,9 @@ Status Redis::ZRemrangebyscore(const Slice& key, double min, double max, bool le
           ZSetsMemberKey zsets_member_key(key, version, parsed_zsets_score_key.member());
           batch.Delete(handles_[kZsetsDataCF], zsets_member_key.Encode());
           batch.Delete(handles_[kZsetsScoreCF], iter->key());
+          if (rank_indexed) {
+            rank_index.DelMember(parsed_zsets_score_key.score(), parsed_zsets_score_key.member());
+          }
           del_cnt++;
           statistic++;
         }
@@ -945,13 +1007,19 @@ Status Redis::ZRemrangebyscore(const Slice& key, double min, double max, bool le
       if (!parsed_zsets_meta_value.CheckModifyCount(-del_cnt)) {
         return Status::InvalidArgument("zset size overflow");
       }
+      if (rank_indexed) {
+        s = rank_index.Update(&batch);
+        if (!s.ok()) {
+          return s;
+        }
+      }
       parsed_zsets_meta_value.ModifyCount(-del_cnt);
       batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
     }
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
   return s;
 }
@@ -999,8 +1067,13 @@ Status Redis::ZRevrange(const Slice& key, int32_t start, int32_t stop, std::vect
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
-      for (iter->SeekForPrev(zsets_score_key.Encode()); iter->Valid() && cur_index >= start_index;
-           iter->Prev(), --cur_index) {
+      if (parsed_zsets_meta_value.RankIndexed()) {
+        cur_index = stop_index;
+        s = ZsetsSeekToRank(key, version, true, read_options, iter, stop_index);
+      } else {
+        iter->SeekForPrev(zsets_score_key.Encode());
+      }
+      for (; s.ok() && iter->Valid() && cur_index >= start_index; iter->Prev(), --cur_index) {
         if (cur_index <= stop_index) {
           ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
           score_member.score = parsed_zsets_score_key.score();
@@ -1124,8 +1197,15 @@ Status Redis::ZRevrank(const Slice& key, const Slice& member, int32_t* rank) {
       int32_t rev_index = 0;
       int32_t left = parsed_zsets_meta_value.Count();
       uint64_t version = parsed_zsets_meta_value.Version();
-      ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
+      if (parsed_zsets_meta_value.RankIndexed()) {
+        s = ZsetsRankOfMember(key, version, read_options, member, &rev_index);
+        if (s.ok()) {
+          *rank = parsed_zsets_meta_value.Count() - 1 - rev_index;
+        }
+        return s;
+      }
+      ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
       for (iter->SeekForPrev(zsets_score_key.Encode()); iter->Valid() && left > 0; iter->Prev(), --left, ++rev_index) {
         ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
@@ -1238,21 +1318,210 @@ Status Redis::ZGetAll(const Slice& key, double weight, std::map<std::string, dou
   return s;
 }
 
+namespace {
+
+// destination members written per batch by ZUNIONSTORE and ZINTERSTORE
+const size_t kZsetsStoreBatchSize = 512;
+
+// Walks the members of one zset with their weighted scores. The data keys
+// only differ in the member and the all zero reserve2 after it, so they
+// come in member order
+class ZSetsMemberCursor {
+ public:
+  ZSetsMemberCursor(rocksdb::Iterator* iter, const KeyVersion& zset, double weight)
+      : iter_(iter), zset_(zset), weight_(weight) {
+    ZSetsMemberKey zsets_member_key(zset_.key, zset_.version, Slice());
+    prefix_ = zsets_member_key.EncodeSeekKey().ToString();
+    iter_->Seek(prefix_);
+    Load();
+  }
+
+  bool Valid() const { return valid_; }
+  const std::string& member() const { return member_; }
+  double score() const { return score_; }
+  Status status() const { return iter_->status(); }
+
+  void Next() {
+    iter_->Next();
+    Load();
+  }
+
+  // moves to the first member not less than member
+  void Seek(const std::string& member) {
+    ZSetsMemberKey zsets_member_key(zset_.key, zset_.version, member);
+    iter_->Seek(zsets_member_key.Encode());
+    Load();
+  }
+
+ private:
+  void Load() {
+    valid_ = iter_->Valid() && iter_->key().starts_with(prefix_);
+    if (valid_) {
+      ParsedZSetsMemberKey parsed_zsets_member_key(iter_->key());
+      member_.assign(parsed_zsets_member_key.member().data(), parsed_zsets_member_key.member().size());
+      ParsedBaseDataValue parsed_value(iter_->value());
+      uint64_t tmp = DecodeFixed64(parsed_value.UserValue().data());
+      const void* ptr_tmp = reinterpret_cast<const void*>(&tmp);
+      score_ = weight_ * *reinterpret_cast<const double*>(ptr_tmp);
+    }
+  }
+
+  std::unique_ptr<rocksdb::Iterator> iter_;
+  KeyVersion zset_;
+  double weight_;
+  std::string prefix_;
+  std::string member_;
+  double score_ = 0;
+  bool valid_ = false;
+};
+
+double Aggregate(AGGREGATE agg, double score, double other) {
+  switch (agg) {
+    case SUM:
+      return score + other;
+    case MIN:
+      return std::min(score, other);
+    case MAX:
+      return std::max(score, other);
+  }
+  return score;
+}
+
+}  // namespace
+
+Status Redis::ZsetsStoreBegin(const Slice& destination, ZsetsStore* store, uint32_t* statistic) {
+  BaseMetaKey base_destination(destination);
+  std::string& meta_value = store->meta_value;
+  // the meta the batches are written against, not the one of the snapshot
+  Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_destination.Encode(), &meta_value);
+  store->found_meta = s.ok() ? meta_value : std::string();
+  store->old_meta = store->found_meta;
+  if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
+    if (ExpectedStale(meta_value)) {
+      s = Status::NotFound();
+    } else {
+      return Status::InvalidArgument(
+        "WRONGTYPE, key: " + destination.ToString() + ", expected type: " +
+        DataTypeStrings[static_cast<int>(DataType::kZSets)] + ", got type: " +
+        DataTypeStrings[static_cast<int>(GetMetaValueType(meta_value))]);
+    }
+  }
+  if (s.ok()) {
+    ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
+    *statistic = parsed_zsets_meta_value.Count();
+    store->version = parsed_zsets_meta_value.InitialMetaValue();
+  } else if (s.IsNotFound()) {
+    char buf[4];
+    EncodeFixed32(buf, 0);
+    ZSetsMetaValue zsets_meta_value(DataType::kZSets, Slice(buf, 4));
+    store->version = zsets_meta_value.UpdateVersion();
+    meta_value = zsets_meta_value.Encode().ToString();
+  } else {
+    return s;
+  }
+  return Status::OK();
+}
+
+Status Redis::ZsetsStoreMember(const Slice& destination, const std::string& member, double score,
+                               ZsetsStore* store) {
+  char score_buf[8];
+  ZSetsMemberKey zsets_member_key(destination, store->version, member);
+  const void* ptr_score = reinterpret_cast<const void*>(&score);
+  EncodeFixed64(score_buf, *reinterpret_cast<const uint64_t*>(ptr_score));
+  BaseDataValue member_i_val(Slice(score_buf, sizeof(uint64_t)));
+  store->batch.Put(handles_[kZsetsDataCF], zsets_member_key.Encode(), member_i_val.Encode());
+
+  ZSetsScoreKey zsets_score_key(destination, store->version, score, member);
+  BaseDataValue score_i_val(Slice{});
+  store->batch.Put(handles_[kZsetsScoreCF], zsets_score_key.Encode(), score_i_val.Encode());
+
+  if (store->batch.Count() >= 2 * kZsetsStoreBatchSize) {
+    return ZsetsStoreFlush(destination, store);
+  }
+  return Status::OK();
+}
+
+/*
+ * The data filters drop a member when the meta of its key is missing, of
+ * another type, expired or of a newer version. The destination record lock
+ * is held for the whole store, so the meta filter keeps the pending meta
+ * even while it is an empty zset. A live zset with a TTL stays readable
+ * without the TTL until the store ends, anything else reads as missing as
+ * before.
+ */
+Status Redis::ZsetsStoreFlush(const Slice& destination, ZsetsStore* store) {
+  if (!store->pending) {
+    bool protects = false;
+    std::string pending_meta = store->meta_value;
+    if (!store->old_meta.empty() && ExpectedMetaValue(DataType::kZSets, store->old_meta)) {
+      std::string stored_meta = store->old_meta;
+      ParsedZSetsMetaValue parsed_zsets_meta_value(&stored_meta);
+      if (parsed_zsets_meta_value.Etime() == 0) {
+        protects = true;
+      } else if (!parsed_zsets_meta_value.IsStale() && parsed_zsets_meta_value.Count() != 0) {
+        parsed_zsets_meta_value.SetEtime(0);
+        pending_meta = stored_meta;
+      }
+    }
+    if (!protects) {
+      BaseMetaKey base_destination(destination);
+      Status s = PutMeta(base_destination.Encode(), store->old_meta, pending_meta);
+      if (!s.ok()) {
+        return s;
+      }
+      store->old_meta = pending_meta;
+    }
+    store->pending = true;
+  }
+  // no meta refers to the version yet, the members need no key counters
+  Status s = db_->Write(default_write_options_, &store->batch);
+  store->batch.Clear();
+  return s;
+}
+
+Status Redis::ZsetsStoreEnd(const Slice& destination, size_t count, ZsetsStore* store) {
+  ParsedZSetsMetaValue parsed_zsets_meta_value(&store->meta_value);
+  if (!parsed_zsets_meta_value.check_set_count(count)) {
+    return Status::InvalidArgument("zset size overflow");
+  }
+  parsed_zsets_meta_value.SetCount(static_cast<int32_t>(count));
+  BaseMetaKey base_destination(destination);
+  store->batch.Put(handles_[kMetaCF], base_destination.Encode(), store->meta_value);
+  return WriteWithKeyCounters(&store->batch, {{base_destination.Encode(), store->old_meta}});
+}
+
+void Redis::ZsetsStoreAbort(const Slice& destination, ZsetsStore* store) {
+  if (!store->pending || store->old_meta == store->found_meta) {
+    return;
+  }
+  BaseMetaKey base_destination(destination);
+  Status s = store->found_meta.empty() ? DeleteMeta(base_destination.Encode(), store->old_meta)
+                                       : PutMeta(base_destination.Encode(), store->old_meta, store->found_meta);
+  if (!s.ok()) {
+    LOG(WARNING) << "restore the meta of " << destination.ToString() << " failed, " << s.ToString();
+  }
+}
+
+/*
+ * Merges the inputs in member order and writes every member of the union
+ * as soon as all the inputs holding it were seen, the inputs are never
+ * loaded whole
+ */
 Status Redis::ZUnionstore(const Slice& destination, const std::vector<std::string>& keys,
                                const std::vector<double>& weights, const AGGREGATE agg, std::map<std::string, double>& value_to_dest, int32_t* ret) {
   *ret = 0;
+  value_to_dest.clear();
   uint32_t statistic = 0;
-  rocksdb::WriteBatch batch;
+  ZsetsStore store;
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot = nullptr;
 
-  uint64_t version;
   std::string meta_value;
-  ScoreMember sm;
   ScopeSnapshot ss(db_, &snapshot);
   read_options.snapshot = snapshot;
   ScopeRecordLock l(lock_mgr_, destination);
-  std::map<std::string, double> member_score_map;
+  std::vector<std::unique_ptr<KeyStatisticsDurationGuard>> guards;
+  std::vector<std::unique_ptr<ZSetsMemberCursor>> cursors;
 
   Status s;
   for (size_t idx = 0; idx < keys.size(); ++idx) {
@@ -1271,94 +1540,82 @@ Status Redis::ZUnionstore(const Slice& destination, const std::vector<std::strin
     if (s.ok()) {
       ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
       if (!parsed_zsets_meta_value.IsStale() && parsed_zsets_meta_value.Count() != 0) {
-        int32_t cur_index = 0;
-        int32_t stop_index = parsed_zsets_meta_value.Count() - 1;
-        double score = 0;
         double weight = idx < weights.size() ? weights[idx] : 1;
-        version = parsed_zsets_meta_value.Version();
-        ZSetsScoreKey zsets_score_key(keys[idx], version, std::numeric_limits<double>::lowest(), Slice());
-        KeyStatisticsDurationGuard guard(this, DataType::kZSets, keys[idx]);
-        rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
-        for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index;
-             iter->Next(), ++cur_index) {
-          ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
-          sm.score = parsed_zsets_score_key.score();
-          sm.member = parsed_zsets_score_key.member().ToString();
-          if (member_score_map.find(sm.member) == member_score_map.end()) {
-            score = weight * sm.score;
-            member_score_map[sm.member] = (score == -0.0) ? 0 : score;
-          } else {
-            score = member_score_map[sm.member];
-            switch (agg) {
-              case SUM:
-                score += weight * sm.score;
-                break;
-              case MIN:
-                score = std::min(score, weight * sm.score);
-                break;
-              case MAX:
-                score = std::max(score, weight * sm.score);
-                break;
-            }
-            member_score_map[sm.member] = (score == -0.0) ? 0 : score;
-          }
-        }
-        delete iter;
+        guards.push_back(std::make_unique<KeyStatisticsDurationGuard>(this, DataType::kZSets, keys[idx]));
+        cursors.push_back(std::make_unique<ZSetsMemberCursor>(db_->NewIterator(read_options, handles_[kZsetsDataCF]),
+                                                              KeyVersion{keys[idx], parsed_zsets_meta_value.Version()},
+                                                              weight));
       }
     } else if (!s.IsNotFound()) {
       return s;
     }
   }
 
-  BaseMetaKey base_destination(destination);
-  s = db_->Get(read_options, handles_[kMetaCF], base_destination.Encode(), &meta_value);
-  if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
-    if (ExpectedStale(meta_value)) {
-      s = Status::NotFound();
-    } else {
-      return Status::InvalidArgument(
-        "WRONGTYPE, key: " + destination.ToString() + ", expected type: " +
-        DataTypeStrings[static_cast<int>(DataType::kZSets)] + ", got type: " +
-        DataTypeStrings[static_cast<int>(GetMetaValueType(meta_value))]);
+  s = ZsetsStoreBegin(destination, &store, &statistic);
+  if (!s.ok()) {
+    return s;
+  }
+
+  // the cursors of one member come out in key order, so the scores are
+  // aggregated in the order of the keys
+  auto greater = [&cursors](size_t a, size_t b) {
+    int cmp = cursors[a]->member().compare(cursors[b]->member());
+    return cmp > 0 || (cmp == 0 && a > b);
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+  for (size_t idx = 0; idx < cursors.size(); ++idx) {
+    if (cursors[idx]->Valid()) {
+      heap.push(idx);
+    }
+  }
+  std::string member;
+  while (!heap.empty()) {
+    size_t idx = heap.top();
+    heap.pop();
+    member = cursors[idx]->member();
+    double score = cursors[idx]->score();
+    score = (score == -0.0) ? 0 : score;
+    for (;;) {
+      cursors[idx]->Next();
+      if (cursors[idx]->Valid()) {
+        heap.push(idx);
+      }
+      if (heap.empty() || cursors[heap.top()]->member() != member) {
+        break;
+      }
+      idx = heap.top();
+      heap.pop();
+      score = Aggregate(agg, score, cursors[idx]->score());
+      score = (score == -0.0) ? 0 : score;
+    }
+    s = ZsetsStoreMember(destination, member, score, &store);
+    if (!s.ok()) {
+      ZsetsStoreAbort(destination, &store);
+      return s;
     }
+    value_to_dest.emplace_hint(value_to_dest.end(), member, score);
   }
-  if (s.ok()) {
-    ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
-    statistic = parsed_zsets_meta_value.Count();
-    version = parsed_zsets_meta_value.InitialMetaValue();
-    if (!parsed_zsets_meta_value.check_set_count(static_cast<int32_t>(member_score_map.size()))) {
-      return Status::InvalidArgument("zset size overflow");
+  for (const auto& cursor : cursors) {
+    if (!cursor->status().ok()) {
+      ZsetsStoreAbort(destination, &store);
+      return cursor->status();
     }
-    parsed_zsets_meta_value.SetCount(static_cast<int32_t>(member_score_map.size()));
-    batch.Put(handles_[kMetaCF], base_destination.Encode(), meta_value);
-  } else {
-    char buf[4];
-    EncodeFixed32(buf, member_score_map.size());
-    ZSetsMetaValue zsets_meta_value(DataType::kZSets, Slice(buf, 4));
-    version = zsets_meta_value.UpdateVersion();
-    batch.Put(handles_[kMetaCF], base_destination.Encode(), zsets_meta_value.Encode());
   }
 
-  char score_buf[8];
-  for (const auto& sm : member_score_map) {
-    ZSetsMemberKey zsets_member_key(destination, version, sm.first);
-
-    const void* ptr_score = reinterpret_cast<const void*>(&sm.second);
-    EncodeFixed64(score_buf, *reinterpret_cast<const uint64_t*>(ptr_score));
-    BaseDataValue member_i_val(Slice(score_buf, sizeof(uint64_t)));
-    batch.Put(handles_[kZsetsDataCF], zsets_member_key.Encode(), member_i_val.Encode());
-
-    ZSetsScoreKey zsets_score_key(destination, version, sm.second, sm.first);
-    BaseDataValue score_i_val(Slice{});
-    batch.Put(handles_[kZsetsScoreCF], zsets_score_key.Encode(), score_i_val.Encode());
+  s = ZsetsStoreEnd(destination, value_to_dest.size(), &store);
+  if (!s.ok()) {
+    ZsetsStoreAbort(destination, &store);
+    return s;
   }
-  *ret = static_cast<int32_t>(member_score_map.size());
-  s = db_->Write(default_write_options_, &batch);
+  *ret = static_cast<int32_t>(value_to_dest.size());
   UpdateSpecificKeyStatistics(DataType::kZSets, destination.ToString(), statistic);
-  value_to_dest = std::move(member_score_map);
   return s;
 }
 
+/*
+ * Leapfrogs the inputs in member order, the smallest one proposes the next
+ * member and the others seek to it, so the work follows the smallest input
+ */
 Status Redis::ZInterstore(const Slice& destination, const std::vector<std::string>& keys,
                                const std::vector<double>& weights, const AGGREGATE agg, std::vector<ScoreMember>& value_to_dest, int32_t* ret) {
   if (keys.empty()) {
@@ -1366,8 +1623,9 @@ Status Redis::ZInterstore(const Slice& destination, const std::vector<std::strin
   }
 
   *ret = 0;
+  value_to_dest.clear();
   uint32_t statistic = 0;
-  rocksdb::WriteBatch batch;
+  ZsetsStore store;
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot = nullptr;
   ScopeSnapshot ss(db_, &snapshot);
@@ -1375,16 +1633,11 @@ Status Redis::ZInterstore(const Slice& destination, const std::vector<std::strin
   ScopeRecordLock l(lock_mgr_, destination);
 
   std::string meta_value;
-  uint64_t version = 0;
   bool have_invalid_zsets = false;
-  ScoreMember item;
   std::vector<KeyVersion> valid_zsets;
-  std::vector<ScoreMember> score_members;
-  std::vector<ScoreMember> final_score_members;
+  std::vector<int32_t> counts;
   Status s;
 
-  int32_t cur_index = 0;
-  int32_t stop_index = 0;
   for (size_t idx = 0; idx < keys.size(); ++idx) {
     BaseMetaKey base_meta_key(keys[idx]);
     s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
@@ -1404,9 +1657,7 @@ Status Redis::ZInterstore(const Slice& destination, const std::vector<std::strin
         have_invalid_zsets = true;
       } else {
         valid_zsets.push_back({keys[idx], parsed_zsets_meta_value.Version()});
-        if (idx == 0) {
-          stop_index = parsed_zsets_meta_value.Count() - 1;
-        }
+        counts.push_back(parsed_zsets_meta_value.Count());
       }
     } else if (s.IsNotFound()) {
       have_invalid_zsets = true;
@@ -1415,102 +1666,80 @@ Status Redis::ZInterstore(const Slice& destination, const std::vector<std::strin
     }
   }
 
-  if (!have_invalid_zsets) {
-    ZSetsScoreKey zsets_score_key(valid_zsets[0].key, valid_zsets[0].version, std::numeric_limits<double>::lowest(), Slice());
-    KeyStatisticsDurationGuard guard(this, DataType::kZSets, valid_zsets[0].key);
-    rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
-    for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
-      ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
-      double score = parsed_zsets_score_key.score();
-      std::string member = parsed_zsets_score_key.member().ToString();
-      score_members.push_back({score, member});
-    }
-    delete iter;
+  s = ZsetsStoreBegin(destination, &store, &statistic);
+  if (!s.ok()) {
+    return s;
+  }
 
-    std::string data_value;
-    for (const auto& sm : score_members) {
-      bool reliable = true;
-      item.member = sm.member;
-      item.score = sm.score * (!weights.empty() ? weights[0] : 1);
-      for (size_t idx = 1; idx < valid_zsets.size(); ++idx) {
-        double weight = idx < weights.size() ? weights[idx] : 1;
-        ZSetsMemberKey zsets_member_key(valid_zsets[idx].key, valid_zsets[idx].version, item.member);
-        s = db_->Get(read_options, handles_[kZsetsDataCF], zsets_member_key.Encode(), &data_value);
-        if (s.ok()) {
-          ParsedBaseDataValue parsed_value(&data_value);
-          parsed_value.StripSuffix();
-          uint64_t tmp = DecodeFixed64(data_value.data());
-          const void* ptr_tmp = reinterpret_cast<const void*>(&tmp);
-          double score = *reinterpret_cast<const double*>(ptr_tmp);
-          switch (agg) {
-            case SUM:
-              item.score += weight * score;
-              break;
-            case MIN:
-              item.score = std::min(item.score, weight * score);
-              break;
-            case MAX:
-              item.score = std::max(item.score, weight * score);
-              break;
-          }
-        } else if (s.IsNotFound()) {
-          reliable = false;
+  if (!have_invalid_zsets) {
+    std::vector<std::unique_ptr<KeyStatisticsDurationGuard>> guards;
+    std::vector<std::unique_ptr<ZSetsMemberCursor>> cursors;
+    for (size_t idx = 0; idx < valid_zsets.size(); ++idx) {
+      double weight = idx < weights.size() ? weights[idx] : 1;
+      guards.push_back(std::make_unique<KeyStatisticsDurationGuard>(this, DataType::kZSets, valid_zsets[idx].key));
+      cursors.push_back(std::make_unique<ZSetsMemberCursor>(db_->NewIterator(read_options, handles_[kZsetsDataCF]),
+                                                            valid_zsets[idx], weight));
+    }
+    // the scores are aggregated in the order of the keys, the members are
+    // matched from the smallest input up
+    std::vector<size_t> order(cursors.size());
+    for (size_t idx = 0; idx < order.size(); ++idx) {
+      order[idx] = idx;
+    }
+    std::stable_sort(order.begin(), order.end(), [&counts](size_t a, size_t b) { return counts[a] < counts[b]; });
+
+    ZSetsMemberCursor* smallest = cursors[order[0]].get();
+    std::string member;
+    bool exhausted = false;
+    while (!exhausted && smallest->Valid()) {
+      member = smallest->member();
+      bool matched = true;
+      for (size_t pos = 1; pos < order.size(); ++pos) {
+        ZSetsMemberCursor* cursor = cursors[order[pos]].get();
+        if (cursor->member() < member) {
+          cursor->Seek(member);
+        }
+        if (!cursor->Valid()) {
+          exhausted = true;
+          matched = false;
           break;
-        } else {
-          return s;
         }
+        if (cursor->member() != member) {
+          smallest->Seek(cursor->member());
+          matched = false;
+          break;
+        }
+      }
+      if (!matched) {
+        continue;
+      }
+      double score = cursors[0]->score();
+      for (size_t idx = 1; idx < cursors.size(); ++idx) {
+        score = Aggregate(agg, score, cursors[idx]->score());
       }
-      if (reliable) {
-        final_score_members.push_back(item);
+      s = ZsetsStoreMember(destination, member, score, &store);
+      if (!s.ok()) {
+        ZsetsStoreAbort(destination, &store);
+        return s;
       }
+      value_to_dest.push_back({score, member});
+      smallest->Next();
     }
-  }
-
-  BaseMetaKey base_destination(destination);
-  s = db_->Get(read_options, handles_[kMetaCF], base_destination.Encode(), &meta_value);
-  if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
-    if (ExpectedStale(meta_value)) {
-      s = Status::NotFound();
-    } else {
-      return Status::InvalidArgument(
-        "WRONGTYPE, key: " + destination.ToString() + ", expected type: " +
-        DataTypeStrings[static_cast<int>(DataType::kZSets)] + ", got type: " +
-        DataTypeStrings[static_cast<int>(GetMetaValueType(meta_value))]);
+    for (const auto& cursor : cursors) {
+      if (!cursor->status().ok()) {
+        ZsetsStoreAbort(destination, &store);
+        return cursor->status();
+      }
     }
   }
-  if (s.ok()) {
-    ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
-    statistic = parsed_zsets_meta_value.Count();
-    version = parsed_zsets_meta_value.InitialMetaValue();
-    if (!parsed_zsets_meta_value.check_set_count(static_cast<int32_t>(final_score_members.size()))) {
-      return Status::InvalidArgument("zset size overflow");
-    }
-    parsed_zsets_meta_value.SetCount(static_cast<int32_t>(final_score_members.size()));
-    batch.Put(handles_[kMetaCF], base_destination.Encode(), meta_value);
-  } else {
-    char buf[4];
-    EncodeFixed32(buf, final_score_members.size());
-    ZSetsMetaValue zsets_meta_value(DataType::kZSets, Slice(buf, 4));
-    version = zsets_meta_value.UpdateVersion();
-    batch.Put(handles_[kMetaCF], base_destination.Encode(), zsets_meta_value.Encode());
-  }
-  char score_buf[8];
-  for (const auto& sm : final_score_members) {
-    ZSetsMemberKey zsets_member_key(destination, version, sm.member);
-
-    const void* ptr_score = reinterpret_cast<const void*>(&sm.score);
-    EncodeFixed64(score_buf, *reinterpret_cast<const uint64_t*>(ptr_score));
-    BaseDataValue member_i_val(Slice(score_buf, sizeof(uint64_t)));
-    batch.Put(handles_[kZsetsDataCF], zsets_member_key.Encode(), member_i_val.Encode());
 
-    ZSetsScoreKey zsets_score_key(destination, version, sm.score, sm.member);
-    BaseDataValue zsets_score_i_val(Slice{});
-    batch.Put(handles_[kZsetsScoreCF], zsets_score_key.Encode(), zsets_score_i_val.Encode());
+  s = ZsetsStoreEnd(destination, value_to_dest.size(), &store);
+  if (!s.ok()) {
+    ZsetsStoreAbort(destination, &store);
+    return s;
   }
-  *ret = static_cast<int32_t>(final_score_members.size());
-  s = db_->Write(default_write_options_, &batch);
+  *ret = static_cast<int32_t>(value_to_dest.size());
   UpdateSpecificKeyStatistics(DataType::kZSets, destination.ToString(), statistic);
-  value_to_dest = std::move(final_score_members);
   return s;
 }
 
@@ -1603,6 +1832,7 @@ Status Redis::ZRemrangebylex(const Slice& key, const Slice& min, const Slice& ma
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  std::string old_meta = meta_value;
   if (s.ok() && !ExpectedMetaValue(DataType::kZSets, meta_value)) {
     if (ExpectedStale(meta_value)) {
       s = Status::NotFound();
@@ -1621,6 +1851,8 @@ Status Redis::ZRemrangebylex(const Slice& key, const Slice& min, const Slice& ma
       uint64_t version = parsed_zsets_meta_value.Version();
       int32_t cur_index = 0;
       int32_t stop_index = parsed_zsets_meta_value.Count() - 1;
+      bool rank_indexed = parsed_zsets_meta_value.RankIndexed();
+      ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], read_options, key, version);
       ZSetsMemberKey zsets_member_key(key, version, Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
       rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsDataCF]);
@@ -1644,6 +1876,9 @@ Status Redis::ZRemrangebylex(const Slice& key, const Slice& min, const Slice& ma
           double score = *reinterpret_cast<const double*>(ptr_tmp);
           ZSetsScoreKey zsets_score_key(key, version, score, member);
           batch.Delete(handles_[kZsetsScoreCF], zsets_score_key.Encode());
+          if (rank_indexed) {
+            rank_index.DelMember(score, member);
+          }
           del_cnt++;
           statistic++;
         }
@@ -1652,6 +1887,12 @@ Status Redis::ZRemrangebylex(const Slice& key, const Slice& min, const Slice& ma
         }
       }
       delete iter;
+      if (rank_indexed) {
+        s = rank_index.Update(&batch);
+        if (!s.ok()) {
+          return s;
+        }
+      }
     }
     if (del_cnt > 0) {
       if (!parsed_zsets_meta_value.CheckModifyCount(-del_cnt)) {
@@ -1664,11 +1905,75 @@ Status Redis::ZRemrangebylex(const Slice& key, const Slice& min, const Slice& ma
   } else {
     return s;
   }
-  s = db_->Write(default_write_options_, &batch);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
   UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
   return s;
 }
 
+Status Redis::ZsetsBuildRankIndexIfNeeded(const Slice& key, ParsedZSetsMetaValue* parsed_zsets_meta_value,
+                                          const std::string& meta_value) {
+  uint64_t threshold = zset_rank_index_threshold_.load();
+  if (threshold == 0 || parsed_zsets_meta_value->RankIndexed() ||
+      static_cast<uint64_t>(parsed_zsets_meta_value->Count()) < threshold) {
+    return Status::OK();
+  }
+  // built under the key lock in its own batch, the command then keeps it
+  // up to date in its batch
+  rocksdb::WriteBatch batch;
+  ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], default_read_options_, key,
+                            parsed_zsets_meta_value->Version());
+  Status s = rank_index.Build(&batch);
+  if (!s.ok()) {
+    return s;
+  }
+  std::string old_meta = meta_value;
+  parsed_zsets_meta_value->SetRankIndexed(true);
+  BaseMetaKey base_meta_key(key);
+  batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+  s = WriteWithKeyCounters(&batch, {{base_meta_key.Encode(), old_meta}});
+  if (!s.ok()) {
+    parsed_zsets_meta_value->SetRankIndexed(false);
+  }
+  return s;
+}
+
+Status Redis::ZsetsSeekToRank(const Slice& key, uint64_t version, bool rank_indexed,
+                              const rocksdb::ReadOptions& read_options, rocksdb::Iterator* iter, int32_t rank) {
+  if (rank_indexed) {
+    ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], read_options, key, version);
+    return rank_index.Seek(iter, rank);
+  }
+  ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
+  iter->Seek(zsets_score_key.Encode());
+  for (int32_t cur_index = 0; iter->Valid() && cur_index < rank; ++cur_index) {
+    iter->Next();
+  }
+  return iter->status();
+}
+
+Status Redis::ZsetsRankOfMember(const Slice& key, uint64_t version, const rocksdb::ReadOptions& read_options,
+                                const Slice& member, int32_t* rank) {
+  std::string data_value;
+  ZSetsMemberKey zsets_member_key(key, version, member);
+  Status s = db_->Get(read_options, handles_[kZsetsDataCF], zsets_member_key.Encode(), &data_value);
+  if (!s.ok()) {
+    return s;
+  }
+  ParsedBaseDataValue parsed_value(&data_value);
+  parsed_value.StripSuffix();
+  uint64_t tmp = DecodeFixed64(data_value.data());
+  const void* ptr_tmp = reinterpret_cast<const void*>(&tmp);
+  double score = *reinterpret_cast<const double*>(ptr_tmp);
+
+  uint64_t index = 0;
+  ZSetsRankIndex rank_index(db_, handles_[kZsetsScoreCF], handles_[kZsetsRankCF], read_options, key, version);
+  s = rank_index.Rank(score, member, &index);
+  if (s.ok()) {
+    *rank = static_cast<int32_t>(index);
+  }
+  return s;
+}
+
 Status Redis::ZsetsExpire(const Slice& key, int64_t ttl_millsec, std::string&& prefetch_meta) {
   std::string meta_value(std::move(prefetch_meta));
   ScopeRecordLock l(lock_mgr_, key);
@@ -1703,7 +2008,7 @@ Status Redis::ZsetsExpire(const Slice& key, int64_t ttl_millsec, std::string&& p
     } else {
       parsed_zsets_meta_value.InitialMetaValue();
     }
-    s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+    s = PutMeta(base_meta_key.Encode(), meta_value);
   }
   return s;
 }
@@ -1738,7 +2043,7 @@ Status Redis::ZsetsDel(const Slice& key, std::string&& prefetch_meta) {
     } else {
       uint32_t statistic = parsed_zsets_meta_value.Count();
       parsed_zsets_meta_value.InitialMetaValue();
-      s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      s = PutMeta(base_meta_key.Encode(), meta_value);
       UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
     }
   }
@@ -1778,7 +2083,7 @@ Status Redis::ZsetsExpireat(const Slice& key, int64_t timestamp_millsec, std::st
       } else {
         parsed_zsets_meta_value.InitialMetaValue();
       }
-      return db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+      return PutMeta(base_meta_key.Encode(), meta_value);
     }
   }
   return s;
@@ -1903,7 +2208,7 @@ Status Redis::ZsetsPersist(const Slice& key, std::string&& prefetch_meta) {
         return Status::NotFound("Not have an associated timeout");
       } else {
         parsed_zsets_meta_value.SetEtime(0);
-        return db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+        return PutMeta(base_meta_key.Encode(), meta_value);
       }
     }
   }
@@ -1964,7 +2269,7 @@ void Redis::ScanZsets() {
   LOG(INFO) << "***************" << "rocksdb instance: " << index_ << " ZSets Meta Data***************";
   auto meta_iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
   for (meta_iter->SeekToFirst(); meta_iter->Valid(); meta_iter->Next()) {
-    if (!ExpectedMetaValue(DataType::kZSets, meta_iter->value().ToString())) {
+    if (!ExpectedMetaValue(DataType::kZSets, meta_iter->value())) {
       continue;
     }
     ParsedBaseMetaKey parsed_meta_key(meta_iter->key());
@@ -0,0 +1,116 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/slot_index_counts.h"
+
+#include <algorithm>
+#include <string>
+
+#include "pstd/include/pika_codis_slot.h"
+#include "src/base_key_format.h"
+#include "src/base_meta_value_format.h"
+#include "src/coding.h"
+#include "src/lists_meta_value_format.h"
+#include "src/pika_stream_meta_value.h"
+#include "src/slot_index_format.h"
+
+namespace storage {
+
+char SlotIndexCounts::IndexType(const Slice& meta_value) {
+  if (meta_value.empty()) {
+    return 0;
+  }
+  auto type = static_cast<DataType>(static_cast<uint8_t>(meta_value[0]));
+  switch (type) {
+    case DataType::kStrings:
+      break;
+    case DataType::kHashes:
+    case DataType::kSets:
+    case DataType::kZSets:
+      if (ParsedBaseMetaValue(meta_value).Count() == 0) {
+        return 0;
+      }
+      break;
+    case DataType::kLists:
+      if (ParsedListsMetaValue(meta_value).Count() == 0) {
+        return 0;
+      }
+      break;
+    case DataType::kStreams:
+      if (ParsedStreamMetaValue(meta_value).length() == 0) {
+        return 0;
+      }
+      break;
+    default:
+      return 0;
+  }
+  return DataTypeToTag(type);
+}
+
+void SlotIndexCounts::AddToBatch(const Deltas& deltas, rocksdb::ColumnFamilyHandle* cf, rocksdb::WriteBatch* batch) {
+  char buf[sizeof(int64_t)];
+  for (const auto& [slot_id, delta] : deltas) {
+    if (delta == 0) {
+      continue;
+    }
+    EncodeFixed64(buf, static_cast<uint64_t>(delta));
+    batch->Merge(cf, SlotIndexPrefix(kSlotIndexCountEntry, slot_id), Slice(buf, sizeof(buf)));
+  }
+}
+
+Status SlotIndexCounts::Read(rocksdb::DB* db, const rocksdb::ReadOptions& read_options,
+                             rocksdb::ColumnFamilyHandle* cf, uint32_t slot_id, int64_t* count) {
+  std::string value;
+  Status s = db->Get(read_options, cf, SlotIndexPrefix(kSlotIndexCountEntry, slot_id), &value);
+  *count = 0;
+  if (s.IsNotFound()) {
+    return Status::OK();
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  if (value.size() != sizeof(int64_t)) {
+    return Status::Corruption("slot index count of wrong size");
+  }
+  // the keys written while the index was off may be dropped without an entry
+  *count = std::max<int64_t>(0, static_cast<int64_t>(DecodeFixed64(value.data())));
+  return Status::OK();
+}
+
+void SlotIndexCounts::AddDropped(const Slice& meta_key, const Slice& meta_value) {
+  if (!Enabled() || IndexType(meta_value) == 0) {
+    return;
+  }
+  ParsedBaseMetaKey parsed_meta_key(meta_key);
+  uint32_t slot_id = GetSlotID(slot_num_, parsed_meta_key.Key().ToString());
+  std::lock_guard l(pending_mutex_);
+  pending_[slot_id] -= 1;
+  has_pending_ = true;
+}
+
+void SlotIndexCounts::AddPending(const Deltas& deltas) {
+  if (deltas.empty()) {
+    return;
+  }
+  std::lock_guard l(pending_mutex_);
+  for (const auto& [slot_id, delta] : deltas) {
+    pending_[slot_id] += delta;
+  }
+  has_pending_ = true;
+}
+
+SlotIndexCounts::Deltas SlotIndexCounts::TakePending() {
+  Deltas pending;
+  // writes check the flag alone until the compaction filter drops a meta
+  if (!has_pending_.load(std::memory_order_relaxed)) {
+    return pending;
+  }
+  std::lock_guard l(pending_mutex_);
+  pending.swap(pending_);
+  has_pending_ = false;
+  return pending;
+}
+
+}  //  namespace storage
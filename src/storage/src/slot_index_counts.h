@@ -0,0 +1,65 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_SLOT_INDEX_COUNTS_H_
+#define SRC_SLOT_INDEX_COUNTS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "rocksdb/db.h"
+#include "rocksdb/write_batch.h"
+
+namespace storage {
+
+using Status = rocksdb::Status;
+using Slice = rocksdb::Slice;
+
+/*
+ * The writes of an instance keep its slot index (see slot_index_format.h)
+ * in step with the metas: a key is in the index while its meta is stored
+ * and not emptied, without looking at the clock, like the keyspace
+ * counters. WriteWithKeyCounters puts and deletes the entries of the keys a
+ * batch creates and drops, and merges the changes of the slot counts, in
+ * that same batch.
+ *
+ * The slot counts of the metas dropped by the meta compaction filter are
+ * kept here and merged with the next batch. Their entries are left behind,
+ * the migration that finds the key gone removes them. A writer replacing a
+ * meta the filter dropped doesn't take it off the count again, see
+ * key_counters.h.
+ */
+class SlotIndexCounts {
+ public:
+  using Deltas = std::unordered_map<uint32_t, int64_t>;
+
+  void SetEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  void SetSlotNum(int slot_num) { slot_num_ = slot_num; }
+  int SlotNum() const { return slot_num_; }
+
+  // the key type tag the index keeps for a meta, 0 for a meta not indexed
+  static char IndexType(const Slice& meta_value);
+  static void AddToBatch(const Deltas& deltas, rocksdb::ColumnFamilyHandle* cf, rocksdb::WriteBatch* batch);
+  static Status Read(rocksdb::DB* db, const rocksdb::ReadOptions& read_options, rocksdb::ColumnFamilyHandle* cf,
+                     uint32_t slot_id, int64_t* count);
+
+  // the slot of a meta key the meta compaction filter dropped
+  void AddDropped(const Slice& meta_key, const Slice& meta_value);
+  void AddPending(const Deltas& deltas);
+  Deltas TakePending();
+
+ private:
+  std::atomic<bool> enabled_{false};
+  int slot_num_ = 1024;
+  std::mutex pending_mutex_;
+  Deltas pending_;
+  std::atomic<bool> has_pending_{false};
+};
+
+}  //  namespace storage
+#endif  // SRC_SLOT_INDEX_COUNTS_H_
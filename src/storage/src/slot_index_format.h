@@ -0,0 +1,54 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_SLOT_INDEX_FORMAT_H_
+#define SRC_SLOT_INDEX_FORMAT_H_
+
+#include <string>
+
+#include "rocksdb/slice.h"
+
+namespace storage {
+
+using Slice = rocksdb::Slice;
+
+/*
+ * Codis slot index, stored in slot_index_cf of the instance holding the slot
+ *
+ * | 's' | slot id | key |  =>  | type |     every key of the slot
+ * | 't' | tag crc | key |  =>  | type |     every key with this hash tag
+ * | 'c' | slot id |       =>  | count |    number of keys of the slot
+ * |  1B |    4B   |              1B  |  8B |
+ *
+ * The ids are big endian, so the entries of one slot (or one tag) are
+ * adjacent and sorted by key. type is the key type tag the legacy
+ * `_internal:slotkey:4migrate:` sets kept in front of every member.
+ */
+const char kSlotIndexSlotEntry = 's';
+const char kSlotIndexTagEntry = 't';
+const char kSlotIndexCountEntry = 'c';
+const size_t kSlotIndexPrefixLength = 5;
+
+inline std::string SlotIndexPrefix(char kind, uint32_t id) {
+  std::string prefix(kSlotIndexPrefixLength, kind);
+  prefix[1] = static_cast<char>((id >> 24) & 0xff);
+  prefix[2] = static_cast<char>((id >> 16) & 0xff);
+  prefix[3] = static_cast<char>((id >> 8) & 0xff);
+  prefix[4] = static_cast<char>(id & 0xff);
+  return prefix;
+}
+
+inline std::string SlotIndexKey(char kind, uint32_t id, const Slice& key) {
+  std::string index_key = SlotIndexPrefix(kind, id);
+  index_key.append(key.data(), key.size());
+  return index_key;
+}
+
+inline Slice SlotIndexUserKey(const Slice& index_key) {
+  return Slice(index_key.data() + kSlotIndexPrefixLength, index_key.size() - kSlotIndexPrefixLength);
+}
+
+}  //  namespace storage
+#endif  // SRC_SLOT_INDEX_FORMAT_H_
@@ -11,12 +11,14 @@
 #include "storage/util.h"
 #include "storage/storage.h"
 #include "scope_snapshot.h"
+#include "src/scope_record_lock.h"
 #include "src/lru_cache.h"
 #include "src/mutex_impl.h"
 #include "src/options_helper.h"
 #include "src/redis_hyperloglog.h"
 #include "src/type_iterator.h"
 #include "src/redis.h"
+#include "src/keyspace_scan.h"
 #include "include/pika_conf.h"
 #include "pstd/include/pika_codis_slot.h"
 
@@ -56,6 +58,7 @@ Storage::Storage(int db_instance_num, int slot_num, bool is_classic_mode) {
   cursors_store_ = std::make_unique<LRUCache<std::string, std::string>>();
   cursors_store_->SetCapacity(5000);
   slot_indexer_ = std::make_unique<SlotIndexer>(db_instance_num);
+  keyspace_scan_pool_ = std::make_unique<KeyspaceScanPool>(4);
   is_classic_mode_ = is_classic_mode;
   db_instance_num_ = db_instance_num;
   slot_num_ = slot_num;
@@ -100,6 +103,8 @@ rocksdb::WriteOptions Storage::GetDefaultWriteOptions(const int idx) const {
 Status Storage::Open(const StorageOptions& storage_options, const std::string& db_path) {
   mkpath(db_path.c_str(), 0755);
 
+  SetKeyspaceScanThreads(storage_options.keyspace_scan_threads);
+  enable_expire_index_ = storage_options.enable_expire_index;
   int inst_count = db_instance_num_;
   for (int index = 0; index < inst_count; index++) {
     insts_.emplace_back(std::make_unique<Redis>(this, index));
@@ -107,6 +112,14 @@ Status Storage::Open(const StorageOptions& storage_options, const std::string& d
     if (!s.ok()) {
       LOG(FATAL) << "open db failed" << s.ToString();
     }
+    // data written before the keyspace counters existed
+    if (!insts_.back()->KeyCountersReconciled()) {
+      AddBGTask({DataType::kNones, kReconcileKeyCounters, {std::to_string(index)}});
+    }
+    // keys that got a TTL while the expiry index was off
+    if (enable_expire_index_ && !insts_.back()->ExpireIndexBackfilled()) {
+      AddBGTask({DataType::kNones, kBackfillExpireIndex, {std::to_string(index)}});
+    }
   }
 
   is_opened_.store(true);
@@ -140,6 +153,43 @@ std::unique_ptr<Redis>& Storage::GetDBInstance(const std::string& key) {
   return insts_[inst_index];
 }
 
+std::unique_ptr<Redis>& Storage::GetSlotInstance(uint32_t slot_id) {
+  return insts_[slot_indexer_->GetInstanceID(slot_id)];
+}
+
+void Storage::GroupKeysByInstance(const std::vector<std::string>& keys,
+                                  std::vector<std::vector<size_t>>* inst_key_positions,
+                                  std::vector<std::vector<Slice>>* inst_keys) {
+  inst_key_positions->assign(insts_.size(), {});
+  inst_keys->assign(insts_.size(), {});
+  for (size_t pos = 0; pos < keys.size(); ++pos) {
+    auto inst_index = slot_indexer_->GetInstanceID(GetSlotID(slot_num_, keys[pos]));
+    (*inst_key_positions)[inst_index].push_back(pos);
+    (*inst_keys)[inst_index].emplace_back(keys[pos]);
+  }
+}
+
+std::vector<std::vector<KeyValue>> Storage::GroupKeyValuesByInstance(const std::vector<KeyValue>& kvs) {
+  std::vector<std::vector<KeyValue>> inst_kvs(insts_.size());
+  for (const auto& kv : kvs) {
+    auto inst_index = slot_indexer_->GetInstanceID(GetSlotID(slot_num_, kv.key));
+    inst_kvs[inst_index].push_back(kv);
+  }
+  return inst_kvs;
+}
+
+Redis* Storage::SingleInstanceOf(const std::vector<std::string>& keys) {
+  Redis* single_inst = nullptr;
+  for (const auto& key : keys) {
+    Redis* inst = GetDBInstance(key).get();
+    if (single_inst != nullptr && inst != single_inst) {
+      return nullptr;
+    }
+    single_inst = inst;
+  }
+  return single_inst;
+}
+
 // Strings Commands
 Status Storage::Set(const Slice& key, const Slice& value) {
   auto& inst = GetDBInstance(key);
@@ -161,6 +211,17 @@ Status Storage::GetWithTTL(const Slice& key, std::string* value, int64_t* ttl_mi
   return inst->GetWithTTL(key, value, ttl_millsec);
 }
 
+Status Storage::Get(const Slice& key, rocksdb::PinnableSlice* pinned_value, Slice* value) {
+  auto& inst = GetDBInstance(key);
+  return inst->Get(key, pinned_value, value);
+}
+
+Status Storage::GetWithTTL(const Slice& key, rocksdb::PinnableSlice* pinned_value, Slice* value,
+                           int64_t* ttl_millsec) {
+  auto& inst = GetDBInstance(key);
+  return inst->GetWithTTL(key, pinned_value, value, ttl_millsec);
+}
+
 Status Storage::MGetWithTTL(const Slice& key, std::string* value, int64_t* ttl_millsec) {
   auto& inst = GetDBInstance(key);
   return inst->MGetWithTTL(key, value, ttl_millsec);
@@ -182,52 +243,64 @@ Status Storage::GetBit(const Slice& key, int64_t offset, int32_t* ret) {
 }
 
 Status Storage::MSet(const std::vector<KeyValue>& kvs) {
-  Status s;
-  for (const auto& kv : kvs) {
-    auto& inst = GetDBInstance(kv.key);
-    s = inst->Set(Slice(kv.key), Slice(kv.value));
+  // every instance applies its share of the keys with one WriteBatch
+  auto inst_kvs = GroupKeyValuesByInstance(kvs);
+  for (size_t inst_index = 0; inst_index < inst_kvs.size(); ++inst_index) {
+    if (inst_kvs[inst_index].empty()) {
+      continue;
+    }
+    Status s = insts_[inst_index]->MSet(inst_kvs[inst_index]);
     if (!s.ok()) {
       return s;
     }
   }
-  return s;
+  return Status::OK();
 }
 
 Status Storage::MGet(const std::vector<std::string>& keys, std::vector<ValueStatus>* vss) {
   vss->clear();
-  Status s;
-  for(const auto& key : keys) {
-    auto& inst = GetDBInstance(key);
-    std::string value;
-    s = inst->MGet(key, &value);
-    if (s.ok()) {
-      vss->push_back({value, Status::OK()});
-    } else if (s.IsNotFound()) {
-      vss->push_back({std::string(), Status::NotFound()});
-    } else {
+  vss->resize(keys.size());
+  std::vector<std::vector<size_t>> inst_key_positions;
+  std::vector<std::vector<Slice>> inst_keys;
+  GroupKeysByInstance(keys, &inst_key_positions, &inst_keys);
+  for (size_t inst_index = 0; inst_index < inst_keys.size(); ++inst_index) {
+    const auto& positions = inst_key_positions[inst_index];
+    if (positions.empty()) {
+      continue;
+    }
+    std::vector<ValueStatus> inst_vss;
+    Status s = insts_[inst_index]->MGet(inst_keys[inst_index], &inst_vss);
+    if (!s.ok()) {
       vss->clear();
       return s;
     }
+    for (size_t idx = 0; idx < positions.size(); ++idx) {
+      (*vss)[positions[idx]] = std::move(inst_vss[idx]);
+    }
   }
   return Status::OK();
 }
 
 Status Storage::MGetWithTTL(const std::vector<std::string>& keys, std::vector<ValueStatus>* vss) {
   vss->clear();
-  Status s;
-  for(const auto& key : keys) {
-    auto& inst = GetDBInstance(key);
-    std::string value;
-    int64_t ttl_millsec;
-    s = inst->MGetWithTTL(key, &value, &ttl_millsec);
-    if (s.ok()) {
-      vss->push_back({value, Status::OK(), ttl_millsec});
-    } else if (s.IsNotFound()) {
-      vss->push_back({std::string(), Status::NotFound(), ttl_millsec});
-    } else {
+  vss->resize(keys.size());
+  std::vector<std::vector<size_t>> inst_key_positions;
+  std::vector<std::vector<Slice>> inst_keys;
+  GroupKeysByInstance(keys, &inst_key_positions, &inst_keys);
+  for (size_t inst_index = 0; inst_index < inst_keys.size(); ++inst_index) {
+    const auto& positions = inst_key_positions[inst_index];
+    if (positions.empty()) {
+      continue;
+    }
+    std::vector<ValueStatus> inst_vss;
+    Status s = insts_[inst_index]->MGetWithTTL(inst_keys[inst_index], &inst_vss);
+    if (!s.ok()) {
       vss->clear();
       return s;
     }
+    for (size_t idx = 0; idx < positions.size(); ++idx) {
+      (*vss)[positions[idx]] = std::move(inst_vss[idx]);
+    }
   }
   return Status::OK();
 }
@@ -238,29 +311,49 @@ Status Storage::Setnx(const Slice& key, const Slice& value, int32_t* ret, int64_
 }
 
 // disallowed in codis, only runs in pika classic mode
-// TODO: Not concurrent safe now, merge wuxianrong's bugfix after floyd's PR review finishes.
 Status Storage::MSetnx(const std::vector<KeyValue>& kvs, int32_t* ret) {
   assert(is_classic_mode_);
-  Status s;
-  for (const auto& kv : kvs) {
-    auto& inst = GetDBInstance(kv.key);
-    s = inst->IsExist(Slice(kv.key));
-    if (!s.IsNotFound()) {
+  *ret = 0;
+  auto inst_kvs = GroupKeyValuesByInstance(kvs);
+
+  // hold the record locks of every involved instance, always taken in
+  // instance order, so the existence check and the writes of all
+  // instances happen in the same locked window
+  std::vector<std::unique_ptr<MultiScopeRecordLock>> inst_locks;
+  for (size_t inst_index = 0; inst_index < inst_kvs.size(); ++inst_index) {
+    if (inst_kvs[inst_index].empty()) {
+      continue;
+    }
+    std::vector<std::string> keys;
+    keys.reserve(inst_kvs[inst_index].size());
+    for (const auto& kv : inst_kvs[inst_index]) {
+      keys.push_back(kv.key);
+    }
+    inst_locks.emplace_back(std::make_unique<MultiScopeRecordLock>(insts_[inst_index]->GetLockMgr(), keys));
+  }
+
+  for (size_t inst_index = 0; inst_index < inst_kvs.size(); ++inst_index) {
+    if (inst_kvs[inst_index].empty()) {
+      continue;
+    }
+    bool exists = false;
+    Status s = insts_[inst_index]->AnyKeyExistsWithoutLock(inst_kvs[inst_index], &exists);
+    if (!s.ok() || exists) {
       return s;
     }
   }
 
-  for (const auto& kv : kvs) {
-    auto& inst = GetDBInstance(kv.key);
-    s = inst->Set(Slice(kv.key), Slice(kv.value));
+  for (size_t inst_index = 0; inst_index < inst_kvs.size(); ++inst_index) {
+    if (inst_kvs[inst_index].empty()) {
+      continue;
+    }
+    Status s = insts_[inst_index]->MSetWithoutLock(inst_kvs[inst_index]);
     if (!s.ok()) {
       return s;
     }
   }
-  if (s.ok()) {
-    *ret = 1;
-  }
-  return s;
+  *ret = 1;
+  return Status::OK();
 }
 
 Status Storage::Setvx(const Slice& key, const Slice& value, const Slice& new_value, int32_t* ret, int64_t ttl_millsec) {
@@ -508,6 +601,12 @@ Status Storage::SDiff(const std::vector<std::string>& keys, std::vector<std::str
     return s;
   }
 
+  // the keys of one instance are combined there at one snapshot
+  Redis* single_inst = SingleInstanceOf(keys);
+  if (single_inst != nullptr) {
+    return single_inst->SDiff(keys, members);
+  }
+
   auto& inst = GetDBInstance(keys[0]);
   std::vector<std::string> keys0_members;
   s = inst->SMembers(Slice(keys[0]), &keys0_members);
@@ -569,6 +668,12 @@ Status Storage::SInter(const std::vector<std::string>& keys, std::vector<std::st
     return s;
   }
 
+  // the keys of one instance are combined there at one snapshot
+  Redis* single_inst = SingleInstanceOf(keys);
+  if (single_inst != nullptr) {
+    return single_inst->SInter(keys, members);
+  }
+
   std::vector<std::string> key0_members;
   auto& inst = GetDBInstance(keys[0]);
   s = inst->SMembers(keys[0], &key0_members);
@@ -693,6 +798,12 @@ Status Storage::SUnion(const std::vector<std::string>& keys, std::vector<std::st
     return inst->SUnion(keys, members);
   }
 
+  // the keys of one instance are combined there at one snapshot
+  Redis* single_inst = SingleInstanceOf(keys);
+  if (single_inst != nullptr) {
+    return single_inst->SUnion(keys, members);
+  }
+
   using Iter = std::vector<std::string>::iterator;
   using Uset = std::unordered_set<std::string>;
   Uset member_set;
@@ -982,6 +1093,14 @@ Status Storage::ZUnionstore(const Slice& destination, const std::vector<std::str
     return s;
   }
 
+  // the keys and destination of one instance are combined there at one snapshot
+  std::vector<std::string> inst_keys(keys);
+  inst_keys.push_back(destination.ToString());
+  Redis* single_inst = SingleInstanceOf(inst_keys);
+  if (single_inst != nullptr) {
+    return single_inst->ZUnionstore(destination, keys, weights, agg, value_to_dest, ret);
+  }
+
   for (int idx = 0; idx < keys.size(); idx++) {
     Slice key = Slice(keys[idx]);
     auto& inst = GetDBInstance(key);
@@ -1041,6 +1160,14 @@ Status Storage::ZInterstore(const Slice& destination, const std::vector<std::str
     return s;
   }
 
+  // the keys and destination of one instance are combined there at one snapshot
+  std::vector<std::string> inst_keys(keys);
+  inst_keys.push_back(destination.ToString());
+  Redis* single_inst = SingleInstanceOf(inst_keys);
+  if (single_inst != nullptr) {
+    return single_inst->ZInterstore(destination, keys, weights, agg, value_to_dest, ret);
+  }
+
   Slice key = Slice(keys[0]);
   auto& inst = GetDBInstance(key);
   std::map<std::string, double> member_to_score;
@@ -1193,29 +1320,36 @@ int32_t Storage::Expire(const Slice& key, int64_t ttl_millsec) {
 
 
 int64_t Storage::Del(const std::vector<std::string>& keys) {
-  Status s;
   int64_t count = 0;
-  for (const auto& key : keys) {
-    auto& inst = GetDBInstance(key);
-    s = inst->Del(key);
-    if (s.ok()) {
-      count++;
+  std::vector<std::vector<size_t>> inst_key_positions;
+  std::vector<std::vector<Slice>> inst_keys;
+  GroupKeysByInstance(keys, &inst_key_positions, &inst_keys);
+  for (size_t inst_index = 0; inst_index < inst_keys.size(); ++inst_index) {
+    if (inst_keys[inst_index].empty()) {
+      continue;
     }
+    int64_t inst_count = 0;
+    insts_[inst_index]->Del(inst_keys[inst_index], &inst_count);
+    count += inst_count;
   }
   return count;
 }
 
 int64_t Storage::Exists(const std::vector<std::string>& keys) {
   int64_t count = 0;
-  Status s;
-  for (const auto& key : keys) {
-    auto& inst = GetDBInstance(key);
-    s = inst->Exists(key);
-    if (s.ok()) {
-      count++;
-    } else if (!s.IsNotFound()) {
+  std::vector<std::vector<size_t>> inst_key_positions;
+  std::vector<std::vector<Slice>> inst_keys;
+  GroupKeysByInstance(keys, &inst_key_positions, &inst_keys);
+  for (size_t inst_index = 0; inst_index < inst_keys.size(); ++inst_index) {
+    if (inst_keys[inst_index].empty()) {
+      continue;
+    }
+    int64_t inst_count = 0;
+    Status s = insts_[inst_index]->Exists(inst_keys[inst_index], &inst_count);
+    if (!s.ok()) {
       return -1;
     }
+    count += inst_count;
   }
   return count;
 }
@@ -1266,12 +1400,17 @@ int64_t Storage::Scan(const DataType& dtype, int64_t cursor, const std::string&
     types.push_back(DataTypeTag[static_cast<int>(dtype)]);
   }
 
+  // no key past the literal prefix of pattern can match
+  std::string lower_bound;
+  std::string upper_bound;
+  MetaKeyPrefixBounds(PatternPrefix(pattern), &lower_bound, &upper_bound);
+  Slice upper_bound_slice(upper_bound);
   for (const auto& type : types) {
     std::vector<IterSptr> inst_iters;
     for (const auto& inst : insts_) {
       IterSptr iter_sptr;
       iter_sptr.reset(inst->CreateIterator(type, pattern,
-          nullptr/*lower_bound*/, nullptr/*upper_bound*/));
+          nullptr/*lower_bound*/, upper_bound.empty() ? nullptr : &upper_bound_slice));
       inst_iters.push_back(iter_sptr);
     }
 
@@ -1432,11 +1571,15 @@ Status Storage::Scanx(const DataType& data_type, const std::string& start_key, c
   keys->clear();
   next_key->clear();
 
+  std::string lower_bound;
+  std::string upper_bound;
+  MetaKeyPrefixBounds(PatternPrefix(pattern), &lower_bound, &upper_bound);
+  Slice upper_bound_slice(upper_bound);
   std::vector<IterSptr> inst_iters;
   for (const auto& inst : insts_) {
     IterSptr iter_sptr;
     iter_sptr.reset(inst->CreateIterator(data_type, pattern,
-        nullptr/*lower_bound*/, nullptr/*upper_bound*/));
+        nullptr/*lower_bound*/, upper_bound.empty() ? nullptr : &upper_bound_slice));
     inst_iters.push_back(iter_sptr);
   }
 
@@ -1515,25 +1658,34 @@ Status Storage::GetType(const std::string& key, enum DataType& type) {
 
 Status Storage::Keys(const DataType& data_type, const std::string& pattern, std::vector<std::string>* keys) {
   keys->clear();
-  std::vector<DataType> types;
-  types.push_back(data_type);
+  std::string lower;
+  std::string upper;
+  MetaKeyPrefixBounds(PatternPrefix(pattern), &lower, &upper);
+  size_t threads = GetKeyspaceScanThreads();
+  std::vector<MetaRange> ranges;
+  for (const auto& inst : insts_) {
+    inst->SplitMetaRange(lower, upper, threads, &ranges);
+  }
 
-  for (const auto& type : types) {
-    std::vector<IterSptr> inst_iters;
-    for (const auto& inst : insts_) {
-      IterSptr inst_iter;
-      inst_iter.reset(inst->CreateIterator(type, pattern, nullptr /*lower_bound*/, nullptr /*upper_bound*/));
-      inst_iters.push_back(inst_iter);
-    }
+  std::vector<std::vector<std::string>> range_keys(ranges.size());
+  Status s = keyspace_scan_pool_->Run(ranges.size(), [&](size_t idx) {
+    return insts_[ranges[idx].inst_index]->ScanMetaRangeKeys(data_type, pattern, ranges[idx], &range_keys[idx]);
+  });
+  if (!s.ok()) {
+    keys->clear();
+    return s;
+  }
 
-    MergingIterator miter(inst_iters);
-    miter.SeekToFirst();
-    while (miter.Valid()) {
-      keys->push_back(miter.Key());
-      miter.Next();
+  // the ranges of an instance are in key order, the instances are merged
+  size_t inst_begin = 0;
+  for (size_t idx = 0; idx < ranges.size(); ++idx) {
+    keys->insert(keys->end(), std::make_move_iterator(range_keys[idx].begin()),
+                 std::make_move_iterator(range_keys[idx].end()));
+    if (idx + 1 == ranges.size() || ranges[idx + 1].inst_index != ranges[idx].inst_index) {
+      std::inplace_merge(keys->begin(), keys->begin() + inst_begin, keys->end());
+      inst_begin = keys->size();
     }
   }
-
   return Status::OK();
 }
 
@@ -1678,6 +1830,25 @@ Status Storage::PfMerge(const std::vector<std::string>& keys, std::string& value
   return s;
 }
 
+Status Storage::ApplyStagedWrites(std::vector<StagedWrite>* writes) {
+  std::vector<std::vector<StagedWrite*>> inst_writes(insts_.size());
+  for (auto& write : *writes) {
+    auto inst_index = slot_indexer_->GetInstanceID(GetSlotID(slot_num_, write.key));
+    inst_writes[inst_index].push_back(&write);
+  }
+  Status first_failure;
+  for (size_t inst_index = 0; inst_index < inst_writes.size(); ++inst_index) {
+    if (inst_writes[inst_index].empty()) {
+      continue;
+    }
+    Status s = insts_[inst_index]->ApplyStagedWrites(inst_writes[inst_index]);
+    if (!s.ok() && first_failure.ok()) {
+      first_failure = s;
+    }
+  }
+  return first_failure;
+}
+
 static void* StartBGThreadWrapper(void* arg) {
   auto s = reinterpret_cast<Storage*>(arg);
   s->RunBGTask();
@@ -1733,11 +1904,104 @@ Status Storage::RunBGTask() {
       if (task.argv.size() == 2) {
         DoCompactRange(task.type, task.argv.front(), task.argv.back());
       }
+    } else if (task.operation == kReconcileKeyCounters) {
+      std::vector<KeyInfo> key_infos;
+      Status s = insts_[std::stoul(task.argv[0])]->ScanKeyNum(&key_infos);
+      if (!s.ok()) {
+        LOG(WARNING) << "reconcile keyspace counters failed, " << s.ToString();
+      }
+    } else if (task.operation == kBackfillExpireIndex) {
+      Status s = insts_[std::stoul(task.argv[0])]->BackfillExpireIndex();
+      if (!s.ok()) {
+        LOG(WARNING) << "backfill expiry index failed, " << s.ToString();
+      }
     }
   }
   return Status::OK();
 }
 
+Status Storage::SlotIndexAdd(const std::string& key, char type) {
+  uint32_t crc = 0;
+  int hastag = 0;
+  uint32_t slot_id = GetSlotsID(slot_num_, key, &crc, &hastag);
+  auto& inst = GetDBInstance(key);
+  return inst->SlotIndexAdd(slot_id, hastag != 0, crc, key);
+}
+
+Status Storage::SlotIndexDel(const std::string& key) {
+  uint32_t crc = 0;
+  int hastag = 0;
+  uint32_t slot_id = GetSlotsID(slot_num_, key, &crc, &hastag);
+  auto& inst = GetDBInstance(key);
+  return inst->SlotIndexDel(slot_id, hastag != 0, crc, key);
+}
+
+Status Storage::SlotIndexDel(uint32_t slot_id, const std::string& key) {
+  if (slot_id >= static_cast<uint32_t>(slot_num_)) {
+    return Status::InvalidArgument("invalid slot id " + std::to_string(slot_id));
+  }
+  uint32_t crc = 0;
+  int hastag = 0;
+  GetSlotsID(slot_num_, key, &crc, &hastag);
+  auto& inst = GetSlotInstance(slot_id);
+  return inst->SlotIndexDel(slot_id, hastag != 0, crc, key);
+}
+
+Status Storage::SlotIndexScan(uint32_t slot_id, int64_t cursor, const std::string& pattern, int64_t count,
+                              std::vector<std::string>* type_keys, int64_t* next_cursor) {
+  if (slot_id >= static_cast<uint32_t>(slot_num_)) {
+    return Status::InvalidArgument("invalid slot id " + std::to_string(slot_id));
+  }
+  auto& inst = GetSlotInstance(slot_id);
+  return inst->SlotIndexScan(slot_id, cursor, pattern, count, type_keys, next_cursor);
+}
+
+Status Storage::SlotIndexTagKeys(const std::string& key, std::vector<std::string>* type_keys) {
+  uint32_t crc = 0;
+  int hastag = 0;
+  GetSlotsID(slot_num_, key, &crc, &hastag);
+  type_keys->clear();
+  if (hastag == 0) {
+    return Status::OK();
+  }
+  // the keys of a tag all map to the slot of the tag
+  auto& inst = GetDBInstance(key);
+  return inst->SlotIndexTagKeys(crc, type_keys);
+}
+
+Status Storage::SlotIndexCount(uint32_t slot_id, int64_t* count) {
+  if (slot_id >= static_cast<uint32_t>(slot_num_)) {
+    return Status::InvalidArgument("invalid slot id " + std::to_string(slot_id));
+  }
+  auto& inst = GetSlotInstance(slot_id);
+  return inst->SlotIndexCount(slot_id, count);
+}
+
+Status Storage::SlotIndexDelSlot(uint32_t slot_id, int64_t* count) {
+  *count = 0;
+  std::vector<std::string> type_keys;
+  int64_t next_cursor = 0;
+  int64_t cursor = 0;
+  // entries are deleted under the scanned slot, the entries of stored keys
+  // stay, so the scan goes on from its cursor
+  do {
+    Status s = SlotIndexScan(slot_id, cursor, "*", 1000, &type_keys, &next_cursor);
+    if (!s.ok()) {
+      return s;
+    }
+    for (const auto& type_key : type_keys) {
+      s = SlotIndexDel(slot_id, type_key.substr(1));
+      if (s.ok()) {
+        ++*count;
+      } else if (!s.IsNotFound() && !s.IsBusy()) {
+        return s;
+      }
+    }
+    cursor = next_cursor;
+  } while (cursor != 0);
+  return Status::OK();
+}
+
 Status Storage::Compact(const DataType& type, bool sync) {
   if (sync) {
     return DoCompactRange(type, "", "");
@@ -1813,6 +2077,18 @@ Status Storage::SetSmallCompactionDurationThreshold(uint32_t small_compaction_du
   return Status::OK();
 }
 
+void Storage::SetKeyspaceScanThreads(size_t keyspace_scan_threads) {
+  keyspace_scan_pool_->SetThreads(keyspace_scan_threads);
+}
+
+size_t Storage::GetKeyspaceScanThreads() const { return keyspace_scan_pool_->Threads(); }
+
+void Storage::SetSlotIndexEnabled(bool enabled) {
+  for (const auto& inst : insts_) {
+    inst->SetSlotIndexEnabled(enabled);
+  }
+}
+
 std::string Storage::GetCurrentTaskType() {
   int type = current_task_type_;
   switch (type) {
@@ -1877,6 +2153,59 @@ Status Storage::GetKeyNum(std::vector<KeyInfo>* key_infos) {
   return Status::OK();
 }
 
+Status Storage::GetKeyCounters(std::vector<KeyInfo>* key_infos) {
+  key_infos->assign(DataTypeNum, KeyInfo());
+  for (const auto& inst : insts_) {
+    if (!inst->KeyCountersReconciled()) {
+      return Status::Incomplete("keyspace counters are not reconciled yet");
+    }
+    std::vector<KeyInfo> inst_key_infos;
+    inst->GetKeyCounters(&inst_key_infos);
+    std::transform(inst_key_infos.begin(), inst_key_infos.end(),
+        key_infos->begin(), key_infos->begin(), std::plus<>{});
+  }
+  return Status::OK();
+}
+
+Status Storage::ScanExpiredKeys(int64_t count, std::vector<std::string>* keys, int64_t* lag_millsec) {
+  keys->clear();
+  *lag_millsec = 0;
+  if (!enable_expire_index_ || count <= 0) {
+    return Status::OK();
+  }
+  // every instance gets its share, one busy instance can't starve the others
+  int64_t inst_count = std::max<int64_t>(1, count / static_cast<int64_t>(insts_.size()));
+  uint64_t now_millsec = pstd::NowMillis();
+  for (const auto& inst : insts_) {
+    uint64_t oldest_etime = 0;
+    Status s = inst->ScanExpiredKeys(now_millsec, inst_count, keys, &oldest_etime);
+    if (!s.ok()) {
+      return s;
+    }
+    if (oldest_etime != 0) {
+      *lag_millsec = std::max(*lag_millsec, static_cast<int64_t>(now_millsec - oldest_etime));
+    }
+  }
+  return Status::OK();
+}
+
+Status Storage::ReapExpiredKeys(const std::vector<std::string>& keys, std::vector<std::string>* reaped) {
+  reaped->clear();
+  std::vector<std::vector<size_t>> inst_key_positions;
+  std::vector<std::vector<Slice>> inst_keys;
+  GroupKeysByInstance(keys, &inst_key_positions, &inst_keys);
+  for (size_t inst_index = 0; inst_index < inst_keys.size(); ++inst_index) {
+    if (inst_keys[inst_index].empty()) {
+      continue;
+    }
+    Status s = insts_[inst_index]->ReapExpiredKeys(inst_keys[inst_index], reaped);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
 Status Storage::StopScanKeyNum() {
   scan_keynum_exit_ = true;
   return Status::OK();
@@ -309,6 +309,9 @@ class AllIterator : public TypeIterator {
   ~AllIterator() {}
 
   bool ShouldSkip() override {
+    if (IsMetaMarker(raw_iter_->key())) {
+      return true;
+    }
     std::string user_value;
     auto type = static_cast<DataType>(static_cast<uint8_t>(raw_iter_->value()[0]));
     switch (type) {
@@ -18,10 +18,16 @@
 
 namespace storage {
 
+/*
+ * Also filters zset_rank_cf, whose keys are score keys with the index level
+ * prepended to the user key (see zsets_rank_index.h), with rank_key set the
+ * level byte is stripped to get the meta key.
+ */
 class ZSetsScoreFilter : public rocksdb::CompactionFilter {
  public:
-  ZSetsScoreFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr, enum DataType type)
-      : db_(db), cf_handles_ptr_(handles_ptr), type_(type) {}
+  ZSetsScoreFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr, enum DataType type,
+                   bool rank_key = false)
+      : db_(db), cf_handles_ptr_(handles_ptr), type_(type), rank_key_(rank_key) {}
 
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
@@ -39,6 +45,10 @@ class ZSetsScoreFilter : public rocksdb::CompactionFilter {
     int key_size = key.size();
     ptr = SeekUserkeyDelim(ptr + kPrefixReserveLength, key_size - kPrefixReserveLength);
     std::string meta_key_enc(key.data(), std::distance(key.data(), ptr));
+    if (rank_key_) {
+      // | reserve1 | level | encoded user key |
+      meta_key_enc.erase(kPrefixReserveLength, 1);
+    }
     meta_key_enc.append(kSuffixReserveLength, kNeedTransformCharacter);
 
     if (meta_key_enc != cur_key_) {
@@ -122,16 +132,18 @@ class ZSetsScoreFilter : public rocksdb::CompactionFilter {
   mutable uint64_t cur_meta_version_ = 0;
   mutable uint64_t cur_meta_etime_ = 0;
   enum DataType type_ = DataType::kNones;
+  bool rank_key_ = false;
 };
 
 class ZSetsScoreFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-  ZSetsScoreFilterFactory(rocksdb::DB** db_ptr, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr, enum DataType type)
-      : db_ptr_(db_ptr), cf_handles_ptr_(handles_ptr), type_(type) {}
+  ZSetsScoreFilterFactory(rocksdb::DB** db_ptr, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr, enum DataType type,
+                          bool rank_key = false)
+      : db_ptr_(db_ptr), cf_handles_ptr_(handles_ptr), type_(type), rank_key_(rank_key) {}
 
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context& context) override {
-    return std::make_unique<ZSetsScoreFilter>(*db_ptr_, cf_handles_ptr_, type_);
+    return std::make_unique<ZSetsScoreFilter>(*db_ptr_, cf_handles_ptr_, type_, rank_key_);
   }
 
   const char* Name() const override { return "ZSetsScoreFilterFactory"; }
@@ -140,6 +152,7 @@ class ZSetsScoreFilterFactory : public rocksdb::CompactionFilterFactory {
   rocksdb::DB** db_ptr_ = nullptr;
   std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr_ = nullptr;
   enum DataType type_ = DataType::kNones;
+  bool rank_key_ = false;
 };
 
 }  //  namespace storage
@@ -0,0 +1,361 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/zsets_rank_index.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#include "src/coding.h"
+#include "src/zsets_data_key_format.h"
+
+namespace storage {
+
+ZSetsRankIndex::ZSetsRankIndex(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* score_cf,
+                               rocksdb::ColumnFamilyHandle* rank_cf, const rocksdb::ReadOptions& read_options,
+                               const Slice& key, uint64_t version)
+    : db_(db), score_cf_(score_cf), rank_cf_(rank_cf), read_options_(read_options), key_(key.ToString()),
+      version_(version) {}
+
+int ZSetsRankIndex::MemberLevel(const Slice& member) {
+  // FNV-1a with a 64 bit finalizer, the levels are persisted so this must
+  // give the same result on every platform and never change
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < member.size(); ++i) {
+    hash ^= static_cast<uint8_t>(member[i]);
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+
+  int level = 0;
+  while (level < kRankIndexMaxLevel && (hash & (kRankIndexFanout - 1)) == 0) {
+    ++level;
+    hash >>= kRankIndexFanoutBits;
+  }
+  return level;
+}
+
+// Same order as ZSetsScoreKeyComparator for one zset version
+int ZSetsRankIndex::Compare(double a_score, const Slice& a_member, double b_score, const Slice& b_member) {
+  if (a_score < b_score) {
+    return -1;
+  } else if (a_score > b_score) {
+    return 1;
+  }
+  return a_member.compare(b_member);
+}
+
+size_t ZSetsRankIndex::CountBefore(const std::vector<Entry>& entries, const Entry& pos) {
+  return std::lower_bound(entries.begin(), entries.end(), pos, Less) - entries.begin();
+}
+
+std::string ZSetsRankIndex::RankKey(int level, double score, const Slice& member) const {
+  std::string level_key(1, static_cast<char>(level));
+  level_key.append(key_);
+  ZSetsScoreKey rank_key(level_key, version_, score, member);
+  return rank_key.Encode().ToString();
+}
+
+std::string ZSetsRankIndex::RankPrefix(int level) const {
+  std::string rank_key = RankKey(level, 0, Slice());
+  rank_key.resize(rank_key.size() - sizeof(uint64_t) - kSuffixReserveLength);
+  return rank_key;
+}
+
+std::string ZSetsRankIndex::ScorePrefix() const {
+  ZSetsScoreKey score_key(key_, version_, 0, Slice());
+  std::string prefix = score_key.Encode().ToString();
+  prefix.resize(prefix.size() - sizeof(uint64_t) - kSuffixReserveLength);
+  return prefix;
+}
+
+void ZSetsRankIndex::AddMember(double score, const Slice& member) { added_.push_back({score, member.ToString()}); }
+
+void ZSetsRankIndex::DelMember(double score, const Slice& member) { deleted_.push_back({score, member.ToString()}); }
+
+Status ZSetsRankIndex::Descend(double score, const Slice& member, uint64_t max_rank, bool by_rank, uint64_t* base,
+                               bool* has_from, Entry* from) {
+  *base = 0;
+  *has_from = false;
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options_, rank_cf_));
+  for (int level = kRankIndexMaxLevel; level >= 1; --level) {
+    // the fence we stopped at is a fence of the lower levels too
+    std::string prefix = RankPrefix(level);
+    if (*has_from) {
+      iter->Seek(RankKey(level, from->score, from->member));
+    } else {
+      iter->Seek(RankKey(level, std::numeric_limits<double>::lowest(), Slice()));
+    }
+    for (; iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+      ParsedZSetsScoreKey fence(iter->key());
+      if (*has_from && Compare(fence.score(), fence.member(), from->score, from->member) <= 0) {
+        continue;
+      }
+      uint64_t count = DecodeFixed64(iter->value().data());
+      if (by_rank ? *base + count > max_rank : Compare(fence.score(), fence.member(), score, member) > 0) {
+        break;
+      }
+      *base += count;
+      *has_from = true;
+      from->score = fence.score();
+      from->member = fence.member().ToString();
+    }
+    if (!iter->status().ok()) {
+      return iter->status();
+    }
+  }
+  return Status::OK();
+}
+
+Status ZSetsRankIndex::Rank(double score, const Slice& member, uint64_t* rank) {
+  uint64_t base = 0;
+  bool has_from = false;
+  Entry from;
+  Status s = Descend(score, member, 0, false, &base, &has_from, &from);
+  if (!s.ok()) {
+    return s;
+  }
+
+  // count the members between the last fence and (score, member)
+  std::string prefix = ScorePrefix();
+  ZSetsScoreKey seek_key(key_, version_, has_from ? from.score : std::numeric_limits<double>::lowest(),
+                         has_from ? Slice(from.member) : Slice());
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options_, score_cf_));
+  for (iter->Seek(seek_key.Encode()); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    ParsedZSetsScoreKey score_key(iter->key());
+    if (Compare(score_key.score(), score_key.member(), score, member) >= 0) {
+      break;
+    }
+    ++base;
+  }
+  if (!iter->status().ok()) {
+    return iter->status();
+  }
+  *rank = base;
+  return Status::OK();
+}
+
+Status ZSetsRankIndex::Seek(rocksdb::Iterator* score_iter, uint64_t rank) {
+  uint64_t base = 0;
+  bool has_from = false;
+  Entry from;
+  Status s = Descend(0, Slice(), rank, true, &base, &has_from, &from);
+  if (!s.ok()) {
+    return s;
+  }
+
+  ZSetsScoreKey seek_key(key_, version_, has_from ? from.score : std::numeric_limits<double>::lowest(),
+                         has_from ? Slice(from.member) : Slice());
+  for (score_iter->Seek(seek_key.Encode()); score_iter->Valid() && base < rank; score_iter->Next()) {
+    ++base;
+  }
+  return score_iter->status();
+}
+
+Status ZSetsRankIndex::NeighborFence(rocksdb::Iterator* iter, int level, const Entry& pos, bool forward,
+                                     const std::vector<Entry>* added_fences, bool* found, Entry* fence) {
+  *found = false;
+  std::string prefix = RankPrefix(level);
+  std::string seek_key = RankKey(level, pos.score, pos.member);
+  if (forward) {
+    iter->Seek(seek_key);
+  } else {
+    iter->SeekForPrev(seek_key);
+  }
+  for (; iter->Valid() && iter->key().starts_with(prefix); forward ? iter->Next() : iter->Prev()) {
+    ParsedZSetsScoreKey parsed_fence(iter->key());
+    Entry entry{parsed_fence.score(), parsed_fence.member().ToString()};
+    if (Compare(entry, pos) == 0) {
+      continue;
+    }
+    if (added_fences && std::binary_search(deleted_.begin(), deleted_.end(), entry, Less)) {
+      continue;
+    }
+    *found = true;
+    *fence = std::move(entry);
+    break;
+  }
+  if (!iter->status().ok()) {
+    return iter->status();
+  }
+
+  if (added_fences) {
+    if (forward) {
+      auto added = std::upper_bound(added_fences->begin(), added_fences->end(), pos, Less);
+      if (added != added_fences->end() && (!*found || Less(*added, *fence))) {
+        *found = true;
+        *fence = *added;
+      }
+    } else {
+      auto added = std::lower_bound(added_fences->begin(), added_fences->end(), pos, Less);
+      if (added != added_fences->begin() && (!*found || Less(*fence, *(added - 1)))) {
+        *found = true;
+        *fence = *(added - 1);
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status ZSetsRankIndex::RankAfterChanges(const Entry& pos, uint64_t* rank) {
+  Status s = Rank(pos.score, pos.member, rank);
+  if (s.ok()) {
+    *rank = *rank + CountBefore(added_, pos) - CountBefore(deleted_, pos);
+  }
+  return s;
+}
+
+Status ZSetsRankIndex::Update(rocksdb::WriteBatch* batch) {
+  // a member deleted and added back with the same score changes nothing
+  std::sort(added_.begin(), added_.end(), Less);
+  std::sort(deleted_.begin(), deleted_.end(), Less);
+  std::vector<Entry> added;
+  std::vector<Entry> deleted;
+  size_t add_idx = 0;
+  size_t del_idx = 0;
+  while (add_idx < added_.size() || del_idx < deleted_.size()) {
+    if (del_idx == deleted_.size() || (add_idx < added_.size() && Less(added_[add_idx], deleted_[del_idx]))) {
+      added.push_back(std::move(added_[add_idx++]));
+    } else if (add_idx == added_.size() || Less(deleted_[del_idx], added_[add_idx])) {
+      deleted.push_back(std::move(deleted_[del_idx++]));
+    } else {
+      ++add_idx;
+      ++del_idx;
+    }
+  }
+  added_.swap(added);
+  deleted_.swap(deleted);
+  if (added_.empty() && deleted_.empty()) {
+    return Status::OK();
+  }
+  std::vector<Entry> changes;
+  std::merge(added_.begin(), added_.end(), deleted_.begin(), deleted_.end(), std::back_inserter(changes), Less);
+
+  Status s;
+  char buf[sizeof(uint64_t)];
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options_, rank_cf_));
+  for (int level = 1; level <= kRankIndexMaxLevel; ++level) {
+    std::vector<Entry> added_fences;
+    for (const auto& entry : added_) {
+      if (MemberLevel(entry.member) >= level) {
+        added_fences.push_back(entry);
+      }
+    }
+    bool fence_deleted = false;
+    for (const auto& entry : deleted_) {
+      if (MemberLevel(entry.member) >= level) {
+        batch->Delete(rank_cf_, RankKey(level, entry.score, entry.member));
+        fence_deleted = true;
+      }
+    }
+
+    // the count of a fence changes when it is new or a change falls in
+    // [previous fence, fence), i.e. it is the first fence after a change
+    std::vector<Entry> affected(added_fences);
+    bool has_next = false;
+    Entry next;
+    for (const auto& change : changes) {
+      if (has_next && Less(change, next)) {
+        continue;
+      }
+      s = NeighborFence(iter.get(), level, change, true, &added_fences, &has_next, &next);
+      if (!s.ok()) {
+        return s;
+      }
+      if (!has_next) {
+        break;
+      }
+      affected.push_back(next);
+    }
+    if (affected.empty() && !fence_deleted) {
+      // levels above hold a subset of these fences, nothing changes there
+      break;
+    }
+    std::sort(affected.begin(), affected.end(), Less);
+    affected.erase(std::unique(affected.begin(), affected.end(),
+                               [](const Entry& a, const Entry& b) { return Compare(a, b) == 0; }),
+                   affected.end());
+
+    for (const auto& fence : affected) {
+      bool has_prev = false;
+      Entry prev;
+      s = NeighborFence(iter.get(), level, fence, false, &added_fences, &has_prev, &prev);
+      if (!s.ok()) {
+        return s;
+      }
+
+      bool adjusted = false;
+      uint64_t count = 0;
+      if (!std::binary_search(added_fences.begin(), added_fences.end(), fence, Less)) {
+        // an existing fence keeping its previous fence only sees the
+        // members added and deleted in between
+        bool has_old_prev = false;
+        Entry old_prev;
+        s = NeighborFence(iter.get(), level, fence, false, nullptr, &has_old_prev, &old_prev);
+        if (!s.ok()) {
+          return s;
+        }
+        if (has_old_prev == has_prev && (!has_prev || Compare(old_prev, prev) == 0)) {
+          std::string count_value;
+          s = db_->Get(read_options_, rank_cf_, RankKey(level, fence.score, fence.member), &count_value);
+          if (!s.ok()) {
+            return s;
+          }
+          int64_t delta = static_cast<int64_t>(CountBefore(added_, fence)) -
+                          static_cast<int64_t>(CountBefore(deleted_, fence));
+          if (has_prev) {
+            delta -= static_cast<int64_t>(CountBefore(added_, prev)) -
+                     static_cast<int64_t>(CountBefore(deleted_, prev));
+          }
+          count = DecodeFixed64(count_value.data()) + delta;
+          adjusted = true;
+        }
+      }
+      if (!adjusted) {
+        uint64_t fence_rank = 0;
+        uint64_t prev_rank = 0;
+        s = RankAfterChanges(fence, &fence_rank);
+        if (s.ok() && has_prev) {
+          s = RankAfterChanges(prev, &prev_rank);
+        }
+        if (!s.ok()) {
+          return s;
+        }
+        count = fence_rank - prev_rank;
+      }
+      EncodeFixed64(buf, count);
+      batch->Put(rank_cf_, RankKey(level, fence.score, fence.member), Slice(buf, sizeof(buf)));
+    }
+  }
+  added_.clear();
+  deleted_.clear();
+  return Status::OK();
+}
+
+Status ZSetsRankIndex::Build(rocksdb::WriteBatch* batch) {
+  char buf[sizeof(uint64_t)];
+  uint64_t rank = 0;
+  std::vector<uint64_t> prev_rank(kRankIndexMaxLevel + 1, 0);
+  std::string prefix = ScorePrefix();
+  ZSetsScoreKey seek_key(key_, version_, std::numeric_limits<double>::lowest(), Slice());
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options_, score_cf_));
+  for (iter->Seek(seek_key.Encode()); iter->Valid() && iter->key().starts_with(prefix); iter->Next(), ++rank) {
+    ParsedZSetsScoreKey score_key(iter->key());
+    int level = MemberLevel(score_key.member());
+    for (int fence_level = 1; fence_level <= level; ++fence_level) {
+      EncodeFixed64(buf, rank - prev_rank[fence_level]);
+      batch->Put(rank_cf_, RankKey(fence_level, score_key.score(), score_key.member()), Slice(buf, sizeof(buf)));
+      prev_rank[fence_level] = rank;
+    }
+  }
+  return iter->status();
+}
+
+}  //  namespace storage
@@ -0,0 +1,105 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_ZSETS_RANK_INDEX_H_
+#define SRC_ZSETS_RANK_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include "rocksdb/db.h"
+#include "rocksdb/write_batch.h"
+
+#include "storage/storage_define.h"
+
+namespace storage {
+
+using Status = rocksdb::Status;
+using Slice = rocksdb::Slice;
+
+/*
+ * Order statistic index of one zset, stored in zset_rank_cf.
+ *
+ * Every member gets a level from the hash of its name: one member in
+ * kRankIndexFanout has level >= 1, one in kRankIndexFanout^2 has level >= 2
+ * and so on. A member with level >= L is a fence of level L, it is stored
+ * in zset_rank_cf as
+ *
+ * | reserve1 | L(1B) + key | version | score | member | reserve2 |  =>  | count |
+ * |    8B    |             |    8B   |  8B   |        |    16B    |      |  8B   |
+ *
+ * where count is the number of members in [previous fence of level L, this
+ * fence). The key sorts like a zset score key, so the fences of one level
+ * are in score order, and the counts of the fences up to a member add up to
+ * its rank. Walking from the top level down visits about kRankIndexFanout
+ * fences per level, rank lookups and seeks to a rank are O(log n) instead of
+ * O(rank).
+ *
+ * Commands that change an indexed zset record the score keys they add and
+ * delete, Update then writes the changed fences into the same WriteBatch.
+ */
+class ZSetsRankIndex {
+ public:
+  ZSetsRankIndex(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* score_cf, rocksdb::ColumnFamilyHandle* rank_cf,
+                 const rocksdb::ReadOptions& read_options, const Slice& key, uint64_t version);
+
+  // Number of members ordered before (score, member)
+  Status Rank(double score, const Slice& member, uint64_t* rank);
+  // Positions score_iter on the member with the given rank
+  Status Seek(rocksdb::Iterator* score_iter, uint64_t rank);
+
+  void AddMember(double score, const Slice& member);
+  void DelMember(double score, const Slice& member);
+  // Writes the fences changed by the recorded members into batch, the
+  // index read is the one before the recorded changes
+  Status Update(rocksdb::WriteBatch* batch);
+
+  // Indexes the whole zset in one pass over zset_score_cf
+  Status Build(rocksdb::WriteBatch* batch);
+
+  static int MemberLevel(const Slice& member);
+
+  static const int kRankIndexFanoutBits = 5;
+  static const int kRankIndexFanout = 1 << kRankIndexFanoutBits;
+  static const int kRankIndexMaxLevel = 6;
+
+ private:
+  struct Entry {
+    double score;
+    std::string member;
+  };
+
+  static int Compare(double a_score, const Slice& a_member, double b_score, const Slice& b_member);
+  static int Compare(const Entry& a, const Entry& b) { return Compare(a.score, a.member, b.score, b.member); }
+  static bool Less(const Entry& a, const Entry& b) { return Compare(a, b) < 0; }
+  static size_t CountBefore(const std::vector<Entry>& entries, const Entry& pos);
+
+  std::string RankKey(int level, double score, const Slice& member) const;
+  std::string RankPrefix(int level) const;
+  std::string ScorePrefix() const;
+
+  // Walks down the levels while the fences stay within (score, member), or
+  // while the rank sum stays within max_rank for seeks
+  Status Descend(double score, const Slice& member, uint64_t max_rank, bool by_rank, uint64_t* base, bool* has_from,
+                 Entry* from);
+  // Closest fence of level strictly after (or before) pos. Given the added
+  // fences of the level it looks at the index after the recorded changes,
+  // deleted members are skipped and the added fences count too
+  Status NeighborFence(rocksdb::Iterator* iter, int level, const Entry& pos, bool forward,
+                       const std::vector<Entry>* added_fences, bool* found, Entry* fence);
+  Status RankAfterChanges(const Entry& pos, uint64_t* rank);
+
+  rocksdb::DB* db_;
+  rocksdb::ColumnFamilyHandle* score_cf_;
+  rocksdb::ColumnFamilyHandle* rank_cf_;
+  rocksdb::ReadOptions read_options_;
+  std::string key_;
+  uint64_t version_;
+  std::vector<Entry> added_;
+  std::vector<Entry> deleted_;
+};
+
+}  //  namespace storage
+#endif  // SRC_ZSETS_RANK_INDEX_H_
@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <thread>
 
 #include "glog/logging.h"
@@ -2431,6 +2432,290 @@ TEST_F(HashesTest, PKHRScanRangeTest) {
   ASSERT_EQ(next_field, "i");
 }
 
+// Small hashes kept in their meta value
+TEST_F(HashesTest, InlineHashesTest) {  // NOLINT
+  std::string path = "./db/hashes_inline";
+  pstd::DeleteDirIfExist(path);
+  mkdir(path.c_str(), 0755);
+  storage::StorageOptions options;
+  options.options.create_if_missing = true;
+  auto inline_db = std::make_unique<storage::Storage>();
+  s = inline_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+
+  int32_t ret;
+  int64_t value_ret;
+  std::string value;
+  std::vector<std::string> fields;
+  std::vector<std::string> values;
+  std::vector<storage::ValueStatus> vss;
+  std::vector<FieldValue> field_value_out;
+
+  // A hash written before inline collections are turned on
+  s = inline_db->HMSet("GP1_INLINE_KEY", {{"f1", "v1"}, {"f2", "v2"}});
+  ASSERT_TRUE(s.ok());
+  inline_db.reset();
+  options.inline_collection_max_entries = 4;
+  inline_db = std::make_unique<storage::Storage>();
+  s = inline_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+
+  // ***************** Group 1 Test *****************
+  // The hash with data keys is still readable and writable
+  s = inline_db->HSet("GP1_INLINE_KEY", "f3", "v3", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(size_match(inline_db.get(), "GP1_INLINE_KEY", 3));
+  ASSERT_TRUE(field_value_match(inline_db.get(), "GP1_INLINE_KEY", {{"f1", "v1"}, {"f2", "v2"}, {"f3", "v3"}}));
+
+  // ***************** Group 2 Test *****************
+  // A new small hash is served from its meta value
+  s = inline_db->HMSet("GP2_INLINE_KEY", {{"f1", "v1"}, {"f2", "v2"}, {"f3", "v3"}});
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(size_match(inline_db.get(), "GP2_INLINE_KEY", 3));
+  ASSERT_TRUE(field_value_match(inline_db.get(), "GP2_INLINE_KEY", {{"f1", "v1"}, {"f2", "v2"}, {"f3", "v3"}}));
+  s = inline_db->HGet("GP2_INLINE_KEY", "f2", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, "v2");
+  s = inline_db->HGet("GP2_INLINE_KEY", "f4", &value);
+  ASSERT_TRUE(s.IsNotFound());
+  s = inline_db->HMGet("GP2_INLINE_KEY", {"f1", "f4", "f3"}, &vss);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(vss.size(), 3);
+  ASSERT_TRUE(vss[0].status.ok());
+  ASSERT_EQ(vss[0].value, "v1");
+  ASSERT_TRUE(vss[1].status.IsNotFound());
+  ASSERT_TRUE(vss[2].status.ok());
+  ASSERT_EQ(vss[2].value, "v3");
+  s = inline_db->HKeys("GP2_INLINE_KEY", &fields);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(fields, std::vector<std::string>({"f1", "f2", "f3"}));
+  s = inline_db->HVals("GP2_INLINE_KEY", &values);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(values, std::vector<std::string>({"v1", "v2", "v3"}));
+  s = inline_db->HExists("GP2_INLINE_KEY", "f1");
+  ASSERT_TRUE(s.ok());
+
+  // Updates and deletes stay inline
+  s = inline_db->HSet("GP2_INLINE_KEY", "f2", "v22", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 0);
+  s = inline_db->HIncrby("GP2_INLINE_KEY", "counter", 5, &value_ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value_ret, 5);
+  s = inline_db->HDel("GP2_INLINE_KEY", {"f1", "f5"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(size_match(inline_db.get(), "GP2_INLINE_KEY", 3));
+  ASSERT_TRUE(
+      field_value_match(inline_db.get(), "GP2_INLINE_KEY", {{"f2", "v22"}, {"f3", "v3"}, {"counter", "5"}}));
+
+  // ***************** Group 3 Test *****************
+  // Growing past the limit moves the fields to data keys
+  s = inline_db->HMSet("GP3_INLINE_KEY", {{"a", "1"}, {"b", "2"}});
+  ASSERT_TRUE(s.ok());
+  std::vector<FieldValue> expect_field_value{{"a", "1"}, {"b", "2"}};
+  for (int32_t idx = 0; idx < 8; ++idx) {
+    s = inline_db->HSet("GP3_INLINE_KEY", "c" + std::to_string(idx), std::to_string(idx), &ret);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(ret, 1);
+    expect_field_value.push_back({"c" + std::to_string(idx), std::to_string(idx)});
+  }
+  ASSERT_TRUE(size_match(inline_db.get(), "GP3_INLINE_KEY", 10));
+  ASSERT_TRUE(field_value_match(inline_db.get(), "GP3_INLINE_KEY", expect_field_value));
+  int64_t next_cursor = 0;
+  s = inline_db->HScan("GP3_INLINE_KEY", 0, "*", 10, &field_value_out, &next_cursor);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(field_value_match(field_value_out, expect_field_value));
+  ASSERT_EQ(next_cursor, 0);
+  // Shrinking again keeps the data keys
+  s = inline_db->HDel("GP3_INLINE_KEY", {"c0", "c1", "c2", "c3", "c4", "c5", "c6"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 7);
+  ASSERT_TRUE(field_value_match(inline_db.get(), "GP3_INLINE_KEY", {{"a", "1"}, {"b", "2"}, {"c7", "7"}}));
+
+  // ***************** Group 4 Test *****************
+  // A field too large for the meta value
+  s = inline_db->HSet("GP4_INLINE_KEY", "big", std::string(2048, 'x'), &ret);
+  ASSERT_TRUE(s.ok());
+  s = inline_db->HGet("GP4_INLINE_KEY", "big", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, std::string(2048, 'x'));
+
+  // ***************** Group 5 Test *****************
+  // Emptied and deleted hashes are recreated inline
+  s = inline_db->HDel("GP2_INLINE_KEY", {"f2", "f3", "counter"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 3);
+  ASSERT_TRUE(size_match(inline_db.get(), "GP2_INLINE_KEY", 0));
+  s = inline_db->HGet("GP2_INLINE_KEY", "f2", &value);
+  ASSERT_TRUE(s.IsNotFound());
+  s = inline_db->HSet("GP2_INLINE_KEY", "f9", "v9", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(field_value_match(inline_db.get(), "GP2_INLINE_KEY", {{"f9", "v9"}}));
+  ASSERT_EQ(inline_db->Del({"GP3_INLINE_KEY"}), 1);
+  s = inline_db->HMSet("GP3_INLINE_KEY", {{"x", "y"}});
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(field_value_match(inline_db.get(), "GP3_INLINE_KEY", {{"x", "y"}}));
+
+  // ***************** Group 6 Test *****************
+  // Inline hashes stay readable and writable once the option goes back to 0
+  inline_db.reset();
+  options.inline_collection_max_entries = 0;
+  inline_db = std::make_unique<storage::Storage>();
+  s = inline_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(field_value_match(inline_db.get(), "GP2_INLINE_KEY", {{"f9", "v9"}}));
+  s = inline_db->HSet("GP2_INLINE_KEY", "f10", "v10", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(size_match(inline_db.get(), "GP2_INLINE_KEY", 2));
+  ASSERT_TRUE(field_value_match(inline_db.get(), "GP2_INLINE_KEY", {{"f9", "v9"}, {"f10", "v10"}}));
+  s = inline_db->HGet("GP3_INLINE_KEY", "x", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, "y");
+
+  // ***************** Group 7 Test *****************
+  // The marker kept in the meta cf is no key and outlives a compaction
+  std::vector<std::string> keys;
+  s = inline_db->Keys(storage::DataType::kAll, "*", &keys);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(keys.size(), 4);
+  s = inline_db->Compact(storage::DataType::kAll, true);
+  ASSERT_TRUE(s.ok());
+  inline_db.reset();
+  inline_db = std::make_unique<storage::Storage>();
+  s = inline_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+  s = inline_db->HSet("GP2_INLINE_KEY", "f11", "v11", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(field_value_match(inline_db.get(), "GP2_INLINE_KEY", {{"f9", "v9"}, {"f10", "v10"}, {"f11", "v11"}}));
+
+  inline_db.reset();
+  DeleteFiles(path.c_str());
+}
+
+// Large field values in blob files
+TEST_F(HashesTest, BlobHashesTest) {  // NOLINT
+  std::string path = "./db/hashes_blob";
+  pstd::DeleteDirIfExist(path);
+  mkdir(path.c_str(), 0755);
+  storage::StorageOptions options;
+  options.options.create_if_missing = true;
+  options.options.enable_blob_files = true;
+  options.options.min_blob_size = 1024;
+  auto blob_db = std::make_unique<storage::Storage>();
+  s = blob_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+
+  int32_t ret;
+  std::string value;
+  std::string large_value(4096, 'b');
+
+  // ***************** Group 1 Test *****************
+  // Values above min_blob_size are read back after a compaction
+  s = blob_db->HMSet("GP1_BLOB_KEY", {{"small", "v"}, {"large", large_value}});
+  ASSERT_TRUE(s.ok());
+  s = blob_db->Compact(DataType::kHashes, true);
+  ASSERT_TRUE(s.ok());
+  s = blob_db->HGet("GP1_BLOB_KEY", "large", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, large_value);
+  ASSERT_TRUE(field_value_match(blob_db.get(), "GP1_BLOB_KEY", {{"small", "v"}, {"large", large_value}}));
+
+  // ***************** Group 2 Test *****************
+  // The data filter drops the fields of a deleted hash by their keys
+  ASSERT_EQ(blob_db->Del({"GP1_BLOB_KEY"}), 1);
+  s = blob_db->Compact(DataType::kHashes, true);
+  ASSERT_TRUE(s.ok());
+  s = blob_db->HGet("GP1_BLOB_KEY", "large", &value);
+  ASSERT_TRUE(s.IsNotFound());
+  s = blob_db->HSet("GP1_BLOB_KEY", "large", "v2", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(field_value_match(blob_db.get(), "GP1_BLOB_KEY", {{"large", "v2"}}));
+
+  // ***************** Group 3 Test *****************
+  // The blob options change at runtime
+  s = blob_db->SetOptions(OptionType::kColumnFamily, storage::ALL_DB,
+                          {{"min_blob_size", "8192"}, {"enable_blob_garbage_collection", "true"}});
+  ASSERT_TRUE(s.ok());
+  s = blob_db->HSet("GP3_BLOB_KEY", "large", large_value, &ret);
+  ASSERT_TRUE(s.ok());
+  s = blob_db->Compact(DataType::kHashes, true);
+  ASSERT_TRUE(s.ok());
+  s = blob_db->HGet("GP3_BLOB_KEY", "large", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, large_value);
+
+  blob_db.reset();
+  DeleteFiles(path.c_str());
+}
+
+TEST_F(HashesTest, ApplyStagedWritesTest) {  // NOLINT
+  int32_t ret = 0;
+  std::string value;
+  std::vector<storage::KeyInfo> key_infos;
+  auto staged = [](StagedWrite::Type type, const std::string& key, const std::string& value,
+                   std::vector<FieldValue> fvs) {
+    StagedWrite write;
+    write.type = type;
+    write.key = key;
+    write.value = value;
+    write.fvs = std::move(fvs);
+    return write;
+  };
+
+  // ***************** Group 1 Test *****************
+  // The writes of the instances go in, HSET reports the new fields
+  s = db.HSet("GP1_STAGED_HASH", "old_field", "old_value", &ret);
+  ASSERT_TRUE(s.ok());
+  std::vector<StagedWrite> writes;
+  writes.push_back(staged(StagedWrite::kSet, "GP1_STAGED_STRING", "value", {}));
+  writes.push_back(staged(StagedWrite::kHSet, "GP1_STAGED_HASH", "", {{"old_field", "new_value"}}));
+  writes.push_back(staged(StagedWrite::kHSet, "GP1_STAGED_NEW_HASH", "", {{"field", "value"}}));
+  writes.push_back(staged(StagedWrite::kHMSet, "GP1_STAGED_HMSET", "", {{"f1", "v1"}, {"f2", "v2"}, {"f1", "v3"}}));
+  s = db.ApplyStagedWrites(&writes);
+  ASSERT_TRUE(s.ok());
+  for (const auto& write : writes) {
+    ASSERT_TRUE(write.status.ok());
+  }
+  ASSERT_EQ(writes[1].ret, 0);
+  ASSERT_EQ(writes[2].ret, 1);
+  s = db.Get("GP1_STAGED_STRING", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, "value");
+  ASSERT_TRUE(field_value_match(&db, "GP1_STAGED_HASH", {{"old_field", "new_value"}}));
+  ASSERT_TRUE(field_value_match(&db, "GP1_STAGED_NEW_HASH", {{"field", "value"}}));
+  ASSERT_TRUE(field_value_match(&db, "GP1_STAGED_HMSET", {{"f1", "v3"}, {"f2", "v2"}}));
+
+  // ***************** Group 2 Test *****************
+  // A write of the wrong type is left out, the others are applied
+  writes.clear();
+  writes.push_back(staged(StagedWrite::kHSet, "GP1_STAGED_STRING", "", {{"field", "value"}}));
+  writes.push_back(staged(StagedWrite::kHMSet, "GP1_STAGED_HMSET", "", {{"f3", "v3"}}));
+  writes.push_back(staged(StagedWrite::kSet, "GP2_STAGED_STRING", "value", {}));
+  s = db.ApplyStagedWrites(&writes);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(writes[0].status.IsInvalidArgument());
+  ASSERT_TRUE(writes[1].status.ok());
+  ASSERT_TRUE(writes[2].status.ok());
+  s = db.Get("GP1_STAGED_STRING", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, "value");
+  ASSERT_TRUE(field_value_match(&db, "GP1_STAGED_HMSET", {{"f1", "v3"}, {"f2", "v2"}, {"f3", "v3"}}));
+  s = db.Get("GP2_STAGED_STRING", &value);
+  ASSERT_TRUE(s.ok());
+
+  // ***************** Group 3 Test *****************
+  // The key counters follow the staged writes
+  s = db.GetKeyCounters(&key_infos);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(key_infos[0].keys, 2);
+  ASSERT_EQ(key_infos[1].keys, 3);
+}
+
 int main(int argc, char** argv) {
   if (!pstd::FileExists("./log")) {
     pstd::CreatePath("./log");
@@ -4,7 +4,9 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <thread>
 
 #include "glog/logging.h"
@@ -5250,6 +5252,358 @@ TEST_F(KeysTest, TTLTest) {
 }
 
 
+// SlotIndex
+TEST_F(KeysTest, SlotIndexTest) {
+  int32_t ret = 0;
+  int64_t count = 0;
+  int64_t next_cursor = 0;
+  std::vector<std::string> type_keys;
+
+  // ***************** Group 1 Test *****************
+  // keys of one slot sharing a hash tag, written while the index is off
+  std::vector<std::string> keys = {"{SLOT_INDEX_TAG}_1", "{SLOT_INDEX_TAG}_2", "{SLOT_INDEX_TAG}_3"};
+  auto slot_id = static_cast<uint32_t>(GetSlotID(db.GetSlotNum(), keys[0]));
+  s = db.Set(keys[0], "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.HSet(keys[1], "FIELD", "VALUE", &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.SlotIndexCount(slot_id, &count);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(count, 0);
+
+  // indexed on demand with the type of the stored key, once
+  s = db.SlotIndexAdd(keys[0], 'k');
+  ASSERT_TRUE(s.ok());
+  s = db.SlotIndexAdd(keys[1], 'k');
+  ASSERT_TRUE(s.ok());
+  s = db.SlotIndexAdd(keys[1], 'h');
+  ASSERT_TRUE(s.ok());
+  s = db.SlotIndexAdd(keys[2], 'k');
+  ASSERT_TRUE(s.IsNotFound());
+  s = db.SlotIndexCount(slot_id, &count);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(count, 2);
+
+  // ***************** Group 2 Test *****************
+  // the writes index the keys they create
+  db.SetSlotIndexEnabled(true);
+  s = db.Set(keys[2], "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.Set(keys[2], "OTHER_VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.SlotIndexCount(slot_id, &count);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(count, 3);
+
+  s = db.SlotIndexScan(slot_id, 0, "*", 2, &type_keys, &next_cursor);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(type_keys, std::vector<std::string>({"k{SLOT_INDEX_TAG}_1", "h{SLOT_INDEX_TAG}_2"}));
+  ASSERT_EQ(next_cursor, 2);
+  s = db.SlotIndexScan(slot_id, next_cursor, "*", 2, &type_keys, &next_cursor);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(type_keys, std::vector<std::string>({"k{SLOT_INDEX_TAG}_3"}));
+  ASSERT_EQ(next_cursor, 0);
+
+  s = db.SlotIndexTagKeys("{SLOT_INDEX_TAG}_OTHER", &type_keys);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(type_keys.size(), 3);
+
+  // ***************** Group 3 Test *****************
+  // and drop the keys they empty or delete
+  s = db.HDel(keys[1], {"FIELD"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(db.Del({keys[2]}), 1);
+  s = db.SlotIndexCount(slot_id, &count);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(count, 1);
+  s = db.SlotIndexTagKeys(keys[0], &type_keys);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(type_keys, std::vector<std::string>({"k{SLOT_INDEX_TAG}_1"}));
+
+  // a stored key keeps its entries
+  s = db.SlotIndexDel(keys[0]);
+  ASSERT_TRUE(s.IsBusy());
+  s = db.SlotIndexDel(keys[1]);
+  ASSERT_TRUE(s.IsNotFound());
+
+  // ***************** Group 4 Test *****************
+  // a compaction takes an expired key off its slot once, with the next
+  // write, which counts the key written again as a new one
+  s = db.Setex(keys[2], "VALUE", 1);
+  ASSERT_TRUE(s.ok());
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  s = db.Compact(DataType::kAll, true);
+  ASSERT_TRUE(s.ok());
+  s = db.Set(keys[2], "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.SlotIndexCount(slot_id, &count);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(count, 2);
+  ASSERT_EQ(db.Del({keys[2]}), 1);
+
+  // ***************** Group 5 Test *****************
+  // a key deleted while the index is off leaves its entries behind
+  db.SetSlotIndexEnabled(false);
+  ASSERT_EQ(db.Del({keys[0]}), 1);
+  s = db.SlotIndexDelSlot(slot_id, &count);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(count, 1);
+  s = db.SlotIndexScan(slot_id, 0, "*", 10, &type_keys, &next_cursor);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(type_keys.empty());
+  s = db.SlotIndexTagKeys(keys[0], &type_keys);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(type_keys.empty());
+}
+
+
+// KeyCounters
+TEST_F(KeysTest, KeyCountersTest) {
+  int32_t ret = 0;
+  std::vector<storage::KeyInfo> key_infos;
+  std::vector<storage::KeyInfo> scan_key_infos;
+
+  // ***************** Group 1 Test *****************
+  // a new database starts with reconciled counters
+  s = db.GetKeyCounters(&key_infos);
+  ASSERT_TRUE(s.ok());
+  for (const auto& key_info : key_infos) {
+    ASSERT_EQ(key_info.keys, 0);
+  }
+
+  s = db.Set("KEY_COUNTERS_STRING_1", "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.Set("KEY_COUNTERS_STRING_2", "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.Setex("KEY_COUNTERS_STRING_3", "VALUE", 100 * 1000);
+  ASSERT_TRUE(s.ok());
+  // overwriting does not count twice
+  s = db.Set("KEY_COUNTERS_STRING_1", "NEW_VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.HSet("KEY_COUNTERS_HASH", "FIELD", "VALUE", &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.SAdd("KEY_COUNTERS_SET", {"MEMBER_1", "MEMBER_2"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(db.Expire("KEY_COUNTERS_HASH", 100 * 1000), 1);
+
+  s = db.GetKeyCounters(&key_infos);
+  ASSERT_TRUE(s.ok());
+  // strings, hashes, lists, zsets, sets, streams
+  ASSERT_EQ(key_infos[0].keys, 3);
+  ASSERT_EQ(key_infos[0].expires, 1);
+  ASSERT_EQ(key_infos[1].keys, 1);
+  ASSERT_EQ(key_infos[1].expires, 1);
+  ASSERT_EQ(key_infos[4].keys, 1);
+  ASSERT_EQ(key_infos[4].expires, 0);
+
+  // ***************** Group 2 Test *****************
+  ASSERT_EQ(db.Del({"KEY_COUNTERS_STRING_2"}), 1);
+  s = db.SRem("KEY_COUNTERS_SET", {"MEMBER_1", "MEMBER_2"}, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.GetKeyCounters(&key_infos);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(key_infos[0].keys, 2);
+  ASSERT_EQ(key_infos[0].expires, 1);
+  ASSERT_EQ(key_infos[4].keys, 0);
+  ASSERT_EQ(key_infos[4].invaild_keys, 1);
+
+  // ***************** Group 3 Test *****************
+  // the full scan finds the same numbers and leaves the counters as they are
+  s = db.GetKeyNum(&scan_key_infos);
+  ASSERT_TRUE(s.ok());
+  s = db.GetKeyCounters(&key_infos);
+  ASSERT_TRUE(s.ok());
+  for (size_t idx = 0; idx < key_infos.size(); ++idx) {
+    ASSERT_EQ(key_infos[idx].keys, scan_key_infos[idx].keys);
+    ASSERT_EQ(key_infos[idx].expires, scan_key_infos[idx].expires);
+    ASSERT_EQ(key_infos[idx].invaild_keys, scan_key_infos[idx].invaild_keys);
+  }
+
+  // ***************** Group 4 Test *****************
+  // the compaction takes the emptied set off the counters once, the set
+  // written again after it is counted as a new key
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  s = db.Compact(DataType::kAll, true);
+  ASSERT_TRUE(s.ok());
+  s = db.GetKeyCounters(&key_infos);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(key_infos[4].invaild_keys, 0);
+  s = db.SAdd("KEY_COUNTERS_SET", {"MEMBER_1"}, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.Compact(DataType::kAll, true);
+  ASSERT_TRUE(s.ok());
+  s = db.GetKeyCounters(&key_infos);
+  ASSERT_TRUE(s.ok());
+  s = db.GetKeyNum(&scan_key_infos);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(key_infos[4].keys, 1);
+  for (size_t idx = 0; idx < key_infos.size(); ++idx) {
+    ASSERT_EQ(key_infos[idx].keys, scan_key_infos[idx].keys);
+    ASSERT_EQ(key_infos[idx].invaild_keys, scan_key_infos[idx].invaild_keys);
+  }
+
+  db.Del({"KEY_COUNTERS_STRING_1", "KEY_COUNTERS_STRING_3", "KEY_COUNTERS_HASH", "KEY_COUNTERS_SET"});
+  s = db.GetKeyCounters(&key_infos);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(key_infos[0].keys, 0);
+  ASSERT_EQ(key_infos[1].keys, 0);
+}
+
+
+// Keys and PKPatternMatchDel over a keyspace split into ranges
+TEST_F(KeysTest, ParallelKeyspaceScanTest) {
+  char buf[32];
+  std::vector<std::string> expected;
+  for (int idx = 0; idx < 1000; ++idx) {
+    snprintf(buf, sizeof(buf), "PARALLEL_SCAN_%04d", idx);
+    s = db.Set(buf, "VALUE");
+    ASSERT_TRUE(s.ok());
+    expected.emplace_back(buf);
+    // compacted into several sst files to split at
+    if (idx % 250 == 249) {
+      s = db.Compact(DataType::kAll, true);
+      ASSERT_TRUE(s.ok());
+    }
+  }
+  s = db.Set("PARALLEL_SCAN", "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.Set("PARALLEL_SCAO", "VALUE");
+  ASSERT_TRUE(s.ok());
+
+  // ***************** Group 1 Test *****************
+  std::vector<std::string> keys;
+  for (size_t threads : {1, 4}) {
+    db.SetKeyspaceScanThreads(threads);
+    s = db.Keys(DataType::kAll, "PARALLEL_SCAN_*", &keys);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(keys, expected);
+    s = db.Keys(DataType::kStrings, "PARALLEL_SCAN_00?1", &keys);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(keys.size(), 10);
+  }
+
+  // ***************** Group 2 Test *****************
+  int64_t ret = 0;
+  std::vector<std::string> remove_keys;
+  s = db.PKPatternMatchDelWithRemoveKeys("PARALLEL_SCAN_01*", &ret, &remove_keys, 50);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 50);
+  ASSERT_EQ(remove_keys.size(), 50);
+  s = db.Keys(DataType::kAll, "PARALLEL_SCAN*", &keys);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(keys.size(), 951);
+
+  db.Del(keys);
+}
+
+// Active expiration through the expiry index
+TEST_F(KeysTest, ExpireIndexTest) {
+  std::string path = "./db/expire_index";
+  pstd::DeleteDirIfExist(path);
+  mkdir(path.c_str(), 0755);
+  storage::StorageOptions options;
+  options.options.create_if_missing = true;
+  options.enable_expire_index = true;
+  auto expire_db = std::make_unique<storage::Storage>();
+  s = expire_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+
+  int32_t ret = 0;
+  int64_t lag = 0;
+  std::string value;
+  std::vector<std::string> keys;
+  std::vector<std::string> reaped;
+  std::vector<storage::KeyInfo> key_infos;
+
+  // ***************** Group 1 Test *****************
+  // only the keys that expired are found, whatever their type
+  s = expire_db->Setex("EXPIRE_INDEX_STRING", "VALUE", 1);
+  ASSERT_TRUE(s.ok());
+  s = expire_db->HSet("EXPIRE_INDEX_HASH", "FIELD", "VALUE", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(expire_db->Expire("EXPIRE_INDEX_HASH", 1), 1);
+  s = expire_db->SAdd("EXPIRE_INDEX_SET", {"MEMBER"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(expire_db->Expire("EXPIRE_INDEX_SET", 1), 1);
+  s = expire_db->Setex("EXPIRE_INDEX_LATER", "VALUE", 100 * 1000);
+  ASSERT_TRUE(s.ok());
+  // a TTL that was removed or replaced leaves no entry behind
+  s = expire_db->Setex("EXPIRE_INDEX_PERSIST", "VALUE", 50);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(expire_db->Persist("EXPIRE_INDEX_PERSIST"), 1);
+  s = expire_db->Setex("EXPIRE_INDEX_OVERWRITE", "VALUE", 50);
+  ASSERT_TRUE(s.ok());
+  s = expire_db->Set("EXPIRE_INDEX_OVERWRITE", "VALUE");
+  ASSERT_TRUE(s.ok());
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  s = expire_db->ScanExpiredKeys(100, &keys, &lag);
+  ASSERT_TRUE(s.ok());
+  std::sort(keys.begin(), keys.end());
+  ASSERT_EQ(keys, std::vector<std::string>({"EXPIRE_INDEX_HASH", "EXPIRE_INDEX_SET", "EXPIRE_INDEX_STRING"}));
+  ASSERT_GT(lag, 0);
+
+  // ***************** Group 2 Test *****************
+  s = expire_db->ReapExpiredKeys(keys, &reaped);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(reaped.size(), 3);
+  s = expire_db->GetKeyCounters(&key_infos);
+  ASSERT_TRUE(s.ok());
+  // strings, hashes, lists, zsets, sets, streams
+  ASSERT_EQ(key_infos[0].keys, 3);
+  ASSERT_EQ(key_infos[0].expires, 1);
+  ASSERT_EQ(key_infos[1].keys, 0);
+  ASSERT_EQ(key_infos[4].keys, 0);
+  s = expire_db->ScanExpiredKeys(100, &keys, &lag);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(keys.empty());
+  ASSERT_EQ(lag, 0);
+
+  // ***************** Group 3 Test *****************
+  // a key that got a new TTL after it was found is not reaped
+  s = expire_db->Setex("EXPIRE_INDEX_AGAIN", "VALUE", 1);
+  ASSERT_TRUE(s.ok());
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  s = expire_db->ScanExpiredKeys(100, &keys, &lag);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(keys, std::vector<std::string>({"EXPIRE_INDEX_AGAIN"}));
+  s = expire_db->Setex("EXPIRE_INDEX_AGAIN", "VALUE", 100 * 1000);
+  ASSERT_TRUE(s.ok());
+  s = expire_db->ReapExpiredKeys(keys, &reaped);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(reaped.empty());
+  s = expire_db->Get("EXPIRE_INDEX_AGAIN", &value);
+  ASSERT_TRUE(s.ok());
+
+  // ***************** Group 4 Test *****************
+  // keys that got a TTL while the index was off are indexed after a reopen
+  expire_db.reset();
+  options.enable_expire_index = false;
+  expire_db = std::make_unique<storage::Storage>();
+  s = expire_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+  s = expire_db->Setex("EXPIRE_INDEX_UNINDEXED", "VALUE", 1);
+  ASSERT_TRUE(s.ok());
+  expire_db.reset();
+  options.enable_expire_index = true;
+  expire_db = std::make_unique<storage::Storage>();
+  s = expire_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+  for (int retry = 0; retry < 50; ++retry) {
+    s = expire_db->ScanExpiredKeys(100, &keys, &lag);
+    ASSERT_TRUE(s.ok());
+    if (!keys.empty()) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  ASSERT_EQ(keys, std::vector<std::string>({"EXPIRE_INDEX_UNINDEXED"}));
+
+  expire_db.reset();
+  storage::DeleteFiles(path.c_str());
+}
+
+
 int main(int argc, char** argv) {
   if (!pstd::FileExists("./log")) {
     pstd::CreatePath("./log");
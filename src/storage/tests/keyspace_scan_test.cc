@@ -0,0 +1,79 @@
+//  Copyright (c) 2024-present, Qihoo, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "src/keyspace_scan.h"
+
+using namespace storage;
+
+// Every task runs once, on at most the threads of the pool
+TEST(KeyspaceScanPoolTest, RunTest) {
+  KeyspaceScanPool pool(3);
+  std::vector<std::atomic<int>> runs(100);
+  std::atomic<int> running = {0};
+  std::atomic<int> max_running = {0};
+  Status s = pool.Run(runs.size(), [&](size_t idx) {
+    int now = ++running;
+    int max = max_running;
+    while (now > max && !max_running.compare_exchange_weak(max, now)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ++runs[idx];
+    --running;
+    return Status::OK();
+  });
+  ASSERT_TRUE(s.ok());
+  for (const auto& run : runs) {
+    ASSERT_EQ(run.load(), 1);
+  }
+  ASSERT_LE(max_running.load(), 3);
+}
+
+// The first failure is returned and the tasks not started are skipped
+TEST(KeyspaceScanPoolTest, FailureTest) {
+  KeyspaceScanPool pool(1);
+  std::atomic<int> runs = {0};
+  Status s = pool.Run(10, [&](size_t idx) {
+    ++runs;
+    return idx == 2 ? Status::Corruption("task 2") : Status::OK();
+  });
+  ASSERT_TRUE(s.IsCorruption());
+  ASSERT_EQ(runs.load(), 3);
+}
+
+// Concurrent scans share the workers, resizing waits for none of them
+TEST(KeyspaceScanPoolTest, SharedTest) {
+  KeyspaceScanPool pool(4);
+  std::atomic<int> total = {0};
+  std::vector<std::thread> scans;
+  for (int scan = 0; scan < 4; ++scan) {
+    scans.emplace_back([&]() {
+      for (int round = 0; round < 10; ++round) {
+        Status s = pool.Run(16, [&](size_t) {
+          ++total;
+          return Status::OK();
+        });
+        ASSERT_TRUE(s.ok());
+      }
+    });
+  }
+  pool.SetThreads(2);
+  pool.SetThreads(6);
+  for (auto& scan : scans) {
+    scan.join();
+  }
+  ASSERT_EQ(total.load(), 4 * 10 * 16);
+  ASSERT_EQ(pool.Threads(), 6);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -5,6 +5,7 @@
 
 #include <gtest/gtest.h>
 #include <iostream>
+#include <memory>
 #include <thread>
 
 #include "glog/logging.h"
@@ -2705,6 +2706,152 @@ TEST_F(ListsTest, RPushxTest) {  // NOLINT
   ASSERT_TRUE(s.ok());
 }
 
+// Chunked lists
+TEST_F(ListsTest, ChunkedListsTest) {  // NOLINT
+  std::string path = "./db/lists_chunked";
+  pstd::DeleteDirIfExist(path);
+  mkdir(path.c_str(), 0755);
+  storage::StorageOptions options;
+  options.options.create_if_missing = true;
+  auto chunked_db = std::make_unique<storage::Storage>();
+  s = chunked_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+
+  uint64_t num;
+  int64_t ret;
+  std::string element;
+  std::vector<std::string> elements;
+
+  // A legacy list written before chunking is turned on
+  s = chunked_db->RPush("GP1_CHUNKED_KEY", {"l1", "l2", "l3"}, &num);
+  ASSERT_TRUE(s.ok());
+  chunked_db.reset();
+  options.list_chunk_max_elements = 4;
+  chunked_db = std::make_unique<storage::Storage>();
+  s = chunked_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+
+  // ***************** Group 1 Test *****************
+  // The legacy list is still readable and writable
+  s = chunked_db->LPush("GP1_CHUNKED_KEY", {"l0"}, &num);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(num, 4);
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP1_CHUNKED_KEY", {"l0", "l1", "l2", "l3"}));
+  s = chunked_db->LInsert("GP1_CHUNKED_KEY", storage::After, "l1", "lx", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 5);
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP1_CHUNKED_KEY", {"l0", "l1", "lx", "l2", "l3"}));
+
+  // ***************** Group 2 Test *****************
+  // Pushes on both ends span several chunks
+  std::vector<std::string> expect;
+  for (int32_t idx = 0; idx < 10; ++idx) {
+    s = chunked_db->RPush("GP2_CHUNKED_KEY", {"r" + std::to_string(idx)}, &num);
+    ASSERT_TRUE(s.ok());
+    expect.push_back("r" + std::to_string(idx));
+  }
+  s = chunked_db->LPush("GP2_CHUNKED_KEY", {"a", "b", "c", "d", "e", "f"}, &num);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(num, 16);
+  expect.insert(expect.begin(), {"f", "e", "d", "c", "b", "a"});
+  ASSERT_TRUE(len_match(chunked_db.get(), "GP2_CHUNKED_KEY", 16));
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP2_CHUNKED_KEY", expect));
+  for (int32_t idx = 0; idx < 16; ++idx) {
+    s = chunked_db->LIndex("GP2_CHUNKED_KEY", idx, &element);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(element, expect[idx]);
+    s = chunked_db->LIndex("GP2_CHUNKED_KEY", idx - 16, &element);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(element, expect[idx]);
+  }
+  s = chunked_db->LIndex("GP2_CHUNKED_KEY", 16, &element);
+  ASSERT_TRUE(s.IsNotFound());
+  s = chunked_db->LRange("GP2_CHUNKED_KEY", 3, -4, &elements);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(elements_match(elements, std::vector<std::string>(expect.begin() + 3, expect.end() - 3)));
+
+  // ***************** Group 3 Test *****************
+  // Edits in the middle
+  s = chunked_db->LSet("GP2_CHUNKED_KEY", 7, "set");
+  ASSERT_TRUE(s.ok());
+  expect[7] = "set";
+  s = chunked_db->LSet("GP2_CHUNKED_KEY", 16, "set");
+  ASSERT_TRUE(s.IsCorruption());
+  for (int32_t idx = 0; idx < 5; ++idx) {
+    s = chunked_db->LInsert("GP2_CHUNKED_KEY", storage::Before, "r4", "ins", &ret);
+    ASSERT_TRUE(s.ok());
+    expect.insert(expect.begin() + 10, "ins");
+  }
+  ASSERT_EQ(ret, 21);
+  s = chunked_db->LInsert("GP2_CHUNKED_KEY", storage::Before, "none", "ins", &ret);
+  ASSERT_TRUE(s.IsNotFound());
+  ASSERT_EQ(ret, -1);
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP2_CHUNKED_KEY", expect));
+
+  s = chunked_db->LRem("GP2_CHUNKED_KEY", -2, "ins", &num);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(num, 2);
+  expect.erase(expect.begin() + 13, expect.begin() + 15);
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP2_CHUNKED_KEY", expect));
+  s = chunked_db->LRem("GP2_CHUNKED_KEY", 0, "ins", &num);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(num, 3);
+  expect.erase(expect.begin() + 10, expect.begin() + 13);
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP2_CHUNKED_KEY", expect));
+
+  // ***************** Group 4 Test *****************
+  // Pops, trims and moves
+  s = chunked_db->LPop("GP2_CHUNKED_KEY", 5, &elements);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(elements_match(elements, std::vector<std::string>(expect.begin(), expect.begin() + 5)));
+  expect.erase(expect.begin(), expect.begin() + 5);
+  s = chunked_db->RPop("GP2_CHUNKED_KEY", 2, &elements);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(elements_match(elements, {expect[expect.size() - 1], expect[expect.size() - 2]}));
+  expect.resize(expect.size() - 2);
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP2_CHUNKED_KEY", expect));
+
+  s = chunked_db->RPoplpush("GP2_CHUNKED_KEY", "GP2_CHUNKED_KEY", &element);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(element, expect.back());
+  expect.insert(expect.begin(), expect.back());
+  expect.pop_back();
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP2_CHUNKED_KEY", expect));
+  s = chunked_db->RPoplpush("GP2_CHUNKED_KEY", "GP1_CHUNKED_KEY", &element);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(element, expect.back());
+  expect.pop_back();
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP1_CHUNKED_KEY", {element, "l0", "l1", "lx", "l2", "l3"}));
+  s = chunked_db->RPoplpush("GP1_CHUNKED_KEY", "GP2_CHUNKED_KEY", &element);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(element, "l3");
+  expect.insert(expect.begin(), "l3");
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP2_CHUNKED_KEY", expect));
+
+  s = chunked_db->LTrim("GP2_CHUNKED_KEY", 1, -2);
+  ASSERT_TRUE(s.ok());
+  expect = std::vector<std::string>(expect.begin() + 1, expect.end() - 1);
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP2_CHUNKED_KEY", expect));
+  s = chunked_db->LTrim("GP2_CHUNKED_KEY", 5, 2);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(len_match(chunked_db.get(), "GP2_CHUNKED_KEY", 0));
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP2_CHUNKED_KEY", {}));
+
+  // ***************** Group 5 Test *****************
+  // A deleted list comes back empty
+  s = chunked_db->RPush("GP5_CHUNKED_KEY", {"a", "b", "c", "d", "e", "f"}, &num);
+  ASSERT_TRUE(s.ok());
+  std::vector<std::string> del_keys{"GP5_CHUNKED_KEY"};
+  ASSERT_EQ(chunked_db->Del(del_keys), 1);
+  s = chunked_db->RPush("GP5_CHUNKED_KEY", {"x"}, &num);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(num, 1);
+  ASSERT_TRUE(elements_match(chunked_db.get(), "GP5_CHUNKED_KEY", {"x"}));
+
+  chunked_db.reset();
+  pstd::DeleteDirIfExist(path);
+}
+
 int main(int argc, char** argv) {
   if (!pstd::FileExists("./log")) {
     pstd::CreatePath("./log");
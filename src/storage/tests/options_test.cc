@@ -54,6 +54,29 @@ TEST_F(StorageOptionsTest, ResetOptionsTest) {
   ASSERT_EQ(storage_options.options.max_background_compactions, 32);
 }
 
+// ResetOptions of the blob files options
+TEST_F(StorageOptionsTest, ResetBlobOptionsTest) {
+  std::unordered_map<std::string, std::string> blob_options_map{{"enable_blob_files", "true"},
+                                                                {"min_blob_size", "8192"},
+                                                                {"blob_file_size", "67108864"},
+                                                                {"enable_blob_garbage_collection", "true"},
+                                                                {"blob_garbage_collection_age_cutoff", "0.5"},
+                                                                {"blob_garbage_collection_force_threshold", "0.8"}};
+  s = storage_options.ResetOptions(OptionType::kColumnFamily, blob_options_map);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(storage_options.options.enable_blob_files);
+  ASSERT_EQ(storage_options.options.min_blob_size, 8192);
+  ASSERT_EQ(storage_options.options.blob_file_size, 67108864);
+  ASSERT_TRUE(storage_options.options.enable_blob_garbage_collection);
+  ASSERT_DOUBLE_EQ(storage_options.options.blob_garbage_collection_age_cutoff, 0.5);
+  ASSERT_DOUBLE_EQ(storage_options.options.blob_garbage_collection_force_threshold, 0.8);
+
+  std::unordered_map<std::string, std::string> invalid_blob_options_map{{"blob_garbage_collection_age_cutoff", "0.5x"}};
+  s = storage_options.ResetOptions(OptionType::kColumnFamily, invalid_blob_options_map);
+  ASSERT_FALSE(s.ok());
+  ASSERT_DOUBLE_EQ(storage_options.options.blob_garbage_collection_age_cutoff, 0.5);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -4,7 +4,11 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <set>
 #include <thread>
 
 #include "glog/logging.h"
@@ -2240,6 +2244,246 @@ TEST_F(SetsTest, SScanTest) {  // NOLINT
   ASSERT_TRUE(members_match(member_out, {}));
 }
 
+// Small sets kept in their meta value
+TEST_F(SetsTest, InlineSetsTest) {  // NOLINT
+  std::string path = "./db/sets_inline";
+  pstd::DeleteDirIfExist(path);
+  mkdir(path.c_str(), 0755);
+  storage::StorageOptions options;
+  options.options.create_if_missing = true;
+  options.inline_collection_max_entries = 4;
+  auto inline_db = std::make_unique<storage::Storage>();
+  s = inline_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+
+  int32_t ret;
+  std::vector<std::string> members_out;
+  std::vector<std::string> value_to_dest;
+
+  // ***************** Group 1 Test *****************
+  // A new small set is served from its meta value
+  s = inline_db->SAdd("GP1_INLINE_KEY", {"a", "b", "c", "b"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 3);
+  ASSERT_TRUE(size_match(inline_db.get(), "GP1_INLINE_KEY", 3));
+  ASSERT_TRUE(members_match(inline_db.get(), "GP1_INLINE_KEY", {"a", "b", "c"}));
+  s = inline_db->SIsmember("GP1_INLINE_KEY", "b", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  s = inline_db->SIsmember("GP1_INLINE_KEY", "d", &ret);
+  ASSERT_TRUE(s.IsNotFound() || ret == 0);
+  s = inline_db->SRem("GP1_INLINE_KEY", {"a", "x"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(members_match(inline_db.get(), "GP1_INLINE_KEY", {"b", "c"}));
+
+  // ***************** Group 2 Test *****************
+  // Growing past the limit moves the members to data keys
+  std::vector<std::string> expect_members{"b", "c"};
+  for (int32_t idx = 0; idx < 6; ++idx) {
+    s = inline_db->SAdd("GP2_INLINE_KEY", {"m" + std::to_string(idx)}, &ret);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(ret, 1);
+  }
+  ASSERT_TRUE(size_match(inline_db.get(), "GP2_INLINE_KEY", 6));
+  ASSERT_TRUE(members_match(inline_db.get(), "GP2_INLINE_KEY", {"m0", "m1", "m2", "m3", "m4", "m5"}));
+
+  // ***************** Group 3 Test *****************
+  // Multi-key commands across inline sets and sets with data keys
+  s = inline_db->SAdd("GP3_INLINE_KEY", {"b", "m1", "m2"}, &ret);
+  ASSERT_TRUE(s.ok());
+  s = inline_db->SInter({"GP2_INLINE_KEY", "GP3_INLINE_KEY"}, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(members_match(members_out, {"m1", "m2"}));
+  members_out.clear();
+  s = inline_db->SUnion({"GP1_INLINE_KEY", "GP3_INLINE_KEY"}, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(members_match(members_out, {"b", "c", "m1", "m2"}));
+  members_out.clear();
+  s = inline_db->SDiff({"GP3_INLINE_KEY", "GP1_INLINE_KEY", "GP2_INLINE_KEY"}, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(members_match(members_out, {}));
+  members_out.clear();
+  s = inline_db->SDiff({"GP2_INLINE_KEY", "GP3_INLINE_KEY"}, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(members_match(members_out, {"m0", "m3", "m4", "m5"}));
+  s = inline_db->SInterstore("GP3_INLINE_DEST", {"GP3_INLINE_KEY", "GP2_INLINE_KEY"}, value_to_dest, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 2);
+  ASSERT_TRUE(members_match(inline_db.get(), "GP3_INLINE_DEST", {"m1", "m2"}));
+
+  // ***************** Group 4 Test *****************
+  // SMOVE and SPOP between inline sets
+  s = inline_db->SMove("GP1_INLINE_KEY", "GP3_INLINE_KEY", "c", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(members_match(inline_db.get(), "GP1_INLINE_KEY", {"b"}));
+  ASSERT_TRUE(members_match(inline_db.get(), "GP3_INLINE_KEY", {"b", "c", "m1", "m2"}));
+  members_out.clear();
+  s = inline_db->SPop("GP3_INLINE_KEY", &members_out, 2);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(members_out.size(), 2);
+  ASSERT_TRUE(members_contains(members_out, {"b", "c", "m1", "m2"}));
+  ASSERT_TRUE(size_match(inline_db.get(), "GP3_INLINE_KEY", 2));
+
+  // ***************** Group 5 Test *****************
+  // Inline sets stay readable and writable once the option goes back to 0
+  inline_db.reset();
+  options.inline_collection_max_entries = 0;
+  inline_db = std::make_unique<storage::Storage>();
+  s = inline_db->Open(options, path);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(members_match(inline_db.get(), "GP1_INLINE_KEY", {"b"}));
+  s = inline_db->SAdd("GP1_INLINE_KEY", {"z"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(members_match(inline_db.get(), "GP1_INLINE_KEY", {"b", "z"}));
+  ASSERT_TRUE(members_match(inline_db.get(), "GP3_INLINE_DEST", {"m1", "m2"}));
+
+  inline_db.reset();
+  DeleteFiles(path.c_str());
+}
+
+// SInter, SUnion and SDiff on sets larger than one probe batch, with
+// operands of very different sizes
+TEST_F(SetsTest, SetAlgebraMixedSizesTest) {  // NOLINT
+  int32_t ret;
+  std::vector<std::string> members_out;
+  std::vector<std::string> value_to_dest;
+  std::set<std::string> large;
+  std::set<std::string> medium;
+  std::set<std::string> small;
+  std::vector<std::string> members;
+  for (int32_t idx = 0; idx < 5000; ++idx) {
+    members.push_back("m" + std::to_string(idx));
+    large.insert(members.back());
+  }
+  s = db.SAdd("{GP1_ALGEBRA}_LARGE", members, &ret);
+  ASSERT_TRUE(s.ok());
+  members.clear();
+  for (int32_t idx = 0; idx < 300; ++idx) {
+    members.push_back("m" + std::to_string(idx * 20 + idx % 2 * 10000));
+    medium.insert(members.back());
+  }
+  s = db.SAdd("{GP1_ALGEBRA}_MEDIUM", members, &ret);
+  ASSERT_TRUE(s.ok());
+  members = {"m0", "m40", "m77", "x"};
+  small.insert(members.begin(), members.end());
+  s = db.SAdd("{GP1_ALGEBRA}_SMALL", members, &ret);
+  ASSERT_TRUE(s.ok());
+
+  auto inter = [](const std::set<std::string>& a, const std::set<std::string>& b) {
+    std::vector<std::string> result;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+  };
+  auto diff = [](const std::set<std::string>& a, const std::set<std::string>& b) {
+    std::vector<std::string> result;
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+  };
+
+  // ***************** Group 1 Test *****************
+  // The members come out once each, in member order, whatever the operand order
+  s = db.SInter({"{GP1_ALGEBRA}_LARGE", "{GP1_ALGEBRA}_MEDIUM", "{GP1_ALGEBRA}_SMALL"}, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(members_out, inter(inter(large, medium), small));
+  s = db.SInter({"{GP1_ALGEBRA}_MEDIUM", "{GP1_ALGEBRA}_LARGE"}, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(members_out, inter(medium, large));
+
+  // ***************** Group 2 Test *****************
+  std::set<std::string> all(large);
+  all.insert(medium.begin(), medium.end());
+  all.insert(small.begin(), small.end());
+  s = db.SUnion({"{GP1_ALGEBRA}_SMALL", "{GP1_ALGEBRA}_LARGE", "{GP1_ALGEBRA}_MEDIUM", "{GP1_ALGEBRA}_SMALL"},
+                &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(members_out, std::vector<std::string>(all.begin(), all.end()));
+
+  // ***************** Group 3 Test *****************
+  // The large set is merged with the first set or probed depending on their sizes
+  s = db.SDiff({"{GP1_ALGEBRA}_SMALL", "{GP1_ALGEBRA}_LARGE"}, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(members_out, diff(small, large));
+  s = db.SDiff({"{GP1_ALGEBRA}_MEDIUM", "{GP1_ALGEBRA}_LARGE", "{GP1_ALGEBRA}_SMALL"}, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(members_out, diff(diff(medium, large), small));
+  s = db.SDiff({"{GP1_ALGEBRA}_LARGE", "{GP1_ALGEBRA}_MEDIUM", "{GP1_ALGEBRA}_NOT_EXIST"}, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(members_out, diff(large, medium));
+
+  // ***************** Group 4 Test *****************
+  s = db.SInterstore("{GP1_ALGEBRA}_DEST", {"{GP1_ALGEBRA}_SMALL", "{GP1_ALGEBRA}_LARGE"}, value_to_dest, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 3);
+  ASSERT_TRUE(members_match(&db, "{GP1_ALGEBRA}_DEST", {"m0", "m40", "m77"}));
+  s = db.SDiffstore("{GP1_ALGEBRA}_DEST", {"{GP1_ALGEBRA}_SMALL", "{GP1_ALGEBRA}_LARGE"}, value_to_dest, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(members_match(&db, "{GP1_ALGEBRA}_DEST", {"x"}));
+}
+
+// SRandmember and SPop on a set past the size it is walked at
+TEST_F(SetsTest, SampleLargeSetTest) {  // NOLINT
+  int32_t ret;
+  int32_t card;
+  std::set<std::string> all;
+  std::vector<std::string> members;
+  std::vector<std::string> members_out;
+  for (int32_t idx = 0; idx < 5000; ++idx) {
+    members.push_back("m" + std::to_string(idx));
+    all.insert(members.back());
+  }
+  s = db.SAdd("GP1_SAMPLE_KEY", members, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 5000);
+
+  // ***************** Group 1 Test *****************
+  // Distinct members for a positive count
+  for (int32_t round = 0; round < 10; ++round) {
+    s = db.SRandmember("GP1_SAMPLE_KEY", 20, &members_out);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(members_out.size(), 20U);
+    std::set<std::string> unique(members_out.begin(), members_out.end());
+    ASSERT_EQ(unique.size(), 20U);
+    for (const auto& member : members_out) {
+      ASSERT_TRUE(all.count(member));
+    }
+  }
+
+  // ***************** Group 2 Test *****************
+  // Members may repeat for a negative count
+  s = db.SRandmember("GP1_SAMPLE_KEY", -30, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(members_out.size(), 30U);
+  for (const auto& member : members_out) {
+    ASSERT_TRUE(all.count(member));
+  }
+
+  // ***************** Group 3 Test *****************
+  // Popped members leave the set and are not sampled again
+  for (int32_t round = 0; round < 10; ++round) {
+    members_out.clear();
+    s = db.SPop("GP1_SAMPLE_KEY", &members_out, 50);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(members_out.size(), 50U);
+    for (const auto& member : members_out) {
+      ASSERT_EQ(all.erase(member), 1U);
+    }
+  }
+  s = db.SCard("GP1_SAMPLE_KEY", &card);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(card, 4500);
+  s = db.SRandmember("GP1_SAMPLE_KEY", 100, &members_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(members_out.size(), 100U);
+  for (const auto& member : members_out) {
+    ASSERT_TRUE(all.count(member));
+  }
+  ASSERT_TRUE(size_match(&db, "GP1_SAMPLE_KEY", 4500));
+}
+
 int main(int argc, char** argv) {
   if (!pstd::FileExists("./log")) {
     pstd::CreatePath("./log");
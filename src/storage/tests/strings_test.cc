@@ -294,6 +294,55 @@ TEST_F(StringsTest, GetTest) {
   ASSERT_STREQ(value.c_str(), "GET_VALUE_2");
 }
 
+// Get through a pinned slice
+TEST_F(StringsTest, GetPinnedTest) {
+  int32_t ret;
+  int64_t ttl_millsec;
+  rocksdb::PinnableSlice pinned_value;
+  Slice value;
+  std::string large_value(65536, 'p');
+  s = db.Set("GET_PINNED_KEY", large_value);
+  ASSERT_TRUE(s.ok());
+
+  s = db.Get("GET_PINNED_KEY", &pinned_value, &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value.ToString(), large_value);
+  pinned_value.Reset();
+
+  s = db.GetWithTTL("GET_PINNED_KEY", &pinned_value, &value, &ttl_millsec);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value.ToString(), large_value);
+  ASSERT_EQ(ttl_millsec, -1);
+  pinned_value.Reset();
+
+  s = db.Setex("GET_PINNED_TTL_KEY", "GET_PINNED_VALUE", 100 * 1000);
+  ASSERT_TRUE(s.ok());
+  s = db.GetWithTTL("GET_PINNED_TTL_KEY", &pinned_value, &value, &ttl_millsec);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value.ToString(), "GET_PINNED_VALUE");
+  ASSERT_GT(ttl_millsec, 0);
+  ASSERT_LE(ttl_millsec, 100 * 1000);
+  pinned_value.Reset();
+
+  // The key does not exist
+  s = db.GetWithTTL("GET_PINNED_NOT_EXIST_KEY", &pinned_value, &value, &ttl_millsec);
+  ASSERT_TRUE(s.IsNotFound());
+  ASSERT_TRUE(value.empty());
+  ASSERT_EQ(ttl_millsec, -2);
+
+  // The key holds another type
+  s = db.SAdd("GET_PINNED_SET_KEY", {"member"}, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.Get("GET_PINNED_SET_KEY", &pinned_value, &value);
+  ASSERT_TRUE(s.IsInvalidArgument());
+
+  // The key is expired
+  ASSERT_TRUE(make_expired(&db, "GET_PINNED_KEY"));
+  s = db.Get("GET_PINNED_KEY", &pinned_value, &value);
+  ASSERT_TRUE(s.IsNotFound());
+  ASSERT_TRUE(value.empty());
+}
+
 // GetBit
 TEST_F(StringsTest, GetBitTest) {
   int32_t ret;
@@ -569,6 +618,59 @@ TEST_F(StringsTest, MGetTest) {
   ASSERT_EQ(vss[2].value, "");
   ASSERT_TRUE(vss[3].status.IsNotFound());
   ASSERT_EQ(vss[3].value, "");
+
+  // ***************** Group 3 Test *****************
+  // keys spread over every rocksdb instance, the results must keep the
+  // request order, non string keys are returned as nil
+  std::vector<storage::KeyValue> kvs3;
+  std::vector<std::string> keys3;
+  for (int idx = 0; idx < 300; ++idx) {
+    std::string key = "GP3_MGET_KEY" + std::to_string(idx);
+    keys3.push_back(key);
+    if (idx % 3 != 0) {
+      kvs3.push_back({key, "VALUE" + std::to_string(idx)});
+    }
+  }
+  s = db.MSet(kvs3);
+  ASSERT_TRUE(s.ok());
+  int32_t ret = 0;
+  s = db.SAdd("GP3_MGET_KEY0", {"MEMBER"}, &ret);
+  ASSERT_TRUE(s.ok());
+
+  vss.clear();
+  s = db.MGet(keys3, &vss);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(vss.size(), 300);
+  for (int idx = 0; idx < 300; ++idx) {
+    if (idx % 3 != 0) {
+      ASSERT_TRUE(vss[idx].status.ok());
+      ASSERT_EQ(vss[idx].value, "VALUE" + std::to_string(idx));
+    } else {
+      ASSERT_TRUE(vss[idx].status.IsNotFound());
+      ASSERT_EQ(vss[idx].value, "");
+    }
+  }
+
+  vss.clear();
+  s = db.MGetWithTTL(keys3, &vss);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(vss.size(), 300);
+  for (int idx = 0; idx < 300; ++idx) {
+    if (idx % 3 != 0) {
+      ASSERT_TRUE(vss[idx].status.ok());
+      ASSERT_EQ(vss[idx].value, "VALUE" + std::to_string(idx));
+      ASSERT_EQ(vss[idx].ttl_millsec, -1);
+    } else {
+      ASSERT_TRUE(vss[idx].status.IsNotFound());
+      ASSERT_EQ(vss[idx].ttl_millsec, -2);
+    }
+  }
+
+  std::vector<std::string> del_keys3(keys3.begin(), keys3.begin() + 30);
+  del_keys3.push_back("GP3_MGET_KEY1");
+  ASSERT_EQ(db.Exists(del_keys3), 22);
+  ASSERT_EQ(db.Del(del_keys3), 21);
+  ASSERT_EQ(db.Exists(del_keys3), 0);
 }
 
 // MSet
@@ -581,6 +683,34 @@ TEST_F(StringsTest, MSetTest) {
   kvs.push_back({"MSET_TEST_KEY3", "MSET_TEST_VALUE3"});
   s = db.MSet(kvs);
   ASSERT_TRUE(s.ok());
+
+  // the keys of one batch are spread over several rocksdb instances
+  int32_t ret = 0;
+  std::vector<std::string> keys;
+  kvs.clear();
+  for (int idx = 0; idx < 100; ++idx) {
+    keys.push_back("MSETNX_TEST_KEY" + std::to_string(idx));
+    kvs.push_back({keys.back(), "MSETNX_TEST_VALUE" + std::to_string(idx)});
+  }
+  s = db.MSetnx(kvs, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+
+  // one existing key stops the whole batch
+  kvs.push_back({"MSET_TEST_KEY1", "MSETNX_NEW_VALUE"});
+  kvs.push_back({"MSETNX_TEST_NEW_KEY", "MSETNX_NEW_VALUE"});
+  s = db.MSetnx(kvs, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 0);
+  ASSERT_EQ(db.Exists({"MSETNX_TEST_NEW_KEY"}), 0);
+
+  std::vector<storage::ValueStatus> vss;
+  s = db.MGet(keys, &vss);
+  ASSERT_TRUE(s.ok());
+  for (int idx = 0; idx < 100; ++idx) {
+    ASSERT_TRUE(vss[idx].status.ok());
+    ASSERT_EQ(vss[idx].value, "MSETNX_TEST_VALUE" + std::to_string(idx));
+  }
 }
 
 // TODO(@tangruilin): 修复测试代码
@@ -4,6 +4,7 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 
 #include <gtest/gtest.h>
+#include <atomic>
 #include <iostream>
 #include <thread>
 
@@ -5235,6 +5236,220 @@ TEST_F(ZSetsTest, ZScanTest) {  // NOLINT
   ASSERT_TRUE(score_members_match(score_member_out, {}));
 }
 
+// Rank index
+TEST_F(ZSetsTest, ZRankIndexTest) {  // NOLINT
+  std::string path = "./db/zsets_rank_index";
+  pstd::DeleteDirIfExist(path);
+  mkdir(path.c_str(), 0755);
+  storage::StorageOptions rank_options;
+  rank_options.options.create_if_missing = true;
+  rank_options.zset_rank_index_threshold = 16;
+  storage::Storage rank_db;
+  s = rank_db.Open(rank_options, path);
+  ASSERT_TRUE(s.ok());
+
+  int32_t ret;
+  std::vector<storage::ScoreMember> expect_sm;
+  std::vector<storage::ScoreMember> score_members;
+  for (int32_t idx = 0; idx < 2000; ++idx) {
+    score_members.push_back({static_cast<double>(idx % 100), "MM" + std::to_string(idx)});
+  }
+  for (int32_t idx = 0; idx < 2000; idx += 100) {
+    std::vector<storage::ScoreMember> part(score_members.begin() + idx, score_members.begin() + idx + 100);
+    s = rank_db.ZAdd("GP1_ZRANK_INDEX_KEY", part, &ret);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(ret, 100);
+  }
+
+  // ***************** Group 1 Test *****************
+  // Members removed and rescored after the index is built
+  std::vector<std::string> del_members;
+  for (int32_t idx = 0; idx < 2000; idx += 7) {
+    del_members.push_back("MM" + std::to_string(idx));
+  }
+  s = rank_db.ZRem("GP1_ZRANK_INDEX_KEY", del_members, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, static_cast<int32_t>(del_members.size()));
+  double score;
+  for (int32_t idx = 3; idx < 2000; idx += 11) {
+    if (idx % 7 != 0) {
+      s = rank_db.ZIncrby("GP1_ZRANK_INDEX_KEY", "MM" + std::to_string(idx), 0.5, &score);
+      ASSERT_TRUE(s.ok());
+    }
+  }
+  s = rank_db.ZRemrangebyrank("GP1_ZRANK_INDEX_KEY", 500, 549, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 50);
+
+  s = db.ZAdd("GP1_ZRANK_INDEX_KEY", score_members, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.ZRem("GP1_ZRANK_INDEX_KEY", del_members, &ret);
+  ASSERT_TRUE(s.ok());
+  for (int32_t idx = 3; idx < 2000; idx += 11) {
+    if (idx % 7 != 0) {
+      s = db.ZIncrby("GP1_ZRANK_INDEX_KEY", "MM" + std::to_string(idx), 0.5, &score);
+      ASSERT_TRUE(s.ok());
+    }
+  }
+  s = db.ZRemrangebyrank("GP1_ZRANK_INDEX_KEY", 500, 549, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.ZRange("GP1_ZRANK_INDEX_KEY", 0, -1, &expect_sm);
+  ASSERT_TRUE(s.ok());
+
+  std::vector<storage::ScoreMember> sm_out;
+  s = rank_db.ZRange("GP1_ZRANK_INDEX_KEY", 0, -1, &sm_out);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(score_members_match(sm_out, expect_sm));
+
+  // ***************** Group 2 Test *****************
+  // ZRank, ZRevrank, ZRange and ZRevrange through the index
+  int32_t size = static_cast<int32_t>(expect_sm.size());
+  for (int32_t rank = 0; rank < size; rank += 37) {
+    int32_t rank_out;
+    s = rank_db.ZRank("GP1_ZRANK_INDEX_KEY", expect_sm[rank].member, &rank_out);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(rank_out, rank);
+    s = rank_db.ZRevrank("GP1_ZRANK_INDEX_KEY", expect_sm[rank].member, &rank_out);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(rank_out, size - rank - 1);
+
+    s = rank_db.ZRange("GP1_ZRANK_INDEX_KEY", rank, rank + 2, &sm_out);
+    ASSERT_TRUE(s.ok());
+    std::vector<storage::ScoreMember> expect_range(expect_sm.begin() + rank,
+                                                   expect_sm.begin() + std::min(rank + 3, size));
+    ASSERT_TRUE(score_members_match(sm_out, expect_range));
+
+    s = rank_db.ZRevrange("GP1_ZRANK_INDEX_KEY", size - rank - 1, size - rank - 1, &sm_out);
+    ASSERT_TRUE(s.ok());
+    ASSERT_TRUE(score_members_match(sm_out, {expect_sm[rank]}));
+  }
+
+  // ***************** Group 3 Test *****************
+  // ZRank of a member that does not exist
+  int32_t rank_out;
+  s = rank_db.ZRank("GP1_ZRANK_INDEX_KEY", "MM0", &rank_out);
+  ASSERT_TRUE(s.IsNotFound());
+}
+
+// ZUNIONSTORE and ZINTERSTORE over inputs larger than one write batch,
+// combined inside one instance
+TEST_F(ZSetsTest, ZStoreLargeInputsTest) {  // NOLINT
+  int32_t ret;
+  std::vector<storage::ScoreMember> large;
+  std::vector<storage::ScoreMember> small;
+  for (int32_t idx = 0; idx < 3000; ++idx) {
+    large.push_back({static_cast<double>(idx), "MM" + std::to_string(idx)});
+  }
+  for (int32_t idx = 0; idx < 3000; idx += 3) {
+    small.push_back({1, "MM" + std::to_string(idx)});
+  }
+  small.push_back({1, "NN"});
+  s = db.ZAdd("{GP1_ZSTORE}_LARGE", large, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.ZAdd("{GP1_ZSTORE}_SMALL", small, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.Set("{GP1_ZSTORE}_STRING", "value");
+  ASSERT_TRUE(s.ok());
+
+  // ***************** Group 1 Test *****************
+  std::map<std::string, double> union_to_dest;
+  s = db.ZUnionstore("{GP1_ZSTORE}_DEST", {"{GP1_ZSTORE}_LARGE", "{GP1_ZSTORE}_SMALL"}, {2, 10}, storage::SUM,
+                     union_to_dest, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 3001);
+  ASSERT_EQ(union_to_dest.size(), 3001U);
+  ASSERT_TRUE(size_match(&db, "{GP1_ZSTORE}_DEST", 3001));
+  double score;
+  s = db.ZScore("{GP1_ZSTORE}_DEST", "MM3", &score);
+  ASSERT_TRUE(s.ok());
+  ASSERT_DOUBLE_EQ(score, 16);
+  s = db.ZScore("{GP1_ZSTORE}_DEST", "MM4", &score);
+  ASSERT_TRUE(s.ok());
+  ASSERT_DOUBLE_EQ(score, 8);
+  s = db.ZScore("{GP1_ZSTORE}_DEST", "NN", &score);
+  ASSERT_TRUE(s.ok());
+  ASSERT_DOUBLE_EQ(score, 10);
+
+  // ***************** Group 2 Test *****************
+  // The destination is replaced by the new version
+  std::vector<storage::ScoreMember> inter_to_dest;
+  s = db.ZInterstore("{GP1_ZSTORE}_DEST", {"{GP1_ZSTORE}_LARGE", "{GP1_ZSTORE}_SMALL"}, {1, 1}, storage::MAX,
+                     inter_to_dest, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1000);
+  ASSERT_EQ(inter_to_dest.size(), 1000U);
+  ASSERT_TRUE(size_match(&db, "{GP1_ZSTORE}_DEST", 1000));
+  s = db.ZScore("{GP1_ZSTORE}_DEST", "MM0", &score);
+  ASSERT_TRUE(s.ok());
+  ASSERT_DOUBLE_EQ(score, 1);
+  s = db.ZScore("{GP1_ZSTORE}_DEST", "MM2997", &score);
+  ASSERT_TRUE(s.ok());
+  ASSERT_DOUBLE_EQ(score, 2997);
+  s = db.ZScore("{GP1_ZSTORE}_DEST", "MM4", &score);
+  ASSERT_TRUE(s.IsNotFound());
+  s = db.ZScore("{GP1_ZSTORE}_DEST", "NN", &score);
+  ASSERT_TRUE(s.IsNotFound());
+
+  // ***************** Group 3 Test *****************
+  s = db.ZInterstore("{GP1_ZSTORE}_DEST", {"{GP1_ZSTORE}_SMALL", "{GP1_ZSTORE}_NOT_EXIST"}, {1, 1}, storage::SUM,
+                     inter_to_dest, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 0);
+  ASSERT_TRUE(size_match(&db, "{GP1_ZSTORE}_DEST", 0));
+  s = db.ZUnionstore("{GP1_ZSTORE}_DEST", {"{GP1_ZSTORE}_SMALL", "{GP1_ZSTORE}_STRING"}, {1, 1}, storage::SUM,
+                     union_to_dest, &ret);
+  ASSERT_TRUE(s.IsInvalidArgument());
+}
+
+// The members of a store survive compactions running while it writes them
+TEST_F(ZSetsTest, ZStoreCompactionTest) {  // NOLINT
+  int32_t ret;
+  std::vector<storage::ScoreMember> large;
+  for (int32_t idx = 0; idx < 5000; ++idx) {
+    large.push_back({static_cast<double>(idx), "MM" + std::to_string(idx)});
+  }
+  s = db.ZAdd("{GP1_ZSTORE_COMPACT}_LARGE", large, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.ZAdd("{GP1_ZSTORE_COMPACT}_EXPIRED", {{1, "MM1"}}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(make_expired(&db, "{GP1_ZSTORE_COMPACT}_EXPIRED"));
+
+  s = db.ZAdd("{GP1_ZSTORE_COMPACT}_TTL", {{1, "MM1"}}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(db.Expire("{GP1_ZSTORE_COMPACT}_TTL", 100000), 1);
+
+  std::atomic<bool> storing(true);
+  std::thread compactor([&]() {
+    while (storing) {
+      db.Compact(storage::DataType::kZSets, true);
+    }
+  });
+
+  // ***************** Group 1 Test *****************
+  // A destination that does not exist yet, an expired one and one with a
+  // TTL, the members go out ahead of the meta
+  std::vector<storage::ScoreMember> score_members;
+  std::map<std::string, double> union_to_dest;
+  for (const std::string destination :
+       {"{GP1_ZSTORE_COMPACT}_DEST", "{GP1_ZSTORE_COMPACT}_EXPIRED", "{GP1_ZSTORE_COMPACT}_TTL"}) {
+    for (int32_t round = 0; round < 5; ++round) {
+      s = db.ZUnionstore(destination, {"{GP1_ZSTORE_COMPACT}_LARGE"}, {1}, storage::SUM, union_to_dest, &ret);
+      ASSERT_TRUE(s.ok());
+      ASSERT_EQ(ret, 5000);
+    }
+  }
+  storing = false;
+  compactor.join();
+  db.Compact(storage::DataType::kZSets, true);
+  for (const std::string destination :
+       {"{GP1_ZSTORE_COMPACT}_DEST", "{GP1_ZSTORE_COMPACT}_EXPIRED", "{GP1_ZSTORE_COMPACT}_TTL"}) {
+    ASSERT_TRUE(size_match(&db, destination, 5000));
+    s = db.ZRange(destination, 0, -1, &score_members);
+    ASSERT_TRUE(s.ok());
+    ASSERT_EQ(score_members.size(), 5000U);
+  }
+}
+
 int main(int argc, char** argv) {
   if (!pstd::FileExists("./log")) {
     pstd::CreatePath("./log");
@@ -0,0 +1,64 @@
+// Copyright (c) 2015-present, Qihoo, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "include/pika_binlog.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "pstd/include/env.h"
+
+namespace {
+
+const std::string kBinlogPath = "./binlog_test/";
+
+bool WaitForSync(Binlog* binlog, int timeout_ms) {
+  for (int i = 0; i < timeout_ms / 10 && !binlog->IsSynced(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return binlog->IsSynced();
+}
+
+class BinlogTest : public ::testing::Test {
+ protected:
+  void SetUp() override { pstd::DeleteDirIfExist(kBinlogPath); }
+  void TearDown() override { pstd::DeleteDirIfExist(kBinlogPath); }
+};
+
+}  // namespace
+
+TEST_F(BinlogTest, BatchSyncPolicy) {
+  Binlog binlog(kBinlogPath);
+  binlog.SetSyncPolicy(BinlogSyncPolicy::kBatch, 1000);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(binlog.Put("ITEM_" + std::to_string(i)).ok());
+    ASSERT_TRUE(binlog.IsSynced());
+  }
+}
+
+// The batches right behind a sync wait for the interval, the sync thread
+// covers them although no Put follows
+TEST_F(BinlogTest, IntervalSyncPolicyTail) {
+  Binlog binlog(kBinlogPath);
+  binlog.SetSyncPolicy(BinlogSyncPolicy::kInterval, 1000);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(binlog.Put("ITEM_" + std::to_string(i)).ok());
+  }
+  ASSERT_FALSE(binlog.IsSynced());
+  ASSERT_TRUE(WaitForSync(&binlog, 3000));
+
+  // and once more after an idle period
+  ASSERT_TRUE(binlog.Put("ITEM_10").ok());
+  ASSERT_TRUE(binlog.Put("ITEM_11").ok());
+  ASSERT_TRUE(WaitForSync(&binlog, 3000));
+
+  uint32_t filenum = 0;
+  uint64_t offset = 0;
+  uint64_t logic_id = 0;
+  ASSERT_TRUE(binlog.GetProducerStatus(&filenum, &offset, nullptr, &logic_id).ok());
+  ASSERT_EQ(logic_id, 12U);
+}
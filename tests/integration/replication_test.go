@@ -5,6 +5,7 @@ import (
 	"fmt"
 	"log"
 	"math/rand"
+	"strconv"
 	"strings"
 	"sync"
 	"time"
@@ -43,6 +44,20 @@ func trySlave(ctx context.Context, clientSlave *redis.Client, ip string, port st
 	}
 }
 
+func replApplyInfo(ctx context.Context, clientSlave *redis.Client, field string) int64 {
+	infoRes := clientSlave.Info(ctx, "replication")
+	Expect(infoRes.Err()).NotTo(HaveOccurred())
+	for _, line := range strings.Split(infoRes.Val(), "\r\n") {
+		if strings.HasPrefix(line, field+":") {
+			value, err := strconv.ParseInt(strings.TrimPrefix(line, field+":"), 10, 64)
+			Expect(err).NotTo(HaveOccurred())
+			return value
+		}
+	}
+	Fail("no " + field + " in info replication")
+	return 0
+}
+
 func randomString(length int) string {
 	rand.Seed(time.Now().UnixNano())
 	b := make([]byte, length)
@@ -795,6 +810,84 @@ var _ = Describe("should replication ", func() {
 			}
 			log.Println("master-slave replication test success")
 		})
+		It("should apply the replicated writes in batches in order", func() {
+			var count = 0
+			for {
+				res := trySlave(ctx, clientSlave, LOCALHOST, MASTERPORT)
+				if res {
+					break
+				} else if count > 4 {
+					break
+				} else {
+					cleanEnv(ctx, clientMaster, clientSlave)
+					count++
+				}
+			}
+			infoRes := clientSlave.Info(ctx, "replication")
+			Expect(infoRes.Err()).NotTo(HaveOccurred())
+			Expect(infoRes.Val()).To(ContainSubstring("master_link_status:up"))
+			appliedCmds := replApplyInfo(ctx, clientSlave, "repl_apply_cmds")
+			appliedBatches := replApplyInfo(ctx, clientSlave, "repl_apply_batches")
+
+			// every round rewrites the same keys, the later rounds must win on
+			// the slave however the commands are split into runs. INCR and
+			// RPUSH are applied one by one between the staged writes
+			const rounds = 200
+			const keys = 50
+			pipe := clientMaster.Pipeline()
+			for round := 0; round < rounds; round++ {
+				for key := 0; key < keys; key++ {
+					value := strconv.Itoa(round)
+					pipe.Set(ctx, fmt.Sprintf("batch_apply_string_%d", key), value, 0)
+					pipe.HSet(ctx, fmt.Sprintf("batch_apply_hash_%d", key), "field", value)
+					pipe.HMSet(ctx, fmt.Sprintf("batch_apply_hmset_%d", key), "f1", value, "f2", value)
+					pipe.Incr(ctx, fmt.Sprintf("batch_apply_counter_%d", key))
+				}
+				pipe.RPush(ctx, "batch_apply_list", round)
+				_, err := pipe.Exec(ctx)
+				Expect(err).NotTo(HaveOccurred())
+			}
+
+			last := strconv.Itoa(rounds - 1)
+			Eventually(func() []string {
+				return clientSlave.LRange(ctx, "batch_apply_list", 0, -1).Val()
+			}, "60s", "100ms").Should(Equal(clientMaster.LRange(ctx, "batch_apply_list", 0, -1).Val()))
+			Eventually(func() int64 {
+				return replApplyInfo(ctx, clientSlave, "repl_apply_pending")
+			}, "60s", "100ms").Should(Equal(int64(0)))
+			for key := 0; key < keys; key++ {
+				Eventually(func() string {
+					return clientSlave.Get(ctx, fmt.Sprintf("batch_apply_string_%d", key)).Val()
+				}, "10s", "100ms").Should(Equal(last))
+				Eventually(func() string {
+					return clientSlave.HGet(ctx, fmt.Sprintf("batch_apply_hash_%d", key), "field").Val()
+				}, "10s", "100ms").Should(Equal(last))
+				Eventually(func() map[string]string {
+					return clientSlave.HGetAll(ctx, fmt.Sprintf("batch_apply_hmset_%d", key)).Val()
+				}, "10s", "100ms").Should(Equal(map[string]string{"f1": last, "f2": last}))
+				Eventually(func() string {
+					return clientSlave.Get(ctx, fmt.Sprintf("batch_apply_counter_%d", key)).Val()
+				}, "10s", "100ms").Should(Equal(strconv.Itoa(rounds)))
+			}
+
+			// all the commands of the burst went through the batched apply,
+			// the SET, HSET and HMSET that shared a run through one WriteBatch
+			Expect(replApplyInfo(ctx, clientSlave, "repl_apply_cmds") - appliedCmds).To(
+				BeNumerically(">=", int64(rounds*(keys*4+1))))
+			batches := replApplyInfo(ctx, clientSlave, "repl_apply_batches") - appliedBatches
+			Expect(batches).To(BeNumerically(">", 0))
+			Expect(replApplyInfo(ctx, clientSlave, "repl_apply_max_batch_size")).To(BeNumerically(">=", 1))
+			Expect(replApplyInfo(ctx, clientSlave, "repl_apply_max_batch_size")).To(BeNumerically("<=", 64))
+			Expect(replApplyInfo(ctx, clientSlave, "repl_apply_staged_cmds")).To(BeNumerically(">", 0))
+			Expect(replApplyInfo(ctx, clientSlave, "repl_apply_lag_ms")).To(Equal(int64(0)))
+
+			for key := 0; key < keys; key++ {
+				Expect(clientMaster.Del(ctx, fmt.Sprintf("batch_apply_string_%d", key), fmt.Sprintf("batch_apply_hash_%d", key),
+					fmt.Sprintf("batch_apply_hmset_%d", key), fmt.Sprintf("batch_apply_counter_%d", key)).Err()).NotTo(HaveOccurred())
+			}
+			Expect(clientMaster.Del(ctx, "batch_apply_list").Err()).NotTo(HaveOccurred())
+		})
+
 		It("should simulate the master node setex and incr operation", func() {
 			setex := clientMaster.SetEx(ctx, "incrkey1", "100", 10*time.Second)
 			Expect(setex.Err()).NotTo(HaveOccurred())